@@ -28,24 +28,79 @@
 #include "uniquestr.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <limits.h>
 #include <string.h>
-#include <math.h>
 
 #include "mem.h"
 
-typedef struct string_link_tag string_link_t;
-
-struct string_link_tag
+// Interning table
+//
+// Open addressing with linear probing over a power of two table. Each slot
+// keeps the hash of its string so probes seldom compare strings. Lookups
+// never write to the table: a slot is only written once, when it goes from
+// empty to used, and its string is published after its hash. Growing builds
+// a new table and publishes it with a single pointer store. The table it
+// replaces is retired but never freed, so a reader that is still probing it
+// keeps seeing valid, if stale, slots. Inserting strings must still be
+// serialized. The strings themselves are copied into big slabs so interning
+// a string does not allocate.
+
+typedef
+struct string_slot_tag
 {
     unsigned int hash;
     const char *string;
-    string_link_t *next;
-};
+} string_slot_t;
+
+typedef
+struct string_table_tag
+{
+    // Always a power of two
+    unsigned int size;
+    // The table this one replaced, if any
+    struct string_table_tag *retired;
+    string_slot_t slots[];
+} string_table_t;
+
+enum { INITIAL_TABLE_SIZE = 4096 };
+
+static string_table_t *table = NULL;
+static unsigned int num_strings = 0;
+static unsigned int num_resizes = 0;
+static unsigned long long int bytes_retired = 0;
+
+static string_table_t *current_table(void)
+{
+    return __atomic_load_n(&table, __ATOMIC_ACQUIRE);
+}
+
+static const char *slot_string(string_slot_t *slot)
+{
+    return __atomic_load_n(&slot->string, __ATOMIC_ACQUIRE);
+}
+
+static void fill_slot(string_slot_t *slot, unsigned int hash, const char *string)
+{
+    slot->hash = hash;
+    __atomic_store_n(&slot->string, string, __ATOMIC_RELEASE);
+}
+
+// Strings are stored in slabs
+enum { SLAB_SIZE = 64 * 1024 };
+
+typedef
+struct string_slab_tag
+{
+    struct string_slab_tag *next;
+    char data[];
+} string_slab_t;
 
-enum { HASH_LENGTH = 76003 };
+static string_slab_t *slabs = NULL;
+static char *slab_current = NULL;
+static char *slab_end = NULL;
+static unsigned long long int bytes_reserved_in_slabs = 0;
 
-static string_link_t *hash_table[HASH_LENGTH];
 static unsigned long long int bytes_used = 0;
 
 unsigned long long int char_trie_used_memory(void)
@@ -53,113 +108,201 @@ unsigned long long int char_trie_used_memory(void)
     return bytes_used;
 }
 
-static unsigned int hash_string(const char *string)
+// FNV-1a plus the finalizer of Murmur3 so all the bits of the hash depend
+// on all the characters, as we only use the lower bits
+static unsigned int hash_string(const char *string, size_t *length)
 {
-    unsigned int hash = 0;
-    const char *p;
+    uint32_t hash = 2166136261u;
+    const unsigned char *p;
+
+    for (p = (const unsigned char*)string; *p; p++)
+    {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
 
-    for (p = string; *p; p++)
-        hash = ((hash << 5) + hash) ^ *p;
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6b;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35;
+    hash ^= hash >> 16;
+
+    *length = (const char*)p - string;
 
     return hash;
 }
 
-const char *uniquestr(const char *string)
+static char *slab_allocate(size_t size)
 {
-    if (string == NULL)
-        return NULL;
-
-    unsigned int hash = hash_string(string);
-    unsigned int hash_index = hash % (sizeof(hash_table) / sizeof(hash_table[0]));
-    string_link_t *p, *p_prev = 0, *new_link;
-
-    for (p = hash_table[hash_index]; p; p_prev = p, p = p->next)
+    if ((size_t)(slab_end - slab_current) < size)
     {
-        if (p->hash == hash && !strcmp(p->string, string))
+        // Strings that would waste most of a slab get one of their own
+        size_t slab_size = SLAB_SIZE;
+        if (size > SLAB_SIZE / 4)
+            slab_size = sizeof(string_slab_t) + size;
+
+        string_slab_t *slab = (string_slab_t*)xmalloc(slab_size);
+        slab->next = slabs;
+        slabs = slab;
+        bytes_reserved_in_slabs += slab_size;
+        bytes_used += slab_size;
+
+        char *data = slab->data;
+        if (size > SLAB_SIZE / 4)
         {
-            if (p != hash_table[hash_index])
-            {
-                p_prev->next = p->next;
-                p->next = hash_table[hash_index];
-                hash_table[hash_index] = p;
-            }
-
-            return p->string;
+            // Keep using the current slab for small strings
+            return data;
         }
+
+        slab_current = data;
+        slab_end = (char*)slab + slab_size;
     }
 
-    bytes_used += sizeof(string_link_t) + strlen(string) + 1;
+    char *result = slab_current;
+    slab_current += size;
+    return result;
+}
 
-    new_link = NEW(string_link_t);
-    new_link->string = xstrdup(string); 
-    new_link->hash = hash; 
-    new_link->next = hash_table[hash_index];
-    hash_table[hash_index] = new_link; 
+static void place_string(string_table_t *t, unsigned int hash, const char *string)
+{
+    unsigned int mask = t->size - 1;
+    unsigned int i = hash & mask;
+    while (t->slots[i].string != NULL)
+    {
+        i = (i + 1) & mask;
+    }
 
-    return new_link->string;
+    fill_slot(&t->slots[i], hash, string);
 }
 
-void uniquestr_stats(void)
+static void grow_table(void)
 {
-    unsigned long long bucket_length[HASH_LENGTH];
-    unsigned long long number_of_strings = 0;
-    unsigned long long number_of_bytes = 0;
-
-    int i, j;
-    for (i = 0; i < HASH_LENGTH; i++)
+    unsigned int old_size = table == NULL ? 0 : table->size;
+    unsigned int new_size = old_size == 0 ? INITIAL_TABLE_SIZE : 2 * old_size;
+    string_table_t *new_table = (string_table_t*)xcalloc(1,
+            sizeof(string_table_t) + new_size * sizeof(string_slot_t));
+    new_table->size = new_size;
+    new_table->retired = table;
+
+    unsigned int i;
+    for (i = 0; i < old_size; i++)
     {
-        string_link_t *p = hash_table[i];
+        if (table->slots[i].string != NULL)
+            place_string(new_table, table->slots[i].hash, table->slots[i].string);
+    }
 
-        j = 0;
-        while (p != NULL)
-        {
-            // fprintf(stderr, "%d.%d |%s|\n", i, j, p->string);
-            number_of_strings++;
-            number_of_bytes += strlen(p->string) + 1; // +1 for NULL
+    bytes_used += sizeof(string_table_t) + (unsigned long long)new_size * sizeof(string_slot_t);
+    if (table != NULL)
+        bytes_retired += sizeof(string_table_t) + (unsigned long long)old_size * sizeof(string_slot_t);
 
-            p = p->next;
-            j++;
-        }
+    // Readers probing the old table may still be using it, so it is not freed
+    __atomic_store_n(&table, new_table, __ATOMIC_RELEASE);
+
+    if (new_size != INITIAL_TABLE_SIZE)
+        num_resizes++;
+}
+
+// Returns the interned string equal to string, or NULL if there is none.
+// It only reads the table
+static const char *lookup_string(string_table_t *t,
+        unsigned int hash, const char *string)
+{
+    unsigned int mask = t->size - 1;
+    unsigned int i = hash & mask;
+    const char *current;
+    while ((current = slot_string(&t->slots[i])) != NULL)
+    {
+        if (t->slots[i].hash == hash
+                && strcmp(current, string) == 0)
+            return current;
 
-        bucket_length[i] = j;
+        i = (i + 1) & mask;
     }
 
-    unsigned long long max_bucket = 0;
-    unsigned long long min_bucket = ULLONG_MAX;
-    unsigned long long sum_buckets = 0;
-    unsigned long long num_empty_buckets = 0;
+    return NULL;
+}
 
-    for (i = 0; i < HASH_LENGTH; i++)
-    {
-        if (bucket_length[i] >= max_bucket)
-            max_bucket = bucket_length[i];
-        if (bucket_length[i] <= min_bucket)
-            min_bucket = bucket_length[i];
+const char *uniquestr(const char *string)
+{
+    if (string == NULL)
+        return NULL;
 
-        sum_buckets += bucket_length[i];
+    if (table == NULL)
+        grow_table();
 
-        num_empty_buckets += (bucket_length[i] == 0);
-    }
+    size_t length;
+    unsigned int hash = hash_string(string, &length);
+
+    const char *found = lookup_string(current_table(), hash, string);
+    if (found != NULL)
+        return found;
+
+    // Not found, keep the load factor at most 1/2 so probes remain short
+    if (2 * (num_strings + 1) > table->size)
+        grow_table();
+
+    char *new_string = slab_allocate(length + 1);
+    memcpy(new_string, string, length + 1);
 
-    float avg_bucket = 0.0f;
-    avg_bucket = ((float)sum_buckets / (float)HASH_LENGTH);
+    place_string(table, hash, new_string);
+    num_strings++;
 
-    float stddev_bucket = 0.0f;
-    for (i = 0; i < HASH_LENGTH; i++)
+    return new_string;
+}
+
+void uniquestr_stats(void)
+{
+    unsigned long long number_of_bytes = 0;
+    unsigned long long sum_probes = 0;
+    unsigned long long max_probe = 0;
+    unsigned long long num_clusters = 0;
+    unsigned long long max_cluster = 0;
+    unsigned long long current_cluster = 0;
+
+    unsigned int table_size = table == NULL ? 0 : table->size;
+    unsigned int i;
+    for (i = 0; i < table_size; i++)
     {
-        stddev_bucket += fabsf(bucket_length[i] - avg_bucket);
+        if (table->slots[i].string == NULL)
+        {
+            current_cluster = 0;
+            continue;
+        }
+
+        number_of_bytes += strlen(table->slots[i].string) + 1; // +1 for NULL
+
+        // Number of slots a successful lookup of this string visits
+        unsigned long long probe = ((i - table->slots[i].hash) & (table_size - 1)) + 1;
+        sum_probes += probe;
+        if (probe > max_probe)
+            max_probe = probe;
+
+        if (current_cluster == 0)
+            num_clusters++;
+        current_cluster++;
+        if (current_cluster > max_cluster)
+            max_cluster = current_cluster;
     }
-    stddev_bucket = sqrtf(stddev_bucket / (float)(HASH_LENGTH - 1));
+
+    float load_factor = 0.0f;
+    float avg_probe = 0.0f;
+    if (table_size > 0)
+        load_factor = (float)num_strings / (float)table_size;
+    if (num_strings > 0)
+        avg_probe = (float)sum_probes / (float)num_strings;
 
     fprintf(stderr, "String table statistics\n");
     fprintf(stderr, "=======================\n\n");
 
-    fprintf(stderr, "Size of hash: %d\n", HASH_LENGTH);
-    fprintf(stderr, "Number of strings: %llu\n", number_of_strings);
+    fprintf(stderr, "Size of hash: %u\n", table_size);
+    fprintf(stderr, "Number of resizes: %u\n", num_resizes);
+    fprintf(stderr, "Number of bytes of retired tables: %llu\n", bytes_retired);
+    fprintf(stderr, "Number of strings: %u\n", num_strings);
+    fprintf(stderr, "Load factor: %.2f\n", load_factor);
     fprintf(stderr, "Number of bytes taken by the strings: %llu\n", number_of_bytes);
-    fprintf(stderr, "Number of empty buckets: %llu\n", num_empty_buckets);
-    fprintf(stderr, "Minimum bucket length: %llu\n", min_bucket);
-    fprintf(stderr, "Maximum bucket length: %llu\n", max_bucket);
-    fprintf(stderr, "Average bucket length: %.2f\n", avg_bucket);
-    fprintf(stderr, "StdDev  bucket length: %.2f\n", stddev_bucket);
+    fprintf(stderr, "Number of bytes reserved in slabs: %llu\n", bytes_reserved_in_slabs);
+    fprintf(stderr, "Average probe length: %.2f\n", avg_probe);
+    fprintf(stderr, "Maximum probe length: %llu\n", max_probe);
+    fprintf(stderr, "Number of clusters: %llu\n", num_clusters);
+    fprintf(stderr, "Maximum cluster length: %llu\n", max_cluster);
 }
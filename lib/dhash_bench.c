@@ -0,0 +1,419 @@
+/*--------------------------------------------------------------------
+  (C) Copyright 2006-2015 Barcelona Supercomputing Center
+                          Centro Nacional de Supercomputacion
+  
+  This file is part of Mercurium C/C++ source-to-source compiler.
+  
+  See AUTHORS file in the top level directory for information
+  regarding developers and contributors.
+  
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3 of the License, or (at your option) any later version.
+  
+  Mercurium C/C++ source-to-source compiler is distributed in the hope
+  that it will be useful, but WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+  PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public
+  License along with Mercurium C/C++ source-to-source compiler; if
+  not, write to the Free Software Foundation, Inc., 675 Mass Ave,
+  Cambridge, MA 02139, USA.
+--------------------------------------------------------------------*/
+
+/*
+ * Microbenchmark for dhash_ptr and dhash_str
+ *
+ * Replays a trace of operations over a set of tables, mimicking the way
+ * scopes use them: lookups walk a chain of nested scopes until the name is
+ * found and block scopes are created and destroyed all the time.
+ *
+ * The trace is either synthesized or read from a file with one operation per
+ * line
+ *
+ *    new <table>
+ *    insert <table> <key>
+ *    query <table> <key>
+ *    remove <table> <key>
+ *    destroy <table>
+ *
+ * where <table> is a small nonnegative integer. Lines starting with '#' are
+ * ignored.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/time.h>
+
+#include "dhash_ptr.h"
+#include "dhash_str.h"
+#include "mem.h"
+
+#define HELP_MESSAGE \
+"Syntax: \n" \
+"  dhash_bench [-r repetitions] [-s seed] [-f functions] [trace_file]" \
+"\n"
+
+typedef
+enum trace_op_kind_tag
+{
+    TRACE_NEW = 0,
+    TRACE_INSERT,
+    TRACE_QUERY,
+    TRACE_REMOVE,
+    TRACE_DESTROY,
+} trace_op_kind_t;
+
+typedef
+struct trace_op_tag
+{
+    trace_op_kind_t kind;
+    int table;
+    // Interned key, used by dhash_ptr
+    const char* key;
+    // A private copy of the key, so dhash_str has to compare the strings
+    const char* key_copy;
+} trace_op_t;
+
+static trace_op_t* trace = NULL;
+static int trace_size = 0;
+static int trace_capacity = 0;
+static int max_table = -1;
+
+static dhash_str_t* interned_keys = NULL;
+
+static int repetitions = 10;
+static unsigned int seed = 1234;
+static int num_functions = 20000;
+
+static void help_message(const char* error_message)
+{
+    if (error_message != NULL)
+    {
+        fprintf(stderr, "Error: %s\n\n", error_message);
+    }
+    fprintf(stderr, HELP_MESSAGE);
+    exit(EXIT_FAILURE);
+}
+
+static const char* intern_key(const char* key)
+{
+    const char* result = (const char*)dhash_str_query(interned_keys, key);
+    if (result == NULL)
+    {
+        result = xstrdup(key);
+        dhash_str_insert(interned_keys, result, (void*)result);
+    }
+    return result;
+}
+
+static void add_op(trace_op_kind_t kind, int table, const char* key)
+{
+    if (table < 0)
+        help_message("Invalid table number in trace");
+
+    if (trace_size == trace_capacity)
+    {
+        trace_capacity = trace_capacity == 0 ? 1024 : 2 * trace_capacity;
+        trace = NEW_REALLOC(trace_op_t, trace, trace_capacity);
+    }
+
+    trace_op_t* op = &trace[trace_size];
+    op->kind = kind;
+    op->table = table;
+    op->key = NULL;
+    op->key_copy = NULL;
+    if (key != NULL)
+    {
+        op->key = intern_key(key);
+        op->key_copy = xstrdup(key);
+    }
+
+    if (table > max_table)
+        max_table = table;
+
+    trace_size++;
+}
+
+static void read_trace(const char* filename)
+{
+    FILE* f = fopen(filename, "r");
+    if (f == NULL)
+    {
+        fprintf(stderr, "Cannot open trace file '%s'\n", filename);
+        exit(EXIT_FAILURE);
+    }
+
+    char line[1024];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        line_number++;
+
+        char op[32], key[sizeof(line)];
+        int table;
+        int n = sscanf(line, "%31s %d %1023s", op, &table, key);
+        if (n <= 0 || op[0] == '#')
+            continue;
+
+        if (n == 2 && strcmp(op, "new") == 0)
+            add_op(TRACE_NEW, table, NULL);
+        else if (n == 2 && strcmp(op, "destroy") == 0)
+            add_op(TRACE_DESTROY, table, NULL);
+        else if (n == 3 && strcmp(op, "insert") == 0)
+            add_op(TRACE_INSERT, table, key);
+        else if (n == 3 && strcmp(op, "query") == 0)
+            add_op(TRACE_QUERY, table, key);
+        else if (n == 3 && strcmp(op, "remove") == 0)
+            add_op(TRACE_REMOVE, table, key);
+        else
+        {
+            fprintf(stderr, "%s:%d: invalid trace line\n", filename, line_number);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    fclose(f);
+}
+
+static unsigned int random_state;
+static unsigned int next_random(void)
+{
+    random_state = random_state * 1103515245u + 12345u;
+    return (random_state >> 16) & 0x7fff;
+}
+
+// Skewed towards small values, like the frequency of names in a program
+static int skewed_random(int n)
+{
+    unsigned int r = next_random();
+    return (int)(((uint64_t)r * r * n) / (0x8000u * 0x8000u));
+}
+
+// Queries a name the way name lookup does: from the innermost scope outwards
+static void add_lookup(int innermost_table, const char* name)
+{
+    int table;
+    for (table = innermost_table; table >= 0; table--)
+    {
+        add_op(TRACE_QUERY, table, name);
+    }
+}
+
+enum { NUM_GLOBAL_NAMES = 8000, NUM_NAMESPACE_NAMES = 1500 };
+
+// Table 0 is the global scope, 1 a namespace scope, 2 a function scope and
+// 3 onwards nested block scopes
+static void synthesize_trace(void)
+{
+    char name[64];
+    int i, j, k;
+
+    random_state = seed;
+
+    add_op(TRACE_NEW, 0, NULL);
+    for (i = 0; i < NUM_GLOBAL_NAMES; i++)
+    {
+        snprintf(name, sizeof(name), "global_name_%d", i);
+        add_op(TRACE_INSERT, 0, name);
+    }
+    add_op(TRACE_NEW, 1, NULL);
+    for (i = 0; i < NUM_NAMESPACE_NAMES; i++)
+    {
+        snprintf(name, sizeof(name), "ns_name_%d", i);
+        add_op(TRACE_INSERT, 1, name);
+    }
+
+    for (i = 0; i < num_functions; i++)
+    {
+        int num_blocks = 1 + next_random() % 3;
+        int num_locals = 2 + next_random() % 12;
+
+        add_op(TRACE_NEW, 2, NULL);
+        for (j = 0; j < num_locals; j++)
+        {
+            snprintf(name, sizeof(name), "local_%d", j);
+            add_op(TRACE_INSERT, 2, name);
+        }
+
+        for (k = 0; k < num_blocks; k++)
+        {
+            int table = 3 + k;
+            add_op(TRACE_NEW, table, NULL);
+            int num_block_locals = next_random() % 4;
+            for (j = 0; j < num_block_locals; j++)
+            {
+                snprintf(name, sizeof(name), "block_%d", j);
+                add_op(TRACE_INSERT, table, name);
+            }
+
+            int num_lookups = 10 + next_random() % 40;
+            for (j = 0; j < num_lookups; j++)
+            {
+                unsigned int what = next_random() % 100;
+                if (what < 40)
+                    snprintf(name, sizeof(name), "local_%d", (int)(next_random() % num_locals));
+                else if (what < 50 && num_block_locals > 0)
+                    snprintf(name, sizeof(name), "block_%d", (int)(next_random() % num_block_locals));
+                else if (what < 65)
+                    snprintf(name, sizeof(name), "ns_name_%d", skewed_random(NUM_NAMESPACE_NAMES));
+                else if (what < 95)
+                    snprintf(name, sizeof(name), "global_name_%d", skewed_random(NUM_GLOBAL_NAMES));
+                else
+                    // Not found anywhere
+                    snprintf(name, sizeof(name), "unknown_%d", (int)next_random());
+
+                add_lookup(table, name);
+            }
+        }
+
+        for (k = num_blocks - 1; k >= 0; k--)
+        {
+            add_op(TRACE_DESTROY, 3 + k, NULL);
+        }
+
+        // Some functions are removed, e.g. when a declaration is replaced
+        if (next_random() % 16 == 0)
+        {
+            snprintf(name, sizeof(name), "global_name_%d", skewed_random(NUM_GLOBAL_NAMES));
+            add_op(TRACE_REMOVE, 0, name);
+            add_op(TRACE_INSERT, 0, name);
+        }
+
+        add_op(TRACE_DESTROY, 2, NULL);
+    }
+
+    add_op(TRACE_DESTROY, 1, NULL);
+    add_op(TRACE_DESTROY, 0, NULL);
+}
+
+static double now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+// Any non-NULL value will do as info
+static char dummy_info;
+
+#define REPLAY_FUNCTION(table_kind, key_field) \
+static int replay_##table_kind(void) \
+{ \
+    dhash_##table_kind##_t** tables = NEW_VEC0(dhash_##table_kind##_t*, max_table + 1); \
+    int found = 0; \
+    int i; \
+    for (i = 0; i < trace_size; i++) \
+    { \
+        trace_op_t* op = &trace[i]; \
+        dhash_##table_kind##_t* table = tables[op->table]; \
+        if (op->kind != TRACE_NEW && table == NULL) \
+        { \
+            fprintf(stderr, "Operation %d uses table %d which does not exist\n", i, op->table); \
+            exit(EXIT_FAILURE); \
+        } \
+        switch (op->kind) \
+        { \
+            case TRACE_NEW: \
+                if (table != NULL) \
+                    dhash_##table_kind##_destroy(table); \
+                tables[op->table] = dhash_##table_kind##_new(5); \
+                break; \
+            case TRACE_INSERT: \
+                dhash_##table_kind##_insert(table, op->key_field, &dummy_info); \
+                break; \
+            case TRACE_QUERY: \
+                found += (dhash_##table_kind##_query(table, op->key_field) != NULL); \
+                break; \
+            case TRACE_REMOVE: \
+                dhash_##table_kind##_remove(table, op->key_field); \
+                break; \
+            case TRACE_DESTROY: \
+                dhash_##table_kind##_destroy(table); \
+                tables[op->table] = NULL; \
+                break; \
+        } \
+    } \
+    for (i = 0; i <= max_table; i++) \
+    { \
+        if (tables[i] != NULL) \
+            dhash_##table_kind##_destroy(tables[i]); \
+    } \
+    DELETE(tables); \
+    return found; \
+}
+
+REPLAY_FUNCTION(ptr, key)
+REPLAY_FUNCTION(str, key_copy)
+
+static void run(const char* name, int (*replay)(void))
+{
+    double best = -1;
+    int found = 0;
+    int i;
+    for (i = 0; i < repetitions; i++)
+    {
+        double start = now();
+        found = replay();
+        double elapsed = now() - start;
+
+        if (best < 0 || elapsed < best)
+            best = elapsed;
+    }
+
+    fprintf(stdout, "%-10s %10.2f ms %8.2f ns/op (%d successful queries)\n",
+            name, best * 1e3, best * 1e9 / trace_size, found);
+}
+
+#define GETOPT_OPTIONS "r:s:f:h"
+static void parse_arguments(int argc, char* argv[])
+{
+    int n;
+    while ((n = getopt(argc, argv, GETOPT_OPTIONS)) != -1)
+    {
+        switch (n)
+        {
+            case 'r':
+                repetitions = atoi(optarg);
+                if (repetitions <= 0)
+                    help_message("Invalid number of repetitions");
+                break;
+            case 's':
+                seed = (unsigned int)strtoul(optarg, NULL, 10);
+                break;
+            case 'f':
+                num_functions = atoi(optarg);
+                if (num_functions <= 0)
+                    help_message("Invalid number of functions");
+                break;
+            default:
+                help_message(NULL);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    parse_arguments(argc, argv);
+
+    interned_keys = dhash_str_new(1024);
+
+    if (optind < argc)
+        read_trace(argv[optind]);
+    else
+        synthesize_trace();
+
+    fprintf(stdout, "%d operations over %d tables, best of %d runs\n",
+            trace_size, max_table + 1, repetitions);
+
+    run("dhash_ptr", replay_ptr);
+    run("dhash_str", replay_str);
+
+    return 0;
+}
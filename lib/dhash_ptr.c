@@ -31,17 +31,19 @@
 #include "dhash_ptr.h"
 #include "mem.h"
 
+// Open addressing with Robin Hood linear probing. Entries are kept inline in
+// a power of two table along with the hash of their key, so a probe rarely
+// has to look at the key itself and inserting does not allocate. An entry
+// with a NULL key is an empty slot.
 typedef
-struct bucket_ptr_tag
+struct entry_ptr_tag
 {
     const char* key;
     dhash_ptr_info_t info;
-    struct bucket_ptr_tag* next;
-} bucket_ptr_t;
+    uint32_t hash;
+} entry_ptr_t;
 
-enum { MAX_BUCKET_SIZE = 76003 };
-const static int prime_set[] = { 5, 11, 23, 53, 131, 317, 787, 1951, 4877, 12163, 30403, MAX_BUCKET_SIZE };
-const static int last_prime = (sizeof(prime_set) / sizeof(prime_set[0])) - 1;
+enum { MIN_CAPACITY = 8 };
 
 #ifdef __GNUC__
   #if __GNUC__ == 4
@@ -62,11 +64,24 @@ STATIC_INLINE uint32_t Murmur3_32(const char* ptr);
 
 struct dhash_ptr_tag
 {
-    bucket_ptr_t **buckets;
-    int num_buckets_idx;
-    int num_items;
+    entry_ptr_t *entries;
+    // Always a power of two
+    uint32_t capacity;
+    uint32_t num_items;
 };
 
+STATIC_INLINE char same_key(const entry_ptr_t* entry, uint32_t hash, const char* key)
+{
+    return entry->hash == hash
+        && entry->key == key;
+}
+
+// Distance between the slot of an entry and its preferred slot
+STATIC_INLINE uint32_t probe_distance(const dhash_ptr_t* dhash, uint32_t hash, uint32_t slot)
+{
+    return (slot - hash) & (dhash->capacity - 1);
+}
+
 dhash_ptr_t* dhash_ptr_new(int initial_size)
 {
     if (initial_size < 0) abort();
@@ -75,136 +90,106 @@ dhash_ptr_t* dhash_ptr_new(int initial_size)
 
     result->num_items = 0;
 
-    if (initial_size >= MAX_BUCKET_SIZE)
-    {
-        result->num_buckets_idx = last_prime;
-    }
-    else
+    // Round to next power of two
+    result->capacity = MIN_CAPACITY;
+    while (result->capacity < (uint32_t)initial_size)
     {
-        // Round to next prime
-        result->num_buckets_idx = 0;
-        while (prime_set[result->num_buckets_idx] < initial_size)
-        {
-            result->num_buckets_idx++;
-        }
+        result->capacity <<= 1;
     }
 
-    result->buckets = NEW_VEC0(bucket_ptr_t*, prime_set[result->num_buckets_idx]);
+    result->entries = NEW_VEC0(entry_ptr_t, result->capacity);
 
     return result;
 }
 
-static void free_bucket_list(bucket_ptr_t* bucket)
+void dhash_ptr_destroy(dhash_ptr_t* dhash)
 {
-    if (bucket == NULL)
-        return;
-
-    free_bucket_list(bucket->next);
-    xfree(bucket);
+    xfree(dhash->entries);
+    xfree(dhash);
 }
 
-void dhash_ptr_destroy(dhash_ptr_t* dhash)
+static entry_ptr_t* dhash_ptr_find(dhash_ptr_t* dhash, const char* key)
 {
-    int num_buckets = prime_set[dhash->num_buckets_idx];
+    uint32_t hash = Murmur3_32(key);
+    uint32_t mask = dhash->capacity - 1;
+    uint32_t slot = hash & mask;
+    uint32_t distance = 0;
 
-    int i;
-    for (i = 0; i < num_buckets; i++)
+    for (;;)
     {
-        free_bucket_list(dhash->buckets[i]);
+        entry_ptr_t* entry = &dhash->entries[slot];
+        // Either an empty slot or an entry that would have been displaced by
+        // the key if it were in the table
+        if (entry->key == NULL
+                || probe_distance(dhash, entry->hash, slot) < distance)
+            return NULL;
+
+        if (same_key(entry, hash, key))
+            return entry;
+
+        slot = (slot + 1) & mask;
+        distance++;
     }
-
-    xfree(dhash->buckets);
-    xfree(dhash);
 }
 
 void* dhash_ptr_query(dhash_ptr_t* dhash, const char* key)
 {
     if (key == NULL) abort();
 
-    int num_buckets = prime_set[dhash->num_buckets_idx];
-    uint32_t hash = Murmur3_32(key) % num_buckets;
+    entry_ptr_t* entry = dhash_ptr_find(dhash, key);
+    if (entry == NULL)
+        return NULL;
 
-    bucket_ptr_t* b = dhash->buckets[hash];
-    while (b != NULL)
-    {
-        if (b->key == key)
-        {
-            return b->info;
-        }
-        b = b->next;
-    }
-
-    return NULL;
+    return entry->info;
 }
 
-
-static void dhash_ptr_do_insert(dhash_ptr_t* dhash, const char* key, dhash_ptr_info_t info)
+// Places a key not present in the table
+static void dhash_ptr_place(dhash_ptr_t* dhash, entry_ptr_t new_entry)
 {
-    int num_buckets = prime_set[dhash->num_buckets_idx];
-    uint32_t hash = Murmur3_32(key) % num_buckets;
-
-    bucket_ptr_t* b = dhash->buckets[hash];
+    uint32_t mask = dhash->capacity - 1;
+    uint32_t slot = new_entry.hash & mask;
+    uint32_t distance = 0;
 
-    while (b != NULL)
+    for (;;)
     {
-        if (b->key == key)
+        entry_ptr_t* entry = &dhash->entries[slot];
+        if (entry->key == NULL)
         {
-            // Update
-            b->info = info;
+            *entry = new_entry;
             return;
         }
-        b = b->next;
-    }
 
-    // Insert
-    b = NEW(bucket_ptr_t);
-    b->key = key;
-    b->info = info;
-    b->next = dhash->buckets[hash];
-    dhash->buckets[hash] = b;
+        // Robin Hood: the entry closer to its preferred slot gives its place
+        uint32_t entry_distance = probe_distance(dhash, entry->hash, slot);
+        if (entry_distance < distance)
+        {
+            entry_ptr_t displaced = *entry;
+            *entry = new_entry;
+            new_entry = displaced;
+            distance = entry_distance;
+        }
 
-    dhash->num_items++;
+        slot = (slot + 1) & mask;
+        distance++;
+    }
 }
 
-static void dhash_ptr_increase_rehash(dhash_ptr_t* dhash)
+static void dhash_ptr_grow(dhash_ptr_t* dhash)
 {
-    // Do not rehash anymore
-    if (dhash->num_buckets_idx == last_prime)
-        return;
-
-    int num_old_buckets = prime_set[dhash->num_buckets_idx];
-    bucket_ptr_t **old_buckets = dhash->buckets;
+    uint32_t num_old_entries = dhash->capacity;
+    entry_ptr_t *old_entries = dhash->entries;
 
-    dhash->num_buckets_idx++;
-    int num_new_buckets = prime_set[dhash->num_buckets_idx];
-    bucket_ptr_t **new_buckets = NEW_VEC0(bucket_ptr_t*, num_new_buckets);
+    dhash->capacity <<= 1;
+    dhash->entries = NEW_VEC0(entry_ptr_t, dhash->capacity);
 
-    int i;
-    for (i = 0; i < num_old_buckets; i++)
+    uint32_t i;
+    for (i = 0; i < num_old_entries; i++)
     {
-        bucket_ptr_t* old_b = old_buckets[i];
-
-        while (old_b != NULL)
-        {
-            uint32_t new_hash = Murmur3_32(old_b->key) % num_new_buckets;
-
-            bucket_ptr_t* new_b = NEW(bucket_ptr_t);
-            new_b->key = old_b->key;
-            new_b->info = old_b->info;
-            new_b->next = new_buckets[new_hash];
-            new_buckets[new_hash] = new_b;
-
-            old_b = old_b->next;
-        }
-    }
-
-    for (i = 0; i < num_old_buckets; i++)
-    {
-        free_bucket_list(old_buckets[i]);
+        if (old_entries[i].key != NULL)
+            dhash_ptr_place(dhash, old_entries[i]);
     }
-    xfree(old_buckets);
 
-    dhash->buckets = new_buckets;
+    xfree(old_entries);
 }
 
 void dhash_ptr_insert(dhash_ptr_t* dhash, const char* key, dhash_ptr_info_t info)
@@ -212,52 +197,65 @@ void dhash_ptr_insert(dhash_ptr_t* dhash, const char* key, dhash_ptr_info_t info
     if (key == NULL) abort();
     if (info == NULL) abort();
 
-    int num_buckets = prime_set[dhash->num_buckets_idx];
-    if (((num_buckets * 3) / 4) < dhash->num_items)
+    entry_ptr_t* entry = dhash_ptr_find(dhash, key);
+    if (entry != NULL)
+    {
+        // Update
+        entry->info = info;
+        return;
+    }
+
+    // Keep the load factor at most 3/4
+    if ((dhash->num_items + 1) * 4 > dhash->capacity * 3)
     {
-        dhash_ptr_increase_rehash(dhash);
+        dhash_ptr_grow(dhash);
     }
 
-    dhash_ptr_do_insert(dhash, key, info);
+    entry_ptr_t new_entry = { key, info, Murmur3_32(key) };
+    dhash_ptr_place(dhash, new_entry);
+
+    dhash->num_items++;
 }
 
 void dhash_ptr_remove(dhash_ptr_t* dhash, const char* key)
 {
     if (key == NULL) abort();
 
-    int num_buckets = prime_set[dhash->num_buckets_idx];
-    uint32_t hash = Murmur3_32(key) % num_buckets;
-
-    bucket_ptr_t** b = &(dhash->buckets[hash]);
+    entry_ptr_t* entry = dhash_ptr_find(dhash, key);
+    if (entry == NULL)
+    {
+        // Not found
+        return;
+    }
 
-    while ((*b) != NULL)
+    // Shift back the entries that follow so no tombstone is needed
+    uint32_t mask = dhash->capacity - 1;
+    uint32_t slot = entry - dhash->entries;
+    for (;;)
     {
-        if ((*b)->key == key)
-        {
-            bucket_ptr_t* current = *b;
-            *b = (*b)->next;
-            xfree(current);
-            dhash->num_items--;
-            return;
-        }
-        b = &((*b)->next);
+        uint32_t next = (slot + 1) & mask;
+        entry_ptr_t* next_entry = &dhash->entries[next];
+        if (next_entry->key == NULL
+                || probe_distance(dhash, next_entry->hash, next) == 0)
+            break;
+
+        dhash->entries[slot] = *next_entry;
+        slot = next;
     }
+    memset(&dhash->entries[slot], 0, sizeof(dhash->entries[slot]));
 
-    // Not found
+    dhash->num_items--;
 }
 
 void dhash_ptr_walk(dhash_ptr_t* dhash, dhash_ptr_walk_fn walk_fn, void *walk_info)
 {
-    int num_buckets = prime_set[dhash->num_buckets_idx];
-
-    int i;
-    for (i = 0; i < num_buckets; i++)
+    uint32_t i;
+    for (i = 0; i < dhash->capacity; i++)
     {
-        bucket_ptr_t* b = dhash->buckets[i];
-        while (b != NULL)
+        entry_ptr_t* entry = &dhash->entries[i];
+        if (entry->key != NULL)
         {
-            walk_fn(b->key, b->info, walk_info);
-            b = b->next;
+            walk_fn(entry->key, entry->info, walk_info);
         }
     }
 }
@@ -295,7 +293,7 @@ STATIC_INLINE uint32_t Murmur3_32(const char* ptr)
 		hash = ((hash << r2) | (hash >> (32-r2)) * m) + n;
 	}
  
-	const uint8_t * tail = (const uint8_t*)(keydata + keydata_it*4);
+	const uint8_t * tail = (const uint8_t*)(keydata + keydata_it);
 	uint32_t k1 = 0;
  
 	switch(len & 3) {
@@ -38,6 +38,16 @@
 #undef realloc
 #undef strdup
 
+static size_t num_allocations = 0;
+static size_t num_allocated_bytes = 0;
+
+#define COUNT_ALLOCATION(_size) \
+    do { \
+        num_allocations++; \
+        num_allocated_bytes += (_size); \
+    } \
+    while (0)
+
 #define OUT_OF_MEM(_size) \
     do { \
         fprintf(stderr, "%s: allocation failure of %zd bytes\n", __FUNCTION__, (_size)); \
@@ -58,6 +68,7 @@ void *xmalloc(size_t size)
     }
     else
     {
+        COUNT_ALLOCATION(size);
         return ptr;
     }
 }
@@ -81,6 +92,7 @@ void *xcalloc(size_t nmemb, size_t size)
     }
     else
     {
+        COUNT_ALLOCATION(nmemb * size);
         return ptr;
     }
 }
@@ -101,6 +113,7 @@ void *xrealloc(void *ptr, size_t size)
         }
         else
         {
+            COUNT_ALLOCATION(size);
             return res;
         }
     }
@@ -115,9 +128,16 @@ char *xstrdup(const char *s)
         OUT_OF_MEM(strlen(s) + 1);
     }
 
+    COUNT_ALLOCATION(strlen(s) + 1);
     return result;
 }
 
+void xmem_get_counters(size_t *allocations, size_t *bytes)
+{
+    *allocations = num_allocations;
+    *bytes = num_allocated_bytes;
+}
+
 // This one is guaranteed to call free
 // DO NOT CHANGE IT
 void c_free(void *ptr)
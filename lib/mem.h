@@ -59,6 +59,10 @@ char *xstrdup(const char *s) MEM_WARN_UNUSED MEM_MALLOC_RETURN;
 // Guaranteed to call free
 void c_free(void *ptr);
 
+// Number of allocations done so far by the functions above and the number of
+// bytes they requested. They are only exact if a single thread allocates
+void xmem_get_counters(size_t *num_allocations, size_t *num_bytes);
+
 #ifdef __cplusplus
 }
 #endif
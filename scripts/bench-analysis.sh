@@ -0,0 +1,169 @@
+#!/usr/bin/env bash
+
+# Times the analyses over the tests of tests/07_phases_analysis.dg
+#
+#   scripts/bench-analysis.sh [-r repetitions] <builddir> [<baseline builddir>]
+#
+# Every test is compiled with the plaincxx of <builddir> as the analysis
+# test generator does (--analysis-check) but without running the native
+# compiler. The best wall time of the repetitions of the whole compiler
+# process is shown for every test. The process is timed from outside, so a
+# baseline build does not need to support any other flag. When a baseline
+# build is given, the same is done with it and the speedup is shown too.
+#
+# Extra flags for the compiler, e.g. include directories of Nanos++, can be
+# passed in MCXX_BENCH_FLAGS
+
+REPETITIONS=5
+
+usage()
+{
+    echo "Usage: $0 [-r repetitions] <builddir> [<baseline builddir>]" 1>&2
+    exit 1
+}
+
+while getopts "r:h" opt;
+do
+    case $opt in
+        r)
+            REPETITIONS=$OPTARG
+            ;;
+        *)
+            usage
+            ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+if [ $# -lt 1 -o $# -gt 2 ];
+then
+    usage
+fi
+
+SRCDIR=$(cd $(dirname $0)/.. && pwd)
+TESTDIR=${SRCDIR}/tests/07_phases_analysis.dg
+
+for builddir in "$@";
+do
+    if [ ! -x ${builddir}/src/driver/plaincxx ];
+    then
+        echo "error: ${builddir}/src/driver/plaincxx not found, build the compiler first" 1>&2
+        exit 1
+    fi
+done
+
+CURRENT=$(cd $1 && pwd)
+BASELINE=
+if [ -n "$2" ];
+then
+    BASELINE=$(cd $2 && pwd)
+fi
+
+WORKDIR=$(mktemp -d)
+trap "rm -rf ${WORKDIR}" EXIT
+
+# Prints the library path of a build, as tests/config/mercurium-libraries does
+library_path()
+{
+    local builddir=$1
+    local path=${LD_LIBRARY_PATH}
+    for dir in $(find -H ${builddir} -iname '*.la' \
+                 -not '(' -path '*/.libs/*' -or -path '*/_libs/*' ')' \
+                 -exec dirname {} \; | sort -u);
+    do
+        path=${dir}/.libs:${path}
+    done
+    echo ${path}
+}
+
+# Prints the best wall time of the compiler process for a test compiled with a build
+time_test()
+{
+    local builddir=$1
+    local test_file=$2
+
+    # Some analyses write files in the current directory
+    cd ${WORKDIR}
+
+    local profile=mcc
+    case ${test_file} in
+        *.cpp)
+            profile=mcxx
+            ;;
+    esac
+
+    LD_LIBRARY_PATH=$(library_path ${builddir}) \
+    python3 - ${REPETITIONS} ${WORKDIR}/log \
+        ${builddir}/src/driver/plaincxx \
+        --profile=${profile} \
+        --config-dir=${builddir}/config \
+        --output-dir=${WORKDIR} \
+        --analysis-check --openmp -y \
+        ${MCXX_BENCH_FLAGS} \
+        -o ${WORKDIR}/out ${test_file} <<'EOF'
+import subprocess, sys, time
+repetitions, log, command = int(sys.argv[1]), sys.argv[2], sys.argv[3:]
+best = None
+for i in range(repetitions):
+    start = time.perf_counter()
+    with open(log, "w") as output:
+        status = subprocess.call(command, stdout=output, stderr=subprocess.STDOUT)
+    seconds = time.perf_counter() - start
+    if status != 0:
+        print("failed")
+        sys.exit(0)
+    if best is None or seconds < best:
+        best = seconds
+print("%.4f" % best)
+EOF
+}
+
+total=0
+total_baseline=0
+if [ -n "${BASELINE}" ];
+then
+    printf "%-28s %12s %12s %8s\n" "test" "baseline (s)" "current (s)" "speedup"
+else
+    printf "%-28s %12s\n" "test" "current (s)"
+fi
+
+for test_file in $(find ${TESTDIR} -name "*.c" -o -name "*.cpp" | sort);
+do
+    # Tests ignored by the testsuite are ignored here too
+    if grep -q 'test_ignore="yes"' ${test_file};
+    then
+        continue
+    fi
+
+    name=${test_file#${TESTDIR}/}
+    current=$(time_test ${CURRENT} ${test_file})
+    if [ "${current}" = "failed" ];
+    then
+        printf "%-28s %12s\n" ${name} "failed"
+        continue
+    fi
+    total=$(python3 -c "print('%.4f' % (${total} + ${current}))")
+
+    if [ -n "${BASELINE}" ];
+    then
+        baseline=$(time_test ${BASELINE} ${test_file})
+        if [ "${baseline}" = "failed" ];
+        then
+            printf "%-28s %12s %12s\n" ${name} "failed" ${current}
+            continue
+        fi
+        total_baseline=$(python3 -c "print('%.4f' % (${total_baseline} + ${baseline}))")
+        printf "%-28s %12s %12s %7sx\n" ${name} ${baseline} ${current} \
+            $(python3 -c "print('%.2f' % (${baseline} / max(${current}, 1e-6)))")
+    else
+        printf "%-28s %12s\n" ${name} ${current}
+    fi
+done
+
+if [ -n "${BASELINE}" ];
+then
+    printf "%-28s %12s %12s %7sx\n" "total" ${total_baseline} ${total} \
+        $(python3 -c "print('%.2f' % (${total_baseline} / max(${total}, 1e-6)))")
+else
+    printf "%-28s %12s\n" "total" ${total}
+fi
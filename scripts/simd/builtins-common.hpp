@@ -812,4 +812,21 @@ void f(const std::string& str)
         ;
 }
 
+// Like f but the builtin is signed in lazily, see cxx-lazybuiltins.h
+template <typename T>
+void f_lazy(const std::string& str)
+{
+    std::cout
+        << "BUILTIN_FUNCTION(" << str << ", " << generate_type<T>::g() << "\n"
+        << ")\n"
+        ;
+}
+
+static inline void f_lazy_alias(const std::string& newname, const std::string& existing)
+{
+    std::cout
+        << "BUILTIN_ALIAS(" << newname << ", " << existing << ")\n"
+        ;
+}
+
 #endif // BUILTINS_COMMON_HPP
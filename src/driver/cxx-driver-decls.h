@@ -298,6 +298,20 @@ typedef struct compilation_process_tag
 
     // Flags
     char parallel_process; // enables features allowing parallel compilation
+
+    // Number of translation units compiled concurrently (-j)
+    int num_jobs;
+
+    // Number of native compilations run in the background (--native-jobs)
+    int num_native_jobs;
+
+    // Values of calls to constexpr functions kept per translation unit
+    // (--constexpr-cache-size)
+    int constexpr_cache_size;
+
+    // Calls to constexpr functions evaluated in a constant expression before
+    // giving up (--constexpr-steps)
+    int constexpr_steps;
 } compilation_process_t;
 
 typedef struct compilation_configuration_conditional_flags
@@ -415,6 +429,8 @@ typedef struct compilation_configuration_tag
     const char* preprocessor_name;
     const char** preprocessor_options;
     char preprocessor_uses_stdout;
+    // The preprocessed file is kept in memory instead of in a temporary file
+    char preprocess_in_memory;
 
     // Fortran preprocessor
     const char* fortran_preprocessor_name;
@@ -446,6 +462,12 @@ typedef struct compilation_configuration_tag
     // Directory where we unwrap the native modules
     const char* module_native_dir;
 
+    // C only: global scope snapshot written after the semantic analysis
+    const char* global_snapshot_out;
+    // C only: global scope snapshot that replaces the common prefix of
+    // the preprocessed file
+    const char* global_snapshot;
+
     // Directory where we hold module locks
     const char* lock_dir;
     char disable_locking;
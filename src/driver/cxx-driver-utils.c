@@ -30,12 +30,17 @@
 #ifdef HAVE_CONFIG_H
   #include <config.h>
 #endif
+#if defined(__linux__)
+  // Needed, otherwise memfd_create is not declared
+  #define _GNU_SOURCE
+#endif
 
 #include <unistd.h>
 #include <string.h>
 #include <errno.h>
 #if !defined(WIN32_BUILD) || defined(__CYGWIN__)
   #include <sys/wait.h>
+  #include <sys/mman.h>
   #include <libgen.h>
   #include <limits.h>
 #else
@@ -76,6 +81,13 @@ void temporal_files_cleanup(void)
         {
             // Skip this file
         }
+        else if (iter->info->is_memory)
+        {
+            if (iter->info->fd >= 0)
+            {
+                close(iter->info->fd);
+            }
+        }
         else
         {
             if (!iter->info->is_dir)
@@ -123,6 +135,21 @@ void temporal_files_cleanup(void)
     temporal_file_list = NULL;
 }
 
+void temporal_files_forget(void)
+{
+    temporal_file_list_t iter = temporal_file_list;
+
+    while (iter != NULL)
+    {
+        temporal_file_list_t prev = iter;
+        iter = iter->next;
+        DELETE(prev->info);
+        DELETE(prev);
+    }
+
+    temporal_file_list = NULL;
+}
+
 static char name_is_in_temporal_files(const char* name)
 {
     temporal_file_list_t it = temporal_file_list;
@@ -280,6 +307,48 @@ static temporal_file_t new_temporal_file_win32(void)
 }
 #endif
 
+temporal_file_t new_temporal_memory_file(void)
+{
+#if defined(MFD_CLOEXEC)
+    // Programs run by the driver inherit this descriptor, so they can open
+    // the file using /proc/self/fd
+    int fd = memfd_create(compilation_process.exec_basename, 0);
+    if (fd < 0)
+        return NULL;
+
+    char c[64];
+    snprintf(c, 63, "/proc/self/fd/%d", fd);
+    c[63] = '\0';
+
+    temporal_file_t result = add_to_list_of_temporal_files(c, /* is_temporary */ 1, /* is_dir */ 0);
+    result->is_memory = 1;
+    result->fd = fd;
+
+    return result;
+#else
+    return NULL;
+#endif
+}
+
+void temporal_memory_file_release(const char* name)
+{
+    temporal_file_list_t it = temporal_file_list;
+
+    while (it != NULL)
+    {
+        // Descriptors are reused so only open memory files are considered
+        if (it->info->is_memory
+                && it->info->fd >= 0
+                && strcmp(it->info->name, name) == 0)
+        {
+            close(it->info->fd);
+            it->info->fd = -1;
+            return;
+        }
+        it = it->next;
+    }
+}
+
 temporal_file_t new_temporal_dir(void)
 {
 #if !defined(WIN32_BUILD) || defined(__CYGWIN__)
@@ -345,11 +414,8 @@ int execute_program(const char* program_name, const char** arguments)
 }
 
 #if !defined(WIN32_BUILD) || defined(__CYGWIN__)
-static int execute_program_flags_unix(const char* program_name, const char** arguments, const char* stdout_f, const char* stderr_f)
+static pid_t spawn_program_flags_unix(const char* program_name, const char** arguments, const char* stdout_f, const char* stderr_f)
 {
-    if (program_name == NULL)
-        program_name = "";
-
     int num = count_null_ended_array((void**)arguments);
 
     const char** execvp_arguments = NEW_VEC0(const char*, num + 1 + 1);
@@ -449,30 +515,53 @@ static int execute_program_flags_unix(const char* program_name, const char** arg
         // Execvp should not return
         fatal_error("error: execution of subprocess '%s' failed (%s)", program_name, strerror(errno));
     }
-    else // I'm the parent
+
+    DELETE(execvp_arguments);
+
+    return spawned_process;
+}
+
+static int exit_status_unix(int status, const char* program_name)
+{
+    if (WIFEXITED(status))
+    {
+        return (WEXITSTATUS(status));
+    }
+    else if (WIFSIGNALED(status))
     {
-        // Wait for my son
-        int status;
-        wait(&status);
-        if (WIFEXITED(status))
-        {
-            return (WEXITSTATUS(status));
-        }
-        else if (WIFSIGNALED(status))
-        {
-            fprintf(stderr, "Subprocess '%s' was ended with signal %d\n",
-                    program_name, WTERMSIG(status));
+        fprintf(stderr, "Subprocess '%s' was ended with signal %d\n",
+                program_name, WTERMSIG(status));
 
-            return 1;
-        }
-        else
-        {
-            internal_error(
-                    "Subprocess '%s' ended but neither by normal exit nor signal", 
-                    program_name);
-        }
+        return 1;
+    }
+    else
+    {
+        internal_error(
+                "Subprocess '%s' ended but neither by normal exit nor signal", 
+                program_name);
     }
 }
+
+static int wait_program_unix(pid_t spawned_process, const char* program_name)
+{
+    // Wait for my son
+    int status;
+    if (waitpid(spawned_process, &status, 0) < 0)
+    {
+        fatal_error("error: could not wait for subprocess '%s' (%s)", program_name, strerror(errno));
+    }
+    return exit_status_unix(status, program_name);
+}
+
+static int execute_program_flags_unix(const char* program_name, const char** arguments, const char* stdout_f, const char* stderr_f)
+{
+    if (program_name == NULL)
+        program_name = "";
+
+    pid_t spawned_process = spawn_program_flags_unix(program_name, arguments, stdout_f, stderr_f);
+
+    return wait_program_unix(spawned_process, program_name);
+}
 #else
 
 static char* quote_string(const char *c)
@@ -633,6 +722,42 @@ int execute_program_flags(const char* program_name, const char** arguments, cons
 #endif
 }
 
+#if !defined(WIN32_BUILD) || defined(__CYGWIN__)
+int execute_program_flags_async(const char* program_name, const char** arguments, const char* stdout_f, const char* stderr_f)
+{
+    if (program_name == NULL)
+        program_name = "";
+
+    return spawn_program_flags_unix(program_name, arguments, stdout_f, stderr_f);
+}
+
+int wait_program(int handle, const char* program_name)
+{
+    if (program_name == NULL)
+        program_name = "";
+
+    return wait_program_unix((pid_t)handle, program_name);
+}
+
+char poll_program(int handle, const char* program_name, int* exit_status)
+{
+    if (program_name == NULL)
+        program_name = "";
+
+    int status;
+    pid_t result = waitpid((pid_t)handle, &status, WNOHANG);
+    if (result < 0)
+    {
+        fatal_error("error: could not wait for subprocess '%s' (%s)", program_name, strerror(errno));
+    }
+    if (result == 0)
+        return 0;
+
+    *exit_status = exit_status_unix(status, program_name);
+    return 1;
+}
+#endif
+
 int count_null_ended_array(void** v)
 {
     int result = 0;
@@ -59,6 +59,9 @@ typedef struct
     const char* name;
     char is_dir;
     char is_temporary;
+    // Memory files are only reachable through their name while fd is open
+    char is_memory;
+    int fd;
 } temporal_file_value_t, *temporal_file_t;
 
 // Gives you a new temporal file that will be removed when
@@ -70,17 +73,42 @@ temporal_file_t new_temporal_dir(void);
 
 temporal_file_t new_temporal_file_extension(const char* extension);
 
+// Gives you a new temporal file that lives in memory. Its name can be used
+// as the name of any other file, also by other programs run by the driver,
+// until the file is released. Returns NULL if the system does not support
+// memory files
+temporal_file_t new_temporal_memory_file(void);
+
+// Releases the memory of the memory file with this name. Does nothing if
+// there is no such memory file
+void temporal_memory_file_release(const char* name);
+
 // Routine that does the cleanup. Can be atexit-registered
 // or used discretionally inside the program. Every temporal
 // file is closed and erased.
 void temporal_files_cleanup(void);
 
+// Forgets every temporal file registered so far without removing it. Used by
+// worker processes so they do not remove the files owned by their parent
+void temporal_files_forget(void);
+
 const char* get_extension_filename(const char* filename);
 
 int execute_program(const char* program_name, const char** arguments);
 int execute_program_flags(const char* program_name, const char** arguments, 
         const char *stdout_f, const char *stderr_f);
 
+#if !defined(WIN32_BUILD) || defined(__CYGWIN__)
+// Like execute_program_flags but it does not wait for the program to end.
+// The returned handle must be passed to wait_program, which returns the exit
+// status of the program, unless poll_program already found it ended
+int execute_program_flags_async(const char* program_name, const char** arguments,
+        const char *stdout_f, const char *stderr_f);
+int wait_program(int handle, const char* program_name);
+// Returns nonzero, and the exit status of the program, if it has ended
+char poll_program(int handle, const char* program_name, int* exit_status);
+#endif
+
 // char** routines
 int count_null_ended_array(void** v);
 void remove_string_from_null_ended_string_array(const char** string_arr, const char* to_remove);
@@ -36,6 +36,7 @@
 #endif
 
 #include <stdlib.h>
+#include <limits.h>
 #include <stdio.h>
 #include <string.h>
 #include <libgen.h>
@@ -52,6 +53,9 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#if !defined(WIN32_BUILD) || defined(__CYGWIN__)
+#include <sys/wait.h>
+#endif
 #include <dirent.h>
 #include <regex.h>
 
@@ -59,11 +63,14 @@
 #include "cxx-driver.h"
 #include "cxx-driver-utils.h"
 #include "cxx-ast.h"
+#include "cxx-ast-arena.h"
+#include "cxx-instantiation.h"
 #include "cxx-ambiguity.h"
 #include "cxx-graphviz.h"
 #include "cxx-html.h"
 #include "cxx-prettyprint.h"
 #include "cxx-scope.h"
+#include "cxx-entrylist.h"
 #include "cxx-buildscope.h"
 #include "cxx-typeenviron.h"
 #include "cxx-lexer.h"
@@ -71,6 +78,7 @@
 #include "cxx-printscope.h"
 #include "cxx-exprtype.h"
 #include "cxx-typededuc.h"
+#include "cxx-type-trie.h"
 #include "cxx-overload.h"
 #include "cxx-lexer.h"
 #include "cxx-parser.h"
@@ -87,6 +95,7 @@
 #include "cxx-compilerphases.hpp"
 #include "cxx-codegen.h"
 #include "cxx-target-tools.h"
+#include "cxx-phaseprofile.h"
 
 #include "filename.h"
 
@@ -99,6 +108,7 @@
 #include "fortran03-typeenviron.h"
 #include "fortran03-mangling.h"
 #include "cxx-driver-fortran.h"
+#include "fortran03-modules.h"
 #include "cxx-driver-build-info.h"
 
 /* ------------------------------------------------------------------ */
@@ -127,6 +137,10 @@
 "  -k, --keep-files         Do not remove intermediate files\n" \
 "  -K, --keep-all-files     Do not remove any generated file, including\n" \
 "                           temporary files\n" \
+"  -j N, --jobs=N           Compile up to N translation units\n" \
+"                           concurrently. Diagnostics are still\n" \
+"                           reported in input order. Fortran files\n" \
+"                           are always compiled sequentially\n" \
 "  -J <dir>                 Sets <dir> as the output module directory\n" \
 "                           This flag is only meaningful for Fortran\n" \
 "                           See flag --module-out-pattern flag\n" \
@@ -218,6 +232,9 @@
 "                           C/C++: .i, .ii\n"\
 "                           Fortran: .f, .f77, .f90, .f95\n"\
 "  --pp-stdout              Preprocessor uses stdout for output\n" \
+"  --pp-in-memory           Keep the preprocessed file in memory\n" \
+"                           instead of in a temporary file.\n" \
+"                           Ignored with -K\n" \
 "  --fpp                    An alias for --pp=on\n"\
 "  --fpp=<name>             Preprocessor <name> will be used for\n" \
 "                           preprocessing Fortran source\n" \
@@ -318,6 +335,31 @@
 "                           explicitly pass the right flag though\n" \
 "                           '--W<flags>,<options>'\n" \
 "  --Xcompiler OPTION       Equivalent to --Wn,OPTION\n" \
+"  --native-jobs=N          Run up to N native compilations in the\n" \
+"                           background while the driver processes\n" \
+"                           the next files. Failures are still\n" \
+"                           reported in input order. 0 (default)\n" \
+"                           waits for every native compilation\n" \
+"  --constexpr-cache-size=N C++ only. Remember the values of up to N\n" \
+"                           calls to constexpr functions per file.\n" \
+"                           0 disables it. Default is 65536\n" \
+"  --constexpr-steps=N      C++ only. Give up the evaluation of a\n" \
+"                           constant expression after N calls to\n" \
+"                           constexpr functions. 0 means no limit.\n" \
+"                           Default is 1048576\n" \
+"  --global-snapshot-out=<file>\n" \
+"                           C only. Writes the symbols declared in\n" \
+"                           the global scope of the file to <file>.\n" \
+"                           Use it with a file that only includes\n" \
+"                           headers\n" \
+"  --global-snapshot=<file> C only. When the preprocessed file starts\n" \
+"                           with the same code used to create <file>,\n" \
+"                           load the symbols from <file> instead of\n" \
+"                           parsing that code again. Function\n" \
+"                           definitions in <file> are still parsed\n" \
+"  --phase-profile=<file>   Appends to <file> one line of JSON per\n" \
+"                           file with the wall time, CPU time, peak\n" \
+"                           RSS and allocations of every phase\n" \
 "\n" \
 "Compatibility parameters:\n" \
 "\n" \
@@ -383,6 +425,8 @@ typedef enum
     OPTION_ALWAYS_PREPROCESS,
     OPTION_NATIVE_VENDOR,
     OPTION_CONFIG_DIR,
+    OPTION_CONSTEXPR_CACHE_SIZE,
+    OPTION_CONSTEXPR_STEPS,
     OPTION_CUDA,
     OPTION_DEBUG_FLAG,
     OPTION_DISABLE_FILE_LOCKING,
@@ -414,6 +458,8 @@ typedef enum
     OPTION_FORTRAN_PREPROCESSOR,
     OPTION_FORTRAN_PRESCANNER,
     OPTION_FORTRAN_REAL_KIND,
+    OPTION_GLOBAL_SNAPSHOT,
+    OPTION_GLOBAL_SNAPSHOT_OUT,
     OPTION_HELP_DEBUG_FLAGS,
     OPTION_HELP_TARGET_OPTIONS,
     OPTION_INSTANTIATE_TEMPLATES,
@@ -426,6 +472,7 @@ typedef enum
     OPTION_LIST_VECTOR_FLAVORS,
     OPTION_MODULE_OUT_PATTERN,
     OPTION_NATIVE_COMPILER_NAME,
+    OPTION_NATIVE_JOBS,
     OPTION_NO_CUDA,
     OPTION_NO_OPENCL,
     OPTION_NO_WHOLE_FILE,
@@ -434,8 +481,10 @@ typedef enum
     OPTION_OUTPUT_DIRECTORY,
     OPTION_PARALLEL,
     OPTION_PASS_THROUGH,
+    OPTION_PHASE_PROFILE,
     OPTION_PREPROCESSOR_NAME,
     OPTION_PREPROCESSOR_USES_STDOUT,
+    OPTION_PREPROCESS_IN_MEMORY,
     OPTION_PRINT_CONFIG_DIR,
     OPTION_PROFILE,
     OPTION_SEARCH_INCLUDES,
@@ -450,7 +499,7 @@ typedef enum
 
 
 // It mimics getopt
-#define SHORT_OPTIONS_STRING "vVkKcho:EyI:J:L:l:gD:U:x:"
+#define SHORT_OPTIONS_STRING "vVkKcho:EyI:J:L:l:gD:U:x:j:"
 // This one mimics getopt_long but with one less field (the third one is not given)
 struct command_line_long_options command_line_long_options[] =
 {
@@ -461,6 +510,7 @@ struct command_line_long_options command_line_long_options[] =
     {"keep-files",  CLP_NO_ARGUMENT, 'k'},
     {"keep-all-files", CLP_NO_ARGUMENT, 'K'},
     {"output",      CLP_REQUIRED_ARGUMENT, 'o'},
+    {"jobs",        CLP_REQUIRED_ARGUMENT, 'j'},
 
     // This option has a chicken-and-egg problem. If we delay till getopt_long
     // to open the configuration file we overwrite variables defined in the
@@ -480,6 +530,7 @@ struct command_line_long_options command_line_long_options[] =
     {"help-target-options", CLP_NO_ARGUMENT, OPTION_HELP_TARGET_OPTIONS},
     {"variable", CLP_REQUIRED_ARGUMENT, OPTION_EXTERNAL_VAR},
     {"pp-stdout", CLP_NO_ARGUMENT, OPTION_PREPROCESSOR_USES_STDOUT},
+    {"pp-in-memory", CLP_NO_ARGUMENT, OPTION_PREPROCESS_IN_MEMORY},
     {"disable-gxx-traits", CLP_NO_ARGUMENT, OPTION_DISABLE_GXX_TRAITS},
     {"pass-through", CLP_NO_ARGUMENT, OPTION_PASS_THROUGH}, 
     {"disable-sizeof", CLP_NO_ARGUMENT, OPTION_DISABLE_SIZEOF},
@@ -535,6 +586,12 @@ struct command_line_long_options command_line_long_options[] =
     {"Xcompiler", CLP_REQUIRED_ARGUMENT, OPTION_XCOMPILER },
     {"iso-c-FloatN", CLP_NO_ARGUMENT, OPTION_ISO_C_FLOATN },
     {"native-vendor", CLP_REQUIRED_ARGUMENT, OPTION_NATIVE_VENDOR },
+    {"native-jobs", CLP_REQUIRED_ARGUMENT, OPTION_NATIVE_JOBS },
+    {"constexpr-cache-size", CLP_REQUIRED_ARGUMENT, OPTION_CONSTEXPR_CACHE_SIZE },
+    {"constexpr-steps", CLP_REQUIRED_ARGUMENT, OPTION_CONSTEXPR_STEPS },
+    {"global-snapshot", CLP_REQUIRED_ARGUMENT, OPTION_GLOBAL_SNAPSHOT },
+    {"global-snapshot-out", CLP_REQUIRED_ARGUMENT, OPTION_GLOBAL_SNAPSHOT_OUT },
+    {"phase-profile", CLP_REQUIRED_ARGUMENT, OPTION_PHASE_PROFILE },
     // sentinel
     {NULL, 0, 0}
 };
@@ -579,6 +636,8 @@ static void semantic_analysis(translation_unit_t* translation_unit, const char*
 static const char* codegen_translation_unit(translation_unit_t* translation_unit, const char* parsed_filename);
 static void native_compilation(translation_unit_t* translation_unit, 
         const char* prettyprinted_filename, char remove_input);
+static void wait_pending_native_compilations(void);
+static void report_finished_native_compilations_if_any(void);
 
 #if !defined(WIN32_BUILD) || defined(__CYGWIN__)
 static void terminating_signal_handler(int sig);
@@ -586,6 +645,7 @@ static void terminating_signal_handler(int sig);
 static char check_tree(AST a);
 
 static void embed_files(void);
+static void embed_files_of_file_process(compilation_file_process_t* file_process);
 static void link_objects(void);
 
 static void add_to_parameter_list_str(const char*** existing_options, const char* str);
@@ -794,6 +854,9 @@ static void driver_initialization(int argc, const char* argv[])
 
     compilation_process.exec_basename = give_basename(argv[0]);
 
+    compilation_process.constexpr_cache_size = MCXX_DEFAULT_CONSTEXPR_CACHE_SIZE;
+    compilation_process.constexpr_steps = MCXX_DEFAULT_CONSTEXPR_STEPS;
+
     // Find my own directory
     compilation_process.home_directory = find_home(argv[0]);
 }
@@ -1127,6 +1190,22 @@ int parse_arguments(int argc, const char* argv[],
                         CURRENT_CONFIGURATION->keep_temporaries = 1;
                         break;
                     }
+                case 'j' : // --jobs || -j
+                    {
+                        char *endptr = NULL;
+                        long num_jobs = strtol(parameter_info.argument, &endptr, 10);
+                        if (endptr == parameter_info.argument
+                                || *endptr != '\0'
+                                || num_jobs < 1)
+                        {
+                            fprintf(stderr, "%s: invalid number of jobs '%s'\n",
+                                    compilation_process.exec_basename,
+                                    parameter_info.argument);
+                            return 1;
+                        }
+                        compilation_process.num_jobs = (int)num_jobs;
+                        break;
+                    }
                 case 'c' : // -c
                     {
                         if (y_specified || E_specified)
@@ -1318,6 +1397,45 @@ int parse_arguments(int argc, const char* argv[],
                         CURRENT_CONFIGURATION->native_compiler_name = uniquestr(parameter_info.argument);
                         break;
                     }
+                case OPTION_NATIVE_JOBS :
+                    {
+                        char *endptr = NULL;
+                        long num_native_jobs = strtol(parameter_info.argument, &endptr, 10);
+                        if (endptr == parameter_info.argument
+                                || *endptr != '\0'
+                                || num_native_jobs < 0)
+                        {
+                            fprintf(stderr, "%s: invalid number of native jobs '%s'\n",
+                                    compilation_process.exec_basename,
+                                    parameter_info.argument);
+                            return 1;
+                        }
+                        compilation_process.num_native_jobs = (int)num_native_jobs;
+                        break;
+                    }
+                case OPTION_CONSTEXPR_CACHE_SIZE :
+                case OPTION_CONSTEXPR_STEPS :
+                    {
+                        char *endptr = NULL;
+                        long value = strtol(parameter_info.argument, &endptr, 10);
+                        if (endptr == parameter_info.argument
+                                || *endptr != '\0'
+                                || value < 0
+                                || value > INT_MAX)
+                        {
+                            fprintf(stderr, "%s: invalid value '%s' for option '--%s'\n",
+                                    compilation_process.exec_basename,
+                                    parameter_info.argument,
+                                    parameter_info.value == OPTION_CONSTEXPR_STEPS
+                                    ? "constexpr-steps" : "constexpr-cache-size");
+                            return 1;
+                        }
+                        if (parameter_info.value == OPTION_CONSTEXPR_STEPS)
+                            compilation_process.constexpr_steps = (int)value;
+                        else
+                            compilation_process.constexpr_cache_size = (int)value;
+                        break;
+                    }
                 case OPTION_LINKER_NAME :
                     {
                         CURRENT_CONFIGURATION->linker_name = uniquestr(parameter_info.argument);
@@ -1379,6 +1497,11 @@ int parse_arguments(int argc, const char* argv[],
                         CURRENT_CONFIGURATION->preprocessor_uses_stdout = 1;
                         break;
                     }
+                case OPTION_PREPROCESS_IN_MEMORY :
+                    {
+                        CURRENT_CONFIGURATION->preprocess_in_memory = 1;
+                        break;
+                    }
                 case OPTION_DISABLE_GXX_TRAITS:
                     {
                         CURRENT_CONFIGURATION->disable_gxx_type_traits = 1;
@@ -1692,6 +1815,21 @@ int parse_arguments(int argc, const char* argv[],
                                 1);
                         break;
                     }
+                case OPTION_GLOBAL_SNAPSHOT:
+                    {
+                        CURRENT_CONFIGURATION->global_snapshot = uniquestr(parameter_info.argument);
+                        break;
+                    }
+                case OPTION_GLOBAL_SNAPSHOT_OUT:
+                    {
+                        CURRENT_CONFIGURATION->global_snapshot_out = uniquestr(parameter_info.argument);
+                        break;
+                    }
+                case OPTION_PHASE_PROFILE:
+                    {
+                        phase_profile_set_output(parameter_info.argument);
+                        break;
+                    }
                 case OPTION_ISO_C_FLOATN:
                     {
                         fprintf(stderr, "%s: option --iso-c-FloatN has been deprecated and it has no effect\n",
@@ -3123,6 +3261,190 @@ static void register_upc_pragmae(compilation_configuration_t* configuration)
     register_new_directive(configuration, "distributed", "", /* is_construct */ 0, /* bound_to_single_stmt */ 0);
 }
 
+// Global scope snapshots. The preprocessed code is compared ignoring line
+// markers and blank lines, so including the same headers from a different
+// file gives the same prefix
+static char is_line_marker(const char* line)
+{
+    while (*line == ' ' || *line == '\t')
+        line++;
+    if (*line != '#')
+        return 0;
+    line++;
+    while (*line == ' ' || *line == '\t')
+        line++;
+    return (('0' <= *line && *line <= '9')
+            || strncmp(line, "line", strlen("line")) == 0);
+}
+
+static char is_blank_line(const char* line)
+{
+    while (*line == ' ' || *line == '\t' || *line == '\n' || *line == '\r')
+        line++;
+    return *line == '\0';
+}
+
+// Hashes up to max_lines lines of code (FNV-1a) and returns the number of
+// lines of code read
+static int hash_preprocessed_prefix(FILE* f, int max_lines, unsigned long long *hash)
+{
+    unsigned long long h = 14695981039346656037ULL;
+    int num_lines = 0;
+
+    char* line = NULL;
+    size_t line_size = 0;
+    ssize_t length;
+    while (num_lines < max_lines
+            && (length = getline(&line, &line_size, f)) != -1)
+    {
+        if (is_blank_line(line)
+                || is_line_marker(line))
+            continue;
+
+        ssize_t i;
+        for (i = 0; i < length; i++)
+        {
+            h ^= (unsigned char)line[i];
+            h *= 1099511628211ULL;
+        }
+        num_lines++;
+    }
+    free(line);
+
+    *hash = h;
+    return num_lines;
+}
+
+static void gather_preexisting_symbols(scope_entry_list_t* entry_list, void *data)
+{
+    dhash_ptr_t* preexisting_symbols = (dhash_ptr_t*)data;
+
+    scope_entry_list_iterator_t* it = NULL;
+    for (it = entry_list_iterator_begin(entry_list);
+            !entry_list_iterator_end(it);
+            entry_list_iterator_next(it))
+    {
+        scope_entry_t* entry = entry_list_iterator_current(it);
+        dhash_ptr_insert(preexisting_symbols, (const char*)entry, entry);
+    }
+    entry_list_iterator_free(it);
+}
+
+static void write_global_scope_snapshot(translation_unit_t* translation_unit,
+        const char* parsed_filename,
+        dhash_ptr_t* preexisting_symbols)
+{
+    FILE* f = fopen(parsed_filename, "r");
+    if (f == NULL)
+    {
+        fatal_error("Could not open file '%s' (%s)", parsed_filename, strerror(errno));
+    }
+
+    unsigned long long prefix_hash = 0;
+    int prefix_num_lines = hash_preprocessed_prefix(f, INT_MAX, &prefix_hash);
+    fclose(f);
+
+    dump_global_scope_snapshot(CURRENT_CONFIGURATION->global_snapshot_out,
+            translation_unit->global_decl_context,
+            preexisting_symbols,
+            nodecl_get_child(translation_unit->nodecl, 0),
+            prefix_hash,
+            prefix_num_lines);
+}
+
+// Returns the file that has to be scanned: parsed_filename if the snapshot
+// cannot be used or a file with the code not covered by the snapshot
+static const char* use_global_scope_snapshot(translation_unit_t* translation_unit,
+        const char* parsed_filename,
+        nodecl_t* nodecl_snapshot_decls)
+{
+    const char* snapshot = CURRENT_CONFIGURATION->global_snapshot;
+
+    unsigned long long expected_hash = 0;
+    int expected_num_lines = 0;
+    if (!global_scope_snapshot_get_prefix(snapshot, &expected_hash, &expected_num_lines))
+    {
+        fprintf(stderr, "warning: ignoring global scope snapshot '%s' because it does not exist "
+                "or was created by a different build or type environment\n",
+                snapshot);
+        return parsed_filename;
+    }
+
+    FILE* f = fopen(parsed_filename, "r");
+    if (f == NULL)
+    {
+        fatal_error("Could not open file '%s' (%s)", parsed_filename, strerror(errno));
+    }
+
+    unsigned long long hash = 0;
+    int num_lines = hash_preprocessed_prefix(f, expected_num_lines, &hash);
+    long prefix_end = ftell(f);
+
+    // The remaining code must start with a line marker, otherwise
+    // its loci would be wrong
+    char prefix_matches = (num_lines == expected_num_lines
+            && hash == expected_hash);
+    if (prefix_matches)
+    {
+        char* line = NULL;
+        size_t line_size = 0;
+        while (getline(&line, &line_size, f) != -1
+                && is_blank_line(line))
+        {
+        }
+        prefix_matches = feof(f) || is_line_marker(line);
+        free(line);
+    }
+
+    if (!prefix_matches)
+    {
+        if (CURRENT_CONFIGURATION->verbose)
+        {
+            fprintf(stderr, "File '%s' does not start with the code of global scope snapshot '%s'\n",
+                    translation_unit->input_filename,
+                    snapshot);
+        }
+        fclose(f);
+        return parsed_filename;
+    }
+
+    const char* definitions = NULL;
+    if (!load_global_scope_snapshot(snapshot,
+                translation_unit->global_decl_context,
+                nodecl_snapshot_decls,
+                &definitions))
+    {
+        fprintf(stderr, "warning: ignoring global scope snapshot '%s' because it refers to "
+                "builtins that are not available\n",
+                snapshot);
+        fclose(f);
+        return parsed_filename;
+    }
+
+    temporal_file_t remainder = new_temporal_file();
+    FILE* out = fopen(remainder->name, "w");
+    if (out == NULL)
+    {
+        fatal_error("Could not create temporary file '%s' (%s)", remainder->name, strerror(errno));
+    }
+
+    // The functions defined in the snapshot are parsed again before the
+    // remaining code, which starts with a line marker
+    fputs(definitions, out);
+
+    fseek(f, prefix_end, SEEK_SET);
+    char buffer[BUFSIZ];
+    size_t bytes;
+    while ((bytes = fread(buffer, 1, sizeof(buffer), f)) > 0)
+    {
+        fwrite(buffer, 1, bytes, out);
+    }
+    fclose(out);
+    fclose(f);
+
+    return remainder->name;
+}
+
 static void compile_every_translation_unit_aux_(int num_translation_units,
         compilation_file_process_t** translation_units)
 {
@@ -3175,6 +3497,11 @@ static void compile_every_translation_unit_aux_(int num_translation_units,
             continue;
         }
 
+        // Do not start this one if an earlier native compilation has failed
+        report_finished_native_compilations_if_any();
+
+        phase_profile_begin_translation_unit(translation_unit->input_filename);
+
         char file_not_processed = BITMAP_TEST(current_extension->source_kind, SOURCE_KIND_DO_NOT_PROCESS)
             || BITMAP_TEST(CURRENT_CONFIGURATION->force_source_kind, SOURCE_KIND_DO_NOT_PROCESS);
 
@@ -3226,7 +3553,9 @@ static void compile_every_translation_unit_aux_(int num_translation_units,
             }
 
             timing_start(&timing_preprocessing);
+            phase_profile_start("preprocessing");
             parsed_filename = preprocess_translation_unit(translation_unit, translation_unit->input_filename);
+            phase_profile_end("preprocessing");
             timing_end(&timing_preprocessing);
 
             FORTRAN_LANGUAGE()
@@ -3258,6 +3587,12 @@ static void compile_every_translation_unit_aux_(int num_translation_units,
                 && !BITMAP_TEST(CURRENT_CONFIGURATION->force_source_kind, SOURCE_KIND_FREE_FORM)
                 && !CURRENT_CONFIGURATION->pass_through);
 
+        // * Trees of this translation unit are allocated in a region of
+        // their own, released when it is done. Secondary translation units
+        // are built from them, so they are released after those
+        ast_arena_region_t* translation_unit_region = ast_arena_region_new();
+        ast_arena_region_t* enclosing_region = ast_arena_set_current_region(translation_unit_region);
+
         if (!CURRENT_CONFIGURATION->do_not_parse)
         {
             if (!CURRENT_CONFIGURATION->pass_through
@@ -3278,20 +3613,46 @@ static void compile_every_translation_unit_aux_(int num_translation_units,
                 // Fill the context with initial information
                 initialize_semantic_analysis(translation_unit, parsed_filename);
 
+                // * Global scope snapshots
+                const char* scanned_filename = parsed_filename;
+                dhash_ptr_t* preexisting_symbols = NULL;
+                nodecl_t nodecl_snapshot_decls = nodecl_null();
+                if ((CURRENT_CONFIGURATION->global_snapshot_out != NULL
+                            || CURRENT_CONFIGURATION->global_snapshot != NULL)
+                        && !IS_C_LANGUAGE)
+                {
+                    fprintf(stderr, "warning: global scope snapshots are only supported in C, "
+                            "ignoring them for file '%s'\n",
+                            translation_unit->input_filename);
+                }
+                else if (CURRENT_CONFIGURATION->global_snapshot_out != NULL)
+                {
+                    preexisting_symbols = dhash_ptr_new(5);
+                    scope_for_each_entity(translation_unit->global_decl_context->global_scope,
+                            preexisting_symbols,
+                            gather_preexisting_symbols);
+                }
+                else if (CURRENT_CONFIGURATION->global_snapshot != NULL)
+                {
+                    scanned_filename = use_global_scope_snapshot(translation_unit,
+                            parsed_filename,
+                            &nodecl_snapshot_decls);
+                }
+
                 // * Open file
                 CXX_LANGUAGE()
                 {
-                    if (mcxx_open_file_for_scanning(parsed_filename, translation_unit->input_filename) != 0)
+                    if (mcxx_open_file_for_scanning(scanned_filename, translation_unit->input_filename) != 0)
                     {
-                        fatal_error("Could not open file '%s'", parsed_filename);
+                        fatal_error("Could not open file '%s'", scanned_filename);
                     }
                 }
 
                 C_LANGUAGE()
                 {
-                    if (mc99_open_file_for_scanning(parsed_filename, translation_unit->input_filename) != 0)
+                    if (mc99_open_file_for_scanning(scanned_filename, translation_unit->input_filename) != 0)
                     {
-                        fatal_error("Could not open file '%s'", parsed_filename);
+                        fatal_error("Could not open file '%s'", scanned_filename);
                     }
                 }
 
@@ -3304,7 +3665,9 @@ static void compile_every_translation_unit_aux_(int num_translation_units,
                 }
 
                 // * Parse file
+                phase_profile_start("parsing");
                 parse_translation_unit(translation_unit, parsed_filename);
+                phase_profile_end("parsing");
                 // The scanner automatically closes the file
 
                 if (debug_options.print_ast_graphviz)
@@ -3321,7 +3684,22 @@ static void compile_every_translation_unit_aux_(int num_translation_units,
                 compiler_phases_pre_execution(CURRENT_CONFIGURATION, translation_unit, parsed_filename);
 
                 // * Semantic analysis
+                phase_profile_start("semantic analysis");
                 semantic_analysis(translation_unit, parsed_filename);
+                phase_profile_end("semantic analysis");
+
+                if (!nodecl_is_null(nodecl_snapshot_decls))
+                {
+                    // Declarations of the code skipped because of the snapshot
+                    nodecl_set_child(translation_unit->nodecl, 0,
+                            nodecl_concat_lists(nodecl_snapshot_decls,
+                                nodecl_get_child(translation_unit->nodecl, 0)));
+                }
+                if (preexisting_symbols != NULL)
+                {
+                    write_global_scope_snapshot(translation_unit, parsed_filename, preexisting_symbols);
+                    dhash_ptr_destroy(preexisting_symbols);
+                }
 
                 // * Check nodecl generated by semantic analysis
                 timing_t timing_check_tree;
@@ -3345,7 +3723,9 @@ static void compile_every_translation_unit_aux_(int num_translation_units,
                 }
 
                 // * TL::run and TL::phase_cleanup
+                phase_profile_start("compiler phases");
                 compiler_phases_execution(CURRENT_CONFIGURATION, translation_unit, parsed_filename);
+                phase_profile_end("compiler phases");
 
                 // * print ast if requested
                 if (debug_options.print_nodecl_graphviz)
@@ -3374,27 +3754,20 @@ static void compile_every_translation_unit_aux_(int num_translation_units,
             if (!file_not_processed
                     && !debug_options.do_not_codegen)
             {
+                phase_profile_start("codegen");
                 prettyprinted_filename
                     = codegen_translation_unit(translation_unit, parsed_filename);
+                phase_profile_end("codegen");
             }
 
-            timing_t timing_free_tree;
-            if (CURRENT_CONFIGURATION->verbose)
-            {
-                DEBUG_CODE()
-                {
-                    fprintf(stderr, "Freeing nodecl tree\n");
-                }
-            }
-            timing_start(&timing_free_tree);
-            nodecl_free(translation_unit->nodecl);
-            timing_end(&timing_free_tree);
-            if (CURRENT_CONFIGURATION->verbose)
+            // * Release the preprocessed file if it was kept in memory
+            temporal_memory_file_release(parsed_filename);
+
+            // * Compact the Fortran modules written by this file, TL phases
+            // may have extended them until now
+            if (current_extension->source_language == SOURCE_LANGUAGE_FORTRAN)
             {
-                DEBUG_CODE()
-                {
-                    fprintf(stderr, "Nodecl tree freed in %.2f seconds\n", timing_elapsed(&timing_free_tree));
-                }
+                compact_module_files();
             }
 
             // * Recursively process secondary translation units
@@ -3426,6 +3799,7 @@ static void compile_every_translation_unit_aux_(int num_translation_units,
             if (!BITMAP_TEST(current_extension->source_kind, SOURCE_KIND_DO_NOT_COMPILE))
             {
                 // * Native compilation
+                phase_profile_start("native compilation");
                 if (!file_not_processed)
                 {
                     native_compilation(translation_unit, prettyprinted_filename, /* remove_input */ 1);
@@ -3435,6 +3809,7 @@ static void compile_every_translation_unit_aux_(int num_translation_units,
                     // Do not process
                     native_compilation(translation_unit, translation_unit->input_filename, /* remove_input */ 0);
                 }
+                phase_profile_end("native compilation");
             }
 
             // * Restore all the wrap modules for subsequent uses
@@ -3464,10 +3839,32 @@ static void compile_every_translation_unit_aux_(int num_translation_units,
             }
         }
 
+        // * Release the trees of this translation unit. Symbols and types
+        // referring to them are not used by later translation units and
+        // trees kept in process-wide caches are in the persistent region
+        translation_unit->nodecl = nodecl_null();
+        ast_arena_set_current_region(enclosing_region);
+
+        timing_t timing_free_tree;
+        timing_start(&timing_free_tree);
+        ast_arena_region_release(translation_unit_region);
+        timing_end(&timing_free_tree);
+        if (CURRENT_CONFIGURATION->verbose)
+        {
+            DEBUG_CODE()
+            {
+                fprintf(stderr, "Trees of '%s' released in %.2f seconds\n",
+                        translation_unit->input_filename,
+                        timing_elapsed(&timing_free_tree));
+            }
+        }
+
         // * Restore CUDA flag
         // FIXME. Is this the best place for this?
         CURRENT_CONFIGURATION->enable_cuda = old_cuda_flag;
 
+        phase_profile_end_translation_unit();
+
         // * This file has already been compiled
         file_process->already_compiled = 1;
     }
@@ -3475,13 +3872,314 @@ static void compile_every_translation_unit_aux_(int num_translation_units,
     // Restore previous state
     SET_CURRENT_FILE_PROCESS(saved_file_process);
     SET_CURRENT_CONFIGURATION(saved_configuration);
+
 #undef return
 }
 
+#if !defined(WIN32_BUILD) || defined(__CYGWIN__)
+// Parallel compilation (-j N)
+//
+// Every translation unit is compiled by a worker process forked from the
+// driver. A worker runs the whole pipeline of its file (including the native
+// compilation and the embedding of its secondary files) with its standard
+// output and error redirected to temporary files. These are replayed in input
+// order once the worker finishes, so diagnostics are not interleaved. The
+// worker sends back the name of the object it generated so the driver can
+// link all of them at the end
+typedef struct parallel_job_tag
+{
+    pid_t pid;
+    int result_fd;
+
+    const char* stdout_filename;
+    const char* stderr_filename;
+
+    char started;
+    char finished;
+    char failed;
+} parallel_job_t;
+
+static char translation_unit_can_be_compiled_in_parallel(
+        compilation_file_process_t* file_process)
+{
+    const char* extension = get_extension_filename(file_process->translation_unit->input_filename);
+    struct extensions_table_t* current_extension = fileextensions_lookup(extension, strlen(extension));
+
+    // Fortran files may depend on modules generated by previous files
+    return (current_extension->source_language != SOURCE_LANGUAGE_FORTRAN
+            && file_process->compilation_configuration->source_language != SOURCE_LANGUAGE_FORTRAN);
+}
+
+static int num_translation_units_to_compile_in_parallel(void)
+{
+    int num_files = 0;
+    int i;
+    for (i = 0; i < compilation_process.num_translation_units; i++)
+    {
+        compilation_file_process_t* file_process = compilation_process.translation_units[i];
+        if (!translation_unit_can_be_compiled_in_parallel(file_process))
+            return 0;
+
+        const char* extension = get_extension_filename(file_process->translation_unit->input_filename);
+        struct extensions_table_t* current_extension = fileextensions_lookup(extension, strlen(extension));
+
+        if (current_extension->source_language != SOURCE_LANGUAGE_LINKER_DATA)
+            num_files++;
+    }
+
+    return num_files;
+}
+
+static void dump_file_to_stream(const char* filename, FILE* stream)
+{
+    FILE* f = fopen(filename, "r");
+    if (f == NULL)
+        return;
+
+    char buffer[4096];
+    size_t num_read;
+    while ((num_read = fread(buffer, 1, sizeof(buffer), f)) > 0)
+    {
+        fwrite(buffer, 1, num_read, stream);
+    }
+    fclose(f);
+    fflush(stream);
+}
+
+static void parallel_job_worker(compilation_file_process_t* file_process,
+        parallel_job_t* job, int result_fd) NORETURN;
+
+static void parallel_job_worker(compilation_file_process_t* file_process,
+        parallel_job_t* job, int result_fd)
+{
+    // The temporal files registered so far belong to the driver
+    temporal_files_forget();
+
+    if (freopen(job->stdout_filename, "w", stdout) == NULL
+            || freopen(job->stderr_filename, "w", stderr) == NULL)
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    compile_every_translation_unit_aux_(1, &file_process);
+    wait_pending_native_compilations();
+
+    // Secondary files only exist in this process, so embed them here
+    if (!CURRENT_CONFIGURATION->do_not_compile)
+    {
+        embed_files_of_file_process(file_process);
+    }
+
+    const char* output_filename = file_process->translation_unit->output_filename;
+    if (output_filename != NULL)
+    {
+        size_t length = strlen(output_filename);
+        if (write(result_fd, output_filename, length) != (ssize_t)length)
+        {
+            fatal_error("error: could not send the output filename of '%s' to the driver (%s)",
+                    file_process->translation_unit->input_filename,
+                    strerror(errno));
+        }
+    }
+    close(result_fd);
+
+    fflush(stdout);
+    fflush(stderr);
+
+    exit(EXIT_SUCCESS);
+}
+
+static void parallel_job_start(compilation_file_process_t* file_process, parallel_job_t* job)
+{
+    job->stdout_filename = new_temporal_file()->name;
+    job->stderr_filename = new_temporal_file()->name;
+
+    int result_pipe[2];
+    if (pipe(result_pipe) != 0)
+    {
+        fatal_error("error: could not create a pipe for a compilation job (%s)", strerror(errno));
+    }
+
+    // Do not let the worker replay pending buffered output
+    fflush(stdout);
+    fflush(stderr);
+
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        fatal_error("error: could not fork a compilation job for '%s' (%s)",
+                file_process->translation_unit->input_filename,
+                strerror(errno));
+    }
+    else if (pid == 0)
+    {
+        close(result_pipe[0]);
+        parallel_job_worker(file_process, job, result_pipe[1]);
+    }
+
+    close(result_pipe[1]);
+
+    job->pid = pid;
+    job->result_fd = result_pipe[0];
+    job->started = 1;
+}
+
+static void parallel_job_finish(compilation_file_process_t* file_process, parallel_job_t* job, int status)
+{
+    job->finished = 1;
+    job->failed = !WIFEXITED(status) || (WEXITSTATUS(status) != 0);
+
+    if (WIFSIGNALED(status))
+    {
+        // This message is replayed along with the diagnostics of the job
+        FILE* f = fopen(job->stderr_filename, "a");
+        if (f != NULL)
+        {
+            fprintf(f, "%s: compilation job of '%s' was ended with signal %d\n",
+                    compilation_process.exec_basename,
+                    file_process->translation_unit->input_filename,
+                    WTERMSIG(status));
+            fclose(f);
+        }
+    }
+
+    char output_filename[1024];
+    ssize_t length = 0, num_read;
+    while (length < (ssize_t)sizeof(output_filename) - 1
+            && (num_read = read(job->result_fd,
+                    output_filename + length,
+                    sizeof(output_filename) - 1 - length)) > 0)
+    {
+        length += num_read;
+    }
+    output_filename[length] = '\0';
+    close(job->result_fd);
+
+    if (!job->failed)
+    {
+        if (length > 0)
+        {
+            file_process->translation_unit->output_filename = uniquestr(output_filename);
+        }
+        file_process->already_compiled = 1;
+    }
+}
+
+static void compile_every_translation_unit_in_parallel(int num_jobs)
+{
+    int num_translation_units = compilation_process.num_translation_units;
+    compilation_file_process_t** translation_units = compilation_process.translation_units;
+
+    parallel_job_t* jobs = NEW_VEC0(parallel_job_t, num_translation_units);
+
+    if (CURRENT_CONFIGURATION->verbose)
+    {
+        fprintf(stderr, "Compiling %d files using up to %d jobs\n",
+                num_translation_units, num_jobs);
+    }
+
+    int next_to_start = 0;
+    int next_to_report = 0;
+    int num_running = 0;
+    char stop_starting_jobs = 0;
+    char any_failed = 0;
+
+    for (;;)
+    {
+        while (!stop_starting_jobs
+                && next_to_start < num_translation_units
+                && num_running < num_jobs)
+        {
+            compilation_file_process_t* file_process = translation_units[next_to_start];
+            parallel_job_t* job = &jobs[next_to_start];
+
+            const char* extension = get_extension_filename(file_process->translation_unit->input_filename);
+            struct extensions_table_t* current_extension = fileextensions_lookup(extension, strlen(extension));
+
+            if (file_process->already_compiled
+                    || current_extension->source_language == SOURCE_LANGUAGE_LINKER_DATA)
+            {
+                // Nothing to do for these, do not bother forking
+                file_process->already_compiled = 1;
+                job->finished = 1;
+            }
+            else
+            {
+                parallel_job_start(file_process, job);
+                num_running++;
+            }
+            next_to_start++;
+        }
+
+        // Report, in input order, the jobs that have already finished
+        while (next_to_report < next_to_start
+                && jobs[next_to_report].finished)
+        {
+            parallel_job_t* job = &jobs[next_to_report];
+            if (job->started)
+            {
+                dump_file_to_stream(job->stdout_filename, stdout);
+                dump_file_to_stream(job->stderr_filename, stderr);
+            }
+            any_failed = any_failed || job->failed;
+            next_to_report++;
+        }
+
+        if (num_running == 0
+                && (next_to_report == num_translation_units
+                    || stop_starting_jobs))
+            break;
+
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            fatal_error("error: could not wait for compilation jobs (%s)", strerror(errno));
+        }
+
+        int i;
+        for (i = next_to_report; i < next_to_start; i++)
+        {
+            if (jobs[i].started
+                    && !jobs[i].finished
+                    && jobs[i].pid == pid)
+            {
+                parallel_job_finish(translation_units[i], &jobs[i], status);
+                num_running--;
+                // Like the sequential compilation, do not compile
+                // further files once one has failed
+                stop_starting_jobs = stop_starting_jobs || jobs[i].failed;
+                break;
+            }
+        }
+    }
+
+    DELETE(jobs);
+
+    if (any_failed)
+    {
+        exit(EXIT_FAILURE);
+    }
+}
+#endif
+
 static void compile_every_translation_unit(void)
 {
+#if !defined(WIN32_BUILD) || defined(__CYGWIN__)
+    if (compilation_process.num_jobs > 1
+            && num_translation_units_to_compile_in_parallel() > 1)
+    {
+        compile_every_translation_unit_in_parallel(compilation_process.num_jobs);
+        return;
+    }
+#endif
     compile_every_translation_unit_aux_(compilation_process.num_translation_units,
             compilation_process.translation_units);
+
+    // Objects must be complete before embedding and linking them
+    wait_pending_native_compilations();
 }
 
 static void compiler_phases_pre_execution(
@@ -4109,7 +4807,18 @@ static const char* preprocess_single_file(const char* input_filename, const char
 
     if (!CURRENT_CONFIGURATION->do_not_parse)
     {
-        temporal_file_t preprocessed_file = new_temporal_file();
+        temporal_file_t preprocessed_file = NULL;
+        // With -K the preprocessed file must be kept, so it must be a real file
+        if (CURRENT_CONFIGURATION->preprocess_in_memory
+                && !CURRENT_CONFIGURATION->keep_temporaries)
+        {
+            // This is NULL if the system does not support memory files
+            preprocessed_file = new_temporal_memory_file();
+        }
+        if (preprocessed_file == NULL)
+        {
+            preprocessed_file = new_temporal_file();
+        }
         preprocessed_filename = preprocessed_file->name;
     }
     else
@@ -4181,6 +4890,144 @@ const char* preprocess_file(const char* input_filename)
     return preprocess_single_file(input_filename, NULL);
 }
 
+#if !defined(WIN32_BUILD) || defined(__CYGWIN__)
+// Native compilations running in the background (--native-jobs). They are
+// kept in input order and always waited for in that order, so their
+// diagnostics and failures are reported as if they had run sequentially
+typedef struct pending_native_compilation_tag
+{
+    translation_unit_t* translation_unit;
+    const char* prettyprinted_filename;
+    const char* native_compiler_name;
+
+    const char* stdout_filename;
+    const char* stderr_filename;
+
+    int handle;
+    timing_t timing_compilation;
+
+    // Set once the compilation has been found finished
+    char finished;
+    int result;
+} pending_native_compilation_t;
+
+static int num_pending_native_compilations = 0;
+static pending_native_compilation_t** pending_native_compilations = NULL;
+
+static int wait_oldest_native_compilation(void)
+{
+    ERROR_CONDITION(num_pending_native_compilations == 0,
+            "There are no pending native compilations", 0);
+
+    pending_native_compilation_t* pending = pending_native_compilations[0];
+    P_LIST_REMOVE(pending_native_compilations, num_pending_native_compilations, pending);
+
+    int result = pending->result;
+    if (!pending->finished)
+    {
+        result = wait_program(pending->handle, pending->native_compiler_name);
+        timing_end(&pending->timing_compilation);
+    }
+
+    dump_file_to_stream(pending->stdout_filename, stdout);
+    dump_file_to_stream(pending->stderr_filename, stderr);
+
+    if (result == 0
+            && CURRENT_CONFIGURATION->verbose)
+    {
+        fprintf(stderr, "File '%s' ('%s') natively compiled in %.2f seconds\n",
+                pending->translation_unit->input_filename,
+                pending->prettyprinted_filename,
+                timing_elapsed(&pending->timing_compilation));
+    }
+
+    if (result != 0)
+    {
+        const char* input_filename = pending->translation_unit->input_filename;
+        DELETE(pending);
+
+        // Let the remaining compilations end before their input files
+        // are removed
+        while (num_pending_native_compilations > 0)
+        {
+            pending = pending_native_compilations[0];
+            P_LIST_REMOVE(pending_native_compilations, num_pending_native_compilations, pending);
+            if (!pending->finished)
+                wait_program(pending->handle, pending->native_compiler_name);
+            DELETE(pending);
+        }
+
+        fatal_error("Native compilation failed for file '%s'", input_filename);
+    }
+
+    DELETE(pending);
+    return result;
+}
+
+// Reports the compilations that have already ended, without waiting for
+// any. Only the oldest one is checked each time, so a failure is reported
+// before going on with the next translation unit but still in input order
+static void report_finished_native_compilations(void)
+{
+    while (num_pending_native_compilations > 0)
+    {
+        pending_native_compilation_t* pending = pending_native_compilations[0];
+        if (!pending->finished)
+        {
+            if (!poll_program(pending->handle, pending->native_compiler_name, &pending->result))
+                return;
+
+            pending->finished = 1;
+            timing_end(&pending->timing_compilation);
+        }
+
+        wait_oldest_native_compilation();
+    }
+}
+
+static void start_native_compilation_in_background(translation_unit_t* translation_unit,
+        const char* prettyprinted_filename,
+        const char** native_compilation_args)
+{
+    while (num_pending_native_compilations >= compilation_process.num_native_jobs)
+    {
+        wait_oldest_native_compilation();
+    }
+
+    pending_native_compilation_t* pending = NEW0(pending_native_compilation_t);
+    pending->translation_unit = translation_unit;
+    pending->prettyprinted_filename = prettyprinted_filename;
+    pending->native_compiler_name = CURRENT_CONFIGURATION->native_compiler_name;
+    pending->stdout_filename = new_temporal_file()->name;
+    pending->stderr_filename = new_temporal_file()->name;
+
+    timing_start(&pending->timing_compilation);
+    pending->handle = execute_program_flags_async(pending->native_compiler_name,
+            native_compilation_args,
+            pending->stdout_filename,
+            pending->stderr_filename);
+
+    P_LIST_ADD(pending_native_compilations, num_pending_native_compilations, pending);
+}
+#endif
+
+static void wait_pending_native_compilations(void)
+{
+#if !defined(WIN32_BUILD) || defined(__CYGWIN__)
+    while (num_pending_native_compilations > 0)
+    {
+        wait_oldest_native_compilation();
+    }
+#endif
+}
+
+static void report_finished_native_compilations_if_any(void)
+{
+#if !defined(WIN32_BUILD) || defined(__CYGWIN__)
+    report_finished_native_compilations();
+#endif
+}
+
 static void native_compilation(translation_unit_t* translation_unit, 
         const char* prettyprinted_filename, 
         char remove_input)
@@ -4344,6 +5191,20 @@ static void native_compilation(translation_unit_t* translation_unit,
                 prettyprinted_filename, output_object_filename);
     }
 
+#if !defined(WIN32_BUILD) || defined(__CYGWIN__)
+    // Binary check and Fortran (whose modules are wrapped right after the
+    // native compilation) need the native compilation to be finished
+    if (compilation_process.num_native_jobs > 0
+            && !debug_options.binary_check
+            && CURRENT_CONFIGURATION->source_language != SOURCE_LANGUAGE_FORTRAN)
+    {
+        start_native_compilation_in_background(translation_unit,
+                prettyprinted_filename,
+                native_compilation_args);
+        return;
+    }
+#endif
+
     timing_t timing_compilation;
     timing_start(&timing_compilation);
 
@@ -4443,132 +5304,137 @@ static void embed_files(void)
 
     for (i = 0; i < compilation_process.num_translation_units; i++)
     {
-        int num_secondary_translation_units = 
-            compilation_process.translation_units[i]->num_secondary_translation_units;
-        compilation_file_process_t** secondary_translation_units = 
-            compilation_process.translation_units[i]->secondary_translation_units;
+        embed_files_of_file_process(compilation_process.translation_units[i]);
+    }
+}
 
-        translation_unit_t* translation_unit = compilation_process.translation_units[i]->translation_unit;
-        const char* extension = get_extension_filename(translation_unit->input_filename);
-        struct extensions_table_t* current_extension = fileextensions_lookup(extension, strlen(extension));
+static void embed_files_of_file_process(compilation_file_process_t* file_process)
+{
+    int num_secondary_translation_units = 
+        file_process->num_secondary_translation_units;
+    compilation_file_process_t** secondary_translation_units = 
+        file_process->secondary_translation_units;
+
+    translation_unit_t* translation_unit = file_process->translation_unit;
+    const char* extension = get_extension_filename(translation_unit->input_filename);
+    struct extensions_table_t* current_extension = fileextensions_lookup(extension, strlen(extension));
+
+    // We do not have to embed linker data
+    if (current_extension->source_language == SOURCE_LANGUAGE_LINKER_DATA
+            // Or languages that we know that cannot be embedded
+            || ((current_extension->source_kind & SOURCE_KIND_DO_NOT_EMBED) == SOURCE_KIND_DO_NOT_EMBED))
+    {
+        return;
+    }
+    const char *output_filename = translation_unit->output_filename;
+
+    if (CURRENT_CONFIGURATION->verbose)
+    {
+        fprintf(stderr, "Embedding secondary files into '%s'\n", output_filename);
+    }
+
+#define MAX_EMBED_MODES 8
+    int num_embed_modes_seen = 0;
+    int embed_modes[MAX_EMBED_MODES] = { 0 };
+    void *embed_mode_data[MAX_EMBED_MODES] = { 0 };
+
+    int j;
+    for (j = 0; j < num_secondary_translation_units; j++)
+    {
+        compilation_file_process_t* secondary_compilation_file = secondary_translation_units[j];
+        compilation_configuration_t* secondary_configuration = secondary_compilation_file->compilation_configuration;
 
-        // We do not have to embed linker data
+        // If a .o file is introduced by a phase, then it will not have an
+        // output filename because we usually compute these very late in
+        // the linking step and we will end using the same name.
+        extension = get_extension_filename(secondary_compilation_file->translation_unit->input_filename);
+        current_extension = fileextensions_lookup(extension, strlen(extension));
         if (current_extension->source_language == SOURCE_LANGUAGE_LINKER_DATA
-                // Or languages that we know that cannot be embedded
-                || ((current_extension->source_kind & SOURCE_KIND_DO_NOT_EMBED) == SOURCE_KIND_DO_NOT_EMBED))
+                && secondary_compilation_file->translation_unit->output_filename == NULL)
         {
-            continue;
+            secondary_compilation_file->translation_unit->output_filename =
+                secondary_compilation_file->translation_unit->input_filename;
         }
-        const char *output_filename = translation_unit->output_filename;
 
-        if (CURRENT_CONFIGURATION->verbose)
+        target_options_map_t* target_options = get_target_options(secondary_configuration, CURRENT_CONFIGURATION->configuration_name);
+
+        if (target_options == NULL)
         {
-            fprintf(stderr, "Embedding secondary files into '%s'\n", output_filename);
+            fatal_error("During embedding, there are no target options defined from profile '%s' to profile '%s' in the configuration\n",
+                    secondary_configuration->configuration_name,
+                    CURRENT_CONFIGURATION->configuration_name);
         }
 
-#define MAX_EMBED_MODES 8
-        int num_embed_modes_seen = 0;
-        int embed_modes[MAX_EMBED_MODES] = { 0 };
-        void *embed_mode_data[MAX_EMBED_MODES] = { 0 };
-
-        int j;
-        for (j = 0; j < num_secondary_translation_units; j++)
-        {
-            compilation_file_process_t* secondary_compilation_file = secondary_translation_units[j];
-            compilation_configuration_t* secondary_configuration = secondary_compilation_file->compilation_configuration;
-
-            // If a .o file is introduced by a phase, then it will not have an
-            // output filename because we usually compute these very late in
-            // the linking step and we will end using the same name.
-            extension = get_extension_filename(secondary_compilation_file->translation_unit->input_filename);
-            current_extension = fileextensions_lookup(extension, strlen(extension));
-            if (current_extension->source_language == SOURCE_LANGUAGE_LINKER_DATA
-                    && secondary_compilation_file->translation_unit->output_filename == NULL)
-            {
-                secondary_compilation_file->translation_unit->output_filename =
-                    secondary_compilation_file->translation_unit->input_filename;
-            }
+        if (!target_options->do_embedding)
+        {
+            // Do nothing if we are told not to embed
+            continue;
+        }
 
-            target_options_map_t* target_options = get_target_options(secondary_configuration, CURRENT_CONFIGURATION->configuration_name);
+        // Remember the embed mode to run the collective embed procedure later
+        ERROR_CONDITION(num_embed_modes_seen == MAX_EMBED_MODES, "Too many embed modes. Max is %d", MAX_EMBED_MODES);
+        int k; 
+        char found = 0;
 
-            if (target_options == NULL)
-            {
-                fatal_error("During embedding, there are no target options defined from profile '%s' to profile '%s' in the configuration\n",
-                        secondary_configuration->configuration_name,
-                        CURRENT_CONFIGURATION->configuration_name);
-            }
+        void **embed_data = NULL;
 
-            if (!target_options->do_embedding)
+        for (k = 0;  k < num_embed_modes_seen && !found; k++)
+        {
+            if (embed_modes[k] == target_options->embedding_mode)
             {
-                // Do nothing if we are told not to embed
-                continue;
+                found = 1;
+                break;
             }
+        }
+        if (!found)
+        {
+            embed_modes[num_embed_modes_seen] = target_options->embedding_mode;
+            embed_data = &(embed_mode_data[num_embed_modes_seen]);
+            num_embed_modes_seen++;
+        }
+        else
+        {
+            embed_data = &(embed_mode_data[k]);
+        }
 
-            // Remember the embed mode to run the collective embed procedure later
-            ERROR_CONDITION(num_embed_modes_seen == MAX_EMBED_MODES, "Too many embed modes. Max is %d", MAX_EMBED_MODES);
-            int k; 
-            char found = 0;
-
-            void **embed_data = NULL;
-
-            for (k = 0;  k < num_embed_modes_seen && !found; k++)
-            {
-                if (embed_modes[k] == target_options->embedding_mode)
+        // Single embed
+        switch (target_options->embedding_mode)
+        {
+            case EMBEDDING_MODE_BFD:
                 {
-                    found = 1;
+                    multifile_embed_bfd_single(embed_data, secondary_compilation_file);
                     break;
                 }
-            }
-            if (!found)
-            {
-                embed_modes[num_embed_modes_seen] = target_options->embedding_mode;
-                embed_data = &(embed_mode_data[num_embed_modes_seen]);
-                num_embed_modes_seen++;
-            }
-            else
-            {
-                embed_data = &(embed_mode_data[k]);
-            }
-
-            // Single embed
-            switch (target_options->embedding_mode)
-            {
-                case EMBEDDING_MODE_BFD:
-                    {
-                        multifile_embed_bfd_single(embed_data, secondary_compilation_file);
-                        break;
-                    }
-                case EMBEDDING_MODE_PARTIAL_LINKING:
-                    {
-                        multifile_embed_partial_linking_single(
-                                embed_data, secondary_compilation_file, output_filename);
-                        break;
-                    }
-                default:
-                    internal_error("Unknown embedding mode", 0);
-            }
-
+            case EMBEDDING_MODE_PARTIAL_LINKING:
+                {
+                    multifile_embed_partial_linking_single(
+                            embed_data, secondary_compilation_file, output_filename);
+                    break;
+                }
+            default:
+                internal_error("Unknown embedding mode", 0);
         }
 
-        // Collective embed
-        for (j = 0; j < num_embed_modes_seen; j++)
+    }
+
+    // Collective embed
+    for (j = 0; j < num_embed_modes_seen; j++)
+    {
+        switch (embed_modes[j])
         {
-            switch (embed_modes[j])
-            {
-                case EMBEDDING_MODE_BFD:
-                    {
-                        multifile_embed_bfd_collective(&(embed_mode_data[j]), output_filename);
-                        break;
-                    }
-                case EMBEDDING_MODE_PARTIAL_LINKING:
-                    {
-                        // We don't need to do anything, secondary translation units
-                        // are already embedded in the output linker object
-                        break;
-                    }
-                default:
-                    internal_error("Unknown embedding mode", 0);
-            }
+            case EMBEDDING_MODE_BFD:
+                {
+                    multifile_embed_bfd_collective(&(embed_mode_data[j]), output_filename);
+                    break;
+                }
+            case EMBEDDING_MODE_PARTIAL_LINKING:
+                {
+                    // We don't need to do anything, secondary translation units
+                    // are already embedded in the output linker object
+                    break;
+                }
+            default:
+                internal_error("Unknown embedding mode", 0);
         }
     }
 }
@@ -5212,7 +6078,6 @@ static compilation_configuration_t* get_sublanguage_configuration(
     return fallback_config;
 }
 
-#ifdef HAVE_MALLINFO
 static char* power_suffixes[9] = 
 {
     "",
@@ -5253,7 +6118,6 @@ static void print_human(char *dest, unsigned long long num_bytes_)
         }
     }
 }
-#endif
 
 static void compute_tree_breakdown(AST a, int breakdown[MCXX_MAX_AST_CHILDREN + 1], int breakdown_real[MCXX_MAX_AST_CHILDREN + 1], int *num_nodes)
 {
@@ -5335,6 +6199,40 @@ static void print_memory_report(void)
     fprintf(stderr, "Size of a type (bytes): %zd\n",
             get_type_t_size());
 
+    // -- Symbols
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Entity specifiers of symbols\n");
+    fprintf(stderr, "----------------------------\n");
+    fprintf(stderr, "\n");
+
+    entity_specs_stats_t entity_specs_stats;
+    symbol_entity_specs_get_stats(&entity_specs_stats);
+
+    size_t num_sparse_live = entity_specs_stats.num_sparse_allocated
+        - entity_specs_stats.num_sparse_freed;
+    // Had all the attributes been kept in the symbol, without the pointer
+    // to the rare attributes nor their reference count
+    size_t unsplit_size = sizeof(entity_specifiers_t)
+        - sizeof(entity_specifiers_sparse_t*)
+        + sizeof(entity_specifiers_sparse_t)
+        - sizeof(int);
+
+    fprintf(stderr, " - Size of the rare attributes (bytes): %zd\n",
+            sizeof(entity_specifiers_sparse_t));
+    fprintf(stderr, " - Symbols created: %zu\n", entity_specs_stats.num_symbols);
+    fprintf(stderr, " - Symbols with rare attributes: %zu\n", num_sparse_live);
+    fprintf(stderr, " - Rare attributes copied from another symbol: %zu\n",
+            entity_specs_stats.num_sparse_unshared);
+    if (entity_specs_stats.num_symbols > 0)
+    {
+        fprintf(stderr, " - Bytes of entity specifiers per symbol if not split: %zu\n",
+                unsplit_size);
+        fprintf(stderr, " - Bytes of entity specifiers per symbol: %zu\n",
+                (entity_specs_stats.num_symbols * sizeof(entity_specifiers_t)
+                 + num_sparse_live * sizeof(entity_specifiers_sparse_t))
+                / entity_specs_stats.num_symbols);
+    }
+
     // -- AST
     fprintf(stderr, "\n");
     fprintf(stderr, "Abstract Syntax Tree(s) breakdown\n");
@@ -5374,6 +6272,141 @@ static void print_memory_report(void)
         fprintf(stderr, " - Nodes with %d real children: %d\n", i, children_real_count[i]);
     }
 
+    // -- AST arena
+    fprintf(stderr, "\n");
+    fprintf(stderr, "AST arena\n");
+    fprintf(stderr, "---------\n");
+    fprintf(stderr, "\n");
+
+    ast_arena_stats_t arena_stats;
+    ast_arena_get_stats(&arena_stats);
+
+    char arena_bytes[256];
+    fprintf(stderr, " - Chunks currently held: %zu\n", arena_stats.num_chunks);
+    print_human(arena_bytes, arena_stats.bytes_reserved);
+    fprintf(stderr, " - Memory currently reserved: %s\n", arena_bytes);
+    print_human(arena_bytes, arena_stats.bytes_used);
+    fprintf(stderr, " - Memory currently handed out: %s\n", arena_bytes);
+    print_human(arena_bytes, arena_stats.peak_bytes_reserved);
+    fprintf(stderr, " - Peak memory reserved: %s\n", arena_bytes);
+    fprintf(stderr, " - Nodes allocated: %zu (%zu reused after being freed)\n",
+            arena_stats.num_nodes_allocated,
+            arena_stats.num_nodes_reused);
+    fprintf(stderr, " - Nodes alive: %zu\n", arena_stats.num_nodes_live);
+
+    // -- AST children layout
+    fprintf(stderr, "\n");
+    fprintf(stderr, "AST children layout\n");
+    fprintf(stderr, "-------------------\n");
+    fprintf(stderr, "\n");
+
+    // Children are stored inline in the node. Compare against a layout where
+    // the node only keeps a pointer to a separate array of its children
+    size_t inline_node_size = ast_node_size();
+    size_t out_of_line_node_size = inline_node_size
+        - MCXX_MAX_AST_CHILDREN * sizeof(AST) + sizeof(AST*);
+    size_t inline_bytes = arena_stats.num_nodes_allocated * inline_node_size;
+    size_t out_of_line_bytes = arena_stats.num_nodes_allocated * out_of_line_node_size;
+    size_t num_children_arrays = 0;
+    for (i = 1; i < MCXX_MAX_AST_CHILDREN + 1; i++)
+    {
+        fprintf(stderr, " - Nodes created with %d children: %zu\n",
+                i, arena_stats.num_nodes_by_children[i]);
+        num_children_arrays += arena_stats.num_nodes_by_children[i];
+        out_of_line_bytes += arena_stats.num_nodes_by_children[i] * i * sizeof(AST);
+    }
+    fprintf(stderr, " - Node size with inline children (bytes): %zu\n", inline_node_size);
+    fprintf(stderr, " - Node size with out of line children (bytes): %zu\n", out_of_line_node_size);
+    fprintf(stderr, " - Children array allocations avoided: %zu\n", num_children_arrays);
+    print_human(arena_bytes, inline_bytes);
+    fprintf(stderr, " - Memory of nodes with inline children: %s\n", arena_bytes);
+    print_human(arena_bytes, out_of_line_bytes);
+    fprintf(stderr, " - Memory of nodes with out of line children: %s\n", arena_bytes);
+
+    // -- Pending instantiations
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Pending instantiations\n");
+    fprintf(stderr, "----------------------\n");
+    fprintf(stderr, "\n");
+
+    instantiation_queue_stats_t queue_stats;
+    instantiation_get_queue_stats(&queue_stats);
+
+    fprintf(stderr, " - Functions requested: %zu\n", queue_stats.num_requests);
+    fprintf(stderr, " - Requests of functions already pending: %zu\n", queue_stats.num_duplicates);
+    fprintf(stderr, " - Functions instantiated: %zu\n", queue_stats.num_processed);
+    fprintf(stderr, " - Rounds: %zu\n", queue_stats.num_rounds);
+    fprintf(stderr, " - Peak of functions pending: %zu\n", queue_stats.peak_pending);
+
+    // -- Constexpr evaluation
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Constexpr evaluation\n");
+    fprintf(stderr, "--------------------\n");
+    fprintf(stderr, "\n");
+
+    constexpr_evaluation_stats_t constexpr_stats;
+    constexpr_evaluation_get_stats(&constexpr_stats);
+
+    fprintf(stderr, " - Calls found in the table: %zu\n", constexpr_stats.num_hits);
+    fprintf(stderr, " - Calls evaluated: %zu\n", constexpr_stats.num_misses);
+    fprintf(stderr, " - Values not kept because the table was full: %zu\n", constexpr_stats.num_not_inserted);
+    fprintf(stderr, " - Peak of values kept: %zu\n", constexpr_stats.peak_entries);
+
+    // -- Implicit conversion sequences
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Implicit conversion sequences\n");
+    fprintf(stderr, "-----------------------------\n");
+    fprintf(stderr, "\n");
+
+    ics_cache_stats_t ics_stats;
+    overload_get_ics_cache_stats(&ics_stats);
+
+    fprintf(stderr, " - Sequences found in the cache: %zu\n", ics_stats.num_hits);
+    fprintf(stderr, " - Sequences computed: %zu\n", ics_stats.num_misses);
+    fprintf(stderr, " - Sequences computed again after a type was completed: %zu\n", ics_stats.num_invalidated);
+    fprintf(stderr, " - Peak of sequences cached: %zu\n", ics_stats.peak_entries);
+
+    // -- Type equivalence
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Type equivalence\n");
+    fprintf(stderr, "----------------\n");
+    fprintf(stderr, "\n");
+
+    type_equivalence_stats_t equivalence_stats;
+    type_get_equivalence_stats(&equivalence_stats);
+
+    fprintf(stderr, " - Types told apart by their hash: %zu\n", equivalence_stats.num_different_hash);
+    fprintf(stderr, " - Types found in the same class: %zu\n", equivalence_stats.num_same_class);
+    fprintf(stderr, " - Types compared structurally: %zu\n", equivalence_stats.num_structural);
+    fprintf(stderr, " - Comparisons of unhashed types: %zu\n", equivalence_stats.num_unhashed);
+
+    // -- Function, braced list and sequence types
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Tables of function, braced list and sequence types\n");
+    fprintf(stderr, "--------------------------------------------------\n");
+    fprintf(stderr, "\n");
+
+    type_trie_stats_t trie_stats;
+    type_trie_get_stats(&trie_stats);
+
+    fprintf(stderr, " - Lookups: %zu\n", trie_stats.num_lookups);
+    fprintf(stderr, " - Lookups that found the type: %zu\n", trie_stats.num_hits);
+    fprintf(stderr, " - Inserts: %zu\n", trie_stats.num_inserts);
+    fprintf(stderr, " - Entries probed: %zu\n", trie_stats.num_probes);
+
+    // -- Ambiguities
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Ambiguities\n");
+    fprintf(stderr, "-----------\n");
+    fprintf(stderr, "\n");
+
+    ambiguity_stats_t ambig_stats;
+    ambiguity_get_stats(&ambig_stats);
+
+    fprintf(stderr, " - Expressions remembered: %zu\n", ambig_stats.num_expressions_recorded);
+    fprintf(stderr, " - Expressions not checked again: %zu\n", ambig_stats.num_expressions_reused);
+    fprintf(stderr, " - Symbols of discarded interpretations removed: %zu\n", ambig_stats.num_symbols_rolled_back);
+
     fprintf(stderr, "\n");
 }
 
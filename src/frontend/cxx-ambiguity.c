@@ -50,6 +50,193 @@
  *
  */
 
+// Expressions successfully checked, without diagnostics, while solving an
+// ambiguity. Interpretations share subtrees and the chosen interpretation is
+// checked again once solved, so these are reused instead of checked again
+typedef struct checked_expression_tag checked_expression_t;
+typedef struct checked_interpretation_tag checked_interpretation_t;
+struct checked_expression_tag
+{
+    const decl_context_t* decl_context;
+    int flags;
+
+    // To tell apart a node reallocated at the same address
+    node_t kind;
+    const locus_t* locus;
+
+    nodecl_t nodecl;
+
+    // Interpretation being checked when this expression was recorded, NULL
+    // once all the enclosing interpretations have been chosen
+    checked_interpretation_t* interpretation;
+    // The interpretation was not chosen, nodecl may refer to symbols that
+    // have been removed
+    char discarded;
+
+    checked_expression_t* next;
+};
+
+static dhash_ptr_t* checked_expressions = NULL;
+
+// An expression recorded while checking an interpretation can only be reused
+// within that interpretation until it is chosen
+struct checked_interpretation_tag
+{
+    int num_checked;
+    checked_expression_t** checked;
+
+    checked_interpretation_t* enclosing;
+};
+
+static checked_interpretation_t* current_interpretation = NULL;
+
+static void checked_interpretation_begin(checked_interpretation_t* interpretation)
+{
+    memset(interpretation, 0, sizeof(*interpretation));
+    interpretation->enclosing = current_interpretation;
+    current_interpretation = interpretation;
+}
+
+static void checked_interpretation_end(checked_interpretation_t* interpretation)
+{
+    ERROR_CONDITION(interpretation != current_interpretation,
+            "Interpretation is not the innermost one", 0);
+    current_interpretation = interpretation->enclosing;
+}
+
+static void checked_interpretation_commit(checked_interpretation_t* interpretation)
+{
+    checked_interpretation_t* enclosing = interpretation->enclosing;
+
+    int i;
+    for (i = 0; i < interpretation->num_checked; i++)
+    {
+        checked_expression_t* checked = interpretation->checked[i];
+        checked->interpretation = enclosing;
+        if (enclosing != NULL)
+        {
+            P_LIST_ADD(enclosing->checked, enclosing->num_checked, checked);
+        }
+    }
+    DELETE(interpretation->checked);
+}
+
+static void checked_interpretation_discard(checked_interpretation_t* interpretation)
+{
+    int i;
+    for (i = 0; i < interpretation->num_checked; i++)
+    {
+        checked_expression_t* checked = interpretation->checked[i];
+        checked->discarded = 1;
+        nodecl_free(checked->nodecl);
+        checked->nodecl = nodecl_null();
+    }
+    DELETE(interpretation->checked);
+}
+
+static char checked_expression_is_visible(checked_expression_t* checked)
+{
+    if (checked->discarded)
+        return 0;
+
+    checked_interpretation_t* it = current_interpretation;
+    while (it != checked->interpretation
+            && it != NULL)
+    {
+        it = it->enclosing;
+    }
+
+    return it == checked->interpretation;
+}
+
+// Number of ambiguities currently being solved
+static int ambiguity_nesting = 0;
+
+static ambiguity_stats_t ambiguity_stats;
+
+void ambiguity_get_stats(ambiguity_stats_t* stats)
+{
+    *stats = ambiguity_stats;
+}
+
+static void free_checked_expressions(const char* key UNUSED_PARAMETER, void* info,
+        void* walk_info UNUSED_PARAMETER)
+{
+    checked_expression_t* it = (checked_expression_t*)info;
+    while (it != NULL)
+    {
+        checked_expression_t* next = it->next;
+        nodecl_free(it->nodecl);
+        DELETE(it);
+        it = next;
+    }
+}
+
+static void clear_checked_expressions(void)
+{
+    if (checked_expressions == NULL)
+        return;
+
+    dhash_ptr_walk(checked_expressions, free_checked_expressions, NULL);
+    dhash_ptr_destroy(checked_expressions);
+    checked_expressions = NULL;
+}
+
+char ambiguity_query_checked_expression(AST expression,
+        const decl_context_t* decl_context,
+        int flags,
+        nodecl_t* nodecl_output)
+{
+    if (checked_expressions == NULL)
+        return 0;
+
+    checked_expression_t* it;
+    for (it = (checked_expression_t*)dhash_ptr_query(checked_expressions, (const char*)expression);
+            it != NULL;
+            it = it->next)
+    {
+        if (it->decl_context == decl_context
+                && it->flags == flags
+                && it->kind == ASTKind(expression)
+                && it->locus == ast_get_locus(expression)
+                && checked_expression_is_visible(it))
+        {
+            ambiguity_stats.num_expressions_reused++;
+            *nodecl_output = nodecl_shallow_copy(it->nodecl);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void ambiguity_record_checked_expression(AST expression,
+        const decl_context_t* decl_context,
+        int flags,
+        nodecl_t nodecl)
+{
+    if (current_interpretation == NULL)
+        return;
+
+    if (checked_expressions == NULL)
+        checked_expressions = dhash_ptr_new(5);
+
+    checked_expression_t* new_checked = NEW0(checked_expression_t);
+    new_checked->decl_context = decl_context;
+    new_checked->flags = flags;
+    new_checked->kind = ASTKind(expression);
+    new_checked->locus = ast_get_locus(expression);
+    new_checked->nodecl = nodecl_shallow_copy(nodecl);
+    new_checked->interpretation = current_interpretation;
+    new_checked->next = (checked_expression_t*)dhash_ptr_query(checked_expressions,
+            (const char*)expression);
+
+    dhash_ptr_insert(checked_expressions, (const char*)expression, new_checked);
+    P_LIST_ADD(current_interpretation->checked, current_interpretation->num_checked, new_checked);
+
+    ambiguity_stats.num_expressions_recorded++;
+}
+
 // Generic routines
 void solve_ambiguity_generic(AST a, const decl_context_t* decl_context, void *info,
         ambiguity_check_intepretation_fun_t* ambiguity_check_intepretation,
@@ -59,11 +246,24 @@ void solve_ambiguity_generic(AST a, const decl_context_t* decl_context, void *in
 {
     ERROR_CONDITION(ASTKind(a) != AST_AMBIGUITY, "Tree is not an ambiguity", 0);
 
+    // What was remembered for the previous ambiguities is not needed anymore
+    if (ambiguity_nesting == 0)
+        clear_checked_expressions();
+    ambiguity_nesting++;
+
     int valid_option = -1;
 
     int i, n = ast_get_num_ambiguities(a);
 
     diagnostic_context_t* ambig_diag[n + 1];
+    // Expressions checked by every interpretation
+    checked_interpretation_t ambig_checked[n + 1];
+    // Symbols declared in the block by every interpretation. They are removed
+    // once the interpretation has been checked, so the following ones do not
+    // find them
+    scope_journal_t* ambig_journal[n + 1];
+    char use_journal = (decl_context->current_scope != NULL
+            && decl_context->current_scope->kind == BLOCK_SCOPE);
 
     for (i = 0; i < n; i++)
     {
@@ -71,9 +271,18 @@ void solve_ambiguity_generic(AST a, const decl_context_t* decl_context, void *in
 
         ast_fix_parents_inside_intepretation(current_interpretation);
 
+        ambig_journal[i] = NULL;
+        if (use_journal)
+            ambig_journal[i] = scope_journal_begin(decl_context->current_scope);
+
+        checked_interpretation_begin(&ambig_checked[i]);
         ambig_diag[i] = diagnostic_context_push_buffered();
         char c = ambiguity_check_intepretation(current_interpretation, decl_context, i, info);
         diagnostic_context_pop();
+        checked_interpretation_end(&ambig_checked[i]);
+
+        if (use_journal)
+            scope_journal_end(ambig_journal[i]);
 
         if (c)
         {
@@ -172,6 +381,25 @@ void solve_ambiguity_generic(AST a, const decl_context_t* decl_context, void *in
         }
     }
 
+    // Keep only the symbols and the expressions of the chosen interpretation
+    for (i = 0; i < n; i++)
+    {
+        if (i == valid_option)
+        {
+            if (use_journal)
+                scope_journal_commit(ambig_journal[i]);
+            checked_interpretation_commit(&ambig_checked[i]);
+        }
+        else
+        {
+            if (use_journal)
+                ambiguity_stats.num_symbols_rolled_back += scope_journal_rollback(ambig_journal[i]);
+            checked_interpretation_discard(&ambig_checked[i]);
+        }
+    }
+
+    ambiguity_nesting--;
+
     ast_replace_with_ambiguity(a, valid_option);
 }
 
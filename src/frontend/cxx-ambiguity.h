@@ -36,6 +36,8 @@
 #include "cxx-asttype.h"
 #include "cxx-scope-decls.h"
 #include "cxx-buildscope-decls.h"
+#include "cxx-nodecl-decls.h"
+#include <stddef.h>
 
 MCXX_BEGIN_DECLS
 
@@ -83,6 +85,30 @@ LIBMCXX_EXTERN char solve_ambiguous_list_of_initializer_clauses(AST ambiguous_li
 
 LIBMCXX_EXTERN int either_type(AST t1, AST t2, node_t n1, node_t n2);
 
+// Expressions checked while solving ambiguities. flags identify the
+// conditions in which the expression was checked
+LIBMCXX_EXTERN char ambiguity_query_checked_expression(AST expression,
+        const decl_context_t* decl_context,
+        int flags,
+        nodecl_t* nodecl_output);
+LIBMCXX_EXTERN void ambiguity_record_checked_expression(AST expression,
+        const decl_context_t* decl_context,
+        int flags,
+        nodecl_t nodecl);
+
+typedef
+struct ambiguity_stats_tag
+{
+    // Expressions remembered while solving ambiguities
+    size_t num_expressions_recorded;
+    // Expressions not checked again because they had been remembered
+    size_t num_expressions_reused;
+    // Symbols removed from the scope because their interpretation was discarded
+    size_t num_symbols_rolled_back;
+} ambiguity_stats_t;
+
+LIBMCXX_EXTERN void ambiguity_get_stats(ambiguity_stats_t* stats);
+
 // Used by the driver for a final test
 LIBMCXX_EXTERN AST find_ambiguity(AST a);
 
@@ -0,0 +1,238 @@
+/*--------------------------------------------------------------------
+  (C) Copyright 2006-2014 Barcelona Supercomputing Center
+                          Centro Nacional de Supercomputacion
+  
+  This file is part of Mercurium C/C++ source-to-source compiler.
+  
+  See AUTHORS file in the top level directory for information
+  regarding developers and contributors.
+  
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3 of the License, or (at your option) any later version.
+  
+  Mercurium C/C++ source-to-source compiler is distributed in the hope
+  that it will be useful, but WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+  PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public
+  License along with Mercurium C/C++ source-to-source compiler; if
+  not, write to the Free Software Foundation, Inc., 675 Mass Ave,
+  Cambridge, MA 02139, USA.
+--------------------------------------------------------------------*/
+
+
+
+
+
+#include <stdint.h>
+#include <stdlib.h>
+#if defined(WIN32_BUILD) && !defined(__CYGWIN__)
+  #include <malloc.h>
+#endif
+
+#include "cxx-ast.h"
+#include "cxx-ast-arena.h"
+#include "cxx-utils.h"
+#include "cxx-process.h"
+
+// Chunks are big enough so a chunk is rarely requested. They are aligned to
+// their size so the chunk (and region) of a node can be found from its address
+enum { AST_ARENA_CHUNK_SIZE = 1024 * 1024 };
+
+typedef
+struct ast_arena_chunk_tag
+{
+    struct ast_arena_chunk_tag* next;
+    ast_arena_region_t* region;
+    // Keeps data aligned for any AST allocation
+    union
+    {
+        void* p;
+        intptr_t i;
+        double d;
+    } data[];
+} ast_arena_chunk_t;
+
+// Free list of nodes
+typedef
+struct ast_arena_free_item_tag
+{
+    struct ast_arena_free_item_tag* next;
+} ast_arena_free_item_t;
+
+struct ast_arena_region_tag
+{
+    ast_arena_chunk_t* chunks;
+    char* current;
+    char* end;
+
+    // Nodes freed are only reused by the region they belong to
+    ast_arena_free_item_t* free_list;
+
+    size_t num_chunks;
+    size_t bytes_used;
+    size_t num_nodes_live;
+};
+
+static ast_arena_region_t persistent_region;
+static ast_arena_region_t* current_region = &persistent_region;
+
+static ast_arena_stats_t arena_stats;
+
+#define ARENA_ALIGNMENT (sizeof(void*))
+#define ARENA_ROUND_UP(x) (((x) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1))
+
+static ast_arena_chunk_t* ast_arena_chunk_allocate(void)
+{
+    void* p = NULL;
+#if !defined(WIN32_BUILD) || defined(__CYGWIN__)
+    if (posix_memalign(&p, AST_ARENA_CHUNK_SIZE, AST_ARENA_CHUNK_SIZE) != 0)
+        p = NULL;
+#else
+    p = _aligned_malloc(AST_ARENA_CHUNK_SIZE, AST_ARENA_CHUNK_SIZE);
+#endif
+    if (p == NULL)
+    {
+        fatal_error("Cannot allocate a chunk of %d bytes for AST nodes\n",
+                AST_ARENA_CHUNK_SIZE);
+    }
+    return (ast_arena_chunk_t*)p;
+}
+
+static void ast_arena_chunk_free(ast_arena_chunk_t* chunk)
+{
+#if !defined(WIN32_BUILD) || defined(__CYGWIN__)
+    c_free(chunk);
+#else
+    _aligned_free(chunk);
+#endif
+}
+
+static inline ast_arena_chunk_t* ast_arena_chunk_of(void* p)
+{
+    return (ast_arena_chunk_t*)((uintptr_t)p & ~(uintptr_t)(AST_ARENA_CHUNK_SIZE - 1));
+}
+
+static void ast_arena_new_chunk(ast_arena_region_t* region)
+{
+    ast_arena_chunk_t* chunk = ast_arena_chunk_allocate();
+    chunk->next = region->chunks;
+    chunk->region = region;
+    region->chunks = chunk;
+    region->num_chunks++;
+
+    region->current = (char*)chunk->data;
+    region->end = (char*)chunk + AST_ARENA_CHUNK_SIZE;
+
+    arena_stats.num_chunks++;
+    arena_stats.bytes_reserved += AST_ARENA_CHUNK_SIZE;
+    if (arena_stats.bytes_reserved > arena_stats.peak_bytes_reserved)
+        arena_stats.peak_bytes_reserved = arena_stats.bytes_reserved;
+}
+
+static inline void* ast_arena_allocate(ast_arena_region_t* region, size_t size)
+{
+    ast_arena_free_item_t* item = region->free_list;
+    if (item != NULL)
+    {
+        region->free_list = item->next;
+        return item;
+    }
+
+    size = ARENA_ROUND_UP(size);
+    if (__builtin_expect((size_t)(region->end - region->current) < size, 0))
+    {
+        ast_arena_new_chunk(region);
+    }
+
+    void* result = region->current;
+    region->current += size;
+    region->bytes_used += size;
+    arena_stats.bytes_used += size;
+
+    return result;
+}
+
+static inline void ast_arena_deallocate(ast_arena_region_t* region, void* p)
+{
+    ast_arena_free_item_t* item = (ast_arena_free_item_t*)p;
+    item->next = region->free_list;
+    region->free_list = item;
+}
+
+AST ast_arena_new_node(int num_children)
+{
+    ERROR_CONDITION(num_children < 0 || num_children > MCXX_MAX_AST_CHILDREN,
+            "Invalid number of children %d", num_children);
+
+    if (current_region->free_list != NULL)
+        arena_stats.num_nodes_reused++;
+
+    arena_stats.num_nodes_allocated++;
+    arena_stats.num_nodes_live++;
+    arena_stats.num_nodes_by_children[num_children]++;
+    current_region->num_nodes_live++;
+
+    return (AST)ast_arena_allocate(current_region, sizeof(AST_node_t));
+}
+
+void ast_arena_free_node(AST a)
+{
+    if (a == NULL)
+        return;
+
+    ast_arena_region_t* region = ast_arena_chunk_of(a)->region;
+
+    arena_stats.num_nodes_live--;
+    region->num_nodes_live--;
+    ast_arena_deallocate(region, a);
+}
+
+ast_arena_region_t* ast_arena_region_new(void)
+{
+    return NEW0(ast_arena_region_t);
+}
+
+ast_arena_region_t* ast_arena_persistent_region(void)
+{
+    return &persistent_region;
+}
+
+ast_arena_region_t* ast_arena_set_current_region(ast_arena_region_t* region)
+{
+    ERROR_CONDITION(region == NULL, "Invalid region", 0);
+
+    ast_arena_region_t* previous = current_region;
+    current_region = region;
+    return previous;
+}
+
+void ast_arena_region_release(ast_arena_region_t* region)
+{
+    ERROR_CONDITION(region == &persistent_region, "The persistent region cannot be released", 0);
+    ERROR_CONDITION(region == current_region, "The current region cannot be released", 0);
+
+    ast_arena_chunk_t* chunk = region->chunks;
+    while (chunk != NULL)
+    {
+        ast_arena_chunk_t* next = chunk->next;
+        ast_arena_chunk_free(chunk);
+        chunk = next;
+    }
+
+    arena_stats.num_chunks -= region->num_chunks;
+    arena_stats.bytes_reserved -= region->num_chunks * AST_ARENA_CHUNK_SIZE;
+    arena_stats.bytes_used -= region->bytes_used;
+    arena_stats.num_nodes_live -= region->num_nodes_live;
+
+    DELETE(region);
+}
+
+void ast_arena_get_stats(ast_arena_stats_t* stats)
+{
+    *stats = arena_stats;
+}
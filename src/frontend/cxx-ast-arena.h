@@ -0,0 +1,97 @@
+/*--------------------------------------------------------------------
+  (C) Copyright 2006-2014 Barcelona Supercomputing Center
+                          Centro Nacional de Supercomputacion
+  
+  This file is part of Mercurium C/C++ source-to-source compiler.
+  
+  See AUTHORS file in the top level directory for information
+  regarding developers and contributors.
+  
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3 of the License, or (at your option) any later version.
+  
+  Mercurium C/C++ source-to-source compiler is distributed in the hope
+  that it will be useful, but WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+  PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public
+  License along with Mercurium C/C++ source-to-source compiler; if
+  not, write to the Free Software Foundation, Inc., 675 Mass Ave,
+  Cambridge, MA 02139, USA.
+--------------------------------------------------------------------*/
+
+
+
+
+
+#ifndef CXX_AST_ARENA_H
+#define CXX_AST_ARENA_H
+
+#include "libmcxx-common.h"
+#include "cxx-macros.h"
+#include "cxx-ast-decls.h"
+#include "cxx-limits.h"
+#include <stddef.h>
+
+MCXX_BEGIN_DECLS
+
+/*
+ * Region allocator for AST nodes
+ *
+ * Nodes are carved out of big chunks by bumping a pointer. Chunks belong to a
+ * region and a region gives back all its chunks at once, so a tree can be
+ * discarded without walking it. Freed nodes are kept in a free list of their
+ * region and reused by later allocations in that region.
+ *
+ * Nodes are allocated in the current region. The driver makes a new region
+ * current for every translation unit and releases it once the translation
+ * unit is done. Trees kept in process-wide caches, which outlive the
+ * translation unit, must be allocated in the persistent region instead.
+ */
+
+typedef struct ast_arena_region_tag ast_arena_region_t;
+
+// Returns a new uninitialized node. num_children is the number of children
+// the node is created with and it is only used for statistics
+LIBMCXX_EXTERN AST ast_arena_new_node(int num_children);
+// Returns a node to its region
+LIBMCXX_EXTERN void ast_arena_free_node(AST a);
+
+// Returns a new empty region
+LIBMCXX_EXTERN ast_arena_region_t* ast_arena_region_new(void);
+// The region current when the process starts. It is never released
+LIBMCXX_EXTERN ast_arena_region_t* ast_arena_persistent_region(void);
+// Makes region current and returns the region that was current
+LIBMCXX_EXTERN ast_arena_region_t* ast_arena_set_current_region(ast_arena_region_t* region);
+// Releases every chunk of region, which cannot be the current one. Every AST
+// allocated in it becomes invalid
+LIBMCXX_EXTERN void ast_arena_region_release(ast_arena_region_t* region);
+
+typedef
+struct ast_arena_stats_tag
+{
+    // Chunks currently held by the arena
+    size_t num_chunks;
+    size_t bytes_reserved;
+    // Bytes handed out by bumping (including those in free lists)
+    size_t bytes_used;
+    // Largest bytes_reserved ever seen
+    size_t peak_bytes_reserved;
+
+    size_t num_nodes_allocated;
+    size_t num_nodes_reused;
+    size_t num_nodes_live;
+
+    // Nodes allocated indexed by the number of children at creation
+    size_t num_nodes_by_children[MCXX_MAX_AST_CHILDREN + 1];
+} ast_arena_stats_t;
+
+LIBMCXX_EXTERN void ast_arena_get_stats(ast_arena_stats_t* stats);
+
+MCXX_END_DECLS
+
+#endif // CXX_AST_ARENA_H
@@ -30,6 +30,7 @@
 
 #include "mem.h"
 #include "cxx-process.h"
+#include "cxx-ast-arena.h"
 #include <stdint.h>
 
 MCXX_BEGIN_DECLS
@@ -44,8 +45,16 @@ struct AST_tag
     // This is a bitmap for the sons
     unsigned int bitmap_sons:MCXX_MAX_AST_CHILDREN;
 
-    // Number of ambiguities of this node
-    int num_ambig;
+    // structural_hash holds the structural hash of this nodecl tree
+    unsigned int has_structural_hash:1;
+
+    union
+    {
+        // Number of ambiguities of this node (only for AST_AMBIGUITY)
+        int num_ambig;
+        // See nodecl_get_structural_hash
+        unsigned int structural_hash;
+    };
 
     // Parent node
     struct AST_tag* parent;
@@ -59,8 +68,10 @@ struct AST_tag
 
     union
     {
-        // The children of this tree (except for AST_AMBIGUITY)
-        struct AST_tag** children;
+        // The children of this tree (except for AST_AMBIGUITY). They are
+        // stored inline and indexed by their position, absent children are
+        // NULL and have their bit cleared in bitmap_sons
+        struct AST_tag* children[MCXX_MAX_AST_CHILDREN];
         // When type == AST_AMBIGUITY, all intepretations are here
         struct AST_tag** ambig;
     };
@@ -100,34 +111,23 @@ static inline void ast_set_text(AST a, const char* str)
     a->text = str;
 }
 
-static inline void ast_set_kind(AST a, node_t node_type)
-{
-    a->node_type = node_type;
-}
-
-static inline int ast_bitmap_to_index(unsigned int bitmap, int num)
+// Structural hashes cached in the tree are not valid anymore once a node
+// changes. A node only caches its hash after the nodes it depends on, so
+// the walk can stop at the first ancestor without a cached hash
+static inline void ast_invalidate_structural_hash(AST a)
 {
-    ERROR_CONDITION(((1 << num) & bitmap) == 0,
-            "Invalid bitmap!", 0);
-#if HAVE__BUILTIN_POPCOUNT
-    bitmap = bitmap & (~(~0U << num));
-    return __builtin_popcount(bitmap);
-#else
-    int i;
-    int s = 0;
-    for (i = 0; i < num; i++)
+    while (a != NULL
+            && a->has_structural_hash)
     {
-        s += bitmap & 1;
-        bitmap = bitmap >> 1;
+        a->has_structural_hash = 0;
+        a = a->parent;
     }
-
-    return s;
-#endif
 }
 
-ALWAYS_INLINE static inline int ast_son_num_to_son_index(const_AST a, int num_son)
+static inline void ast_set_kind(AST a, node_t node_type)
 {
-    return ast_bitmap_to_index(a->bitmap_sons, num_son);
+    ast_invalidate_structural_hash(a);
+    a->node_type = node_type;
 }
 
 ALWAYS_INLINE static inline char ast_has_son(const_AST a, int son)
@@ -139,7 +139,7 @@ ALWAYS_INLINE static inline AST ast_get_child(const_AST a, int num_child)
 {
     if (ast_has_son(a, num_child))
     {
-        return a->children[ast_son_num_to_son_index(a, num_child)];
+        return a->children[num_child];
     }
     else
     {
@@ -173,37 +173,29 @@ static inline AST ast_make(node_t type, int __num_children UNUSED_PARAMETER,
         AST child0, AST child1, AST child2, AST child3, 
         const locus_t* location, const char *text)
 {
-    AST result = NEW(AST_node_t);
+    unsigned int bitmap_sons =
+        (!!child0)
+        | (!!child1 << 1)
+        | (!!child2 << 2)
+        | (!!child3 << 3);
+
+    AST result = ast_arena_new_node(ast_count_bitmap(bitmap_sons));
     // ERROR_CONDITION(result & 0x1 != 0, "Invalid pointer for AST", 0);
 
     result->node_type = type;
-
-    int num_children = 0;
-    unsigned int bitmap_sons = 0;
-
     result->bitmap_sons = bitmap_sons;
+    result->has_structural_hash = 0;
+    result->num_ambig = 0;
     result->parent = NULL;
     result->locus = location;
 
     result->text = text;
 
-    bitmap_sons =
-        (!!child0)
-        | (!!child1 << 1)
-        | (!!child2 << 2)
-        | (!!child3 << 3);
-    num_children = ast_count_bitmap(bitmap_sons);
-
-    result->bitmap_sons = bitmap_sons;
-    result->children = NEW_VEC(AST, num_children);
-
-    int idx = 0;
 #define ADD_SON(n) \
+    result->children[n] = child##n; \
     if (child##n != NULL) \
     { \
-        result->children[idx] = child##n; \
         child##n->parent = result; \
-        idx++; \
     }
 
     ADD_SON(0);
@@ -217,16 +209,12 @@ static inline AST ast_make(node_t type, int __num_children UNUSED_PARAMETER,
     return result;
 }
 
-// This function works both for shrinking or widening
-static inline void ast_reallocate_children(AST a, int num_child, AST new_child)
+static inline void ast_set_child_but_parent(AST a, int num_child, AST new_child)
 {
-    // Reallocate childrens
-    // Save the old children array
-    AST* old_children = a->children;
-    // And the old children bitmap
-    unsigned int old_bitmap = a->bitmap_sons;
-
-    // Enable or disable this new son depending on it being null
+    ast_invalidate_structural_hash(a);
+    // Children are stored inline so neither widening nor shrinking the node
+    // requires moving the remaining children
+    a->children[num_child] = new_child;
     if (new_child != NULL)
     {
         a->bitmap_sons = (a->bitmap_sons | (1 << num_child));
@@ -235,58 +223,6 @@ static inline void ast_reallocate_children(AST a, int num_child, AST new_child)
     {
         a->bitmap_sons = (a->bitmap_sons & (~(1 << num_child)));
     }
-
-    a->children = NEW_VEC(AST, ast_count_bitmap(a->bitmap_sons));
-
-    // Now for every old son, update the new children
-    int i;
-    for (i = 0; i < MCXX_MAX_AST_CHILDREN; i++)
-    {
-        // Note that when shrinking the node ast_has_son
-        // will always return false for num_child.
-        if (ast_has_son(a, i))
-        {
-            if (i == num_child)
-            {
-                // The new son
-                a->children[ast_son_num_to_son_index(a, i)] = new_child;
-            }
-            else
-            {
-                // Old sons that are updated their position
-                a->children[ast_son_num_to_son_index(a, i)] = 
-                    old_children[ast_bitmap_to_index(old_bitmap, i)];
-            }
-        }
-    }
-
-    // Now DELETE the old children (if any)
-    if (old_children != NULL)
-        DELETE(old_children);
-}
-
-static inline void ast_set_child_but_parent(AST a, int num_child, AST new_child)
-{
-    if (new_child == NULL)
-    {
-        if (ast_has_son(a, num_child))
-        {
-            // Shrink the node if we have it
-            ast_reallocate_children(a, num_child, new_child);
-        }
-    }
-    else
-    {
-        if (ast_has_son(a, num_child))
-        {
-            a->children[ast_son_num_to_son_index(a, num_child)] = new_child;
-        }
-        else
-        {
-            // This will widen the node
-            ast_reallocate_children(a, num_child, new_child);
-        }
-    }
 }
 
 static inline void ast_set_child(AST a, int num_child, AST new_child)
@@ -455,7 +391,9 @@ static inline AST ast_make_ambiguous(AST son0, AST son1)
 
 static inline void ast_replace(AST dest, const_AST src)
 {
+    ast_invalidate_structural_hash(dest);
     *dest = *src;
+    dest->has_structural_hash = 0;
 }
 
 static inline void ast_free(AST a)
@@ -490,10 +428,14 @@ static inline void ast_free(AST a)
     }
 
     DELETE(a->expr_info);
-    DELETE(a->children);
+    if (ast_get_kind(a) == AST_AMBIGUITY)
+    {
+        // Interpretations are not allocated in the arena
+        DELETE(a->ambig);
+    }
     // Clear the node for safety
     // __builtin_memset(a, 0, sizeof(*a));
-    DELETE(a);
+    ast_arena_free_node(a);
 }
 
 static inline void ast_replace_with_ambiguity(AST a, int n)
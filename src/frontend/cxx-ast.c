@@ -218,7 +218,8 @@ static void ast_copy_one_node(AST dest, AST orig)
 {
     *dest = *orig;
     dest->bitmap_sons = 0;
-    dest->children = 0;
+    dest->has_structural_hash = 0;
+    memset(dest->children, 0, sizeof(dest->children));
 }
 
 AST ast_duplicate_one_node(AST orig)
@@ -234,7 +235,7 @@ AST ast_copy(const_AST a)
     if (a == NULL)
         return NULL;
 
-    AST result = NEW0(AST_node_t);
+    AST result = ast_arena_new_node(ast_num_children(a));
 
     ast_copy_one_node(result, (AST)a);
 
@@ -251,11 +252,6 @@ AST ast_copy(const_AST a)
     }
     else
     {
-        result->bitmap_sons = a->bitmap_sons;
-        int num_children = ast_count_bitmap(result->bitmap_sons);
-
-        result->children = NEW_VEC(AST, num_children);
-
         for (i = 0; i < MCXX_MAX_AST_CHILDREN; i++)
         {
             AST c = ast_copy(ast_get_child(a, i));
@@ -62,6 +62,7 @@
 #include "cxx-koenig.h"
 #include "cxx-codegen.h"
 #include "cxx-placeholders.h"
+#include "cxx-phaseprofile.h"
 #include "cxx-driver-utils.h"
 
 #ifdef EXTRAE_ENABLED
@@ -555,6 +556,9 @@ static void build_scope_translation_unit_pre(translation_unit_t* translation_uni
     CXX_LANGUAGE()
     {
         instantiation_init();
+        overload_init();
+        constexpr_evaluation_init(compilation_process.constexpr_cache_size,
+                compilation_process.constexpr_steps);
     }
 #ifdef EXTRAE_ENABLED
     extrae_declaration_locus_value_set = dhash_ptr_new(5);
@@ -615,9 +619,13 @@ nodecl_t build_scope_translation_unit(translation_unit_t* translation_unit)
     AST list = ASTSon0(a);
     if (list != NULL)
     {
+        phase_profile_start("declarations");
         build_scope_declaration_sequence(list, decl_context, &nodecl);
+        phase_profile_end("declarations");
     }
+    phase_profile_start("pending instantiations");
     build_scope_translation_unit_post(translation_unit, &nodecl);
+    phase_profile_end("pending instantiations");
 
     return nodecl;
 }
@@ -4044,6 +4052,7 @@ static void gather_type_spec_from_friend_elaborated_class_specifier_common(
         // going to change its type
         scope_entry_t* new_dep = NEW0(scope_entry_t);
         *new_dep = *entry;
+        symbol_entity_specs_share_sparse(new_dep);
         new_dep->type_information = set_dependent_entry_kind(entry->type_information, class_kind);
         new_dep->decl_context = decl_context;
 
@@ -4865,6 +4874,7 @@ static void gather_type_spec_from_elaborated_class_specifier(AST a,
                 scope_entry_t* old_entry = entry;
                 entry = NEW0(scope_entry_t);
                 *entry = *old_entry;
+                symbol_entity_specs_share_sparse(entry);
 
                 keep_extra_attributes_in_symbol(entry, &class_gather_info);
             }
@@ -10364,6 +10374,7 @@ void gather_type_spec_from_class_specifier(AST a, type_t** type_info,
                     class_entry->symbol_name);
 
             *injected_symbol = *class_entry;
+            symbol_entity_specs_share_sparse(injected_symbol);
             // the injected class name is logically in the class-scope
             injected_symbol->decl_context = inner_decl_context;
             injected_symbol->do_not_print = 1;
@@ -10633,6 +10644,7 @@ static template_parameter_list_t* hide_template_parameters_because_of_members(
             // Make a clone here
             new_tpl->entry = NEW0(scope_entry_t);
             *new_tpl->entry = *current_tpl->entry;
+            symbol_entity_specs_share_sparse(new_tpl->entry);
             symbol_entity_specs_copy_from(new_tpl->entry, current_tpl->entry);
             uniquestr_sprintf(&new_tpl->entry->symbol_name, "__hidden_tpl__param_%d_%d__",
                     symbol_entity_specs_get_template_parameter_nesting(current_tpl->entry),
@@ -45,6 +45,7 @@
 #include "cxx-exprtype.h"
 #include "cxx-cexpr.h"
 #include "cxx-ast.h"
+#include "cxx-ast-arena.h"
 #include "cxx-utils.h"
 #include "cxx-prettyprint.h"
 #include "cxx-ambiguity.h"
@@ -1739,10 +1740,21 @@ nodecl_t const_value_to_nodecl_with_basic_type(const_value_t* v,
     return const_value_to_nodecl_(v, basic_type, /* cached */ 0);
 }
 
+// Cached trees are shared by every translation unit
+static nodecl_t const_value_to_nodecl_persistent(const_value_t* v,
+        type_t* basic_type)
+{
+    ast_arena_region_t* region = ast_arena_set_current_region(ast_arena_persistent_region());
+    nodecl_t result = const_value_to_nodecl_(v, basic_type, /* cached */ 1);
+    ast_arena_set_current_region(region);
+
+    return result;
+}
+
 nodecl_t const_value_to_nodecl_with_basic_type_cached(const_value_t* v, 
         type_t* basic_type)
 {
-    return const_value_to_nodecl_(v, basic_type, /* cached */ 1);
+    return const_value_to_nodecl_persistent(v, basic_type);
 }
 
 nodecl_t const_value_to_nodecl(const_value_t* v)
@@ -1752,7 +1764,7 @@ nodecl_t const_value_to_nodecl(const_value_t* v)
 
 nodecl_t const_value_to_nodecl_cached(const_value_t* v)
 {
-    return const_value_to_nodecl_(v, /* basic_type */ NULL, /* cached */ 1);
+    return const_value_to_nodecl_persistent(v, /* basic_type */ NULL);
 }
 
 char const_value_is_integer(const_value_t* v)
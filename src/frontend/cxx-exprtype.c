@@ -29,6 +29,7 @@
 
 #include "cxx-exprtype.h"
 #include "cxx-ambiguity.h"
+#include "cxx-ast-arena.h"
 #include "cxx-utils.h"
 #include "cxx-typeutils.h"
 #include "cxx-typededuc.h"
@@ -770,8 +771,25 @@ void ensure_function_is_emitted(scope_entry_t* entry,
 
 static char c_check_expression(AST expression, const decl_context_t* decl_context, nodecl_t* nodecl_output)
 {
+    int flags = (check_expr_flags.must_be_constant == MUST_BE_CONSTANT)
+        | (!!check_expr_flags.do_not_call_constexpr << 1)
+        | (!!check_expr_flags.is_non_executable << 2);
+
+    // This expression may have been checked while solving an ambiguity
+    if (ambiguity_query_checked_expression(expression, decl_context, flags, nodecl_output))
+        return 1;
+
+    int num_diagnostics = diagnostics_get_error_count() + diagnostics_get_warn_count();
+
     check_expression_impl_(expression, decl_context, nodecl_output);
     char is_ok = !nodecl_is_err_expr(*nodecl_output);
+
+    if (is_ok
+            && num_diagnostics == diagnostics_get_error_count() + diagnostics_get_warn_count())
+    {
+        ambiguity_record_checked_expression(expression, decl_context, flags, *nodecl_output);
+    }
+
     return is_ok;
 }
 
@@ -4138,6 +4156,18 @@ static const_value_t* const_value_generalized_add(const_value_t* lhs, const_valu
     else return const_value_add(lhs, rhs);
 }
 
+// Operator names are looked up from trees kept in static variables and
+// shared by every translation unit
+static AST make_operator_function_id_tree(node_t operator_kind)
+{
+    ast_arena_region_t* region = ast_arena_set_current_region(ast_arena_persistent_region());
+    AST result = ASTMake1(AST_OPERATOR_FUNCTION_ID,
+            ASTLeaf(operator_kind, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+    ast_arena_set_current_region(region);
+
+    return result;
+}
+
 static
 void compute_bin_operator_add_type(nodecl_t* lhs, nodecl_t* rhs, const decl_context_t* decl_context, 
         const locus_t* locus, nodecl_t* nodecl_output)
@@ -4146,8 +4176,7 @@ void compute_bin_operator_add_type(nodecl_t* lhs, nodecl_t* rhs, const decl_cont
     static AST operation_add_tree = NULL;
     if (operation_add_tree == NULL)
     {
-        operation_add_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_ADD_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_add_tree = make_operator_function_id_tree(AST_ADD_OPERATOR);
     }
 
     compute_bin_operator_generic(
@@ -4199,8 +4228,7 @@ void compute_bin_operator_mul_type(nodecl_t* lhs, nodecl_t* rhs, const decl_cont
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_MUL_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_MUL_OPERATOR);
     }
 
     compute_bin_operator_only_arithmetic_types(lhs, rhs, operation_tree, 
@@ -4271,8 +4299,7 @@ void compute_bin_operator_div_type(nodecl_t* lhs, nodecl_t* rhs, const decl_cont
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_DIV_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_DIV_OPERATOR);
     }
 
     const_value_t* (*const_value_div_safe)(const_value_t*, const_value_t*) = const_value_div;
@@ -4388,8 +4415,7 @@ void compute_bin_operator_mod_type(nodecl_t* lhs, nodecl_t* rhs, const decl_cont
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_MOD_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_MOD_OPERATOR);
     }
 
     compute_bin_operator_only_integer_types(lhs, rhs, operation_tree, decl_context, 
@@ -4600,8 +4626,7 @@ void compute_bin_operator_sub_type(nodecl_t* lhs, nodecl_t* rhs, const decl_cont
     static AST operator = NULL;
     if (operator == NULL)
     {
-        operator = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_MINUS_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operator = make_operator_function_id_tree(AST_MINUS_OPERATOR);
     }
 
     compute_bin_operator_generic(
@@ -4712,8 +4737,7 @@ void compute_bin_operator_bitwise_shl_type(nodecl_t* lhs, nodecl_t* rhs, const d
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_LEFT_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_LEFT_OPERATOR);
     }
 
     compute_bin_operator_only_integral_lhs_type(lhs, rhs, 
@@ -4765,8 +4789,7 @@ void compute_bin_operator_shr_type(nodecl_t* lhs, nodecl_t* rhs, const decl_cont
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_RIGHT_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_RIGHT_OPERATOR);
     }
 
     compute_bin_operator_only_integral_lhs_type(lhs, rhs, 
@@ -5344,8 +5367,7 @@ void compute_bin_operator_lower_equal_type(nodecl_t* lhs, nodecl_t* rhs, const d
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_LESS_OR_EQUAL_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_LESS_OR_EQUAL_OPERATOR);
     }
 
     compute_bin_operator_relational(lhs, rhs, 
@@ -5382,8 +5404,7 @@ void compute_bin_operator_lower_than_type(nodecl_t* lhs, nodecl_t* rhs, const de
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_LOWER_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_LOWER_OPERATOR);
     }
 
     compute_bin_operator_relational(lhs, rhs, 
@@ -5419,8 +5440,7 @@ static void compute_bin_operator_greater_equal_type(nodecl_t* lhs, nodecl_t* rhs
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_GREATER_OR_EQUAL_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_GREATER_OR_EQUAL_OPERATOR);
     }
 
     compute_bin_operator_relational(lhs, rhs, 
@@ -5460,8 +5480,7 @@ static void compute_bin_operator_greater_than_type(nodecl_t* lhs, nodecl_t* rhs,
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_GREATER_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_GREATER_OPERATOR);
     }
 
     compute_bin_operator_relational(lhs, rhs, 
@@ -5502,8 +5521,7 @@ static void compute_bin_operator_different_type(nodecl_t* lhs, nodecl_t* rhs, co
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_DIFFERENT_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_DIFFERENT_OPERATOR);
     }
 
     compute_bin_operator_relational_eq_or_neq(lhs, rhs,
@@ -5539,8 +5557,7 @@ static void compute_bin_operator_equal_type(nodecl_t* lhs, nodecl_t* rhs, const
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_EQUAL_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_EQUAL_OPERATOR);
     }
 
     compute_bin_operator_relational_eq_or_neq(lhs, rhs,
@@ -5666,8 +5683,7 @@ static void compute_bin_operator_logical_or_type(nodecl_t* lhs, nodecl_t* rhs, c
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_LOGICAL_OR_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_LOGICAL_OR_OPERATOR);
     }
 
     compute_bin_logical_op_type(lhs, rhs, 
@@ -5684,8 +5700,7 @@ static void compute_bin_operator_logical_and_type(nodecl_t* lhs, nodecl_t* rhs,
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_LOGICAL_AND_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_LOGICAL_AND_OPERATOR);
     }
 
     compute_bin_logical_op_type(lhs, rhs, 
@@ -5703,8 +5718,7 @@ static void compute_bin_operator_bitwise_and_type(nodecl_t* lhs, nodecl_t* rhs,
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_BITWISE_AND_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_BITWISE_AND_OPERATOR);
     }
 
     compute_bin_operator_only_integer_types(
@@ -5722,8 +5736,7 @@ static void compute_bin_operator_bitwise_or_type(nodecl_t* lhs, nodecl_t* rhs, c
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_BITWISE_OR_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_BITWISE_OR_OPERATOR);
     }
 
     compute_bin_operator_only_integer_types(
@@ -5741,8 +5754,7 @@ static void compute_bin_operator_bitwise_xor_type(nodecl_t* lhs, nodecl_t* rhs,
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_BITWISE_XOR_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_BITWISE_XOR_OPERATOR);
     }
 
     compute_bin_operator_only_integer_types(
@@ -6273,8 +6285,7 @@ static void compute_bin_operator_mod_assig_type(nodecl_t* lhs, nodecl_t* rhs,
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_MOD_ASSIGN_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_MOD_ASSIGN_OPERATOR);
     }
 
     compute_bin_operator_assig_only_integral_type(lhs, rhs, 
@@ -6291,8 +6302,7 @@ static void compute_bin_operator_bitwise_shl_assig_type(nodecl_t* lhs, nodecl_t*
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_LEFT_ASSIGN_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_LEFT_ASSIGN_OPERATOR);
     }
 
     compute_bin_operator_assig_only_integral_type(lhs, rhs, 
@@ -6308,8 +6318,7 @@ static void compute_bin_operator_shr_assig_type(nodecl_t* lhs, nodecl_t* rhs,
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_RIGHT_ASSIGN_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_RIGHT_ASSIGN_OPERATOR);
     }
 
     compute_bin_operator_assig_only_integral_type(lhs, rhs, 
@@ -6326,8 +6335,7 @@ static void compute_bin_operator_bitwise_and_assig_type(nodecl_t* lhs, nodecl_t*
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_BITWISE_AND_ASSIGN_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_BITWISE_AND_ASSIGN_OPERATOR);
     }
 
     compute_bin_operator_assig_only_integral_type(lhs, rhs, 
@@ -6343,8 +6351,7 @@ static void compute_bin_operator_bitwise_or_assig_type(nodecl_t* lhs, nodecl_t*
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_BITWISE_OR_ASSIGN_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_BITWISE_OR_ASSIGN_OPERATOR);
     }
 
     compute_bin_operator_assig_only_integral_type(lhs, rhs, 
@@ -6360,8 +6367,7 @@ static void compute_bin_operator_bitwise_xor_assig_type(nodecl_t* lhs, nodecl_t*
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_BITWISE_XOR_ASSIGN_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_BITWISE_XOR_ASSIGN_OPERATOR);
     }
 
     compute_bin_operator_assig_only_integral_type(lhs, rhs, 
@@ -6377,8 +6383,7 @@ static void compute_bin_operator_mul_assig_type(nodecl_t* lhs, nodecl_t* rhs,
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_MUL_ASSIGN_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_MUL_ASSIGN_OPERATOR);
     }
 
     compute_bin_operator_assig_only_arithmetic_type(lhs, rhs, 
@@ -6394,8 +6399,7 @@ static void compute_bin_operator_assig_type(nodecl_t* lhs, nodecl_t* rhs,
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_ASSIGNMENT_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_ASSIGNMENT_OPERATOR);
     }
 
     compute_bin_nonoperator_assig_only_arithmetic_type(lhs, rhs, 
@@ -6412,8 +6416,7 @@ static void compute_bin_operator_div_assig_type(nodecl_t* lhs, nodecl_t* rhs,
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_DIV_ASSIGN_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_DIV_ASSIGN_OPERATOR);
     }
 
     compute_bin_operator_assig_only_arithmetic_type(lhs, rhs, 
@@ -6429,8 +6432,7 @@ static void compute_bin_operator_add_assig_type(nodecl_t* lhs, nodecl_t* rhs,
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_ADD_ASSIGN_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_ADD_ASSIGN_OPERATOR);
     }
 
     compute_bin_operator_assig_arithmetic_or_pointer_type(lhs, rhs, 
@@ -6446,8 +6448,7 @@ static void compute_bin_operator_sub_assig_type(nodecl_t* lhs, nodecl_t* rhs,
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_SUB_ASSIGN_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_SUB_ASSIGN_OPERATOR);
     }
 
     compute_bin_operator_assig_arithmetic_or_pointer_type(lhs, rhs, 
@@ -6780,8 +6781,7 @@ static void compute_operator_dereference_type(
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_MUL_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_MUL_OPERATOR);
     }
 
     compute_unary_operator_generic(op,
@@ -6908,8 +6908,7 @@ static void compute_operator_plus_type(nodecl_t* op,
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_ADD_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_ADD_OPERATOR);
     }
 
     compute_unary_operator_generic(
@@ -6995,8 +6994,7 @@ static void compute_operator_minus_type(nodecl_t* op, const decl_context_t* decl
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_MINUS_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_MINUS_OPERATOR);
     }
 
     compute_unary_operator_generic(
@@ -7054,8 +7052,7 @@ static void compute_operator_complement_type(nodecl_t* op,
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_BITWISE_NEG_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_BITWISE_NEG_OPERATOR);
     }
 
     compute_unary_operator_generic(
@@ -7137,8 +7134,7 @@ static void compute_operator_not_type(nodecl_t* op,
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_LOGICAL_NOT_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_LOGICAL_NOT_OPERATOR);
     }
 
     compute_unary_operator_generic(
@@ -7391,8 +7387,7 @@ static void compute_operator_reference_type(nodecl_t* op,
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_BITWISE_AND_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_BITWISE_AND_OPERATOR);
     }
 
     // If parse_reference passes us a qualified name we know this is a pointer
@@ -9272,8 +9267,7 @@ static void check_nodecl_array_subscript_expression_cxx(
     static AST operator_subscript_tree = NULL;
     if (operator_subscript_tree == NULL)
     {
-        operator_subscript_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_SUBSCRIPT_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operator_subscript_tree = make_operator_function_id_tree(AST_SUBSCRIPT_OPERATOR);
     }
 
     // Try to see if an overload operator[] is useable
@@ -10712,15 +10706,13 @@ static void check_new_expression_impl(
     static AST operation_new_tree = NULL;
     if (operation_new_tree == NULL)
     {
-        operation_new_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_NEW_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_new_tree = make_operator_function_id_tree(AST_NEW_OPERATOR);
     }
 
     static AST operation_new_array_tree = NULL;
     if (operation_new_array_tree == NULL)
     {
-        operation_new_array_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_NEW_ARRAY_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_new_array_tree = make_operator_function_id_tree(AST_NEW_ARRAY_OPERATOR);
     }
 
     AST called_operation_new_tree = operation_new_tree;
@@ -13977,8 +13969,7 @@ static void check_nodecl_function_call_cxx(
             static AST operator = NULL;
             if (operator == NULL)
             {
-                operator = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                        ASTLeaf(AST_FUNCTION_CALL_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+                operator = make_operator_function_id_tree(AST_FUNCTION_CALL_OPERATOR);
             }
 
             scope_entry_list_t* first_set_candidates = get_member_of_class_type(class_type, operator, decl_context, NULL);
@@ -14656,8 +14647,7 @@ static void check_nodecl_comma_operand(nodecl_t nodecl_lhs,
     static AST operation_comma_tree = NULL;
     if (operation_comma_tree == NULL)
     {
-        operation_comma_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_COMMA_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_comma_tree = make_operator_function_id_tree(AST_COMMA_OPERATOR);
     }
 
     if (nodecl_is_err_expr(nodecl_lhs)
@@ -17596,8 +17586,7 @@ static void check_nodecl_member_access(
         static AST arrow_operator_tree = NULL;
         if (arrow_operator_tree == NULL)
         {
-            arrow_operator_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                    ASTLeaf(AST_POINTER_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+            arrow_operator_tree = make_operator_function_id_tree(AST_POINTER_OPERATOR);
         }
 
         // First normalize the type keeping the cv-qualifiers
@@ -18692,8 +18681,7 @@ static void check_nodecl_postincrement(
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_INCREMENT_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_INCREMENT_OPERATOR);
     }
 
     check_nodecl_postoperator(operation_tree,
@@ -18725,8 +18713,7 @@ static void check_nodecl_postdecrement(nodecl_t nodecl_postdecremented,
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_DECREMENT_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_DECREMENT_OPERATOR);
     }
 
     check_nodecl_postoperator(operation_tree,
@@ -18759,8 +18746,7 @@ static void check_nodecl_preincrement(nodecl_t nodecl_preincremented,
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_INCREMENT_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_INCREMENT_OPERATOR);
     }
 
     check_nodecl_preoperator(operation_tree,
@@ -18793,8 +18779,7 @@ static void check_nodecl_predecrement(
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_DECREMENT_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_DECREMENT_OPERATOR);
     }
 
     check_nodecl_preoperator(operation_tree,
@@ -18817,8 +18802,7 @@ static void check_predecrement(AST expr, const decl_context_t* decl_context, nod
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_DECREMENT_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_DECREMENT_OPERATOR);
     }
 
     nodecl_t nodecl_predecremented = nodecl_null();
@@ -21553,8 +21537,7 @@ static void check_nodecl_pointer_to_pointer_member(
     static AST operation_tree = NULL;
     if (operation_tree == NULL)
     {
-        operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                ASTLeaf(AST_POINTER_DERREF_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+        operation_tree = make_operator_function_id_tree(AST_POINTER_DERREF_OPERATOR);
     }
 
     builtin_operators_set_t builtin_set; 
@@ -25124,8 +25107,7 @@ char check_copy_assignment_operator(scope_entry_t* entry,
         static AST operation_tree = NULL;
         if (operation_tree == NULL)
         {
-            operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                    ASTLeaf(AST_ASSIGNMENT_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+            operation_tree = make_operator_function_id_tree(AST_ASSIGNMENT_OPERATOR);
         }
 
         type_t* argument_type = t;
@@ -25228,8 +25210,7 @@ char check_move_assignment_operator(scope_entry_t* entry,
         static AST operation_tree = NULL;
         if (operation_tree == NULL)
         {
-            operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                    ASTLeaf(AST_ASSIGNMENT_OPERATOR, make_locus("", 0, 0), NULL), make_locus("", 0, 0), NULL);
+            operation_tree = make_operator_function_id_tree(AST_ASSIGNMENT_OPERATOR);
         }
 
         type_t* argument_type = t;
@@ -25543,6 +25524,171 @@ static const_value_t* stacked_map_of_values_get_value(scope_entry_t* entry)
     return dhash_ptr_query(stacked_map_of_values->map, (const char*)entry);
 }
 
+// Values of calls to constexpr functions already evaluated in this
+// translation unit, keyed by the function and the values of its arguments.
+// Constant values are unique so they are compared by address
+typedef struct constexpr_memo_entry_tag constexpr_memo_entry_t;
+struct constexpr_memo_entry_tag
+{
+    scope_entry_t* function;
+    int num_values;
+    const_value_t** values;
+
+    const_value_t* result;
+
+    constexpr_memo_entry_t* next;
+};
+
+static struct
+{
+    int num_buckets;
+    constexpr_memo_entry_t** buckets;
+    int num_entries;
+    // Maximum number of entries, 0 disables the table
+    int max_entries;
+
+    // Evaluations of constexpr calls currently nested
+    int depth;
+    // Evaluations since the outermost one started
+    int num_steps;
+    // Maximum number of evaluations, 0 means no limit
+    int num_steps_max;
+    char steps_exceeded;
+
+    constexpr_evaluation_stats_t stats;
+} constexpr_evaluation;
+
+static unsigned int constexpr_memo_hash(scope_entry_t* function,
+        int num_values,
+        const_value_t** values)
+{
+    uintptr_t h = (uintptr_t)function >> 3;
+    int i;
+    for (i = 0; i < num_values; i++)
+    {
+        h = h * 31 + ((uintptr_t)values[i] >> 3);
+    }
+    return (unsigned int)(h ^ (h >> 16));
+}
+
+void constexpr_evaluation_init(int max_entries, int num_steps_max)
+{
+    int i;
+    for (i = 0; i < constexpr_evaluation.num_buckets; i++)
+    {
+        constexpr_memo_entry_t* it = constexpr_evaluation.buckets[i];
+        while (it != NULL)
+        {
+            constexpr_memo_entry_t* next = it->next;
+            DELETE(it->values);
+            DELETE(it);
+            it = next;
+        }
+    }
+    DELETE(constexpr_evaluation.buckets);
+
+    constexpr_evaluation.num_buckets = 0;
+    constexpr_evaluation.buckets = NULL;
+    constexpr_evaluation.num_entries = 0;
+    constexpr_evaluation.max_entries = max_entries;
+
+    constexpr_evaluation.depth = 0;
+    constexpr_evaluation.num_steps = 0;
+    constexpr_evaluation.num_steps_max = num_steps_max;
+    constexpr_evaluation.steps_exceeded = 0;
+}
+
+void constexpr_evaluation_get_stats(constexpr_evaluation_stats_t* stats)
+{
+    *stats = constexpr_evaluation.stats;
+}
+
+static const_value_t* constexpr_memo_query(scope_entry_t* function,
+        int num_values,
+        const_value_t** values)
+{
+    if (constexpr_evaluation.max_entries == 0)
+        return NULL;
+
+    if (constexpr_evaluation.num_buckets > 0)
+    {
+        unsigned int h = constexpr_memo_hash(function, num_values, values);
+        constexpr_memo_entry_t* it;
+        for (it = constexpr_evaluation.buckets[h % constexpr_evaluation.num_buckets];
+                it != NULL;
+                it = it->next)
+        {
+            if (it->function == function
+                    && it->num_values == num_values
+                    && memcmp(it->values, values, num_values * sizeof(*values)) == 0)
+            {
+                constexpr_evaluation.stats.num_hits++;
+                return it->result;
+            }
+        }
+    }
+
+    constexpr_evaluation.stats.num_misses++;
+    return NULL;
+}
+
+static void constexpr_memo_rehash(int num_buckets)
+{
+    constexpr_memo_entry_t** buckets = NEW_VEC0(constexpr_memo_entry_t*, num_buckets);
+
+    int i;
+    for (i = 0; i < constexpr_evaluation.num_buckets; i++)
+    {
+        constexpr_memo_entry_t* it = constexpr_evaluation.buckets[i];
+        while (it != NULL)
+        {
+            constexpr_memo_entry_t* next = it->next;
+            unsigned int h = constexpr_memo_hash(it->function, it->num_values, it->values);
+            it->next = buckets[h % num_buckets];
+            buckets[h % num_buckets] = it;
+            it = next;
+        }
+    }
+    DELETE(constexpr_evaluation.buckets);
+
+    constexpr_evaluation.buckets = buckets;
+    constexpr_evaluation.num_buckets = num_buckets;
+}
+
+// The table keeps values, they must have been allocated with NEW_VEC
+static void constexpr_memo_insert(scope_entry_t* function,
+        int num_values,
+        const_value_t** values,
+        const_value_t* result)
+{
+    if (constexpr_evaluation.num_entries >= constexpr_evaluation.max_entries)
+    {
+        if (constexpr_evaluation.max_entries > 0)
+            constexpr_evaluation.stats.num_not_inserted++;
+        DELETE(values);
+        return;
+    }
+
+    if (constexpr_evaluation.num_entries >= 2 * constexpr_evaluation.num_buckets)
+    {
+        constexpr_memo_rehash(2 * constexpr_evaluation.num_buckets + 61);
+    }
+
+    constexpr_memo_entry_t* new_entry = NEW0(constexpr_memo_entry_t);
+    new_entry->function = function;
+    new_entry->num_values = num_values;
+    new_entry->values = values;
+    new_entry->result = result;
+
+    unsigned int h = constexpr_memo_hash(function, num_values, values);
+    new_entry->next = constexpr_evaluation.buckets[h % constexpr_evaluation.num_buckets];
+    constexpr_evaluation.buckets[h % constexpr_evaluation.num_buckets] = new_entry;
+
+    constexpr_evaluation.num_entries++;
+    if ((size_t)constexpr_evaluation.num_entries > constexpr_evaluation.stats.peak_entries)
+        constexpr_evaluation.stats.peak_entries = constexpr_evaluation.num_entries;
+}
+
 static const_value_t* compute_value_of_regular_glvalue(nodecl_t expr,
         const decl_context_t* decl_context,
         const locus_t* locus);
@@ -26325,11 +26471,15 @@ static void argument_list_remove_default_arguments(nodecl_t* list_of_arguments,
     }
 }
 
+// If values is not NULL it is given a new vector with the values bound to
+// the parameters, in order
 static char
 constexpr_function_set_constants_of_arguments(
         nodecl_t converted_arg_list,
         scope_entry_t* entry,
-        const decl_context_t* decl_context)
+        const decl_context_t* decl_context,
+        int *num_values,
+        const_value_t*** values)
 {
     int num_map_items = 0;
 
@@ -26512,6 +26662,16 @@ constexpr_function_set_constants_of_arguments(
         stacked_map_of_values_set_value(map[i].parameter, map[i].value);
     }
 
+    if (values != NULL)
+    {
+        *num_values = num_map_items;
+        *values = NEW_VEC(const_value_t*, num_map_items);
+        for (i = 0; i < num_map_items; i++)
+        {
+            (*values)[i] = map[i].value;
+        }
+    }
+
     DELETE(map);
     DEBUG_CODE()
     {
@@ -26611,7 +26771,8 @@ static const_value_t* evaluate_constexpr_constructor(
     }
 
     stacked_map_of_values_push();
-    char args_ok = constexpr_function_set_constants_of_arguments(converted_arg_list, entry, decl_context);
+    char args_ok = constexpr_function_set_constants_of_arguments(converted_arg_list, entry, decl_context,
+            /* num_values */ NULL, /* values */ NULL);
     if (!args_ok)
     {
         DEBUG_CODE()
@@ -26879,7 +27040,10 @@ static const_value_t* evaluate_constexpr_regular_function_call(
     }
 
     stacked_map_of_values_push();
-    char args_ok = constexpr_function_set_constants_of_arguments(converted_arg_list, entry, decl_context);
+    int num_values = 0;
+    const_value_t** values = NULL;
+    char args_ok = constexpr_function_set_constants_of_arguments(converted_arg_list, entry, decl_context,
+            &num_values, &values);
     if (!args_ok)
     {
         DEBUG_CODE()
@@ -26891,6 +27055,48 @@ static const_value_t* evaluate_constexpr_regular_function_call(
         return NULL;
     }
 
+    // The implicit argument of nonstatic member functions is bound to a new
+    // temporary in every call so these calls are never found in the table
+    char is_memoizable = !symbol_entity_specs_get_is_member(entry)
+        || symbol_entity_specs_get_is_static(entry);
+    if (is_memoizable)
+    {
+        const_value_t* memoized_value = constexpr_memo_query(entry, num_values, values);
+        if (memoized_value != NULL)
+        {
+            DEBUG_CODE()
+            {
+                fprintf(stderr, "EXPRTYPE: Using memoized value '%s' of constexpr call\n",
+                        const_value_to_str(memoized_value));
+            }
+            DELETE(values);
+            stacked_map_of_values_pop();
+            return memoized_value;
+        }
+    }
+
+    // Steps are counted along the outermost evaluation
+    if (constexpr_evaluation.depth == 0)
+    {
+        constexpr_evaluation.num_steps = 0;
+        constexpr_evaluation.steps_exceeded = 0;
+    }
+
+    if (constexpr_evaluation.num_steps_max > 0
+            && constexpr_evaluation.num_steps >= constexpr_evaluation.num_steps_max)
+    {
+        DEBUG_CODE()
+        {
+            fprintf(stderr, "EXPRTYPE: Evaluation of constexpr call exceeded the maximum number of steps\n");
+        }
+        // This is diagnosed by the outermost call, nested calls are not
+        // evaluated in a constant-expression
+        constexpr_evaluation.steps_exceeded = 1;
+        DELETE(values);
+        stacked_map_of_values_pop();
+        return NULL;
+    }
+
     nodecl_t nodecl_function_code = symbol_entity_specs_get_function_code(entry);
     ERROR_CONDITION(nodecl_is_null(nodecl_function_code), "Function lacks function code", 0);
 
@@ -26906,11 +27112,16 @@ static const_value_t* evaluate_constexpr_regular_function_call(
             instantiation_symbol_map = symbol_entity_specs_get_instantiation_symbol_map(entry);
         }
 
+        constexpr_evaluation.num_steps++;
+        constexpr_evaluation.depth++;
+
         nodecl_evaluated_expr = instantiate_expression(
                 nodecl_returned_expression,
                 nodecl_retrieve_context(nodecl_returned_expression),
                 instantiation_symbol_map,
                 /* pack_index */ -1);
+
+        constexpr_evaluation.depth--;
     }
 
     DEBUG_CODE()
@@ -26928,7 +27139,19 @@ static const_value_t* evaluate_constexpr_regular_function_call(
         {
             fprintf(stderr, "EXPRTYPE: Evaluation of regular constexpr call did not give a constant value\n");
         }
-        if (check_expr_flags.must_be_constant)
+        if (check_expr_flags.must_be_constant
+                && constexpr_evaluation.steps_exceeded)
+        {
+            if (constexpr_evaluation.depth == 0)
+            {
+                error_printf_at(locus, "evaluation of constexpr function '%s' exceeded the maximum "
+                        "number of steps (%d), use --constexpr-steps=N to increase it\n",
+                        print_decl_type_str(entry->type_information, entry->decl_context,
+                            get_qualified_symbol_name(entry, entry->decl_context)),
+                        constexpr_evaluation.num_steps_max);
+            }
+        }
+        else if (check_expr_flags.must_be_constant)
         {
             error_printf_at(locus, "call to constexpr function '%s' in constant-expression did not yield a constant value\n",
                     print_decl_type_str(entry->type_information, entry->decl_context,
@@ -26938,6 +27161,19 @@ static const_value_t* evaluate_constexpr_regular_function_call(
 
     const_value_t* cval = nodecl_get_constant(nodecl_evaluated_expr);
     stacked_map_of_values_pop();
+
+    // Failed evaluations are not remembered so they are diagnosed again
+    if (is_memoizable
+            && cval != NULL
+            && !constexpr_evaluation.steps_exceeded)
+    {
+        constexpr_memo_insert(entry, num_values, values, cval);
+    }
+    else
+    {
+        DELETE(values);
+    }
+
     return cval;
 }
 
@@ -27424,9 +27660,7 @@ static nodecl_t compute_assignment_for_nonarray_member(
         static AST operation_tree = NULL;
         if (operation_tree == NULL)
         {
-            operation_tree = ASTMake1(AST_OPERATOR_FUNCTION_ID,
-                    ASTLeaf(AST_ASSIGNMENT_OPERATOR, make_locus("", 0, 0), NULL),
-                    make_locus("", 0, 0), NULL);
+            operation_tree = make_operator_function_id_tree(AST_ASSIGNMENT_OPERATOR);
         }
 
         nodecl_t nodecl_op_name =
@@ -282,6 +282,26 @@ LIBMCXX_EXTERN type_t* clear_special_expr_type_variants(type_t* t);
 // Used by the lexer
 char* interpret_schar(const char* schar, const locus_t* locus);
 
+// Calls to constexpr functions are memoized per translation unit. This
+// clears the table, which keeps up to max_entries values (0 disables it).
+// An evaluation gives up after num_steps_max calls (0 means no limit)
+LIBMCXX_EXTERN void constexpr_evaluation_init(int max_entries, int num_steps_max);
+
+typedef
+struct constexpr_evaluation_stats_tag
+{
+    // Calls whose value was found in the table
+    size_t num_hits;
+    // Calls that had to be evaluated
+    size_t num_misses;
+    // Values not kept because the table was full
+    size_t num_not_inserted;
+    // Largest number of values kept at once
+    size_t peak_entries;
+} constexpr_evaluation_stats_t;
+
+LIBMCXX_EXTERN void constexpr_evaluation_get_stats(constexpr_evaluation_stats_t* stats);
+
 MCXX_END_DECLS
 
 #endif
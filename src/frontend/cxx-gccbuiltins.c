@@ -33,6 +33,7 @@
 #include "cxx-cexpr.h"
 #include "cxx-diagnostic.h"
 #include "cxx-intelsupport.h"
+#include "cxx-lazybuiltins.h"
 #include <string.h>
 #include <math.h>
 
@@ -3540,11 +3541,31 @@ static scope_entry_t* solve_gcc_atomic_builtins_overload_name_generic(
     return NULL;
 }
 
+// Intel architecture gcc builtins, signed in lazily
+#define BUILTIN_FUNCTION(name, type) \
+    static type_t* gcc_ia32_builtin_type_##name(void) { return type; }
+#define BUILTIN_ALIAS(name, existing) \
+    static type_t* gcc_ia32_builtin_type_##name(void) { return gcc_ia32_builtin_type_##existing(); }
+#include "cxx-gccbuiltins-ia32.h"
+#undef BUILTIN_ALIAS
+#undef BUILTIN_FUNCTION
+
+static const lazy_builtin_t gcc_ia32_builtins[] =
+{
+#define BUILTIN_FUNCTION(name, type) { #name, gcc_ia32_builtin_type_##name },
+#define BUILTIN_ALIAS(name, existing) { #name, gcc_ia32_builtin_type_##name },
+#include "cxx-gccbuiltins-ia32.h"
+#undef BUILTIN_ALIAS
+#undef BUILTIN_FUNCTION
+};
+
 static void sign_in_gcc_simd_builtins(const decl_context_t* decl_context)
 {
     // Intel architecture gcc builtins
     const locus_t* builtins_locus = make_locus("(gcc-builtin-ia32)", 0, 0);
-#include "cxx-gccbuiltins-ia32.h"
+    lazy_builtins_add_table(decl_context,
+            gcc_ia32_builtins, STATIC_ARRAY_LENGTH(gcc_ia32_builtins),
+            builtins_locus);
 #include "cxx-gccbuiltins-ia32-deprecated.h"
 }
 
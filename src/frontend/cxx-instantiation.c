@@ -58,6 +58,7 @@ static scope_entry_t* add_duplicate_member_to_class(
             member_of_template->symbol_name);
 
     *new_member = *member_of_template;
+    symbol_entity_specs_share_sparse(new_member);
     symbol_clear_indirect_types(new_member);
 
     symbol_entity_specs_set_is_member(new_member, 1);
@@ -1470,6 +1471,7 @@ static void instantiate_dependent_friend_function(
 
                     scope_entry_t* new_entry = NEW0(scope_entry_t);
                     memcpy(new_entry, current_temp_param->entry, sizeof(*current_temp_param->entry));
+                    symbol_entity_specs_share_sparse(new_entry);
                     symbol_clear_indirect_types(new_entry);
                     symbol_entity_specs_set_template_parameter_nesting(new_entry, 1);
                     current_temp_param->entry = new_entry;
@@ -1574,6 +1576,15 @@ static void instantiate_bases(
         instantiation_symbol_map_t* instantiation_symbol_map,
         const locus_t* locus);
 
+// Classes whose instantiation has started but not finished yet. They are
+// already complete though they still lack some of their members
+static int num_classes_being_instantiated = 0;
+
+char instantiation_is_instantiating_class(void)
+{
+    return num_classes_being_instantiated > 0;
+}
+
 static void instantiate_class_common(
         scope_entry_t* being_instantiated_sym,
         type_t* being_instantiated,
@@ -1583,6 +1594,8 @@ static void instantiate_class_common(
         const decl_context_t* inner_decl_context,
         const locus_t* locus)
 {
+    num_classes_being_instantiated++;
+
     instantiation_symbol_map_t* instantiation_symbol_map =
         instantiation_symbol_map_push(enclosing_instantiation_symbol_map);
     symbol_entity_specs_set_instantiation_symbol_map(being_instantiated_sym, instantiation_symbol_map);
@@ -1602,6 +1615,7 @@ static void instantiate_class_common(
                 inner_decl_context->current_scope, being_instantiated_sym->symbol_name);
 
         *injected_symbol = *being_instantiated_sym;
+        symbol_entity_specs_share_sparse(injected_symbol);
         // the injected class name is logically in the class-scope
         injected_symbol->decl_context = inner_decl_context;
         injected_symbol->do_not_print = 1;
@@ -1802,6 +1816,8 @@ static void instantiate_class_common(
     }
 
     push_instantiated_entity(being_instantiated_sym);
+
+    num_classes_being_instantiated--;
 }
 
 typedef
@@ -2309,14 +2325,28 @@ struct instantiation_item_tag
     const locus_t* locus;
 } instantiation_item_t;
 
+// Functions pending of instantiation in the order they were requested. A
+// function is in symbols_to_instantiate at most once: pending_symbols is the
+// set of the symbols in it
 static instantiation_item_t** symbols_to_instantiate;
 static int num_symbols_to_instantiate;
+static int size_symbols_to_instantiate;
+static dhash_ptr_t* pending_symbols;
+
+static instantiation_queue_stats_t instantiation_queue_stats;
 
 void instantiation_init(void)
 {
     nodecl_instantiation_units = nodecl_null();
     symbols_to_instantiate = NULL;
     num_symbols_to_instantiate = 0;
+    size_symbols_to_instantiate = 0;
+    pending_symbols = NULL;
+}
+
+void instantiation_get_queue_stats(instantiation_queue_stats_t* stats)
+{
+    *stats = instantiation_queue_stats;
 }
 
 static void instantiate_every_symbol(scope_entry_t* entry,
@@ -2362,8 +2392,15 @@ void instantiation_instantiate_pending_functions(nodecl_t* nodecl_output)
         int tmp_num_symbols_to_instantiate = num_symbols_to_instantiate;
         instantiation_item_t** tmp_symbols_to_instantiate = symbols_to_instantiate;
 
+        // Functions requested while instantiating these ones form the next
+        // round, even if they have already been instantiated in this one
         num_symbols_to_instantiate = 0;
+        size_symbols_to_instantiate = 0;
         symbols_to_instantiate = NULL;
+        dhash_ptr_destroy(pending_symbols);
+        pending_symbols = NULL;
+
+        instantiation_queue_stats.num_rounds++;
 
         int i;
         for (i = 0; i < tmp_num_symbols_to_instantiate; i++)
@@ -2371,7 +2408,7 @@ void instantiation_instantiate_pending_functions(nodecl_t* nodecl_output)
             instantiate_every_symbol(
                     tmp_symbols_to_instantiate[i]->symbol,
                     tmp_symbols_to_instantiate[i]->locus);
-
+            instantiation_queue_stats.num_processed++;
 
             DELETE(tmp_symbols_to_instantiate[i]);
         }
@@ -2600,30 +2637,39 @@ void instantiation_instantiate_pending_functions(nodecl_t* nodecl_output)
     DELETE(list);
 }
 
-static char compare_instantiate_items(instantiation_item_t* current_item, instantiation_item_t* new_item)
-{
-    return current_item->symbol == new_item->symbol;
-}
-
 void instantiation_add_symbol_to_instantiate(scope_entry_t* entry,
         const locus_t* locus)
 {
+    instantiation_queue_stats.num_requests++;
+
+    if (pending_symbols == NULL)
+    {
+        pending_symbols = dhash_ptr_new(5);
+    }
+    else if (dhash_ptr_query(pending_symbols, (const char*)entry) != NULL)
+    {
+        // Already pending, keep the first locus
+        instantiation_queue_stats.num_duplicates++;
+        return;
+    }
+    dhash_ptr_insert(pending_symbols, (const char*)entry, entry);
+
     instantiation_item_t* item = NEW0(instantiation_item_t);
     item->symbol = entry;
     item->locus = locus;
 
-    int old_num = num_symbols_to_instantiate;
-
-    P_LIST_ADD_ONCE_FUN(symbols_to_instantiate,
-            num_symbols_to_instantiate,
-            item,
-            compare_instantiate_items);
-
-    // Crummy way to know if it was added
-    if (old_num == num_symbols_to_instantiate)
+    if (num_symbols_to_instantiate == size_symbols_to_instantiate)
     {
-        DELETE(item);
+        size_symbols_to_instantiate = 2 * size_symbols_to_instantiate + 16;
+        symbols_to_instantiate = NEW_REALLOC(instantiation_item_t*,
+                symbols_to_instantiate,
+                size_symbols_to_instantiate);
     }
+    symbols_to_instantiate[num_symbols_to_instantiate] = item;
+    num_symbols_to_instantiate++;
+
+    if ((size_t)num_symbols_to_instantiate > instantiation_queue_stats.peak_pending)
+        instantiation_queue_stats.peak_pending = num_symbols_to_instantiate;
 }
 
 static char instantiate_true_template_function(scope_entry_t* entry, const locus_t* locus UNUSED_PARAMETER)
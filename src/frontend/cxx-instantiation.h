@@ -57,6 +57,25 @@ LIBMCXX_EXTERN void instantiation_instantiate_pending_functions(nodecl_t* nodecl
 LIBMCXX_EXTERN void instantiation_add_symbol_to_instantiate(scope_entry_t* entry,
         const locus_t* locus);
 
+typedef
+struct instantiation_queue_stats_tag
+{
+    // Calls to instantiation_add_symbol_to_instantiate
+    size_t num_requests;
+    // Requests of functions that were already pending
+    size_t num_duplicates;
+    // Functions taken from the queue and instantiated
+    size_t num_processed;
+    // Times the queue has been drained
+    size_t num_rounds;
+    // Largest number of functions pending at once
+    size_t peak_pending;
+} instantiation_queue_stats_t;
+
+LIBMCXX_EXTERN void instantiation_get_queue_stats(instantiation_queue_stats_t* stats);
+
+LIBMCXX_EXTERN char instantiation_is_instantiating_class(void);
+
 LIBMCXX_EXTERN char function_may_be_instantiated(scope_entry_t* entry);
 LIBMCXX_EXTERN void instantiate_template_function(scope_entry_t* entry, const locus_t* locus);
 
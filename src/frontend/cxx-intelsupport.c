@@ -27,6 +27,7 @@
 
 
 #include "cxx-intelsupport.h"
+#include "cxx-lazybuiltins.h"
 
 #include "cxx-typeutils.h"
 #include "cxx-nodecl.h"
@@ -561,11 +562,31 @@ char intel_vector_struct_to_intel_vector_struct_reinterpret_type(type_t* orig, t
     return 0;
 }
 
+// Xeon intrinsics, signed in lazily
+#define BUILTIN_FUNCTION(name, type) \
+    static type_t* icc_builtin_type_##name(void) { return type; }
+#define BUILTIN_ALIAS(name, existing) \
+    static type_t* icc_builtin_type_##name(void) { return icc_builtin_type_##existing(); }
+#include "cxx-iccbuiltins.h"
+#undef BUILTIN_ALIAS
+#undef BUILTIN_FUNCTION
+
+static const lazy_builtin_t icc_builtins[] =
+{
+#define BUILTIN_FUNCTION(name, type) { #name, icc_builtin_type_##name },
+#define BUILTIN_ALIAS(name, existing) { #name, icc_builtin_type_##name },
+#include "cxx-iccbuiltins.h"
+#undef BUILTIN_ALIAS
+#undef BUILTIN_FUNCTION
+};
+
 void sign_in_icc_intrinsics(const decl_context_t* decl_context)
 {
     const locus_t* builtins_locus = make_locus("(intel-builtins)", 0, 0);
     // Xeon
-#include "cxx-iccbuiltins.h"
+    lazy_builtins_add_table(decl_context,
+            icc_builtins, STATIC_ARRAY_LENGTH(icc_builtins),
+            builtins_locus);
 
     // Knights Corner (aka MIC)
     builtins_locus = make_locus("(intel-builtins-knc)", 0, 0);
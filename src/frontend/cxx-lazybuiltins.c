@@ -0,0 +1,214 @@
+/*--------------------------------------------------------------------
+  (C) Copyright 2006-2014 Barcelona Supercomputing Center
+                          Centro Nacional de Supercomputacion
+  
+  This file is part of Mercurium C/C++ source-to-source compiler.
+  
+  See AUTHORS file in the top level directory for information
+  regarding developers and contributors.
+  
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3 of the License, or (at your option) any later version.
+  
+  Mercurium C/C++ source-to-source compiler is distributed in the hope
+  that it will be useful, but WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+  PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public
+  License along with Mercurium C/C++ source-to-source compiler; if
+  not, write to the Free Software Foundation, Inc., 675 Mass Ave,
+  Cambridge, MA 02139, USA.
+--------------------------------------------------------------------*/
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "cxx-lazybuiltins.h"
+#include "cxx-scope.h"
+#include "cxx-entrylist.h"
+#include "cxx-utils.h"
+
+// Builtins of a table sorted by name. This only depends on the table so it is
+// computed once per process
+typedef
+struct lazy_builtins_index_tag
+{
+    const lazy_builtin_t* table;
+    const lazy_builtin_t** sorted;
+    struct lazy_builtins_index_tag* next;
+} lazy_builtins_index_t;
+
+static lazy_builtins_index_t* lazy_builtins_indexes = NULL;
+
+typedef
+struct lazy_builtins_table_tag
+{
+    const lazy_builtin_t* table;
+    int num_builtins;
+    const lazy_builtin_t** sorted;
+    const locus_t* locus;
+
+    // Nonzero once the builtin has been signed in, indexed like table
+    char* signed_in;
+} lazy_builtins_table_t;
+
+struct lazy_builtins_tag
+{
+    const decl_context_t* decl_context;
+
+    int num_tables;
+    lazy_builtins_table_t* tables;
+
+    // Nonzero if every builtin of every table has been signed in
+    char all_signed_in;
+};
+
+static int compare_lazy_builtins(const void* a, const void* b)
+{
+    const lazy_builtin_t* const* builtin_a = (const lazy_builtin_t* const*)a;
+    const lazy_builtin_t* const* builtin_b = (const lazy_builtin_t* const*)b;
+
+    return strcmp((*builtin_a)->name, (*builtin_b)->name);
+}
+
+static const lazy_builtin_t** get_sorted_builtins(const lazy_builtin_t* table, int num_builtins)
+{
+    lazy_builtins_index_t* it;
+    for (it = lazy_builtins_indexes; it != NULL; it = it->next)
+    {
+        if (it->table == table)
+            return it->sorted;
+    }
+
+    lazy_builtins_index_t* index = NEW0(lazy_builtins_index_t);
+    index->table = table;
+    index->sorted = NEW_VEC(const lazy_builtin_t*, num_builtins);
+
+    int i;
+    for (i = 0; i < num_builtins; i++)
+    {
+        index->sorted[i] = &table[i];
+    }
+    qsort(index->sorted, num_builtins, sizeof(*index->sorted), compare_lazy_builtins);
+
+    index->next = lazy_builtins_indexes;
+    lazy_builtins_indexes = index;
+
+    return index->sorted;
+}
+
+void lazy_builtins_add_table(
+        const decl_context_t* decl_context,
+        const lazy_builtin_t* table,
+        int num_builtins,
+        const locus_t* locus)
+{
+    scope_t* sc = decl_context->current_scope;
+
+    if (sc->lazy_builtins == NULL)
+    {
+        sc->lazy_builtins = NEW0(lazy_builtins_t);
+        sc->lazy_builtins->decl_context = decl_context;
+    }
+    lazy_builtins_t* lazy_builtins = sc->lazy_builtins;
+
+    lazy_builtins->num_tables++;
+    lazy_builtins->tables = NEW_REALLOC(lazy_builtins_table_t,
+            lazy_builtins->tables,
+            lazy_builtins->num_tables);
+
+    lazy_builtins_table_t* new_table = &lazy_builtins->tables[lazy_builtins->num_tables - 1];
+    new_table->table = table;
+    new_table->num_builtins = num_builtins;
+    new_table->sorted = get_sorted_builtins(table, num_builtins);
+    new_table->locus = locus;
+    new_table->signed_in = NEW_VEC0(char, num_builtins);
+
+    lazy_builtins->all_signed_in = 0;
+}
+
+static void sign_in_lazy_builtin(const decl_context_t* decl_context,
+        lazy_builtins_table_t* table,
+        const lazy_builtin_t* builtin)
+{
+    int index = builtin - table->table;
+    if (table->signed_in[index])
+        return;
+
+    // Set it first as new_symbol will ask us again about this name
+    table->signed_in[index] = 1;
+
+    scope_entry_t* sym = new_symbol(decl_context, decl_context->current_scope,
+            uniquestr(builtin->name));
+    sym->kind = SK_FUNCTION;
+    sym->do_not_print = 1;
+    sym->locus = table->locus;
+    sym->type_information = (builtin->compute_type)();
+    symbol_entity_specs_set_is_builtin(sym, 1);
+}
+
+void lazy_builtins_sign_in(scope_t* sc, const char* name)
+{
+    lazy_builtins_t* lazy_builtins = sc->lazy_builtins;
+    if (lazy_builtins == NULL)
+        return;
+
+    lazy_builtin_t key_builtin = { name, NULL };
+    const lazy_builtin_t* key = &key_builtin;
+
+    int i;
+    for (i = 0; i < lazy_builtins->num_tables; i++)
+    {
+        lazy_builtins_table_t* table = &lazy_builtins->tables[i];
+
+        const lazy_builtin_t** found = (const lazy_builtin_t**)bsearch(&key,
+                table->sorted,
+                table->num_builtins,
+                sizeof(*table->sorted),
+                compare_lazy_builtins);
+        if (found == NULL)
+            continue;
+
+        // There may be several builtins with the same name
+        const lazy_builtin_t** first = found;
+        while (first > table->sorted
+                && strcmp((*(first - 1))->name, name) == 0)
+            first--;
+
+        const lazy_builtin_t** end = table->sorted + table->num_builtins;
+        const lazy_builtin_t** it;
+        for (it = first; it < end && strcmp((*it)->name, name) == 0; it++)
+        {
+            sign_in_lazy_builtin(lazy_builtins->decl_context, table, *it);
+        }
+    }
+}
+
+void lazy_builtins_sign_in_all(scope_t* sc)
+{
+    lazy_builtins_t* lazy_builtins = sc->lazy_builtins;
+    if (lazy_builtins == NULL
+            || lazy_builtins->all_signed_in)
+        return;
+
+    int i;
+    for (i = 0; i < lazy_builtins->num_tables; i++)
+    {
+        lazy_builtins_table_t* table = &lazy_builtins->tables[i];
+
+        int j;
+        for (j = 0; j < table->num_builtins; j++)
+        {
+            sign_in_lazy_builtin(lazy_builtins->decl_context, table, &table->table[j]);
+        }
+    }
+
+    lazy_builtins->all_signed_in = 1;
+}
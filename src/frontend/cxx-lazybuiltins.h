@@ -0,0 +1,83 @@
+/*--------------------------------------------------------------------
+  (C) Copyright 2006-2014 Barcelona Supercomputing Center
+                          Centro Nacional de Supercomputacion
+  
+  This file is part of Mercurium C/C++ source-to-source compiler.
+  
+  See AUTHORS file in the top level directory for information
+  regarding developers and contributors.
+  
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3 of the License, or (at your option) any later version.
+  
+  Mercurium C/C++ source-to-source compiler is distributed in the hope
+  that it will be useful, but WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+  PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public
+  License along with Mercurium C/C++ source-to-source compiler; if
+  not, write to the Free Software Foundation, Inc., 675 Mass Ave,
+  Cambridge, MA 02139, USA.
+--------------------------------------------------------------------*/
+
+
+
+
+#ifndef CXX_LAZYBUILTINS_H
+#define CXX_LAZYBUILTINS_H
+
+#include "libmcxx-common.h"
+#include "cxx-scope-decls.h"
+
+MCXX_BEGIN_DECLS
+
+/*
+ * Builtins signed in on demand
+ *
+ * Target specific builtins are thousands of functions of which a translation
+ * unit uses very few. Instead of creating all their symbols and types upfront
+ * a table of them is attached to the scope. The symbol of a builtin and its
+ * type are only created the first time its name is looked up (or declared)
+ * in that scope.
+ *
+ * Tables are usually built from a generated file with one
+ *
+ *   BUILTIN_FUNCTION(name, type-expression)
+ *   BUILTIN_ALIAS(name, existing-name)
+ *
+ * per builtin. The file is included twice: once to define a function per
+ * builtin that computes its type and once more to define the table itself.
+ */
+
+typedef type_t* lazy_builtin_type_fn_t(void);
+
+typedef
+struct lazy_builtin_tag
+{
+    const char* name;
+    lazy_builtin_type_fn_t* compute_type;
+} lazy_builtin_t;
+
+// Attaches the builtins of table to the current scope of decl_context. Tables
+// must be static, they are not copied
+LIBMCXX_EXTERN void lazy_builtins_add_table(
+        const decl_context_t* decl_context,
+        const lazy_builtin_t* table,
+        int num_builtins,
+        const locus_t* locus);
+
+// Signs in the builtins called name attached to sc that have not been signed
+// in yet
+LIBMCXX_EXTERN void lazy_builtins_sign_in(scope_t* sc, const char* name);
+
+// Signs in every builtin attached to sc that has not been signed in yet. Code
+// that walks all the entities of a scope must call this first
+LIBMCXX_EXTERN void lazy_builtins_sign_in_all(scope_t* sc);
+
+MCXX_END_DECLS
+
+#endif // CXX_LAZYBUILTINS_H
@@ -69,6 +69,10 @@ enum
     // C++ associated namespaces during lookup
     MCXX_MAX_ASSOCIATED_NAMESPACES = 256,
 
+    // Constexpr evaluation (--constexpr-cache-size and --constexpr-steps)
+    MCXX_DEFAULT_CONSTEXPR_CACHE_SIZE = 65536,
+    MCXX_DEFAULT_CONSTEXPR_STEPS = 1048576,
+
     // Environmental limits
     MCXX_MAX_BYTES_INTEGER = 16,
 
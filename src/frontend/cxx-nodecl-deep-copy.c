@@ -34,6 +34,8 @@
 #include "cxx-utils.h"
 #include "cxx-symbol-deep-copy.h"
 #include "cxx-typeutils.h"
+#include "cxx-lazybuiltins.h"
+#include "fortran/fortran03-scope.h"
 
 // Machine generated in cxx-nodecl-deep-copy-base.c
 extern nodecl_t nodecl_deep_copy_rec(nodecl_t n, 
@@ -392,6 +394,11 @@ static void copy_scope(const decl_context_t* new_decl_context, scope_t* original
     closure_info.nodecl_deep_copy_map = nodecl_deep_copy_map;
     closure_info.symbol_deep_copy_map = symbol_deep_copy_map;
 
+    // Builtins not signed in yet are copied too. USE-associated names are
+    // not, the new scope keeps signing them in on demand
+    if (original_scope->lazy_builtins != NULL)
+        lazy_builtins_sign_in_all(original_scope);
+
     // First walk, sign in all the names but leave them empty
     dhash_ptr_walk(original_scope->dhash, (dhash_ptr_walk_fn*)create_symbols, &closure_info);
     dhash_ptr_walk(original_scope->dhash, (dhash_ptr_walk_fn*)register_symbols, &closure_info);
@@ -402,6 +409,8 @@ static void copy_scope(const decl_context_t* new_decl_context, scope_t* original
     fill_symbols(&closure_info);
 
     entry_list_free(closure_info.symbols);
+
+    fortran_lazy_uses_copy(new_decl_context, original_scope);
 }
 
 static decl_context_t* copy_function_scope(decl_context_t* new_decl_context,
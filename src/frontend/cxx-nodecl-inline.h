@@ -122,6 +122,7 @@ static inline void nodecl_expr_set_##what(AST expr, type * datum) \
     { \
      expr_info = nodecl_expr_get_expression_info(expr); \
     } \
+    ast_invalidate_structural_hash(expr); \
     expr_info->field_name = datum; \
 }
 
@@ -214,6 +214,85 @@ size_t nodecl_hash_table(nodecl_t key)
     return hash;
 }
 
+static unsigned int structural_hash_combine(unsigned int hash, uint64_t value)
+{
+    hash ^= (unsigned int)value + (unsigned int)(value >> 32)
+        + 0x9e3779b9U + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+// Hash of the kind, symbol and constant of a node, and of its children.
+// Constants of objects and addresses are not compared structurally (see
+// cmp_trees_rec in TL) so they are not hashed either
+static unsigned int nodecl_compute_structural_hash(AST a)
+{
+    nodecl_t n = _nodecl_wrap(a);
+
+    unsigned int hash = structural_hash_combine(0, nodecl_get_kind(n));
+    hash = structural_hash_combine(hash, (uintptr_t)nodecl_get_symbol(n));
+
+    const_value_t* cval = nodecl_get_constant(n);
+    if (cval != NULL
+            && !const_value_is_address_or_object(cval))
+        hash = structural_hash_combine(hash, (uintptr_t)cval);
+
+    int i;
+    for (i = 0; i < MCXX_MAX_AST_CHILDREN; i++)
+    {
+        hash = structural_hash_combine(hash,
+                nodecl_get_structural_hash(nodecl_get_child(n, i)));
+    }
+
+    return hash;
+}
+
+unsigned int nodecl_get_structural_hash(nodecl_t n)
+{
+    AST a = nodecl_get_ast(n);
+    if (a == NULL)
+        return 0;
+
+    if (a->has_structural_hash)
+        return a->structural_hash;
+
+    unsigned int hash;
+    if (ast_get_kind(a) == NODECL_CONVERSION)
+    {
+        // Conversions are skipped
+        AST nest = ast_get_child(a, 0);
+        if (ast_get_kind(nest) == NODECL_CONVERSION)
+        {
+            // Only one conversion is skipped, so the hash of this node is
+            // not the hash of nest. Still cache nest: every node below a
+            // cached one must be cached, otherwise invalidating it would
+            // not reach this node
+            nodecl_get_structural_hash(_nodecl_wrap(nest));
+            hash = nodecl_compute_structural_hash(nest);
+        }
+        else
+        {
+            hash = nodecl_get_structural_hash(_nodecl_wrap(nest));
+        }
+    }
+    else
+    {
+        hash = nodecl_compute_structural_hash(a);
+    }
+
+    // Cache the hash only after the nodes it depends on have cached theirs
+    a->structural_hash = hash;
+    a->has_structural_hash = 1;
+
+    return hash;
+}
+
+char nodecl_has_structural_hash(nodecl_t n)
+{
+    AST a = nodecl_get_ast(n);
+    return a != NULL
+        && a->has_structural_hash;
+}
+
 // Placeholder
 void nodecl_set_placeholder(nodecl_t n, AST* p)
 {
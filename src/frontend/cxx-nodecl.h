@@ -156,6 +156,15 @@ void nodecl_replace(nodecl_t old_node, nodecl_t new_node);
 // Hash table
 size_t nodecl_hash_table(nodecl_t key);
 
+// Structural hash: equal for trees that are structurally equal when
+// conversions are skipped (kind, symbol and constant of every node).
+// It is cached in the tree and recomputed only after the tree changes
+unsigned int nodecl_get_structural_hash(nodecl_t n);
+// Nonzero while the structural hash of n remains cached, that is, if n has
+// not been modified since nodecl_get_structural_hash was called on it or on
+// an ancestor
+char nodecl_has_structural_hash(nodecl_t n);
+
 // Sourceify
 const char* nodecl_stmt_to_source(nodecl_t n);
 const char* nodecl_expr_to_source(nodecl_t n);
@@ -839,7 +839,7 @@ static char solve_initialization_of_class_type_(
         scope_entry_list_t** candidates,
         char *is_ambiguous);
 
-static void compute_ics_flags(type_t* orig, type_t* dest, const decl_context_t* decl_context, 
+static void compute_ics_flags_(type_t* orig, type_t* dest, const decl_context_t* decl_context, 
         implicit_conversion_sequence_t *result, 
         char no_user_defined_conversions,
         char is_implicit_argument,
@@ -1056,6 +1056,249 @@ static void compute_ics_flags(type_t* orig, type_t* dest, const decl_context_t*
     }
 }
 
+// Implicit conversion sequences already computed in this translation unit.
+//
+// An ICS does not depend on the context where it is computed, only on the
+// types and the flags. Once the classes involved are complete the ICS cannot
+// change anymore. Otherwise it might, so the ICS is only valid until the
+// next type is completed
+typedef struct ics_cache_entry_tag ics_cache_entry_t;
+struct ics_cache_entry_tag
+{
+    type_t* orig;
+    type_t* dest;
+    int flags;
+
+    // Nonzero if this ICS involves incomplete types
+    char until_completion;
+    // Value of get_type_completion_counter when the ICS was computed
+    unsigned int completion_counter;
+
+    implicit_conversion_sequence_t ics;
+
+    ics_cache_entry_t* next;
+};
+
+static struct
+{
+    int num_buckets;
+    ics_cache_entry_t** buckets;
+    int num_entries;
+
+    ics_cache_stats_t stats;
+} ics_cache;
+
+void overload_init(void)
+{
+    int i;
+    for (i = 0; i < ics_cache.num_buckets; i++)
+    {
+        ics_cache_entry_t* it = ics_cache.buckets[i];
+        while (it != NULL)
+        {
+            ics_cache_entry_t* next = it->next;
+            DELETE(it);
+            it = next;
+        }
+    }
+    DELETE(ics_cache.buckets);
+
+    ics_cache.num_buckets = 0;
+    ics_cache.buckets = NULL;
+    ics_cache.num_entries = 0;
+}
+
+void overload_get_ics_cache_stats(ics_cache_stats_t* stats)
+{
+    *stats = ics_cache.stats;
+}
+
+static unsigned int ics_cache_hash(type_t* orig, type_t* dest, int flags)
+{
+    uintptr_t h = (uintptr_t)orig >> 3;
+    h = h * 31 + ((uintptr_t)dest >> 3);
+    h = h * 31 + flags;
+    return (unsigned int)(h ^ (h >> 16));
+}
+
+// Returns nonzero if the conversions from or to t cannot change later
+static char ics_cache_type_is_stable(type_t* t)
+{
+    for (;;)
+    {
+        if (is_dependent_type(t))
+            return 0;
+
+        if (is_any_reference_type(t))
+        {
+            t = reference_type_get_referenced_type(t);
+        }
+        else if (is_pointer_to_member_type(t))
+        {
+            if (!ics_cache_type_is_stable(pointer_to_member_type_get_class_type(t)))
+                return 0;
+            t = pointer_type_get_pointee_type(t);
+        }
+        else if (is_pointer_type(t))
+        {
+            t = pointer_type_get_pointee_type(t);
+        }
+        else if (is_array_type(t))
+        {
+            t = array_type_get_element_type(t);
+        }
+        else if (is_class_type(t)
+                || is_enum_type(t))
+        {
+            return is_complete_type(t);
+        }
+        else
+        {
+            return 1;
+        }
+    }
+}
+
+static void ics_cache_rehash(int num_buckets)
+{
+    ics_cache_entry_t** buckets = NEW_VEC0(ics_cache_entry_t*, num_buckets);
+
+    int i;
+    for (i = 0; i < ics_cache.num_buckets; i++)
+    {
+        ics_cache_entry_t* it = ics_cache.buckets[i];
+        while (it != NULL)
+        {
+            ics_cache_entry_t* next = it->next;
+            unsigned int h = ics_cache_hash(it->orig, it->dest, it->flags);
+            it->next = buckets[h % num_buckets];
+            buckets[h % num_buckets] = it;
+            it = next;
+        }
+    }
+    DELETE(ics_cache.buckets);
+
+    ics_cache.buckets = buckets;
+    ics_cache.num_buckets = num_buckets;
+}
+
+static ics_cache_entry_t* ics_cache_lookup(type_t* orig, type_t* dest, int flags)
+{
+    if (ics_cache.num_buckets == 0)
+        return NULL;
+
+    unsigned int h = ics_cache_hash(orig, dest, flags);
+    ics_cache_entry_t* it;
+    for (it = ics_cache.buckets[h % ics_cache.num_buckets];
+            it != NULL;
+            it = it->next)
+    {
+        if (it->orig == orig
+                && it->dest == dest
+                && it->flags == flags)
+            return it;
+    }
+
+    return NULL;
+}
+
+static void compute_ics_flags(type_t* orig, type_t* dest, const decl_context_t* decl_context, 
+        implicit_conversion_sequence_t *result, 
+        char no_user_defined_conversions,
+        char is_implicit_argument,
+        char needs_contextual_conversion,
+        ref_qualifier_t ref_qualifier,
+        const locus_t* locus)
+{
+    // Unresolved overloads and braced lists are resolved against the context
+    // and classes being instantiated are complete before having all their
+    // members
+    if (orig == NULL
+            || dest == NULL
+            || is_braced_list_type(orig)
+            || is_unresolved_overloaded_type(orig)
+            || instantiation_is_instantiating_class())
+    {
+        compute_ics_flags_(orig, dest, decl_context, result,
+                no_user_defined_conversions,
+                is_implicit_argument,
+                needs_contextual_conversion,
+                ref_qualifier,
+                locus);
+        return;
+    }
+
+    int flags = (!!no_user_defined_conversions)
+        | (!!is_implicit_argument << 1)
+        | (!!needs_contextual_conversion << 2)
+        | (ref_qualifier << 3);
+
+    ics_cache_entry_t* entry = ics_cache_lookup(orig, dest, flags);
+    if (entry != NULL)
+    {
+        if (!entry->until_completion
+                || entry->completion_counter == get_type_completion_counter())
+        {
+            DEBUG_CODE()
+            {
+                fprintf(stderr, "ICS: Using cached ICS from '%s' -> '%s'\n",
+                        print_declarator(orig),
+                        print_declarator(dest));
+            }
+            ics_cache.stats.num_hits++;
+            *result = entry->ics;
+            return;
+        }
+        ics_cache.stats.num_invalidated++;
+    }
+    else
+    {
+        ics_cache.stats.num_misses++;
+    }
+
+    compute_ics_flags_(orig, dest, decl_context, result,
+            no_user_defined_conversions,
+            is_implicit_argument,
+            needs_contextual_conversion,
+            ref_qualifier,
+            locus);
+
+    // Computing the ICS may have instantiated classes
+    if (instantiation_is_instantiating_class())
+        return;
+
+    if (entry == NULL)
+    {
+        // Computing the ICS may have added this very same entry
+        entry = ics_cache_lookup(orig, dest, flags);
+    }
+    if (entry == NULL)
+    {
+        if (ics_cache.num_entries >= 2 * ics_cache.num_buckets)
+        {
+            ics_cache_rehash(2 * ics_cache.num_buckets + 61);
+        }
+
+        entry = NEW0(ics_cache_entry_t);
+        entry->orig = orig;
+        entry->dest = dest;
+        entry->flags = flags;
+
+        unsigned int h = ics_cache_hash(orig, dest, flags);
+        entry->next = ics_cache.buckets[h % ics_cache.num_buckets];
+        ics_cache.buckets[h % ics_cache.num_buckets] = entry;
+
+        ics_cache.num_entries++;
+        if ((size_t)ics_cache.num_entries > ics_cache.stats.peak_entries)
+            ics_cache.stats.peak_entries = ics_cache.num_entries;
+    }
+
+    entry->until_completion = !ics_cache_type_is_stable(orig)
+        || !ics_cache_type_is_stable(dest);
+    entry->completion_counter = get_type_completion_counter();
+    entry->ics = *result;
+}
+
 static scope_entry_t* solve_overload_(candidate_t* candidate_set,
         const decl_context_t* decl_context,
         enum initialization_kind initialization_kind,
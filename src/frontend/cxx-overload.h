@@ -82,6 +82,24 @@ LIBMCXX_EXTERN char solve_list_initialization_of_class_type(
         scope_entry_t** constructor,
         scope_entry_list_t** candidates);
 
+LIBMCXX_EXTERN void overload_init(void);
+
+typedef
+struct ics_cache_stats_tag
+{
+    // Implicit conversion sequences found in the cache
+    size_t num_hits;
+    // Implicit conversion sequences not found in the cache
+    size_t num_misses;
+    // Implicit conversion sequences found but computed again because a type
+    // has been completed since they were cached
+    size_t num_invalidated;
+    // Largest number of implicit conversion sequences cached
+    size_t peak_entries;
+} ics_cache_stats_t;
+
+LIBMCXX_EXTERN void overload_get_ics_cache_stats(ics_cache_stats_t* stats);
+
 MCXX_END_DECLS
 
 #endif // CXX_OVERLOAD_H
@@ -0,0 +1,310 @@
+/*--------------------------------------------------------------------
+  (C) Copyright 2006-2013 Barcelona Supercomputing Center
+                          Centro Nacional de Supercomputacion
+  
+  This file is part of Mercurium C/C++ source-to-source compiler.
+  
+  See AUTHORS file in the top level directory for information
+  regarding developers and contributors.
+  
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3 of the License, or (at your option) any later version.
+  
+  Mercurium C/C++ source-to-source compiler is distributed in the hope
+  that it will be useful, but WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+  PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public
+  License along with Mercurium C/C++ source-to-source compiler; if
+  not, write to the Free Software Foundation, Inc., 675 Mass Ave,
+  Cambridge, MA 02139, USA.
+--------------------------------------------------------------------*/
+
+
+
+
+
+#ifdef HAVE_CONFIG_H
+  #include <config.h>
+#endif
+
+#include "cxx-phaseprofile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include "cxx-utils.h"
+#include "cxx-process.h"
+#include "uniquestr.h"
+#include "mem.h"
+
+typedef
+struct phase_profile_sample_tag
+{
+    struct timeval wall;
+    double cpu;
+    double children_cpu;
+    size_t allocations;
+    size_t allocated_bytes;
+} phase_profile_sample_t;
+
+typedef
+struct phase_profile_record_tag
+{
+    const char* name;
+    int depth;
+    // Sample taken when the phase started
+    phase_profile_sample_t start;
+
+    double wall_seconds;
+    double cpu_seconds;
+    double children_cpu_seconds;
+    long peak_rss_kib;
+    size_t allocations;
+    size_t allocated_bytes;
+} phase_profile_record_t;
+
+typedef
+struct phase_profile_unit_tag
+{
+    const char* input_filename;
+
+    // In the order the phases started
+    int num_records;
+    phase_profile_record_t* records;
+
+    // Indexes of the records of the phases that have not ended yet
+    int num_open_records;
+    int* open_records;
+
+    struct phase_profile_unit_tag* enclosing;
+} phase_profile_unit_t;
+
+static const char* phase_profile_output = NULL;
+static phase_profile_unit_t* current_unit = NULL;
+
+void phase_profile_set_output(const char* filename)
+{
+    phase_profile_output = uniquestr(filename);
+}
+
+char phase_profile_is_enabled(void)
+{
+    return phase_profile_output != NULL;
+}
+
+static double timeval_to_seconds(struct timeval t)
+{
+    return t.tv_sec + t.tv_usec / 1e6;
+}
+
+static void phase_profile_take_sample(phase_profile_sample_t* sample, long *peak_rss_kib)
+{
+    gettimeofday(&sample->wall, NULL);
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    sample->cpu = timeval_to_seconds(usage.ru_utime) + timeval_to_seconds(usage.ru_stime);
+    // On Linux ru_maxrss is in kibibytes
+    *peak_rss_kib = usage.ru_maxrss;
+
+    getrusage(RUSAGE_CHILDREN, &usage);
+    sample->children_cpu = timeval_to_seconds(usage.ru_utime) + timeval_to_seconds(usage.ru_stime);
+
+    xmem_get_counters(&sample->allocations, &sample->allocated_bytes);
+}
+
+void phase_profile_begin_translation_unit(const char* input_filename)
+{
+    if (!phase_profile_is_enabled())
+        return;
+
+    phase_profile_unit_t* unit = NEW0(phase_profile_unit_t);
+    unit->input_filename = uniquestr(input_filename);
+    unit->enclosing = current_unit;
+
+    current_unit = unit;
+}
+
+void phase_profile_start(const char* phase_name)
+{
+    if (current_unit == NULL)
+        return;
+
+    phase_profile_unit_t* unit = current_unit;
+
+    unit->num_records++;
+    unit->records = NEW_REALLOC(phase_profile_record_t, unit->records, unit->num_records);
+    phase_profile_record_t* record = &unit->records[unit->num_records - 1];
+    memset(record, 0, sizeof(*record));
+
+    record->name = uniquestr(phase_name);
+    record->depth = unit->num_open_records;
+
+    unit->num_open_records++;
+    unit->open_records = NEW_REALLOC(int, unit->open_records, unit->num_open_records);
+    unit->open_records[unit->num_open_records - 1] = unit->num_records - 1;
+
+    // Sample last so the bookkeeping above is not accounted to the phase
+    phase_profile_take_sample(&record->start, &record->peak_rss_kib);
+}
+
+void phase_profile_end(const char* phase_name)
+{
+    if (current_unit == NULL)
+        return;
+
+    phase_profile_sample_t end;
+    long peak_rss_kib;
+    phase_profile_take_sample(&end, &peak_rss_kib);
+
+    phase_profile_unit_t* unit = current_unit;
+    ERROR_CONDITION(unit->num_open_records == 0,
+            "Phase '%s' ended but no phase has been started", phase_name);
+
+    phase_profile_record_t* record = &unit->records[unit->open_records[unit->num_open_records - 1]];
+    ERROR_CONDITION(strcmp(record->name, phase_name) != 0,
+            "Phase '%s' ended before phase '%s'", phase_name, record->name);
+    unit->num_open_records--;
+
+    record->wall_seconds = timeval_to_seconds(end.wall) - timeval_to_seconds(record->start.wall);
+    record->cpu_seconds = end.cpu - record->start.cpu;
+    record->children_cpu_seconds = end.children_cpu - record->start.children_cpu;
+    record->peak_rss_kib = peak_rss_kib;
+    record->allocations = end.allocations - record->start.allocations;
+    record->allocated_bytes = end.allocated_bytes - record->start.allocated_bytes;
+}
+
+typedef
+struct json_buffer_tag
+{
+    char* str;
+    size_t length;
+    size_t capacity;
+} json_buffer_t;
+
+static void json_buffer_append(json_buffer_t* buffer, const char* str, size_t length)
+{
+    if (buffer->length + length + 1 > buffer->capacity)
+    {
+        buffer->capacity = 2 * (buffer->length + length) + 256;
+        buffer->str = NEW_REALLOC(char, buffer->str, buffer->capacity);
+    }
+    memcpy(&buffer->str[buffer->length], str, length);
+    buffer->length += length;
+    buffer->str[buffer->length] = '\0';
+}
+
+static void json_buffer_printf(json_buffer_t* buffer, const char* format, ...)
+{
+    char c[256];
+    va_list va;
+    va_start(va, format);
+    int length = vsnprintf(c, sizeof(c), format, va);
+    va_end(va);
+    ERROR_CONDITION(length < 0 || (size_t)length >= sizeof(c),
+            "Formatted value is too long", 0);
+
+    json_buffer_append(buffer, c, length);
+}
+
+static void json_buffer_append_string(json_buffer_t* buffer, const char* str)
+{
+    json_buffer_append(buffer, "\"", 1);
+    const char* p;
+    for (p = str; *p != '\0'; p++)
+    {
+        unsigned char c = *p;
+        if (c == '"' || c == '\\')
+        {
+            char escaped[2] = { '\\', c };
+            json_buffer_append(buffer, escaped, 2);
+        }
+        else if (c < 0x20)
+        {
+            json_buffer_printf(buffer, "\\u%04x", c);
+        }
+        else
+        {
+            json_buffer_append(buffer, p, 1);
+        }
+    }
+    json_buffer_append(buffer, "\"", 1);
+}
+
+static void phase_profile_write_unit(phase_profile_unit_t* unit)
+{
+    json_buffer_t buffer;
+    memset(&buffer, 0, sizeof(buffer));
+
+    json_buffer_printf(&buffer, "{\"file\": ");
+    json_buffer_append_string(&buffer, unit->input_filename);
+    json_buffer_printf(&buffer, ", \"phases\": [");
+
+    int i;
+    for (i = 0; i < unit->num_records; i++)
+    {
+        phase_profile_record_t* record = &unit->records[i];
+        if (i > 0)
+            json_buffer_printf(&buffer, ", ");
+
+        json_buffer_printf(&buffer, "{\"name\": ");
+        json_buffer_append_string(&buffer, record->name);
+        json_buffer_printf(&buffer, ", \"depth\": %d", record->depth);
+        json_buffer_printf(&buffer, ", \"wall_seconds\": %.6f", record->wall_seconds);
+        json_buffer_printf(&buffer, ", \"cpu_seconds\": %.6f", record->cpu_seconds);
+        json_buffer_printf(&buffer, ", \"children_cpu_seconds\": %.6f", record->children_cpu_seconds);
+        json_buffer_printf(&buffer, ", \"peak_rss_kib\": %ld", record->peak_rss_kib);
+        json_buffer_printf(&buffer, ", \"allocations\": %zu", record->allocations);
+        json_buffer_printf(&buffer, ", \"allocated_bytes\": %zu}", record->allocated_bytes);
+    }
+    json_buffer_printf(&buffer, "]}\n");
+
+    // A single write in append mode keeps the lines of several compiler
+    // processes (e.g. with -j) writing to the same file apart
+    int fd = open(phase_profile_output, O_WRONLY | O_CREAT | O_APPEND, 0666);
+    if (fd < 0)
+    {
+        fatal_error("error: cannot open phase profile file '%s' (%s)\n",
+                phase_profile_output, strerror(errno));
+    }
+    ssize_t written = write(fd, buffer.str, buffer.length);
+    if (written < 0
+            || (size_t)written != buffer.length)
+    {
+        fatal_error("error: cannot write phase profile file '%s' (%s)\n",
+                phase_profile_output, strerror(errno));
+    }
+    close(fd);
+
+    DELETE(buffer.str);
+}
+
+void phase_profile_end_translation_unit(void)
+{
+    if (current_unit == NULL)
+        return;
+
+    phase_profile_unit_t* unit = current_unit;
+    ERROR_CONDITION(unit->num_open_records != 0,
+            "Translation unit '%s' ended before phase '%s'",
+            unit->input_filename,
+            unit->records[unit->open_records[unit->num_open_records - 1]].name);
+
+    phase_profile_write_unit(unit);
+
+    current_unit = unit->enclosing;
+
+    DELETE(unit->records);
+    DELETE(unit->open_records);
+    DELETE(unit);
+}
@@ -0,0 +1,58 @@
+/*--------------------------------------------------------------------
+  (C) Copyright 2006-2013 Barcelona Supercomputing Center
+                          Centro Nacional de Supercomputacion
+  
+  This file is part of Mercurium C/C++ source-to-source compiler.
+  
+  See AUTHORS file in the top level directory for information
+  regarding developers and contributors.
+  
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3 of the License, or (at your option) any later version.
+  
+  Mercurium C/C++ source-to-source compiler is distributed in the hope
+  that it will be useful, but WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+  PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public
+  License along with Mercurium C/C++ source-to-source compiler; if
+  not, write to the Free Software Foundation, Inc., 675 Mass Ave,
+  Cambridge, MA 02139, USA.
+--------------------------------------------------------------------*/
+
+
+
+
+#ifndef CXX_PHASEPROFILE_H
+#define CXX_PHASEPROFILE_H
+
+#include "libmcxx-common.h"
+#include "cxx-macros.h"
+
+MCXX_BEGIN_DECLS
+
+// Profiling of the phases that compile every translation unit (see
+// --phase-profile). For every phase it records wall time, CPU time of the
+// compiler and of its children, peak RSS and allocations. When a translation
+// unit ends its phases are appended to the output file as a single line of
+// JSON. Phases nest and the measurements of a phase include those of the
+// phases run inside it. Nothing is recorded if no output file has been set
+
+LIBMCXX_EXTERN void phase_profile_set_output(const char* filename);
+LIBMCXX_EXTERN char phase_profile_is_enabled(void);
+
+// Translation units may nest too (e.g. secondary translation units)
+LIBMCXX_EXTERN void phase_profile_begin_translation_unit(const char* input_filename);
+LIBMCXX_EXTERN void phase_profile_end_translation_unit(void);
+
+// Phases must end in the reverse order they started
+LIBMCXX_EXTERN void phase_profile_start(const char* phase_name);
+LIBMCXX_EXTERN void phase_profile_end(const char* phase_name);
+
+MCXX_END_DECLS
+
+#endif // CXX_PHASEPROFILE_H
@@ -333,6 +333,9 @@ struct scope_entry_tag
     // specially for the injected class-name, where printing it in print scope
     // routines would create an infinite recursion.
     bool do_not_print:1;
+    // Some related symbols of this symbol have not been loaded yet (see
+    // symbol_entity_specs_load_lazy_related_symbols)
+    bool lazy_related_symbols:1;
 
     // Decl context when the symbol was declared it contains the scope where
     // the symbol was registered
@@ -375,6 +378,9 @@ enum scope_kind
 };
 
 // This is the scope
+typedef struct lazy_builtins_tag lazy_builtins_t;
+typedef struct fortran_lazy_uses_tag fortran_lazy_uses_t;
+
 struct scope_tag
 {
     // Kind of this scope
@@ -399,6 +405,12 @@ struct scope_tag
     // they contain the namespace symbol, the class symbol
     // and the function symbol
     scope_entry_t* related_entry;
+
+    // Builtins not signed in yet, see cxx-lazybuiltins.h
+    lazy_builtins_t* lazy_builtins;
+
+    // USE-associated names not signed in yet, see fortran03-scope.h
+    fortran_lazy_uses_t* fortran_lazy_uses;
 };
 
 typedef const char* (*print_symbol_callback_t)(scope_entry_t*, const decl_context_t*, void*);
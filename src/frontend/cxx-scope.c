@@ -48,6 +48,8 @@
 #include "cxx-codegen.h"
 #include "cxx-entrylist.h"
 #include "cxx-diagnostic.h"
+#include "cxx-lazybuiltins.h"
+#include "fortran/fortran03-scope.h"
 #include "dhash_ptr.h"
 
 
@@ -432,6 +434,190 @@ decl_context_t* new_class_context(const decl_context_t* enclosing_context,
     return result;
 }
 
+// Journals of symbols inserted in a scope so they can be removed later.
+// Only the innermost journal of each scope records insertions
+typedef struct scope_journal_item_tag
+{
+    scope_t* sc;
+    const char* name;
+    scope_entry_t* entry;
+    // A copy of the symbols called name right before entry was inserted
+    scope_entry_list_t* previous;
+} scope_journal_item_t;
+
+struct scope_journal_tag
+{
+    scope_t* sc;
+
+    int num_items;
+    int size_items;
+    scope_journal_item_t* items;
+
+    char is_recording;
+    scope_journal_t* enclosing;
+};
+
+static scope_journal_t* current_scope_journal = NULL;
+
+static void scope_journal_add_item(scope_journal_t* journal,
+        scope_t* sc, const char* name, scope_entry_t* entry,
+        scope_entry_list_t* previous)
+{
+    if (journal->num_items == journal->size_items)
+    {
+        journal->size_items = 2 * journal->size_items + 8;
+        journal->items = NEW_REALLOC(scope_journal_item_t,
+                journal->items, journal->size_items);
+    }
+    scope_journal_item_t* item = &journal->items[journal->num_items];
+    item->sc = sc;
+    item->name = name;
+    item->entry = entry;
+    item->previous = previous;
+    journal->num_items++;
+}
+
+// Must be called before entry is inserted as name
+static void scope_journal_record(scope_t* sc, const char* name, scope_entry_t* entry)
+{
+    scope_journal_t* journal = current_scope_journal;
+    while (journal != NULL
+            && journal->sc != sc)
+    {
+        journal = journal->enclosing;
+    }
+
+    if (journal == NULL)
+        return;
+
+    scope_journal_add_item(journal, sc, name, entry,
+            entry_list_copy((scope_entry_list_t*)dhash_ptr_query(sc->dhash, name)));
+}
+
+scope_journal_t* scope_journal_begin(scope_t* sc)
+{
+    scope_journal_t* journal = NEW0(scope_journal_t);
+    journal->sc = sc;
+    journal->is_recording = 1;
+    journal->enclosing = current_scope_journal;
+
+    current_scope_journal = journal;
+
+    return journal;
+}
+
+// Symbols may have been inserted more than once under the same name, even
+// before the journal started, so do not just remove entry
+static void restore_previous_aliases(scope_t* sc, const char* name,
+        scope_entry_list_t* previous)
+{
+    if (previous == NULL)
+    {
+        dhash_ptr_remove(sc->dhash, name);
+    }
+    else
+    {
+        // Keep previous, an enclosing journal may have to restore it again
+        dhash_ptr_insert(sc->dhash, name, entry_list_copy(previous));
+    }
+}
+
+static void restore_alias(scope_t* sc, scope_entry_t* entry, const char* name)
+{
+    scope_entry_list_t* entry_list = dhash_ptr_query(sc->dhash, name);
+    if (entry_list == NULL)
+    {
+        entry_list = entry_list_new(entry);
+    }
+    else if (!entry_list_contains(entry_list, entry))
+    {
+        entry_list = entry_list_prepend(entry_list, entry);
+    }
+
+    dhash_ptr_insert(sc->dhash, name, entry_list);
+}
+
+void scope_journal_end(scope_journal_t* journal)
+{
+    ERROR_CONDITION(journal != current_scope_journal, "Journal is not the innermost one", 0);
+
+    journal->is_recording = 0;
+    current_scope_journal = journal->enclosing;
+
+    // Remove the symbols until the journal is committed, so what is checked
+    // afterwards cannot find them. Undoing the insertions in reverse order
+    // leaves every name as it was when the journal started
+    int i;
+    for (i = journal->num_items - 1; i >= 0; i--)
+    {
+        restore_previous_aliases(journal->items[i].sc,
+                journal->items[i].name,
+                journal->items[i].previous);
+    }
+}
+
+static void scope_journal_free(scope_journal_t* journal, char free_previous)
+{
+    if (free_previous)
+    {
+        int i;
+        for (i = 0; i < journal->num_items; i++)
+        {
+            entry_list_free(journal->items[i].previous);
+        }
+    }
+
+    DELETE(journal->items);
+    DELETE(journal);
+}
+
+int scope_journal_rollback(scope_journal_t* journal)
+{
+    ERROR_CONDITION(journal->is_recording, "Journal is still recording", 0);
+
+    int num_items = journal->num_items;
+
+    scope_journal_free(journal, /* free_previous */ 1);
+
+    return num_items;
+}
+
+void scope_journal_commit(scope_journal_t* journal)
+{
+    ERROR_CONDITION(journal->is_recording, "Journal is still recording", 0);
+
+    int i;
+    for (i = 0; i < journal->num_items; i++)
+    {
+        restore_alias(journal->items[i].sc,
+                journal->items[i].entry,
+                journal->items[i].name);
+    }
+
+    // Symbols kept here can still be removed by an enclosing journal of the
+    // same scope
+    scope_journal_t* enclosing = journal->enclosing;
+    while (enclosing != NULL
+            && enclosing->sc != journal->sc)
+    {
+        enclosing = enclosing->enclosing;
+    }
+    char handed_over = (enclosing != NULL && enclosing->is_recording);
+    if (handed_over)
+    {
+        for (i = 0; i < journal->num_items; i++)
+        {
+            scope_journal_add_item(enclosing,
+                    journal->items[i].sc,
+                    journal->items[i].name,
+                    journal->items[i].entry,
+                    journal->items[i].previous);
+        }
+    }
+
+    scope_journal_free(journal, /* free_previous */ !handed_over);
+}
+
 void insert_alias(scope_t* sc, scope_entry_t* entry, const char* name)
 {
     ERROR_CONDITION(name == NULL ||
@@ -439,8 +625,16 @@ void insert_alias(scope_t* sc, scope_entry_t* entry, const char* name)
 
     const char* symbol_name = uniquestr(name);
 
+    // Builtins with this name must be there before
+    if (sc->lazy_builtins != NULL)
+        lazy_builtins_sign_in(sc, symbol_name);
+    // Likewise for USE-associated names
+    if (sc->fortran_lazy_uses != NULL)
+        fortran_lazy_uses_sign_in(sc, symbol_name);
+
     scope_entry_list_t* result_set = (scope_entry_list_t*)dhash_ptr_query(sc->dhash, symbol_name);
 
+    scope_journal_record(sc, symbol_name, entry);
     if (result_set != NULL)
     {
         result_set = entry_list_prepend(result_set, entry);
@@ -463,6 +657,52 @@ static const char* scope_names[] =
     [CLASS_SCOPE] = "CLASS_SCOPE",
 };
 
+static entity_specs_stats_t entity_specs_stats;
+
+const entity_specifiers_sparse_t entity_specifiers_sparse_empty;
+
+void symbol_entity_specs_allocate_sparse(scope_entry_t* s)
+{
+    entity_specifiers_sparse_t* sparse = NEW0(entity_specifiers_sparse_t);
+    if (s->_entity_specs._sparse != NULL)
+    {
+        // This symbol shares the current structure with its copies
+        *sparse = *s->_entity_specs._sparse;
+        entity_specifiers_sparse_copy_lists(sparse);
+        s->_entity_specs._sparse->_refcount--;
+        entity_specs_stats.num_sparse_unshared++;
+    }
+    sparse->_refcount = 1;
+    s->_entity_specs._sparse = sparse;
+
+    entity_specs_stats.num_sparse_allocated++;
+}
+
+void symbol_entity_specs_free_sparse(scope_entry_t* s)
+{
+    if (s->_entity_specs._sparse != NULL)
+    {
+        s->_entity_specs._sparse->_refcount--;
+        if (s->_entity_specs._sparse->_refcount == 0)
+        {
+            DELETE(s->_entity_specs._sparse);
+            entity_specs_stats.num_sparse_freed++;
+        }
+    }
+    s->_entity_specs._sparse = NULL;
+}
+
+void symbol_entity_specs_share_sparse(scope_entry_t* s)
+{
+    if (s->_entity_specs._sparse != NULL)
+        s->_entity_specs._sparse->_refcount++;
+}
+
+void symbol_entity_specs_get_stats(entity_specs_stats_t* stats)
+{
+    *stats = entity_specs_stats;
+}
+
 scope_entry_t* new_symbol(const decl_context_t* decl_context, scope_t* sc, const char* name)
 {
     ERROR_CONDITION(name == NULL ||
@@ -471,6 +711,7 @@ scope_entry_t* new_symbol(const decl_context_t* decl_context, scope_t* sc, const
     // ERROR_CONDITION(name != uniquestr(name), "Invalid name", 0);
 
     scope_entry_t* result = NEW0(scope_entry_t);
+    entity_specs_stats.num_symbols++;
 
     result->symbol_name = uniquestr(name);
     result->decl_context = decl_context;
@@ -508,6 +749,22 @@ static scope_entry_list_t* query_name_in_scope(scope_t* sc, const char* name)
 
     scope_entry_list_t *result = (scope_entry_list_t*)dhash_ptr_query(sc->dhash, name);
 
+    if (result == NULL
+            && sc->lazy_builtins != NULL)
+    {
+        // Maybe a builtin not signed in yet
+        lazy_builtins_sign_in(sc, name);
+        result = (scope_entry_list_t*)dhash_ptr_query(sc->dhash, name);
+    }
+
+    if (result == NULL
+            && sc->fortran_lazy_uses != NULL)
+    {
+        // Maybe a USE-associated name not signed in yet
+        fortran_lazy_uses_sign_in(sc, name);
+        result = (scope_entry_list_t*)dhash_ptr_query(sc->dhash, name);
+    }
+
     // ERROR_CONDITION(name != uniquestr(name), "Invalid name", 0);
 
     DEBUG_CODE()
@@ -533,6 +790,12 @@ void insert_entry(scope_t* sc, scope_entry_t* entry)
     ERROR_CONDITION((entry->symbol_name == NULL), "Inserting a symbol entry without name!", 0);
     // ERROR_CONDITION(entry->symbol_name != uniquestr(entry->symbol_name), "Name of symbol not canonical", 0);
 
+    // Builtins with this name must be there before
+    if (sc->lazy_builtins != NULL)
+        lazy_builtins_sign_in(sc, entry->symbol_name);
+    if (sc->fortran_lazy_uses != NULL)
+        fortran_lazy_uses_sign_in(sc, entry->symbol_name);
+
     scope_entry_list_t* result_set = (scope_entry_list_t*)dhash_ptr_query(sc->dhash, entry->symbol_name);
 
     if (result_set != NULL)
@@ -552,12 +815,14 @@ void insert_entry(scope_t* sc, scope_entry_t* entry)
 
         if (!do_not_add)
         {
+            scope_journal_record(sc, entry->symbol_name, entry);
             result_set = entry_list_prepend(result_set, entry);
             dhash_ptr_insert(sc->dhash, entry->symbol_name, result_set);
         }
     }
     else
     {
+        scope_journal_record(sc, entry->symbol_name, entry);
         result_set = entry_list_new(entry);
         dhash_ptr_insert(sc->dhash, entry->symbol_name, result_set);
     }
@@ -6423,10 +6688,20 @@ static void for_each_fun_adaptor(const void* key UNUSED_PARAMETER, void* info, v
     (adaptor_data->fun)(entry_list_copy(it), adaptor_data->data);
 }
 
+void scope_sign_in_lazy_entities(scope_t* sc)
+{
+    if (sc->lazy_builtins != NULL)
+        lazy_builtins_sign_in_all(sc);
+    if (sc->fortran_lazy_uses != NULL)
+        fortran_lazy_uses_sign_in_all(sc);
+}
+
 void scope_for_each_entity(scope_t* sc, void *data, void (*fun)(scope_entry_list_t*, void*))
 {
     struct fun_adaptor_data_tag fun_adaptor_data = { .data = data, .fun = fun };
 
+    scope_sign_in_lazy_entities(sc);
+
     dhash_ptr_walk(sc->dhash, (dhash_ptr_walk_fn*)for_each_fun_adaptor, &fun_adaptor_data);
 }
 
@@ -30,6 +30,8 @@
 #ifndef CXX_SCOPE_H
 #define CXX_SCOPE_H
 
+#include <stddef.h>
+
 #include "libmcxx-common.h"
 #include "cxx-macros.h"
 #include "cxx-ast-decls.h"
@@ -62,6 +64,34 @@ LIBMCXX_EXTERN void remove_entry(struct scope_tag* st, scope_entry_t* entry);
 LIBMCXX_EXTERN void insert_entry(struct scope_tag* st, scope_entry_t* entry);
 LIBMCXX_EXTERN void insert_alias(struct scope_tag* st, scope_entry_t* entry, const char* alias_name);
 
+// Journals record the symbols inserted in a given scope between
+// scope_journal_begin and scope_journal_end. Journals nest and only the
+// innermost journal of a scope records. Ending a journal removes its symbols
+// from the scope. Then it is either rolled back, which forgets them, or
+// committed, which inserts them again and passes them to the enclosing
+// journal of the same scope
+typedef struct scope_journal_tag scope_journal_t;
+LIBMCXX_EXTERN scope_journal_t* scope_journal_begin(struct scope_tag* st);
+LIBMCXX_EXTERN void scope_journal_end(scope_journal_t* journal);
+// Returns the number of symbols removed
+LIBMCXX_EXTERN int scope_journal_rollback(scope_journal_t* journal);
+LIBMCXX_EXTERN void scope_journal_commit(scope_journal_t* journal);
+
+// Rare attributes of the symbols are kept in an entity_specifiers_sparse_t
+// allocated on demand, see cxx-entity-specs.h
+typedef struct entity_specs_stats_tag
+{
+    // Symbols created by new_symbol
+    size_t num_symbols;
+    size_t num_sparse_allocated;
+    // Allocations of symbols that shared the structure of the symbol they
+    // were copied from
+    size_t num_sparse_unshared;
+    size_t num_sparse_freed;
+} entity_specs_stats_t;
+
+LIBMCXX_EXTERN void symbol_entity_specs_get_stats(entity_specs_stats_t* stats);
+
 // Given a list of symbols, purge all those that are not of symbol_kind kind
 LIBMCXX_EXTERN scope_entry_list_t* filter_symbol_kind(scope_entry_list_t* entry_list, enum cxx_symbol_kind symbol_kind);
 // Similar but can be used to filter based on a kind set
@@ -222,6 +252,9 @@ LIBMCXX_EXTERN template_parameter_value_t* update_template_parameter_value(
 LIBMCXX_EXTERN char is_friend_declared(scope_entry_t* entry);
 
 // Iteration in scopes
+// Builtins and USE-associated names are signed in on demand, code walking the
+// dhash of a scope must sign all of them in first
+LIBMCXX_EXTERN void scope_sign_in_lazy_entities(scope_t* sc);
 LIBMCXX_EXTERN void scope_for_each_entity(scope_t* sc, void *data, void (fun)(scope_entry_list_t*, void*));
 
 // Internal use only
@@ -0,0 +1,448 @@
+/*--------------------------------------------------------------------
+  (C) Copyright 2006-2015 Barcelona Supercomputing Center
+                          Centro Nacional de Supercomputacion
+  
+  This file is part of Mercurium C/C++ source-to-source compiler.
+  
+  See AUTHORS file in the top level directory for information
+  regarding developers and contributors.
+  
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3 of the License, or (at your option) any later version.
+  
+  Mercurium C/C++ source-to-source compiler is distributed in the hope
+  that it will be useful, but WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+  PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public
+  License along with Mercurium C/C++ source-to-source compiler; if
+  not, write to the Free Software Foundation, Inc., 675 Mass Ave,
+  Cambridge, MA 02139, USA.
+--------------------------------------------------------------------*/
+
+/*
+ * Microbenchmark for the tables of cxx-type-trie.c
+ *
+ * Compares the hash table of type sequences used by the frontend with the
+ * sorted array trie it replaced, which is kept here as a reference. Both are
+ * fed the same sequences, mimicking the way function types are built: the
+ * builtins first, each one with its own parameters, and then lookups of
+ * sequences skewed towards the most common parameter types, some of which
+ * are not there and have to be inserted.
+ *
+ * Types are never dereferenced, so they are addresses of a contiguous array,
+ * like types allocated one after the other.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/time.h>
+
+#include "cxx-type-trie.h"
+#include "mem.h"
+
+#define HELP_MESSAGE \
+"Syntax: \n" \
+"  type_trie_bench [-r repetitions] [-s seed] [-n sequences] [-t types] [-l max_length]" \
+"\n"
+
+static int repetitions = 10;
+static unsigned int seed = 1234;
+static int num_sequences = 30000;
+static int num_types = 2000;
+static int max_length = 6;
+
+static void help_message(const char* error_message)
+{
+    if (error_message != NULL)
+    {
+        fprintf(stderr, "Error: %s\n\n", error_message);
+    }
+    fprintf(stderr, HELP_MESSAGE);
+    exit(EXIT_FAILURE);
+}
+
+// ****************************************************************************
+// Sorted array trie, as cxx-type-trie.c implemented it before
+// ****************************************************************************
+
+typedef struct sorted_trie_tag sorted_trie_t;
+
+typedef struct sorted_trie_element_tag
+{
+    const type_t* elem;
+    // Only valid when next == NULL
+    const type_t *function_type;
+    sorted_trie_t* next;
+} sorted_trie_element_t;
+
+struct sorted_trie_tag
+{
+    int capacity;
+    int num_elements;
+    sorted_trie_element_t* elements;
+};
+
+static sorted_trie_t* sorted_trie_allocate(void)
+{
+    sorted_trie_t* t = NEW0(sorted_trie_t);
+    t->capacity = 1;
+    t->elements = NEW_VEC0(sorted_trie_element_t, t->capacity);
+    return t;
+}
+
+static void sorted_trie_free(sorted_trie_t* t)
+{
+    int i;
+    for (i = 0; i < t->num_elements; i++)
+    {
+        if (t->elements[i].next != NULL)
+            sorted_trie_free(t->elements[i].next);
+    }
+    DELETE(t->elements);
+    DELETE(t);
+}
+
+static sorted_trie_element_t* sorted_trie_lookup_element(const sorted_trie_t* t,
+        const type_t* entity, int lower, int upper)
+{
+    if (lower > upper)
+        return NULL;
+
+    int middle = (lower + upper) / 2;
+    const type_t* i_middle = t->elements[middle].elem;
+
+    if (entity < i_middle)
+        return sorted_trie_lookup_element(t, entity, lower, middle - 1);
+    else if (i_middle < entity)
+        return sorted_trie_lookup_element(t, entity, middle + 1, upper);
+    else
+        return &(t->elements[middle]);
+}
+
+static const type_t* sorted_trie_lookup(const sorted_trie_t* t, const type_t** type_seq, int length)
+{
+    if (length == 0)
+    {
+        if (t->num_elements > 0
+                && t->elements[0].elem == NULL)
+        {
+            return t->elements[0].function_type;
+        }
+        return NULL;
+    }
+
+    sorted_trie_element_t* elem = sorted_trie_lookup_element(t, *type_seq, 0, t->num_elements - 1);
+    if (elem == NULL)
+        return NULL;
+    return sorted_trie_lookup(elem->next, type_seq + 1, length - 1);
+}
+
+static void sorted_trie_create_elements(sorted_trie_t* t, const type_t** type_seq,
+        const type_t* function_type, int length)
+{
+    t->num_elements++;
+    if (t->capacity == t->num_elements)
+    {
+        t->capacity *= 2;
+        t->elements = NEW_REALLOC(sorted_trie_element_t, t->elements, t->capacity);
+    }
+
+    const type_t* i_entity = NULL;
+    if (length != 0)
+        i_entity = *type_seq;
+
+    // Locate the place where the element goes
+    int lower = 0;
+    int upper = t->num_elements - 2;
+    while (lower <= upper)
+    {
+        int middle = (lower + upper) / 2;
+        const type_t* i_middle = t->elements[middle].elem;
+        if (i_entity < i_middle)
+            upper = middle - 1;
+        else
+            lower = middle + 1;
+    }
+
+    int i;
+    for (i = t->num_elements - 1; i > lower; i--)
+    {
+        t->elements[i] = t->elements[i - 1];
+    }
+
+    if (length == 0)
+    {
+        t->elements[lower].elem = NULL;
+        t->elements[lower].next = NULL;
+        t->elements[lower].function_type = function_type;
+    }
+    else
+    {
+        t->elements[lower].elem = *type_seq;
+        t->elements[lower].next = sorted_trie_allocate();
+        sorted_trie_create_elements(t->elements[lower].next,
+                type_seq + 1, function_type, length - 1);
+    }
+}
+
+static void sorted_trie_insert(sorted_trie_t* t, const type_t** type_seq,
+        const type_t* function_type, int length)
+{
+    if (length == 0)
+    {
+        if (t->num_elements == 0
+                || t->elements[0].elem != NULL)
+        {
+            sorted_trie_create_elements(t, type_seq, function_type, length);
+        }
+        return;
+    }
+
+    sorted_trie_element_t* elem = sorted_trie_lookup_element(t, *type_seq, 0, t->num_elements - 1);
+    if (elem == NULL)
+    {
+        // None of the remaining elements will be found
+        sorted_trie_create_elements(t, type_seq, function_type, length);
+    }
+    else
+    {
+        sorted_trie_insert(elem->next, type_seq + 1, function_type, length - 1);
+    }
+}
+
+// ****************************************************************************
+// Workload
+// ****************************************************************************
+
+typedef
+struct sequence_tag
+{
+    int length;
+    const type_t** types;
+    // The type built for this sequence
+    const type_t* result;
+} sequence_t;
+
+// Sequences inserted up front, like the builtins
+static sequence_t* inserted = NULL;
+static int num_inserted = 0;
+// Sequences looked up afterwards, and inserted when not found
+static sequence_t* looked_up = NULL;
+static int num_looked_up = 0;
+
+// Storage of the fake types
+typedef
+struct fake_type_tag
+{
+    char storage[32];
+} fake_type_t;
+static fake_type_t* fake_types = NULL;
+
+static unsigned int random_state;
+static unsigned int next_random(void)
+{
+    random_state = random_state * 1103515245u + 12345u;
+    return (random_state >> 16) & 0x7fff;
+}
+
+// Skewed towards small values, like the frequency of parameter types
+static int skewed_random(int n)
+{
+    unsigned int r = next_random();
+    return (int)(((uint64_t)r * r * n) / (0x8000u * 0x8000u));
+}
+
+static void random_sequence(sequence_t* seq, int skewed)
+{
+    seq->length = next_random() % (max_length + 1);
+    seq->types = NEW_VEC(const type_t*, seq->length + 1);
+    int i;
+    for (i = 0; i < seq->length; i++)
+    {
+        int t = skewed ? skewed_random(num_types) : (int)(next_random() % num_types);
+        seq->types[i] = (const type_t*)&fake_types[t];
+    }
+    seq->result = (const type_t*)&fake_types[next_random() % num_types];
+}
+
+static void synthesize_workload(void)
+{
+    random_state = seed;
+
+    fake_types = NEW_VEC0(fake_type_t, num_types);
+
+    num_inserted = num_sequences;
+    inserted = NEW_VEC(sequence_t, num_inserted);
+    int i;
+    for (i = 0; i < num_inserted; i++)
+    {
+        random_sequence(&inserted[i], /* skewed */ 0);
+    }
+
+    num_looked_up = 4 * num_sequences;
+    looked_up = NEW_VEC(sequence_t, num_looked_up);
+    for (i = 0; i < num_looked_up; i++)
+    {
+        // Half of the lookups ask again for sequences already there
+        if (next_random() % 2 == 0)
+            looked_up[i] = inserted[next_random() % num_inserted];
+        else
+            random_sequence(&looked_up[i], /* skewed */ 1);
+    }
+}
+
+static double now(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+typedef
+struct results_tag
+{
+    double insert_time;
+    double lookup_time;
+    int num_found;
+} results_t;
+
+static void run_sorted_trie(results_t* results)
+{
+    int i;
+    double start = now();
+    sorted_trie_t* t = sorted_trie_allocate();
+    for (i = 0; i < num_inserted; i++)
+    {
+        sorted_trie_insert(t, inserted[i].types, inserted[i].result, inserted[i].length);
+    }
+    results->insert_time = now() - start;
+
+    results->num_found = 0;
+    start = now();
+    for (i = 0; i < num_looked_up; i++)
+    {
+        if (sorted_trie_lookup(t, looked_up[i].types, looked_up[i].length) != NULL)
+            results->num_found++;
+        else
+            sorted_trie_insert(t, looked_up[i].types, looked_up[i].result, looked_up[i].length);
+    }
+    results->lookup_time = now() - start;
+
+    sorted_trie_free(t);
+}
+
+static void run_hash_table(results_t* results)
+{
+    int i;
+    double start = now();
+    // The tables of the frontend are never freed
+    type_trie_t* t = allocate_type_trie();
+    for (i = 0; i < num_inserted; i++)
+    {
+        insert_type_trie(t, inserted[i].types, inserted[i].length, inserted[i].result);
+    }
+    results->insert_time = now() - start;
+
+    results->num_found = 0;
+    start = now();
+    for (i = 0; i < num_looked_up; i++)
+    {
+        if (lookup_type_trie(t, looked_up[i].types, looked_up[i].length) != NULL)
+            results->num_found++;
+        else
+            insert_type_trie(t, looked_up[i].types, looked_up[i].length, looked_up[i].result);
+    }
+    results->lookup_time = now() - start;
+}
+
+static int run(const char* name, void (*run_table)(results_t*))
+{
+    results_t best;
+    memset(&best, 0, sizeof(best));
+    int i;
+    for (i = 0; i < repetitions; i++)
+    {
+        results_t current;
+        run_table(&current);
+
+        if (i == 0 || current.insert_time < best.insert_time)
+            best.insert_time = current.insert_time;
+        if (i == 0 || current.lookup_time < best.lookup_time)
+            best.lookup_time = current.lookup_time;
+        best.num_found = current.num_found;
+    }
+
+    fprintf(stdout, "%-12s insert %8.2f ns/op   lookup %8.2f ns/op (%d found)\n",
+            name,
+            best.insert_time * 1e9 / num_inserted,
+            best.lookup_time * 1e9 / num_looked_up,
+            best.num_found);
+
+    return best.num_found;
+}
+
+#define GETOPT_OPTIONS "r:s:n:t:l:h"
+static void parse_arguments(int argc, char* argv[])
+{
+    int n;
+    while ((n = getopt(argc, argv, GETOPT_OPTIONS)) != -1)
+    {
+        switch (n)
+        {
+            case 'r':
+                repetitions = atoi(optarg);
+                if (repetitions <= 0)
+                    help_message("Invalid number of repetitions");
+                break;
+            case 's':
+                seed = (unsigned int)strtoul(optarg, NULL, 10);
+                break;
+            case 'n':
+                num_sequences = atoi(optarg);
+                if (num_sequences <= 0)
+                    help_message("Invalid number of sequences");
+                break;
+            case 't':
+                num_types = atoi(optarg);
+                if (num_types <= 0)
+                    help_message("Invalid number of types");
+                break;
+            case 'l':
+                max_length = atoi(optarg);
+                if (max_length < 0)
+                    help_message("Invalid maximum length");
+                break;
+            default:
+                help_message(NULL);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    parse_arguments(argc, argv);
+
+    synthesize_workload();
+
+    fprintf(stdout, "%d inserts and %d lookups of up to %d types out of %d, best of %d runs\n",
+            num_inserted, num_looked_up, max_length, num_types, repetitions);
+
+    int found_trie = run("sorted trie", run_sorted_trie);
+    int found_hash = run("hash table", run_hash_table);
+
+    if (found_trie != found_hash)
+    {
+        fprintf(stderr, "Error: both tables should find the same sequences\n");
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
@@ -31,200 +31,181 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include "cxx-typeutils.h"
 
-typedef struct type_trie_element_tag
+/*
+ * Despite its name this is a hash table keyed by the whole sequence of
+ * types. Sequences are interned in a single array owned by the table, so a
+ * lookup hashes the sequence once and probes a flat vector of entries
+ * instead of walking one allocation per element of the sequence.
+ */
+
+typedef struct type_trie_entry_tag
 {
-    const type_t* elem;
-    // Only valid when next == NULL
-    const type_t *function_type;
-    type_trie_t* next;
-} type_trie_element_t;
+    unsigned int hash;
+    int num_types;
+    // Offset of the sequence in the interned types of the table. Negative
+    // if the entry is empty
+    int first_type;
+    const type_t* result;
+} type_trie_entry_t;
 
 struct type_trie_tag
 {
-    int capacity;
-    int num_elements;
-    type_trie_element_t* elements;
+    // Always a power of two
+    int num_entries;
+    int num_used;
+    type_trie_entry_t* entries;
+
+    int num_types;
+    int size_types;
+    const type_t** types;
 };
 
-static type_trie_element_t *lookup_element(const type_trie_t* type_trie, const type_t** type_seq);
+static type_trie_stats_t type_trie_stats;
 
-static const type_t* lookup_list(const type_trie_t* type_trie, const type_t** type_seq, int length)
+void type_trie_get_stats(type_trie_stats_t* stats)
 {
-    if (length == 0)
-    {
-        if (type_trie->num_elements > 0
-                && type_trie->elements[0].elem == NULL)
-        {
-            return type_trie->elements[0].function_type;
-        }
-        return NULL;
-    }
-    else
-    {
-        type_trie_element_t* elem = lookup_element(type_trie, type_seq);
-        if (elem == NULL)
-            return NULL;
-        else
-            return lookup_list(elem->next, type_seq + 1, length - 1);
-    }
+    *stats = type_trie_stats;
 }
 
-static const type_t* create_elements(type_trie_t* type_trie, const type_t **type_seq, const type_t* function_type, int length);
-
-static const type_t* insert_list_rec(type_trie_t* type_trie, const type_t **type_seq, const type_t* function_type, int length)
+static unsigned int hash_type_seq(const type_t** type_seq, int num_types)
 {
-    if (length == 0)
+    // Types are allocated close to each other so their addresses must be
+    // mixed well, otherwise linear probing clusters
+    uint64_t h = num_types;
+    int i;
+    for (i = 0; i < num_types; i++)
     {
-        if ((type_trie->num_elements == 0)
-                || (type_trie->elements[0].elem != 0))
-        {
-            return create_elements(type_trie, type_seq, function_type, length);
-        }
-        return NULL;
+        h = (h ^ (uint64_t)(uintptr_t)type_seq[i]) * UINT64_C(0x9e3779b97f4a7c15);
+        h ^= h >> 29;
     }
-    else
-    {
-        type_trie_element_t* elem = lookup_element(type_trie, type_seq);
-        if (elem == NULL)
-        {
-            // Create all the remaining elements since they will not be found
-            // anymore
-            return create_elements(type_trie, type_seq, function_type, length);
-        }
-        else
-        {
-            return insert_list_rec(elem->next, type_seq + 1, function_type, length - 1);
-        }
-    }
-}
-
-static const type_t* insert_list(type_trie_t* type_trie, const type_t** type_seq, const type_t *function_type, int length)
-{
-    return insert_list_rec(type_trie, type_seq, function_type, length);
+    return (unsigned int)(h ^ (h >> 32));
 }
 
-static int elements_compare_fun(const type_t* i1, const type_t* i2)
+static type_trie_entry_t* lookup_entry(type_trie_t* trie,
+        const type_t** type_seq,
+        int num_types,
+        unsigned int hash)
 {
-    if (i1 == i2)
-        return 0;
-    else if (i1 < i2)
-        return -1;
-    else 
-        return 1;
-}
-
-static type_trie_element_t *lookup_element_rec(const type_trie_t* type_trie, const type_t *entity, int lower, int upper)
-{
-    if (lower > upper)
-        return NULL;
-
-    int middle = (lower + upper) / 2;
+    unsigned int mask = trie->num_entries - 1;
+    unsigned int i = hash & mask;
+    for (;;)
+    {
+        type_trie_stats.num_probes++;
 
-    const type_t* i_middle = type_trie->elements[middle].elem;
-    const type_t* i_entity = entity;
+        type_trie_entry_t* entry = &trie->entries[i];
+        if (entry->first_type < 0)
+            return entry;
 
-    int cmp = elements_compare_fun(i_entity, i_middle);
+        if (entry->hash == hash
+                && entry->num_types == num_types
+                && memcmp(&trie->types[entry->first_type],
+                    type_seq, num_types * sizeof(*type_seq)) == 0)
+            return entry;
 
-    if (cmp < 0)
-        return lookup_element_rec(type_trie, entity, lower, middle - 1);
-    else if (0 < cmp)
-        return lookup_element_rec(type_trie, entity, middle + 1, upper);
-    else 
-        return &(type_trie->elements[middle]);
+        i = (i + 1) & mask;
+    }
 }
 
-static type_trie_element_t *lookup_element(const type_trie_t* type_trie, const type_t** type_seq)
+static void allocate_entries(type_trie_t* trie, int num_entries)
 {
-    return lookup_element_rec(type_trie, *type_seq, 0, type_trie->num_elements - 1);
-}
+    trie->num_entries = num_entries;
+    trie->entries = NEW_VEC(type_trie_entry_t, num_entries);
 
-static const type_t* create_elements(type_trie_t* type_trie, const type_t** type_seq, const type_t* function_type, int length)
-{
-    type_trie->num_elements++;
-    if (type_trie->capacity == type_trie->num_elements)
+    int i;
+    for (i = 0; i < num_entries; i++)
     {
-        type_trie->capacity *= 2;
-        type_trie->elements = NEW_REALLOC(type_trie_element_t, type_trie->elements, type_trie->capacity);
+        trie->entries[i].first_type = -1;
     }
+}
 
-    // Locate place where the element would go
-    int lower = 0;
-    int upper = type_trie->num_elements - 2;
-
-    const type_t* i_entity = NULL;
+static void grow_entries(type_trie_t* trie)
+{
+    int old_num_entries = trie->num_entries;
+    type_trie_entry_t* old_entries = trie->entries;
 
-    if (length != 0)
-        i_entity = *type_seq;
+    allocate_entries(trie, 2 * old_num_entries);
 
-    while (lower <= upper)
+    int i;
+    for (i = 0; i < old_num_entries; i++)
     {
-        int middle = (lower + upper) / 2;
-        const type_t* i_middle = type_trie->elements[middle].elem;
+        if (old_entries[i].first_type < 0)
+            continue;
 
-        int cmp = elements_compare_fun(i_entity, i_middle);
-        if (cmp < 0)
-        {
-            upper = middle - 1;
-        }
-        else if (0 < cmp)
+        unsigned int mask = trie->num_entries - 1;
+        unsigned int j = old_entries[i].hash & mask;
+        while (trie->entries[j].first_type >= 0)
         {
-            lower = middle + 1;
-        }
-        // This should never happen
-        else 
-        {
-            abort();
+            j = (j + 1) & mask;
         }
+        trie->entries[j] = old_entries[i];
     }
 
-    // lower contains the position where the element should go
-    // shift all elements rightwards one position
-    int i;
-    for (i = type_trie->num_elements - 1; i > lower; i--)
-    {
-        type_trie->elements[i] = type_trie->elements[i - 1];
-    }
+    DELETE(old_entries);
+}
 
-    if (length == 0)
+static int intern_type_seq(type_trie_t* trie, const type_t** type_seq, int num_types)
+{
+    if (trie->num_types + num_types > trie->size_types)
     {
-        type_trie->elements[lower].elem = 0;
-        // No next after the "end of list"
-        type_trie->elements[lower].next = NULL;
-        // Create the type itself
-        type_trie->elements[lower].function_type = function_type;
-
-        return type_trie->elements[lower].function_type;
+        while (trie->num_types + num_types > trie->size_types)
+        {
+            trie->size_types = 2 * trie->size_types + 16;
+        }
+        trie->types = NEW_REALLOC(const type_t*, trie->types, trie->size_types);
     }
-    else
-    {
-        type_trie->elements[lower].elem = *type_seq;
-        type_trie->elements[lower].next = allocate_type_trie();
 
-        const type_t* result =
-        create_elements(type_trie->elements[lower].next,
-                type_seq + 1,
-                function_type, length - 1);
+    int first_type = trie->num_types;
+    memcpy(&trie->types[first_type], type_seq, num_types * sizeof(*type_seq));
+    trie->num_types += num_types;
 
-        return result;
-    }
+    return first_type;
 }
 
 type_trie_t* allocate_type_trie(void)
 {
     type_trie_t* t = NEW0(type_trie_t);
-    t->capacity = 1;
-    t->elements = NEW_VEC0(type_trie_element_t, t->capacity);
+    allocate_entries(t, 16);
     return t;
 }
 
 void insert_type_trie(type_trie_t* trie, const type_t** type_seq, int num_types, const type_t* funct_type)
 {
-    insert_list(trie, type_seq, funct_type, num_types);
+    type_trie_stats.num_inserts++;
+
+    // Keep the load factor below 3/4
+    if (4 * (trie->num_used + 1) > 3 * trie->num_entries)
+    {
+        grow_entries(trie);
+    }
+
+    unsigned int hash = hash_type_seq(type_seq, num_types);
+    type_trie_entry_t* entry = lookup_entry(trie, type_seq, num_types, hash);
+    if (entry->first_type >= 0)
+    {
+        // Already there, the first one inserted is kept
+        return;
+    }
+
+    entry->hash = hash;
+    entry->num_types = num_types;
+    entry->first_type = intern_type_seq(trie, type_seq, num_types);
+    entry->result = funct_type;
+
+    trie->num_used++;
 }
 
 const type_t* lookup_type_trie(type_trie_t* trie, const type_t** type_seq, int num_types)
 {
-    return lookup_list(trie, type_seq, num_types);
+    type_trie_stats.num_lookups++;
+
+    unsigned int hash = hash_type_seq(type_seq, num_types);
+    type_trie_entry_t* entry = lookup_entry(trie, type_seq, num_types, hash);
+    if (entry->first_type < 0)
+        return NULL;
+
+    type_trie_stats.num_hits++;
+    return entry->result;
 }
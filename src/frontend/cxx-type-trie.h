@@ -30,7 +30,9 @@
 #ifndef CXX_TYPE_TRIE_H
 #define CXX_TYPE_TRIE_H
 
+#include "libmcxx-common.h"
 #include "cxx-type-decls.h"
+#include <stddef.h>
 
 MCXX_BEGIN_DECLS
 
@@ -41,6 +43,19 @@ type_trie_t* allocate_type_trie(void);
 const type_t* lookup_type_trie(type_trie_t* trie, const type_t** type_seq, int num_types);
 void insert_type_trie(type_trie_t* trie, const type_t** type_seq, int num_types, const type_t* funct_type);
 
+typedef
+struct type_trie_stats_tag
+{
+    size_t num_lookups;
+    // Lookups that found the sequence
+    size_t num_hits;
+    size_t num_inserts;
+    // Entries visited by lookups and inserts
+    size_t num_probes;
+} type_trie_stats_t;
+
+LIBMCXX_EXTERN void type_trie_get_stats(type_trie_stats_t* stats);
+
 MCXX_END_DECLS
 
 #endif // CXX_TYPE_TRIE_H
@@ -560,8 +560,26 @@ struct type_tag
 
     // Cache typedefs
     type_t* _advanced_type;
+
+    // Cache equivalence. Types that have the same structural hash and
+    // belong to the same equivalence class are equivalent
+    type_t* _equivalence_class;
+    unsigned int _structural_hash;
+    enum structural_hash_state_tag
+    {
+        STRUCTURAL_HASH_UNKNOWN = 0,
+        STRUCTURAL_HASH_KNOWN,
+        STRUCTURAL_HASH_NONE,
+    } _structural_hash_state:2;
 };
 
+static void reset_equivalence_cache(type_t* t)
+{
+    t->_equivalence_class = NULL;
+    t->_structural_hash = 0;
+    t->_structural_hash_state = STRUCTURAL_HASH_UNKNOWN;
+}
+
 static common_type_info_t* new_common_type_info(void)
 {
     common_type_info_t* result = NEW0(common_type_info_t);
@@ -588,6 +606,7 @@ static type_t* copy_type_for_class_alias(type_t* t)
     *result = *t;
 
     result->_advanced_type = NULL;
+    reset_equivalence_cache(result);
 
     result->info = copy_common_type_info(t->info);
 
@@ -605,6 +624,7 @@ static type_t* copy_type_for_variant(type_t* t)
     result->unqualified_type = result;
 
     result->_advanced_type = NULL;
+    reset_equivalence_cache(result);
 
     result->info = copy_common_type_info(t->info);
 
@@ -2045,6 +2065,7 @@ extern inline type_t* get_new_template_alias_type(template_parameter_list_t* tem
     symbol_entity_specs_set_is_instantiable(primary_symbol, 1);
 
     *primary_type = *aliased_type;
+    reset_equivalence_cache(primary_type);
     primary_type->info = new_common_type_info();
     *primary_type->info = *aliased_type->info;
 
@@ -4352,6 +4373,7 @@ static inline type_t *get_qualified_type(type_t *original,
         qualified_type->unqualified_type = original->unqualified_type;
 
         qualified_type->_advanced_type = NULL;
+        reset_equivalence_cache(qualified_type);
 
         dhash_ptr_insert(_qualification[(int)(cv_qualification)], 
                 (const char*)original->unqualified_type, 
@@ -5439,6 +5461,7 @@ static type_t* _get_duplicated_class_type(type_t* class_type)
     result->unqualified_type = result;
 
     result->_advanced_type = NULL;
+    reset_equivalence_cache(result);
 
     // These are the parts relevant for duplication
     result->info = NEW0(common_type_info_t);
@@ -7096,15 +7119,251 @@ extern inline scope_entry_list_t* class_type_get_all_conversions(type_t* class_t
     return this_class_conversors;
 }
 
+static type_equivalence_stats_t type_equivalence_stats;
+
+void type_get_equivalence_stats(type_equivalence_stats_t* stats)
+{
+    *stats = type_equivalence_stats;
+}
+
+static char structural_hash_of_type(type_t* t, unsigned int* hash);
+
+static char structural_hash_of_simple_type(type_t* t, unsigned int* hash)
+{
+    simple_type_t* st = t->type;
+    unsigned int h = st->kind;
+    unsigned int h_related = 0;
+    switch (st->kind)
+    {
+        case STK_BUILTIN_TYPE:
+            h = h * 31 + st->builtin_type;
+            break;
+        case STK_CLASS:
+        case STK_ENUM:
+        case STK_TEMPLATE_TYPE:
+            // These are compared by address
+            h = h * 31 + (unsigned int)((uintptr_t)st >> 3);
+            break;
+        case STK_INDIRECT:
+            {
+                scope_entry_t* entry = st->user_defined_type;
+                if (st->is_mutable
+                        || entry == NULL
+                        || entry->type_information == NULL
+                        || symbol_entity_specs_get_is_template_parameter(entry)
+                        || !structural_hash_of_type(entry->type_information, &h_related))
+                    return 0;
+                h = h * 31 + h_related;
+                break;
+            }
+        case STK_COMPLEX:
+            if (!structural_hash_of_type(st->complex_element, &h_related))
+                return 0;
+            h = h * 31 + h_related;
+            break;
+        case STK_UNDERLYING:
+            if (!structural_hash_of_type(st->underlying_type, &h_related))
+                return 0;
+            h = h * 31 + h_related;
+            break;
+        case STK_VECTOR:
+            if (!structural_hash_of_type(st->vector_element, &h_related))
+                return 0;
+            h = (h * 31 + h_related) * 31 + st->vector_size;
+            break;
+        case STK_MASK:
+        case STK_VA_LIST:
+            break;
+        default:
+            // Dependent types and types compared by their expressions
+            return 0;
+    }
+
+    *hash = h;
+    return 1;
+}
+
+// Computes a hash of t that is the same for all types equivalent to t.
+// Returns zero when equivalence of t is not transitive or may change, in
+// these cases it must always be checked structurally
+static char structural_hash_of_type(type_t* t, unsigned int* hash)
+{
+    if (t->_structural_hash_state == STRUCTURAL_HASH_KNOWN)
+    {
+        *hash = t->_structural_hash;
+        return 1;
+    }
+    else if (t->_structural_hash_state == STRUCTURAL_HASH_NONE)
+    {
+        return 0;
+    }
+
+    // Dependent types are never hashed but they may stop being dependent so
+    // this is not remembered
+    if (is_dependent_type(t))
+        return 0;
+
+    char is_cacheable = 1;
+    cv_qualifier_t cv = CV_NONE;
+    type_t* advanced = advance_over_typedefs_with_cv_qualif_(t, &cv, &is_cacheable);
+
+    unsigned int h = advanced->kind * 31 + cv;
+    unsigned int h_related = 0;
+    char is_hashable = is_cacheable;
+    if (is_hashable)
+    {
+        switch (advanced->kind)
+        {
+            case TK_DIRECT:
+                is_hashable = structural_hash_of_simple_type(advanced, &h_related);
+                h = h * 31 + h_related;
+                break;
+            case TK_POINTER:
+            case TK_LVALUE_REFERENCE:
+            case TK_RVALUE_REFERENCE:
+            case TK_REBINDABLE_REFERENCE:
+                is_hashable = structural_hash_of_type(advanced->pointer->pointee, &h_related);
+                h = h * 31 + h_related;
+                break;
+            case TK_POINTER_TO_MEMBER:
+                is_hashable = structural_hash_of_type(advanced->pointer->pointee, &h_related);
+                h = h * 31 + h_related;
+                is_hashable = is_hashable
+                    && structural_hash_of_type(advanced->pointer->pointee_class_type, &h_related);
+                h = h * 31 + h_related;
+                break;
+            case TK_ARRAY:
+                // Arrays of nonconstant size are compatible with any other
+                // size in C, and compared by expression in C++
+                is_hashable = (nodecl_is_null(advanced->array->whole_size)
+                        || nodecl_is_constant(advanced->array->whole_size))
+                    && structural_hash_of_type(advanced->array->element_type, &h_related);
+                h = (h * 31 + h_related) * 31 + nodecl_is_null(advanced->array->whole_size);
+                break;
+            case TK_FUNCTION:
+                {
+                    function_info_t* function = advanced->function;
+                    if (function->return_type != NULL)
+                    {
+                        is_hashable = structural_hash_of_type(function->return_type, &h_related);
+                        h = h * 31 + h_related;
+                    }
+                    h = (h * 31 + function->num_parameters) * 31 + function->ref_qualifier;
+
+                    // Parameters of array and function type are compatible
+                    // with pointers, which is not transitive
+                    int i;
+                    for (i = 0; i < function->num_parameters && is_hashable; i++)
+                    {
+                        parameter_info_t* parameter = function->parameter_list[i];
+                        if (parameter->is_ellipsis)
+                        {
+                            h = h * 31 + 1;
+                            continue;
+                        }
+                        type_t* parameter_type = advance_over_typedefs(parameter->type_info);
+                        is_hashable = parameter_type->kind != TK_ARRAY
+                            && parameter_type->kind != TK_FUNCTION
+                            && structural_hash_of_type(
+                                    get_cv_qualified_type(parameter->type_info, CV_NONE),
+                                    &h_related);
+                        h = h * 31 + h_related;
+                    }
+                    break;
+                }
+            default:
+                // Packs, sequences and braced lists are rare and overloads,
+                // errors and auto are not ordinary types
+                t->_structural_hash_state = STRUCTURAL_HASH_NONE;
+                return 0;
+        }
+    }
+
+    if (!is_hashable)
+    {
+        // It may be dependent through one of its components, so this is not
+        // remembered either
+        return 0;
+    }
+
+    t->_structural_hash = h;
+    t->_structural_hash_state = STRUCTURAL_HASH_KNOWN;
+
+    *hash = h;
+    return 1;
+}
+
+static type_t* equivalence_class_of_type(type_t* t)
+{
+    type_t* root = t;
+    while (root->_equivalence_class != NULL)
+        root = root->_equivalence_class;
+
+    // Path compression
+    while (t != root)
+    {
+        type_t* next = t->_equivalence_class;
+        t->_equivalence_class = root;
+        t = next;
+    }
+
+    return root;
+}
+
+static char equivalent_types_(type_t* t1, type_t* t2);
+
 /*
  * States if two types are equivalent. This means that they are the same
  * (ignoring typedefs). Just plain comparison, no standard conversion is
  * performed. cv-qualifiers are relevant for comparison
+ *
+ * Nondependent types are first compared by their structural hash and
+ * equivalence class, so the structural comparison is only done the first
+ * time two types are found equivalent
  */
 extern inline char equivalent_types(type_t* t1, type_t* t2)
 {
     ERROR_CONDITION( (t1 == NULL || t2 == NULL), "No type can be null here", 0);
 
+    unsigned int h1, h2;
+    if (!IS_FORTRAN_LANGUAGE
+            && structural_hash_of_type(t1, &h1)
+            && structural_hash_of_type(t2, &h2))
+    {
+        if (h1 != h2)
+        {
+            type_equivalence_stats.num_different_hash++;
+            return 0;
+        }
+
+        type_t* class1 = equivalence_class_of_type(t1);
+        type_t* class2 = equivalence_class_of_type(t2);
+        if (class1 == class2)
+        {
+            type_equivalence_stats.num_same_class++;
+            return 1;
+        }
+
+        type_equivalence_stats.num_structural++;
+        char result = equivalent_types_(t1, t2);
+        if (result)
+        {
+            // Classes may have been merged while comparing
+            class1 = equivalence_class_of_type(class1);
+            class2 = equivalence_class_of_type(class2);
+            if (class1 != class2)
+                class2->_equivalence_class = class1;
+        }
+        return result;
+    }
+
+    type_equivalence_stats.num_unhashed++;
+    return equivalent_types_(t1, t2);
+}
+
+static char equivalent_types_(type_t* t1, type_t* t2)
+{
+
     cv_qualifier_t cv_qualifier_t1 = CV_NONE, cv_qualifier_t2 = CV_NONE;
 
     // Advance over typedefs
@@ -14349,9 +14608,19 @@ extern inline char is_complete_type(type_t* t)
     return !is_incomplete_type(t);
 }
 
+// Number of times a type has gone from incomplete to complete
+static unsigned int type_completion_counter = 0;
+
+unsigned int get_type_completion_counter(void)
+{
+    return type_completion_counter;
+}
+
 extern inline void set_is_incomplete_type(type_t* t, char is_incomplete)
 {
     t = canonical_type(t);
+    if (t->info->is_incomplete && !is_incomplete)
+        type_completion_counter++;
     t->info->is_incomplete = is_incomplete;
 }
 
@@ -298,6 +298,21 @@ LIBMCXX_EXTERN type_t* fix_dependent_typenames_in_context(type_t* t, const decl_
 
 /* Type comparison functions */
 LIBMCXX_EXTERN char equivalent_types(type_t* t1, type_t* t2);
+
+typedef
+struct type_equivalence_stats_tag
+{
+    // Nondependent types told apart by their structural hash
+    size_t num_different_hash;
+    // Nondependent types found in the same equivalence class
+    size_t num_same_class;
+    // Nondependent types compared structurally
+    size_t num_structural;
+    // Comparisons involving dependent or otherwise unhashed types
+    size_t num_unhashed;
+} type_equivalence_stats_t;
+
+LIBMCXX_EXTERN void type_get_equivalence_stats(type_equivalence_stats_t* stats);
 LIBMCXX_EXTERN char equivalent_cv_qualification(cv_qualifier_t cv1, cv_qualifier_t cv2);
 
 // Compares two function types ignoring ref qualifiers
@@ -345,6 +360,8 @@ LIBMCXX_EXTERN void enum_type_set_underlying_type_is_fixed(type_t* t, char is_fi
 
 LIBMCXX_EXTERN void set_is_incomplete_type(type_t* t, char is_incomplete);
 LIBMCXX_EXTERN void set_is_complete_type(type_t* t, char is_complete);
+// It changes every time an incomplete type becomes complete
+LIBMCXX_EXTERN unsigned int get_type_completion_counter(void);
 LIBMCXX_EXTERN void set_is_dependent_type(type_t* t, char is_dependent);
 
 LIBMCXX_EXTERN void template_type_set_related_symbol(type_t* t, scope_entry_t*);
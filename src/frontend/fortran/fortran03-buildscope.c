@@ -10313,6 +10313,7 @@ scope_entry_t* insert_symbol_from_module(scope_entry_t* entry,
 
     // Copy everything and restore the name
     *current_symbol = *entry;
+    symbol_entity_specs_share_sparse(current_symbol);
     symbol_clear_indirect_types(current_symbol);
 
     // Restore original context
@@ -10544,28 +10545,43 @@ static void build_scope_use_stmt(AST a, const decl_context_t* decl_context, node
             }
         }
 
-        // Now add the ones not renamed
-        int i;
-        for (i = 0; i < symbol_entity_specs_get_num_related_symbols(module_symbol); i++)
+        // Now add the ones not renamed. Modules must have all of them as
+        // they are written to the module file, elsewhere only those names
+        // that are actually used will be added
+        scope_entry_t* current_unit = decl_context->current_scope->related_entry;
+        if (current_unit == NULL
+                || current_unit->kind != SK_MODULE)
+        {
+            fortran_lazy_uses_add(decl_context,
+                    module_symbol,
+                    num_renamed_symbols,
+                    renamed_symbols,
+                    ast_get_locus(a));
+        }
+        else
         {
-            scope_entry_t* sym_in_module = symbol_entity_specs_get_related_symbols_num(module_symbol, i);
+            int i;
+            for (i = 0; i < symbol_entity_specs_get_num_related_symbols(module_symbol); i++)
+            {
+                scope_entry_t* sym_in_module = symbol_entity_specs_get_related_symbols_num(module_symbol, i);
 
-            if (symbol_entity_specs_get_access(sym_in_module) == AS_PRIVATE)
-                continue;
+                if (symbol_entity_specs_get_access(sym_in_module) == AS_PRIVATE)
+                    continue;
 
-            char found = 0;
-            int j;
-            for (j = 0; j < num_renamed_symbols && !found; j++)
-            {
-                found = (renamed_symbols[j] == sym_in_module);
-            }
-            if (!found)
-            {
-                insert_symbol_from_module(sym_in_module, 
-                        decl_context, 
-                        sym_in_module->symbol_name, 
-                        module_symbol,
-                        ast_get_locus(a));
+                char found = 0;
+                int j;
+                for (j = 0; j < num_renamed_symbols && !found; j++)
+                {
+                    found = (renamed_symbols[j] == sym_in_module);
+                }
+                if (!found)
+                {
+                    insert_symbol_from_module(sym_in_module, 
+                            decl_context, 
+                            sym_in_module->symbol_name, 
+                            module_symbol,
+                            ast_get_locus(a));
+                }
             }
         }
 
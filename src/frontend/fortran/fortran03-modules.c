@@ -43,12 +43,19 @@
 #include "cxx-driver-fortran.h"
 #include "cxx-entrylist.h"
 #include "cxx-asttype-str.h"
+#include "dhash_str.h"
+#include "cxx-codegen.h"
 
 #include <stdio.h>
 #include <sqlite3.h>
 #include <errno.h>
 #include <string.h>
 #include <unistd.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 
 #ifdef Q
  #error Q cannot be defined here
@@ -76,6 +83,51 @@ static void prepare_statements(sqlite3*);
 static void start_transaction(sqlite3*);
 static void end_transaction(sqlite3*);
 
+// Binary module images, see compact_module_files
+typedef
+struct module_image_tag module_image_t;
+
+typedef
+enum module_image_table_tag
+{
+    MIT_INFO = 0,
+    MIT_SYMBOL,
+    MIT_ATTRIBUTES,
+    MIT_TYPE,
+    MIT_AST,
+    MIT_DECL_CONTEXT,
+    MIT_SCOPE,
+    MIT_CONST_VALUE,
+    MIT_RAW_CONST_VALUE,
+    MIT_MULTI_CONST_VALUE,
+    MIT_MODULE_EXTRA_NAME,
+    MIT_MODULE_EXTRA_DATA,
+    MIT_NUM_TABLES
+} module_image_table_t;
+
+static module_image_t* module_image_open(const char* filename);
+static void module_image_close(module_image_t* image);
+static uint32_t module_image_lower_bound(module_image_t* image, module_image_table_t table,
+        sqlite3_uint64 oid);
+static char module_image_row_has_key(module_image_t* image, module_image_table_t table,
+        uint32_t row, sqlite3_uint64 oid);
+static int module_image_num_columns(module_image_t* image, module_image_table_t table);
+static void module_image_get_row(module_image_t* image, module_image_table_t table,
+        uint32_t row, char** values);
+static uint32_t module_image_num_rows(module_image_t* image, module_image_table_t table);
+static char** module_image_column_names(module_image_t* image, module_image_table_t table);
+static void module_image_select(module_image_t* image, module_image_table_t table,
+        sqlite3_uint64 oid,
+        int (*fun)(void* datum, int ncols, char** values, char **names),
+        void *datum);
+static void register_module_file_to_compact(const char* filename);
+
+typedef struct lazy_module_tag lazy_module_t;
+static void register_lazy_module(lazy_module_t* lazy_module, scope_entry_t* module);
+static void record_lazy_members(lazy_module_t* lazy_module, sqlite3_uint64 module_oid);
+static lazy_module_t* get_lazy_module(scope_entry_t* module);
+static void load_lazy_members_by_name(lazy_module_t* lazy_module, const char* name);
+
 UNUSED_PARAMETER
 static const char* full_name_of_symbol(scope_entry_t* entry)
 {
@@ -188,7 +240,14 @@ enum type_kind_table_tag
     TKT_INDIRECT,
     TKT_NAMED,
     TKT_COMPUTED_FUNCTION,
-    TKT_ENUM
+    TKT_ENUM,
+    // Only used by global scope snapshots
+    TKT_C_BUILTIN,
+    TKT_C_FLOAT,
+    TKT_C_COMPLEX,
+    TKT_C_ARRAY,
+    TKT_C_CLASS,
+    TKT_ELLIPSIS
 } type_kind_table_t;
 
 typedef
@@ -334,8 +393,57 @@ static int safe_atoi(const char *c)
 static scope_entry_t* module_being_emitted = NULL;
 static sqlite3_uint64 module_oid_being_loaded = 0;
 
+// Set while dumping a global scope snapshot
+static char snapshot_mode = 0;
+static dhash_ptr_t* snapshot_preexisting_symbols = NULL;
+static const char* snapshot_unsupported = NULL;
+
 static rb_red_blk_tree * _oid_map = NULL;
 
+// Set while loading a module from a binary image. In this case there is no
+// sqlite3 handle and the rows are looked up in the image
+static module_image_t* _module_image = NULL;
+
+// Members of a module loaded from an image are not loaded along with the
+// module but the first time they are needed. The image and the map of the
+// loaded oids are kept until all of them have been loaded
+typedef
+enum lazy_member_state_tag
+{
+    LAZY_MEMBER_PENDING = 0,
+    LAZY_MEMBER_LOADING,
+    LAZY_MEMBER_LOADED,
+} lazy_member_state_t;
+
+typedef
+struct lazy_member_tag
+{
+    const char* name;
+    sqlite3_uint64 oid;
+    lazy_member_state_t state;
+} lazy_member_t;
+
+struct lazy_module_tag
+{
+    scope_entry_t* module;
+    sqlite3_uint64 module_oid;
+
+    module_image_t* image;
+    rb_red_blk_tree* oid_map;
+
+    // Sorted by name
+    int num_members;
+    lazy_member_t* members;
+    int num_pending;
+
+    lazy_module_t* next;
+};
+
+static lazy_module_t* _lazy_modules = NULL;
+
+// Set while loading a module from an image, its members are recorded here
+static lazy_module_t* _lazy_module_being_loaded = NULL;
+
 void dump_module_info(scope_entry_t* module)
 {
     ERROR_CONDITION(module->kind != SK_MODULE, "Invalid symbol!", 0);
@@ -461,7 +569,20 @@ void load_module_info(const char* module_name, scope_entry_t** module)
 
     sqlite3* handle = NULL;
 
-    load_storage(&handle, filename);
+    // Modules written by older versions of Mercurium are sqlite databases
+    _module_image = module_image_open(filename);
+    if (_module_image != NULL)
+    {
+        _oid_map = rb_tree_create(int64cmp_vptr, null_dtor_func, null_dtor_func);
+
+        _lazy_module_being_loaded = NEW0(lazy_module_t);
+        _lazy_module_being_loaded->image = _module_image;
+        _lazy_module_being_loaded->oid_map = _oid_map;
+    }
+    else
+    {
+        load_storage(&handle, filename);
+    }
 
     module_info_t minfo;
     memset(&minfo, 0, sizeof(minfo));
@@ -474,9 +595,17 @@ void load_module_info(const char* module_name, scope_entry_t** module)
                 filename, minfo.version, CURRENT_MODULE_VERSION);
     }
 
-    prepare_statements(handle);
+    if (_module_image == NULL)
+    {
+        prepare_statements(handle);
 
-    start_transaction(handle);
+        start_transaction(handle);
+    }
+
+    if (_lazy_module_being_loaded != NULL)
+    {
+        _lazy_module_being_loaded->module_oid = minfo.module_oid;
+    }
 
     module_oid_being_loaded = minfo.module_oid;
     *module = load_symbol(handle, minfo.module_oid);
@@ -484,9 +613,29 @@ void load_module_info(const char* module_name, scope_entry_t** module)
 
     load_extra_data_from_module(handle, *module);
 
-    end_transaction(handle);
+    if (_module_image == NULL)
+    {
+        end_transaction(handle);
 
-    dispose_storage(handle);
+        dispose_storage(handle);
+    }
+    else
+    {
+        lazy_module_t* lazy_module = _lazy_module_being_loaded;
+        _lazy_module_being_loaded = NULL;
+
+        if (lazy_module->num_pending > 0)
+        {
+            register_lazy_module(lazy_module, *module);
+        }
+        else
+        {
+            module_image_close(_module_image);
+            DELETE(lazy_module->members);
+            DELETE(lazy_module);
+        }
+        _module_image = NULL;
+    }
 
     timing_end(&timing_load_module);
 
@@ -531,6 +680,8 @@ static void create_storage(sqlite3** handle, scope_entry_t* module)
     }
 
     load_storage(handle, filename);
+
+    register_module_file_to_compact(filename);
 }
 
 static int run_select_query(sqlite3* handle, const char* query, 
@@ -880,6 +1031,20 @@ static int get_module_info_(void *datum,
 
 static void get_module_info(sqlite3* handle, module_info_t* minfo)
 {
+    if (_module_image != NULL)
+    {
+        uint32_t row = module_image_lower_bound(_module_image, MIT_INFO, 0);
+        if (!module_image_row_has_key(_module_image, MIT_INFO, row, 0))
+        {
+            fatal_error("Module image does not have module information\n");
+        }
+        int ncols = module_image_num_columns(_module_image, MIT_INFO);
+        char* values[ncols + 1];
+        module_image_get_row(_module_image, MIT_INFO, row, values);
+        get_module_info_(minfo, ncols, values, module_image_column_names(_module_image, MIT_INFO));
+        return;
+    }
+
     const char * module_info_query = "SELECT module, date, version, build, root_symbol FROM info LIMIT 1;";
 
     char* errmsg = NULL;
@@ -1254,12 +1419,152 @@ static sqlite3_uint64 insert_nodecl(sqlite3* handle, nodecl_t n)
     return insert_ast(handle, nodecl_get_ast(n));
 }
 
+// C types are stored exactly when dumping a snapshot: Fortran modules only
+// keep the kind of scalar types, which would merge C types like 'int' and
+// 'long' of the same size
+typedef type_t* (*snapshot_builtin_type_fn_t)(void);
+static snapshot_builtin_type_fn_t snapshot_builtin_types[] =
+{
+    NULL, // 0 is not a valid index
+    get_char_type,
+    get_signed_char_type,
+    get_unsigned_char_type,
+    get_wchar_t_type,
+    get_char16_t_type,
+    get_char32_t_type,
+    get_bool_type,
+    get_signed_short_int_type,
+    get_unsigned_short_int_type,
+    get_signed_int_type,
+    get_unsigned_int_type,
+    get_signed_long_int_type,
+    get_unsigned_long_int_type,
+    get_signed_long_long_int_type,
+    get_unsigned_long_long_int_type,
+    get_signed_int128_type,
+    get_unsigned_int128_type,
+    get_gcc_builtin_va_list_type,
+};
+
+enum
+{
+    SNAPSHOT_CLASS_IS_UNION = 1 << 0,
+    SNAPSHOT_CLASS_IS_COMPLETE = 1 << 1,
+    SNAPSHOT_CLASS_IS_PACKED = 1 << 2,
+};
+
+static sqlite3_uint64 insert_type_snapshot(sqlite3* handle, type_t* t, char *handled)
+{
+    *handled = 1;
+
+    if (is_variant_type(t))
+    {
+        snapshot_unsupported = "types with attributes";
+        return 0;
+    }
+    else if (is_named_type(t))
+    {
+        // Keep typedef names, the Fortran path sees through them
+        sqlite3_uint64 sym_oid = insert_symbol(handle, named_type_get_symbol(t));
+
+        return insert_type_ref_to_symbol(handle, t,
+                is_indirect_type(t) ? TKT_INDIRECT : TKT_NAMED,
+                0, sym_oid);
+    }
+    else if (is_ellipsis_type(t))
+    {
+        return insert_type_simple(handle, t, TKT_ELLIPSIS, 0);
+    }
+    else if (is_floating_type(t))
+    {
+        const floating_type_info_t* info = floating_type_get_info(t);
+        int i;
+        for (i = 0; i < CURRENT_CONFIGURATION->type_environment->num_float_types; i++)
+        {
+            if (CURRENT_CONFIGURATION->type_environment->all_floats[i] == info)
+                return insert_type_simple(handle, t, TKT_C_FLOAT, i);
+        }
+        snapshot_unsupported = "floating types not in the type environment";
+        return 0;
+    }
+    else if (is_complex_type(t))
+    {
+        sqlite3_uint64 base = insert_type(handle, complex_type_get_base_type(t));
+        return insert_type_ref_to(handle, t, TKT_C_COMPLEX, base);
+    }
+    else if (is_array_type(t))
+    {
+        sqlite3_uint64 size_expr = insert_nodecl(handle, array_type_get_array_size_expr(t));
+        sqlite3_uint64 element_type = insert_type(handle, array_type_get_element_type(t));
+        return insert_type_ref_to_ast(handle, t, TKT_C_ARRAY, element_type, size_expr, 0);
+    }
+    else if (is_unnamed_class_type(t))
+    {
+        scope_entry_list_t* members = class_type_get_nonstatic_data_members(t);
+
+        int num_fields = entry_list_size(members);
+
+        sqlite3_uint64 field_list[num_fields+1];
+        memset(field_list, 0, sizeof(field_list));
+
+        int i = 0;
+        scope_entry_list_iterator_t* it = NULL;
+        for (it = entry_list_iterator_begin(members);
+                !entry_list_iterator_end(it);
+                entry_list_iterator_next(it))
+        {
+            field_list[i] = insert_symbol(handle, entry_list_iterator_current(it));
+            i++;
+        }
+        entry_list_iterator_free(it);
+        entry_list_free(members);
+
+        sqlite3_uint64 class_flags = 0;
+        if (is_union_type(t))
+            class_flags |= SNAPSHOT_CLASS_IS_UNION;
+        if (is_complete_type(t))
+            class_flags |= SNAPSHOT_CLASS_IS_COMPLETE;
+        if (class_type_is_packed(t))
+            class_flags |= SNAPSHOT_CLASS_IS_PACKED;
+
+        return insert_type_ref_to_list_symbols(handle, t, TKT_C_CLASS, class_flags, num_fields, field_list);
+    }
+    else if (is_vector_type(t)
+            || is_transparent_union(t))
+    {
+        snapshot_unsupported = "vector types and transparent unions";
+        return 0;
+    }
+    else
+    {
+        type_t* unqualified = get_unqualified_type(t);
+        unsigned int i;
+        for (i = 1; i < STATIC_ARRAY_LENGTH(snapshot_builtin_types); i++)
+        {
+            if (unqualified == (snapshot_builtin_types[i])())
+                return insert_type_simple(handle, t, TKT_C_BUILTIN, i);
+        }
+    }
+
+    // Pointers, functions, enums and void are handled like in Fortran
+    *handled = 0;
+    return 0;
+}
+
 static sqlite3_uint64 insert_type(sqlite3* handle, type_t* t)
 {
     sqlite3_uint64 result = 0;
     if (t == NULL)
         return result;
 
+    if (snapshot_mode)
+    {
+        char handled = 0;
+        result = insert_type_snapshot(handle, t, &handled);
+        if (handled)
+            return result;
+    }
+
     if (is_any_int_type(t))
     {
         result = insert_type_simple(handle, t, TKT_INTEGER, type_get_size(t));
@@ -1406,6 +1711,10 @@ static sqlite3_uint64 insert_type(sqlite3* handle, type_t* t)
         result = insert_type_ref_to_list_symbols(
             handle, t, TKT_ENUM, underlying, num_enumerators, enumerator_list);
     }
+    else if (snapshot_mode)
+    {
+        snapshot_unsupported = "some types";
+    }
     else
     {
         internal_error("Invalid type '%s'\n", print_declarator(t));
@@ -1818,6 +2127,35 @@ static void get_extended_attribute(sqlite3* handle, sqlite3_uint64 oid, const ch
         void *extra_info,
         int (*get_extra_info_fun)(void *datum, int ncols, char **values, char **names))
 {
+    if (_lazy_module_being_loaded != NULL
+            && oid == module_oid_being_loaded
+            && strcmp(attr_name, "related_symbols") == 0)
+    {
+        // Members of the module will be loaded on demand
+        record_lazy_members(_lazy_module_being_loaded, oid);
+        return;
+    }
+
+    if (_module_image != NULL)
+    {
+        // Rows of attributes are (value, name) and only the value is
+        // passed to the callback
+        char** names = module_image_column_names(_module_image, MIT_ATTRIBUTES);
+        char* values[2];
+        uint32_t row;
+        for (row = module_image_lower_bound(_module_image, MIT_ATTRIBUTES, oid);
+                module_image_row_has_key(_module_image, MIT_ATTRIBUTES, row, oid);
+                row++)
+        {
+            module_image_get_row(_module_image, MIT_ATTRIBUTES, row, values);
+            if (strcmp(values[1], attr_name) == 0)
+            {
+                get_extra_info_fun(extra_info, 1, values, names);
+            }
+        }
+        return;
+    }
+
     sqlite3_bind_int64(_get_extended_attr_stmt, 1, oid);
     sqlite3_bind_text (_get_extended_attr_stmt, 2, attr_name, -1, SQLITE_STATIC);
 
@@ -1927,11 +2265,37 @@ module_packed_bits_t module_packed_bits_from_hexstr(const char* c)
     return module_packed_bits;
 }
 
+static sqlite3_uint64 insert_snapshot_external_symbol(sqlite3* handle, scope_entry_t* symbol)
+{
+    if (symbol->decl_context == NULL
+            || symbol->decl_context->current_scope != symbol->decl_context->global_scope)
+    {
+        snapshot_unsupported = "references to builtins not in the global scope";
+        return 0;
+    }
+
+    char* insert_external = sqlite3_mprintf("INSERT OR IGNORE INTO snapshot_external(oid, name, kind) "
+            "VALUES(%llu, " Q ", " Q ");",
+            P2ULL(symbol),
+            symbol->symbol_name,
+            symbol_kind_to_str(symbol->kind));
+    run_query(handle, insert_external);
+    sqlite3_free(insert_external);
+
+    return P2ULL(symbol);
+}
+
 static sqlite3_uint64 insert_symbol(sqlite3* handle, scope_entry_t* symbol)
 {
     if (symbol == NULL)
         return 0;
 
+    // Symbols that exist before the snapshot is loaded are looked up by name
+    if (snapshot_mode
+            && (symbol_entity_specs_get_is_builtin(symbol)
+                || dhash_ptr_query(snapshot_preexisting_symbols, (const char*)symbol) != NULL))
+        return insert_snapshot_external_symbol(handle, symbol);
+
     if (oid_already_inserted_symbol(handle, symbol))
         return (sqlite3_uint64)(uintptr_t)symbol;
 
@@ -2085,9 +2449,19 @@ static int get_symbol(void *datum,
 
         if (in_module != NULL)
         {
-            for (i = 0; i < symbol_entity_specs_get_num_related_symbols(in_module); i++)
+            // If the members of in_module are loaded on demand load those
+            // with this name. Not if we are loading in_module itself: in
+            // this case this symbol is one of them
+            lazy_module_t* lazy_module = get_lazy_module(in_module);
+            if (lazy_module != NULL
+                    && lazy_module->image != _module_image)
+            {
+                load_lazy_members_by_name(lazy_module, name);
+            }
+
+            for (i = 0; i < symbol_entity_specs_get_num_loaded_related_symbols(in_module); i++)
             {
-                scope_entry_t* member = symbol_entity_specs_get_related_symbols_num(in_module, i);
+                scope_entry_t* member = symbol_entity_specs_get_loaded_related_symbols_num(in_module, i);
                 if (strcasecmp(member->symbol_name, name) == 0
                         && member->kind == (enum cxx_symbol_kind)symbol_kind
                         && symbol_entity_specs_get_from_module(member) == from_module
@@ -2268,6 +2642,28 @@ static scope_entry_t* load_symbol(sqlite3* handle, sqlite3_uint64 oid)
         }
     }
 
+    if (_module_image != NULL)
+    {
+        uint32_t row = module_image_lower_bound(_module_image, MIT_SYMBOL, oid);
+        if (!module_image_row_has_key(_module_image, MIT_SYMBOL, row, oid))
+        {
+            internal_error("Symbol with oid %llu not found\n", oid);
+        }
+
+        int ncols = module_image_num_columns(_module_image, MIT_SYMBOL);
+        char* values[ncols + 1];
+        module_image_get_row(_module_image, MIT_SYMBOL, row, values);
+
+        symbol_handle_t symbol_handle;
+        memset(&symbol_handle, 0, sizeof(symbol_handle));
+        symbol_handle.handle = handle;
+
+        get_symbol(&symbol_handle, ncols, values,
+                module_image_column_names(_module_image, MIT_SYMBOL));
+
+        return symbol_handle.symbol;
+    }
+
     // Bind the oid parameter
     sqlite3_bind_int64(_load_symbol_stmt, 1, oid);
 
@@ -2385,6 +2781,12 @@ static scope_t* load_scope(sqlite3* handle, sqlite3_uint64 oid)
     memset(&info, 0, sizeof(info));
     info.handle = handle;
 
+    if (_module_image != NULL)
+    {
+        module_image_select(_module_image, MIT_SCOPE, oid, get_scope_, &info);
+        return info.scope;
+    }
+
     sqlite3_bind_int64(_select_scope_stmt, 1, oid);
     const char *errmsg = NULL;
 
@@ -2423,6 +2825,20 @@ static sqlite3_uint64 get_current_scope_oid_of_decl_context_oid(sqlite3* handle,
 
     sqlite3_uint64 result_oid = 0;
 
+    if (_module_image != NULL)
+    {
+        uint32_t row = module_image_lower_bound(_module_image, MIT_DECL_CONTEXT, decl_context_oid);
+        if (module_image_row_has_key(_module_image, MIT_DECL_CONTEXT, row, decl_context_oid))
+        {
+            // See get_decl_context_ for the layout of the row
+            int ncols = module_image_num_columns(_module_image, MIT_DECL_CONTEXT);
+            char* values[ncols + 1];
+            module_image_get_row(_module_image, MIT_DECL_CONTEXT, row, values);
+            result_oid = safe_atoull(values[8]);
+        }
+        return result_oid;
+    }
+
     const char *errmsg = NULL;
     sqlite3_bind_int64(_get_current_scope_of_decl_context_stmt, 1, decl_context_oid);
     if (run_select_query_prepared(handle, _get_current_scope_of_decl_context_stmt,
@@ -2477,6 +2893,13 @@ static const decl_context_t* load_decl_context(sqlite3* handle, sqlite3_uint64 d
     decl_context_info.decl_context = NULL;
     decl_context_info.handle = handle;
 
+    if (_module_image != NULL)
+    {
+        module_image_select(_module_image, MIT_DECL_CONTEXT, decl_context_oid,
+                get_decl_context_, &decl_context_info);
+        return decl_context_info.decl_context;
+    }
+
     const char *errmsg = NULL;
     sqlite3_bind_int64(_select_decl_context_stmt, 1, decl_context_oid);
     if (run_select_query_prepared(handle, _select_decl_context_stmt, get_decl_context_, &decl_context_info, &errmsg) != SQLITE_OK)
@@ -2575,6 +2998,12 @@ static AST load_ast(sqlite3* handle, sqlite3_uint64 oid)
     memset(&query_handle, 0, sizeof(query_handle));
     query_handle.handle = handle;
 
+    if (_module_image != NULL)
+    {
+        module_image_select(_module_image, MIT_AST, oid, get_ast, &query_handle);
+        return query_handle.a;
+    }
+
     const char *errmsg = NULL;
     sqlite3_bind_int64(_select_ast_stmt, 1, oid);
     if (run_select_query_prepared(handle, _select_ast_stmt, get_ast, &query_handle, &errmsg) != SQLITE_OK)
@@ -2765,6 +3194,8 @@ static int get_type(void *datum,
                     ERROR_CONDITION(num_parameters == MCXX_MAX_FUNCTION_PARAMETERS, "Too many parameters %d", num_parameters);
 
                     parameter_info[num_parameters].type_info = load_type(handle, safe_atoull(field));
+                    parameter_info[num_parameters].is_ellipsis =
+                        is_ellipsis_type(parameter_info[num_parameters].type_info);
 
                     num_parameters++;
                     field = strtok_r(NULL, ",", &context);
@@ -2861,6 +3292,82 @@ static int get_type(void *datum,
 
             break;
         }
+        case TKT_C_BUILTIN:
+        {
+            ERROR_CONDITION(kind_size <= 0
+                    || (unsigned int)kind_size >= STATIC_ARRAY_LENGTH(snapshot_builtin_types),
+                    "Invalid builtin type index %d\n", kind_size);
+            *pt = (snapshot_builtin_types[kind_size])();
+            *pt = get_cv_qualified_type(*pt, cv_qualifier);
+            insert_map_ptr(handle, current_oid, *pt);
+            break;
+        }
+        case TKT_C_FLOAT:
+        {
+            ERROR_CONDITION(kind_size < 0
+                    || kind_size >= CURRENT_CONFIGURATION->type_environment->num_float_types,
+                    "Invalid floating type index %d\n", kind_size);
+            *pt = get_floating_type_from_descriptor(
+                    CURRENT_CONFIGURATION->type_environment->all_floats[kind_size]);
+            *pt = get_cv_qualified_type(*pt, cv_qualifier);
+            insert_map_ptr(handle, current_oid, *pt);
+            break;
+        }
+        case TKT_C_COMPLEX:
+        {
+            *pt = get_complex_type(load_type(handle, ref));
+            *pt = get_cv_qualified_type(*pt, cv_qualifier);
+            insert_map_ptr(handle, current_oid, *pt);
+            break;
+        }
+        case TKT_C_ARRAY:
+        {
+            nodecl_t size_expr = load_nodecl(handle, ast0);
+            type_t* element_type = load_type(handle, ref);
+
+            *pt = get_array_type(element_type, size_expr,
+                    CURRENT_COMPILED_FILE->global_decl_context);
+            *pt = get_cv_qualified_type(*pt, cv_qualifier);
+            insert_map_ptr(handle, current_oid, *pt);
+            break;
+        }
+        case TKT_C_CLASS:
+        {
+            *pt = get_new_class_type(CURRENT_COMPILED_FILE->global_decl_context,
+                    (ref & SNAPSHOT_CLASS_IS_UNION) ? TT_UNION : TT_STRUCT);
+            *pt = get_cv_qualified_type(*pt, cv_qualifier);
+            insert_map_ptr(handle, current_oid, *pt);
+
+            set_is_complete_type(*pt, !!(ref & SNAPSHOT_CLASS_IS_COMPLETE));
+            class_type_set_is_packed(*pt, !!(ref & SNAPSHOT_CLASS_IS_PACKED));
+
+            if (symbols != NULL)
+            {
+                char *copy = xstrdup(symbols);
+
+                char *context = NULL;
+                char *field = strtok_r(copy, ",", &context);
+                while (field != NULL)
+                {
+                    scope_entry_t* member = load_symbol(handle, safe_atoull(field));
+
+                    ERROR_CONDITION(member == NULL, "Invalid member!\n", 0);
+                    class_type_add_member(*pt, member,
+                            member->decl_context,
+                            /* is_definition */ 1);
+
+                    field = strtok_r(NULL, ",", &context);
+                }
+                DELETE(copy);
+            }
+            break;
+        }
+        case TKT_ELLIPSIS:
+        {
+            *pt = get_ellipsis_type();
+            insert_map_ptr(handle, current_oid, *pt);
+            break;
+        }
         default:
         {
             internal_error("Invalid type '%d'\n", kind);
@@ -2887,6 +3394,12 @@ static type_t* load_type(sqlite3* handle, sqlite3_uint64 oid)
     memset(&type_handle, 0, sizeof(type_handle));
     type_handle.handle = handle;
 
+    if (_module_image != NULL)
+    {
+        module_image_select(_module_image, MIT_TYPE, oid, get_type, &type_handle);
+        return type_handle.type;
+    }
+
     const char* errmsg = NULL;
     sqlite3_bind_int64(_select_type_stmt, 1, oid);
     if (run_select_query_prepared(handle, _select_type_stmt, get_type, &type_handle, &errmsg) != SQLITE_OK)
@@ -3006,20 +3519,120 @@ static sqlite3_uint64 insert_const_value(sqlite3* handle, const_value_t* value)
     return 0;
 }
 
-static const_value_t* load_const_value(sqlite3* handle, sqlite3_uint64 oid)
+static const_value_t* make_multi_const_value(int multival_kind,
+        int num_elems, const_value_t** list, type_t* struct_type)
 {
-    void *p = get_ptr_of_oid(handle, oid);
-    if (p != NULL)
+    switch (multival_kind)
     {
-        return (const_value_t*)p;
+        case CKT_ARRAY:
+            {
+                return const_value_make_array(num_elems, list);
+            }
+        case CKT_VECTOR:
+            {
+                return const_value_make_vector(num_elems, list);
+            }
+        case CKT_STRUCT:
+            {
+                return const_value_make_struct(num_elems, list, struct_type);
+            }
+        case CKT_COMPLEX:
+            {
+                ERROR_CONDITION(num_elems != 2, "Invalid complex constant!", 0);
+
+                return const_value_make_complex(list[0], list[1]);
+            }
+        case CKT_STRING:
+            {
+                return const_value_make_string_from_values(num_elems, list);
+            }
+        case CKT_RANGE:
+            {
+                ERROR_CONDITION(num_elems != 3, "Invalid range constant!", 0);
+
+                return const_value_make_range(list[0], list[1], list[2]);
+            }
+        default:
+            {
+                internal_error("Code unreachable", 0);
+            }
     }
+    return NULL;
+}
 
-    const_value_t* result = NULL;
+static const_value_t* load_const_value_from_image(sqlite3* handle, sqlite3_uint64 oid)
+{
+    uint32_t row = module_image_lower_bound(_module_image, MIT_CONST_VALUE, oid);
+    if (!module_image_row_has_key(_module_image, MIT_CONST_VALUE, row, oid))
+    {
+        internal_error("Constant with oid %llu not found\n", oid);
+    }
 
-    sqlite3_bind_int64(_select_const_value_stmt, 1, oid);
+    // oid, kind, raw_oid, struct_type
+    char* values[4];
+    module_image_get_row(_module_image, MIT_CONST_VALUE, row, values);
 
-    int result_query = sqlite3_step(_select_const_value_stmt);
-    if (result_query == SQLITE_ROW)
+    const_value_t* result = NULL;
+    // Single values have a raw_oid
+    if (values[2] != NULL)
+    {
+        sqlite3_uint64 raw_oid = safe_atoull(values[2]);
+        uint32_t raw_row = module_image_lower_bound(_module_image, MIT_RAW_CONST_VALUE, raw_oid);
+        if (!module_image_row_has_key(_module_image, MIT_RAW_CONST_VALUE, raw_row, raw_oid))
+        {
+            internal_error("Raw constant with oid %llu not found\n", raw_oid);
+        }
+
+        char* raw_values[1];
+        module_image_get_row(_module_image, MIT_RAW_CONST_VALUE, raw_row, raw_values);
+        result = const_value_build_from_raw_data(raw_values[0]);
+    }
+    else
+    {
+        int multival_kind = safe_atoi(values[1]);
+        type_t* struct_type = load_type(handle, safe_atoull(values[3]));
+
+        uint32_t first = module_image_lower_bound(_module_image, MIT_MULTI_CONST_VALUE, oid);
+        uint32_t last = first;
+        while (module_image_row_has_key(_module_image, MIT_MULTI_CONST_VALUE, last, oid))
+            last++;
+
+        int i, num_elems = last - first;
+        const_value_t* list[num_elems + 1];
+        for (i = 0; i < num_elems; i++)
+        {
+            char* part_values[1];
+            module_image_get_row(_module_image, MIT_MULTI_CONST_VALUE, first + i, part_values);
+            list[i] = load_const_value(handle, safe_atoull(part_values[0]));
+        }
+
+        result = make_multi_const_value(multival_kind, num_elems, list, struct_type);
+    }
+
+    insert_map_ptr(handle, oid, result);
+
+    return result;
+}
+
+static const_value_t* load_const_value(sqlite3* handle, sqlite3_uint64 oid)
+{
+    void *p = get_ptr_of_oid(handle, oid);
+    if (p != NULL)
+    {
+        return (const_value_t*)p;
+    }
+
+    if (_module_image != NULL)
+    {
+        return load_const_value_from_image(handle, oid);
+    }
+
+    const_value_t* result = NULL;
+
+    sqlite3_bind_int64(_select_const_value_stmt, 1, oid);
+
+    int result_query = sqlite3_step(_select_const_value_stmt);
+    if (result_query == SQLITE_ROW)
     {
         int column_type = sqlite3_column_type(_select_const_value_stmt, 2);
         // Single values have a raw_oid
@@ -3106,47 +3719,7 @@ static const_value_t* load_const_value(sqlite3* handle, sqlite3_uint64 oid)
             }
 
             // Finally build the multi const value
-            switch (multival_kind)
-            {
-                case CKT_ARRAY:
-                    {
-                        result = const_value_make_array(num_elems, list);
-                        break;
-                    }
-                case CKT_VECTOR:
-                    {
-                        result = const_value_make_vector(num_elems, list);
-                        break;
-                    }
-                case CKT_STRUCT:
-                    {
-                        result = const_value_make_struct(num_elems, list, struct_type);
-                        break;
-                    }
-                case CKT_COMPLEX:
-                    {
-                        ERROR_CONDITION(num_elems != 2, "Invalid complex constant!", 0);
-
-                        result = const_value_make_complex(list[0], list[1]);
-                        break;
-                    }
-                case CKT_STRING:
-                    {
-                        result = const_value_make_string_from_values(num_elems, list);
-                        break;
-                    }
-                case CKT_RANGE:
-                    {
-                        ERROR_CONDITION(num_elems != 3, "Invalid range constant!", 0);
-
-                        result = const_value_make_range(list[0], list[1], list[2]);
-                        break;
-                    }
-                default:
-                    {
-                        internal_error("Code unreachable", 0);
-                    }
-            }
+            result = make_multi_const_value(multival_kind, num_elems, list, struct_type);
         }
         else
         {
@@ -3256,6 +3829,18 @@ struct get_module_extra_name_tag
     scope_entry_t* module;
 };
 
+static void add_module_extra_data(scope_entry_t* module, fortran_modules_data_t* module_data)
+{
+    fortran_modules_data_set_t* extra_info_attr = symbol_entity_specs_get_module_extra_info(module);
+    if (extra_info_attr == NULL)
+    {
+        extra_info_attr = NEW0(fortran_modules_data_set_t);
+        symbol_entity_specs_set_module_extra_info(module, extra_info_attr);
+    }
+
+    P_LIST_ADD(extra_info_attr->data, extra_info_attr->num_data, module_data);
+}
+
 static int count_module_extra_name(void *data, 
         int num_columns UNUSED_PARAMETER, 
         char **values, 
@@ -3309,20 +3894,62 @@ static int get_module_extra_name(void *data,
 
     sqlite3_free(query);
 
-    fortran_modules_data_set_t* extra_info_attr = symbol_entity_specs_get_module_extra_info(p->module);
-    if (extra_info_attr == NULL)
+    add_module_extra_data(p->module, module_data);
+
+    return 0;
+}
+
+static void load_extra_data_from_module_image(scope_entry_t* module)
+{
+    int ncols = module_image_num_columns(_module_image, MIT_MODULE_EXTRA_NAME);
+    char* values[ncols + 1];
+    char** names = module_image_column_names(_module_image, MIT_MODULE_EXTRA_DATA);
+
+    // Rows of module_extra_name are (oid, name) and rows of
+    // module_extra_data are (kind, value) sorted by their order
+    uint32_t row, num_rows = module_image_num_rows(_module_image, MIT_MODULE_EXTRA_NAME);
+    for (row = 0; row < num_rows; row++)
     {
-        extra_info_attr = NEW0(fortran_modules_data_set_t);
-        symbol_entity_specs_set_module_extra_info(p->module, extra_info_attr);
-    }
+        module_image_get_row(_module_image, MIT_MODULE_EXTRA_NAME, row, values);
+        sqlite3_uint64 oid_name = safe_atoull(values[0]);
 
-    P_LIST_ADD(extra_info_attr->data, extra_info_attr->num_data, module_data);
+        uint32_t first = module_image_lower_bound(_module_image, MIT_MODULE_EXTRA_DATA, oid_name);
+        uint32_t last = first;
+        while (module_image_row_has_key(_module_image, MIT_MODULE_EXTRA_DATA, last, oid_name))
+            last++;
 
-    return 0;
+        if (first == last)
+            continue;
+
+        fortran_modules_data_t *module_data = NEW0(fortran_modules_data_t);
+        module_data->name = uniquestr(values[1]);
+        module_data->num_items = last - first;
+        module_data->items = NEW_VEC0(tl_type_t, last - first);
+
+        struct get_module_extra_data_tag extra_data;
+        extra_data.handle = NULL;
+        extra_data.current_item = module_data->items;
+
+        uint32_t i;
+        for (i = first; i < last; i++)
+        {
+            char* data_values[2];
+            module_image_get_row(_module_image, MIT_MODULE_EXTRA_DATA, i, data_values);
+            get_module_extra_data(&extra_data, 2, data_values, names);
+        }
+
+        add_module_extra_data(module, module_data);
+    }
 }
 
 static void load_extra_data_from_module(sqlite3* handle, scope_entry_t* module)
 {
+    if (_module_image != NULL)
+    {
+        load_extra_data_from_module_image(module);
+        return;
+    }
+
     struct get_module_extra_name_tag module_extra_name;
 
     module_extra_name.handle = handle;
@@ -3346,7 +3973,17 @@ void extend_module_info(scope_entry_t* module, const char* domain, int num_items
 
     driver_fortran_register_module(module_name, &filename, 
             /* is_intrinsic */ symbol_entity_specs_get_is_builtin(module));
+
+    module_image_t* image = module_image_open(filename);
+    if (image != NULL)
+    {
+        module_image_close(image);
+        fatal_error("Module file '%s' cannot be extended because it has already been compacted\n",
+                filename);
+    }
+
     load_storage(&handle, filename);
+    register_module_file_to_compact(filename);
 
     prepare_statements(handle);
 
@@ -3444,14 +4081,1279 @@ void extend_module_info(scope_entry_t* module, const char* domain, int num_items
     dispose_storage(handle);
 }
 
-scope_entry_t* get_module_in_cache(const char* module_name)
+// Binary module images
+//
+// Modules are written through sqlite because TL phases may still extend
+// them (see extend_module_info). Once the translation unit is done with
+// them, compact_module_files turns every module written into a single
+// image that load_module_info maps in memory
+//
+//    header | string pool | per table: column names, keys, rows
+//
+// The rows of every table are sorted by their key (the oid of the object)
+// so finding an object is a binary search. Each row is an array of offsets
+// into the pool (0 means NULL) which stores every string once, prefixed by
+// its length. Joins with the string table are already solved, so rows look
+// like those of the sqlite queries they replace and are handed to the same
+// callbacks
+#define MODULE_IMAGE_MAGIC "MF03IMG"
+enum { MODULE_IMAGE_VERSION = 1 };
+enum { MODULE_IMAGE_BYTE_ORDER = 0x01020304 };
+
+typedef
+struct module_image_table_header_tag
 {
-    rb_red_blk_node* query = rb_tree_query(CURRENT_COMPILED_FILE->module_file_cache, module_name);
-    ERROR_CONDITION(query == NULL, "Module '%s' has not been registered", module_name);
-    scope_entry_t* module_sym = (scope_entry_t*)rb_node_get_info(query);
-    return module_sym;
+    uint32_t num_columns;
+    uint32_t num_rows;
+    // uint32_t[num_columns], names of the columns
+    uint64_t names_offset;
+    // sqlite3_int64[num_rows], sorted
+    uint64_t keys_offset;
+    // uint32_t[num_rows][num_columns], values of the rows
+    uint64_t rows_offset;
+} module_image_table_header_t;
+
+typedef
+struct module_image_header_tag
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t size;
+    uint64_t pool_offset;
+    uint64_t pool_size;
+    module_image_table_header_t tables[MIT_NUM_TABLES];
+} module_image_header_t;
+
+struct module_image_tag
+{
+    const char* base;
+    size_t size;
+    const module_image_header_t* header;
+    // Decoded once, the callbacks want a char**
+    char** names[MIT_NUM_TABLES];
+};
+
+// The first column is the key of the row, the remaining ones are those of
+// the prepared statements used when loading from sqlite
+static const char* module_image_queries[MIT_NUM_TABLES] =
+{
+    [MIT_INFO] = "SELECT 0, module, date, version, build, root_symbol FROM info LIMIT 1;",
+    // MIT_SYMBOL depends on attr_field_names, see module_image_table_query
+    [MIT_ATTRIBUTES] = "SELECT a.symbol, a.value, str.string AS name FROM attributes a, string_table str "
+        "WHERE a.name = str.oid ORDER BY a.symbol, a.oid;",
+    [MIT_TYPE] = "SELECT oid, oid, kind, cv_qualifier, kind_size, ast0, ast1, ref_type, "
+        "types, symbols FROM type ORDER BY oid;",
+    [MIT_AST] = "SELECT a.oid, a.oid, str0.string AS kind, str1.string AS file, a.line, str2.string AS text, "
+        "a.ast0, a.ast1, a.ast2, a.ast3, "
+        "a.type, a.symbol, a.is_lvalue, a.is_const_val, a.const_val, a.is_value_dependent "
+        "FROM ast a, string_table str0, string_table str1, string_table str2 "
+        "WHERE a.kind = str0.oid AND a.file = str1.oid AND a.text = str2.oid ORDER BY a.oid;",
+    [MIT_DECL_CONTEXT] = "SELECT oid, oid, " DECL_CONTEXT_FIELDS " FROM decl_context ORDER BY oid;",
+    [MIT_SCOPE] = "SELECT oid, oid, kind, contained_in, related_entry FROM scope ORDER BY oid;",
+    [MIT_CONST_VALUE] = "SELECT c.oid, c.oid, c.kind, c.raw_oid, c.struct_type FROM const_value c ORDER BY c.oid;",
+    [MIT_RAW_CONST_VALUE] = "SELECT r.oid, r.raw_bytes FROM raw_const_value r ORDER BY r.oid;",
+    [MIT_MULTI_CONST_VALUE] = "SELECT oid_object, oid_part FROM multi_const_value ORDER BY oid_object, oid;",
+    [MIT_MODULE_EXTRA_NAME] = "SELECT oid, oid, name FROM module_extra_name ORDER BY oid;",
+    [MIT_MODULE_EXTRA_DATA] = "SELECT oid_name, kind, value FROM module_extra_data ORDER BY oid_name, order_;",
+};
+
+static char* module_image_table_query(module_image_table_t table)
+{
+    if (table == MIT_SYMBOL)
+    {
+        return sqlite3_mprintf(
+                "SELECT s.oid, s.oid, decl_context, str1.string AS name, str2.string AS kind, type, str3.string AS file, line,"
+                " value, bit_entity_specs, related_decl_context, %s "
+                "FROM symbol s, string_table str1, string_table str2, string_table str3 "
+                "WHERE str1.oid = s.name AND str2.oid = s.kind AND str3.oid = s.file ORDER BY s.oid;",
+                attr_field_names);
+    }
+    return sqlite3_mprintf("%s", module_image_queries[table]);
+}
+
+// Columns, without the key, returned by module_image_table_query. Loading
+// an image checks its tables against these, the callbacks index the rows
+// by position
+static const uint32_t module_image_columns[MIT_NUM_TABLES] =
+{
+    [MIT_INFO] = 5,
+    // Plus one per field of attr_field_names, see module_image_table_columns
+    [MIT_SYMBOL] = 10,
+    [MIT_ATTRIBUTES] = 2,
+    [MIT_TYPE] = 9,
+    [MIT_AST] = 15,
+    [MIT_DECL_CONTEXT] = 9,
+    [MIT_SCOPE] = 4,
+    [MIT_CONST_VALUE] = 4,
+    [MIT_RAW_CONST_VALUE] = 1,
+    [MIT_MULTI_CONST_VALUE] = 1,
+    [MIT_MODULE_EXTRA_NAME] = 2,
+    [MIT_MODULE_EXTRA_DATA] = 2,
+};
+
+static uint32_t module_image_table_columns(module_image_table_t table)
+{
+    uint32_t num_columns = module_image_columns[table];
+    if (table == MIT_SYMBOL)
+    {
+        const char* p;
+        num_columns++;
+        for (p = attr_field_names; *p != '\0'; p++)
+        {
+            if (*p == ',')
+                num_columns++;
+        }
+    }
+    return num_columns;
+}
+
+typedef
+struct image_buffer_tag
+{
+    char* data;
+    size_t size;
+    size_t capacity;
+} image_buffer_t;
+
+// Appends size bytes of data (or zeros if data is NULL) and returns their offset
+static size_t image_buffer_append(image_buffer_t* buffer, const void* data, size_t size)
+{
+    if (buffer->size + size > buffer->capacity)
+    {
+        size_t capacity = (buffer->capacity == 0) ? 4096 : buffer->capacity;
+        while (buffer->size + size > capacity)
+            capacity *= 2;
+
+        buffer->data = NEW_REALLOC(char, buffer->data, capacity);
+        buffer->capacity = capacity;
+    }
+
+    size_t offset = buffer->size;
+    if (data != NULL)
+        memcpy(buffer->data + offset, data, size);
+    else
+        memset(buffer->data + offset, 0, size);
+    buffer->size += size;
+
+    return offset;
+}
+
+static void image_buffer_align(image_buffer_t* buffer, size_t alignment)
+{
+    image_buffer_append(buffer, NULL, (alignment - (buffer->size % alignment)) % alignment);
+}
+
+typedef
+struct module_image_builder_tag
+{
+    image_buffer_t pool;
+    image_buffer_t tables;
+    dhash_str_t* strings;
+} module_image_builder_t;
+
+static uint32_t module_image_add_to_pool(module_image_builder_t* builder,
+        const void* data, uint32_t size)
+{
+    image_buffer_align(&builder->pool, sizeof(uint32_t));
+    size_t offset = image_buffer_append(&builder->pool, &size, sizeof(size));
+    image_buffer_append(&builder->pool, data, size);
+    // Strings are used in place, so keep them NUL-terminated
+    image_buffer_append(&builder->pool, NULL, 1);
+
+    if (builder->pool.size > UINT32_MAX)
+    {
+        fatal_error("Module is too large to be written\n");
+    }
+
+    return offset;
+}
+
+static uint32_t module_image_add_string(module_image_builder_t* builder, const char* str)
+{
+    uint32_t offset = (uint32_t)(uintptr_t)dhash_str_query(builder->strings, str);
+    if (offset == 0)
+    {
+        offset = module_image_add_to_pool(builder, str, strlen(str));
+        dhash_str_insert(builder->strings, xstrdup(str), (void*)(uintptr_t)offset);
+    }
+    return offset;
+}
+
+static void module_image_free_string(const char* key, void* info UNUSED_PARAMETER,
+        void* walk_info UNUSED_PARAMETER)
+{
+    DELETE((char*)key);
+}
+
+static void compact_module_table(sqlite3* handle, module_image_builder_t* builder,
+        const char* query, module_image_table_header_t* table_header)
+{
+    sqlite3_stmt* stmt = NULL;
+    if (sqlite3_prepare_v2(handle, query, -1, &stmt, NULL) != SQLITE_OK)
+    {
+        internal_error("An error happened while preparing statement '%s' %s\n",
+                query,
+                sqlite3_errmsg(handle));
+    }
+
+    int i, ncols = sqlite3_column_count(stmt) - 1;
+    table_header->num_columns = ncols;
+
+    image_buffer_align(&builder->tables, sizeof(uint32_t));
+    table_header->names_offset = builder->tables.size;
+    for (i = 0; i < ncols; i++)
+    {
+        uint32_t name = module_image_add_string(builder, sqlite3_column_name(stmt, i + 1));
+        image_buffer_append(&builder->tables, &name, sizeof(name));
+    }
+
+    image_buffer_t keys, rows;
+    memset(&keys, 0, sizeof(keys));
+    memset(&rows, 0, sizeof(rows));
+
+    uint32_t num_rows = 0;
+    int result_query;
+    while ((result_query = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        sqlite3_int64 key = sqlite3_column_int64(stmt, 0);
+        image_buffer_append(&keys, &key, sizeof(key));
+
+        for (i = 1; i <= ncols; i++)
+        {
+            uint32_t value = 0;
+            switch (sqlite3_column_type(stmt, i))
+            {
+                case SQLITE_NULL:
+                    {
+                        break;
+                    }
+                case SQLITE_BLOB:
+                    {
+                        value = module_image_add_to_pool(builder,
+                                sqlite3_column_blob(stmt, i),
+                                sqlite3_column_bytes(stmt, i));
+                        break;
+                    }
+                default:
+                    {
+                        value = module_image_add_string(builder,
+                                (const char*)sqlite3_column_text(stmt, i));
+                        break;
+                    }
+            }
+            image_buffer_append(&rows, &value, sizeof(value));
+        }
+        num_rows++;
+    }
+
+    if (result_query != SQLITE_DONE)
+    {
+        internal_error("Unexpected error %d when running query '%s'",
+                result_query,
+                sqlite3_errmsg(handle));
+    }
+    sqlite3_finalize(stmt);
+
+    table_header->num_rows = num_rows;
+
+    image_buffer_align(&builder->tables, sizeof(sqlite3_int64));
+    table_header->keys_offset = image_buffer_append(&builder->tables, keys.data, keys.size);
+    table_header->rows_offset = image_buffer_append(&builder->tables, rows.data, rows.size);
+
+    DELETE(keys.data);
+    DELETE(rows.data);
+}
+
+static void write_module_image_part(FILE* f, const char* filename, const void* data, size_t size)
+{
+    if (size > 0
+            && fwrite(data, size, 1, f) != 1)
+    {
+        fatal_error("Error while writing module file '%s' (%s)\n", filename, strerror(errno));
+    }
+}
+
+static void compact_module_file(const char* filename)
+{
+    DEBUG_CODE()
+    {
+        fprintf(stderr, "FORTRAN-MODULES: Compacting module file '%s'\n", filename);
+    }
+
+    sqlite3* handle = NULL;
+    if (sqlite3_open_v2(filename, &handle, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK)
+    {
+        fatal_error("Error while opening module database '%s' (%s)\n", filename, sqlite3_errmsg(handle));
+    }
+
+    module_image_builder_t builder;
+    memset(&builder, 0, sizeof(builder));
+    builder.strings = dhash_str_new(0);
+
+    // Offset 0 of the pool means NULL
+    image_buffer_append(&builder.pool, NULL, sizeof(uint32_t));
+
+    module_image_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MODULE_IMAGE_MAGIC, sizeof(header.magic));
+    header.version = MODULE_IMAGE_VERSION;
+    header.byte_order = MODULE_IMAGE_BYTE_ORDER;
+
+    int i;
+    for (i = 0; i < MIT_NUM_TABLES; i++)
+    {
+        char* query = module_image_table_query(i);
+        compact_module_table(handle, &builder, query, &header.tables[i]);
+        sqlite3_free(query);
+
+        ERROR_CONDITION(header.tables[i].num_columns != module_image_table_columns(i),
+                "Query of table %d returns %u columns but %u were expected", i,
+                header.tables[i].num_columns, module_image_table_columns(i));
+    }
+
+    if (sqlite3_close(handle) != SQLITE_OK)
+    {
+        fatal_error("Error while closing database (%s)\n", sqlite3_errmsg(handle));
+    }
+
+    // Tables were laid out relative to their own buffer
+    image_buffer_align(&builder.pool, sizeof(uint64_t));
+    header.pool_offset = sizeof(header);
+    header.pool_size = builder.pool.size;
+
+    uint64_t tables_offset = header.pool_offset + header.pool_size;
+    for (i = 0; i < MIT_NUM_TABLES; i++)
+    {
+        header.tables[i].names_offset += tables_offset;
+        header.tables[i].keys_offset += tables_offset;
+        header.tables[i].rows_offset += tables_offset;
+    }
+    header.size = tables_offset + builder.tables.size;
+
+    // Do not leave a partial module behind if something goes wrong
+    const char* tmp_filename = strappend(filename, ".tmp");
+    FILE* f = fopen(tmp_filename, "wb");
+    if (f == NULL)
+    {
+        fatal_error("Error while creating module file '%s' (%s)\n", tmp_filename, strerror(errno));
+    }
+
+    write_module_image_part(f, tmp_filename, &header, sizeof(header));
+    write_module_image_part(f, tmp_filename, builder.pool.data, builder.pool.size);
+    write_module_image_part(f, tmp_filename, builder.tables.data, builder.tables.size);
+
+    if (fclose(f) != 0)
+    {
+        fatal_error("Error while writing module file '%s' (%s)\n", tmp_filename, strerror(errno));
+    }
+
+    if (rename(tmp_filename, filename) != 0)
+    {
+        fatal_error("Error while renaming module file '%s' -> '%s' (%s)\n",
+                tmp_filename, filename, strerror(errno));
+    }
+
+    dhash_str_walk(builder.strings, module_image_free_string, NULL);
+    dhash_str_destroy(builder.strings);
+    DELETE(builder.pool.data);
+    DELETE(builder.tables.data);
+}
+
+// Module files written by the current translation unit
+static const char** _module_files_to_compact = NULL;
+static int _num_module_files_to_compact = 0;
+
+static void register_module_file_to_compact(const char* filename)
+{
+    int i;
+    for (i = 0; i < _num_module_files_to_compact; i++)
+    {
+        if (strcmp(_module_files_to_compact[i], filename) == 0)
+            return;
+    }
+
+    P_LIST_ADD(_module_files_to_compact, _num_module_files_to_compact, uniquestr(filename));
+}
+
+void compact_module_files(void)
+{
+    int i;
+    for (i = 0; i < _num_module_files_to_compact; i++)
+    {
+        compact_module_file(_module_files_to_compact[i]);
+    }
+
+    DELETE(_module_files_to_compact);
+    _module_files_to_compact = NULL;
+    _num_module_files_to_compact = 0;
 }
 
+static const char* module_image_pool_value(module_image_t* image, uint32_t offset)
+{
+    if (offset == 0)
+        return NULL;
+
+    return image->base + image->header->pool_offset + offset + sizeof(uint32_t);
+}
+
+// Checks that offset is 0 or the start of a NUL-terminated entry that lies
+// within the pool. Then module_image_pool_value never has to
+static char module_image_pool_offset_is_valid(module_image_t* image, uint32_t offset)
+{
+    if (offset == 0)
+        return 1;
+
+    uint64_t pool_size = image->header->pool_size;
+    if (offset % sizeof(uint32_t) != 0
+            || (uint64_t)offset + sizeof(uint32_t) > pool_size)
+        return 0;
+
+    const char* entry = image->base + image->header->pool_offset + offset;
+    uint32_t size;
+    memcpy(&size, entry, sizeof(size));
+
+    return (uint64_t)offset + sizeof(uint32_t) + size + 1 <= pool_size
+        && entry[sizeof(uint32_t) + size] == '\0';
+}
+
+// Returns NULL if the file is not a module image, likely because it is an
+// sqlite database written by an older version of Mercurium
+static module_image_t* module_image_open(const char* filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        // Let sqlite diagnose this
+        return NULL;
+    }
+
+    struct stat s;
+    module_image_header_t header;
+    if (fstat(fd, &s) < 0
+            || read(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)
+            || memcmp(header.magic, MODULE_IMAGE_MAGIC, sizeof(header.magic)) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    if (header.version != MODULE_IMAGE_VERSION
+            || header.byte_order != MODULE_IMAGE_BYTE_ORDER)
+    {
+        fatal_error("Module file '%s' is not compatible with this version of Mercurium\n", filename);
+    }
+
+    if (header.size != (uint64_t)s.st_size)
+    {
+        fatal_error("Module file '%s' is truncated\n", filename);
+    }
+
+    const char* base = mmap(0, s.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        fatal_error("Cannot map module file '%s' in memory (%s)\n", filename, strerror(errno));
+    }
+
+    module_image_t* image = NEW0(module_image_t);
+    image->base = base;
+    image->size = s.st_size;
+    image->header = (const module_image_header_t*)base;
+
+    if (image->header->pool_offset < sizeof(module_image_header_t)
+            || image->header->pool_offset > image->size
+            || image->header->pool_size > image->size - image->header->pool_offset)
+    {
+        fatal_error("Module file '%s' is corrupt\n", filename);
+    }
+
+    // Everything the loader reads is checked here, once, so the callbacks
+    // can use the rows without further checks
+    int i;
+    for (i = 0; i < MIT_NUM_TABLES; i++)
+    {
+        const module_image_table_header_t* table = &image->header->tables[i];
+        if (table->num_columns != module_image_table_columns(i)
+                || table->names_offset > image->size
+                || table->keys_offset > image->size
+                || table->rows_offset > image->size
+                || table->names_offset + table->num_columns * sizeof(uint32_t) > image->size
+                || table->keys_offset + table->num_rows * sizeof(sqlite3_int64) > image->size
+                || table->rows_offset
+                + (uint64_t)table->num_rows * table->num_columns * sizeof(uint32_t) > image->size)
+        {
+            fatal_error("Module file '%s' is corrupt\n", filename);
+        }
+
+        const uint32_t* names = (const uint32_t*)(image->base + table->names_offset);
+        const uint32_t* values = (const uint32_t*)(image->base + table->rows_offset);
+        uint64_t j, num_values = (uint64_t)table->num_rows * table->num_columns;
+        for (j = 0; j < num_values; j++)
+        {
+            if (!module_image_pool_offset_is_valid(image, values[j]))
+            {
+                fatal_error("Module file '%s' is corrupt\n", filename);
+            }
+        }
+
+        image->names[i] = NEW_VEC0(char*, table->num_columns + 1);
+        for (j = 0; j < table->num_columns; j++)
+        {
+            if (!module_image_pool_offset_is_valid(image, names[j]))
+            {
+                fatal_error("Module file '%s' is corrupt\n", filename);
+            }
+            image->names[i][j] = (char*)module_image_pool_value(image, names[j]);
+        }
+    }
+
+    return image;
+}
+
+static void module_image_close(module_image_t* image)
+{
+    int i;
+    for (i = 0; i < MIT_NUM_TABLES; i++)
+    {
+        DELETE(image->names[i]);
+    }
+
+    munmap((void*)image->base, image->size);
+    DELETE(image);
+}
+
+static int module_image_num_columns(module_image_t* image, module_image_table_t table)
+{
+    return image->header->tables[table].num_columns;
+}
+
+static uint32_t module_image_num_rows(module_image_t* image, module_image_table_t table)
+{
+    return image->header->tables[table].num_rows;
+}
+
+static char** module_image_column_names(module_image_t* image, module_image_table_t table)
+{
+    return image->names[table];
+}
+
+// First row whose key is not lower than oid
+static uint32_t module_image_lower_bound(module_image_t* image, module_image_table_t table,
+        sqlite3_uint64 oid)
+{
+    const module_image_table_header_t* table_header = &image->header->tables[table];
+    const sqlite3_int64* keys = (const sqlite3_int64*)(image->base + table_header->keys_offset);
+
+    // Keys are sorted like sqlite does
+    sqlite3_int64 key = (sqlite3_int64)oid;
+
+    uint32_t first = 0, last = table_header->num_rows;
+    while (first < last)
+    {
+        uint32_t middle = first + (last - first) / 2;
+        if (keys[middle] < key)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+
+    return first;
+}
+
+static char module_image_row_has_key(module_image_t* image, module_image_table_t table,
+        uint32_t row, sqlite3_uint64 oid)
+{
+    const module_image_table_header_t* table_header = &image->header->tables[table];
+    const sqlite3_int64* keys = (const sqlite3_int64*)(image->base + table_header->keys_offset);
+
+    return row < table_header->num_rows
+        && keys[row] == (sqlite3_int64)oid;
+}
+
+// values must have room for the columns of the table. Values point into the
+// image and must not be modified
+static void module_image_get_row(module_image_t* image, module_image_table_t table,
+        uint32_t row, char** values)
+{
+    const module_image_table_header_t* table_header = &image->header->tables[table];
+    const uint32_t* offsets = (const uint32_t*)(image->base + table_header->rows_offset)
+        + (uint64_t)row * table_header->num_columns;
+
+    uint32_t i;
+    for (i = 0; i < table_header->num_columns; i++)
+    {
+        values[i] = (char*)module_image_pool_value(image, offsets[i]);
+    }
+}
+
+static void module_image_select(module_image_t* image, module_image_table_t table,
+        sqlite3_uint64 oid,
+        int (*fun)(void* datum, int ncols, char** values, char **names),
+        void *datum)
+{
+    int ncols = module_image_num_columns(image, table);
+    char* values[ncols + 1];
+
+    uint32_t row;
+    for (row = module_image_lower_bound(image, table, oid);
+            module_image_row_has_key(image, table, row, oid);
+            row++)
+    {
+        module_image_get_row(image, table, row, values);
+        fun(datum, ncols, values, image->names[table]);
+    }
+}
+
+static int compare_lazy_members(const void* a, const void* b)
+{
+    const lazy_member_t* member_a = (const lazy_member_t*)a;
+    const lazy_member_t* member_b = (const lazy_member_t*)b;
+
+    return strcasecmp(member_a->name, member_b->name);
+}
+
+static void record_lazy_members(lazy_module_t* lazy_module, sqlite3_uint64 module_oid)
+{
+    int ncols = module_image_num_columns(_module_image, MIT_SYMBOL);
+    char* symbol_values[ncols + 1];
+
+    char* values[2];
+    uint32_t row;
+    for (row = module_image_lower_bound(_module_image, MIT_ATTRIBUTES, module_oid);
+            module_image_row_has_key(_module_image, MIT_ATTRIBUTES, row, module_oid);
+            row++)
+    {
+        module_image_get_row(_module_image, MIT_ATTRIBUTES, row, values);
+        if (strcmp(values[1], "related_symbols") != 0)
+            continue;
+
+        sqlite3_uint64 oid = safe_atoull(values[0]);
+
+        // The name of the member is the third column of its symbol
+        uint32_t symbol_row = module_image_lower_bound(_module_image, MIT_SYMBOL, oid);
+        if (!module_image_row_has_key(_module_image, MIT_SYMBOL, symbol_row, oid))
+        {
+            fatal_error("Symbol with oid=%llu not found in module image\n", (unsigned long long)oid);
+        }
+        module_image_get_row(_module_image, MIT_SYMBOL, symbol_row, symbol_values);
+
+        lazy_member_t new_member;
+        new_member.name = uniquestr(symbol_values[2]);
+        new_member.oid = oid;
+        new_member.state = LAZY_MEMBER_PENDING;
+
+        P_LIST_ADD(lazy_module->members, lazy_module->num_members, new_member);
+        lazy_module->num_pending++;
+    }
+}
+
+static void register_lazy_module(lazy_module_t* lazy_module, scope_entry_t* module)
+{
+    qsort(lazy_module->members, lazy_module->num_members,
+            sizeof(*lazy_module->members), compare_lazy_members);
+
+    lazy_module->module = module;
+    lazy_module->next = _lazy_modules;
+    _lazy_modules = lazy_module;
+
+    module->lazy_related_symbols = 1;
+}
+
+static lazy_module_t* get_lazy_module(scope_entry_t* module)
+{
+    if (!module->lazy_related_symbols)
+        return NULL;
+
+    lazy_module_t* it;
+    for (it = _lazy_modules; it != NULL; it = it->next)
+    {
+        if (it->module == module)
+            return it;
+    }
+
+    return NULL;
+}
+
+static void unregister_lazy_module(lazy_module_t* lazy_module)
+{
+    lazy_module_t** it = &_lazy_modules;
+    while (*it != lazy_module)
+        it = &((*it)->next);
+    *it = lazy_module->next;
+
+    lazy_module->module->lazy_related_symbols = 0;
+
+    // lazy_module itself is not freed as the callers of load_lazy_member may
+    // still be iterating its members
+    module_image_close(lazy_module->image);
+    lazy_module->image = NULL;
+}
+
+static void load_lazy_member(lazy_module_t* lazy_module, lazy_member_t* member)
+{
+    if (member->state != LAZY_MEMBER_PENDING)
+        return;
+
+    // Set it first as loading the member may ask us again about it
+    member->state = LAZY_MEMBER_LOADING;
+
+    // We may be loading another module right now
+    module_image_t* saved_module_image = _module_image;
+    rb_red_blk_tree* saved_oid_map = _oid_map;
+    sqlite3_uint64 saved_module_oid_being_loaded = module_oid_being_loaded;
+    lazy_module_t* saved_lazy_module_being_loaded = _lazy_module_being_loaded;
+
+    _module_image = lazy_module->image;
+    _oid_map = lazy_module->oid_map;
+    module_oid_being_loaded = lazy_module->module_oid;
+    _lazy_module_being_loaded = NULL;
+
+    scope_entry_t* sym = load_symbol(NULL, member->oid);
+
+    _module_image = saved_module_image;
+    _oid_map = saved_oid_map;
+    module_oid_being_loaded = saved_module_oid_being_loaded;
+    _lazy_module_being_loaded = saved_lazy_module_being_loaded;
+
+    // get_symbol adds the members to their module but this one may have
+    // been loaded before as part of another member
+    scope_entry_t* module = lazy_module->module;
+    char found = 0;
+    int i;
+    for (i = 0; i < symbol_entity_specs_get_num_loaded_related_symbols(module) && !found; i++)
+    {
+        found = (symbol_entity_specs_get_loaded_related_symbols_num(module, i) == sym);
+    }
+    if (!found)
+    {
+        symbol_entity_specs_append_related_symbols(module, sym);
+    }
+
+    member->state = LAZY_MEMBER_LOADED;
+    lazy_module->num_pending--;
+
+    if (lazy_module->num_pending == 0)
+    {
+        unregister_lazy_module(lazy_module);
+    }
+}
+
+static void load_lazy_members_by_name(lazy_module_t* lazy_module, const char* name)
+{
+    lazy_member_t key;
+    memset(&key, 0, sizeof(key));
+    key.name = name;
+
+    lazy_member_t* found = (lazy_member_t*)bsearch(&key,
+            lazy_module->members,
+            lazy_module->num_members,
+            sizeof(*lazy_module->members),
+            compare_lazy_members);
+    if (found == NULL)
+        return;
+
+    // There may be several members with the same name
+    lazy_member_t* first = found;
+    while (first > lazy_module->members
+            && strcasecmp((first - 1)->name, name) == 0)
+        first--;
+
+    lazy_member_t* end = lazy_module->members + lazy_module->num_members;
+    lazy_member_t* it;
+    for (it = first; it < end && strcasecmp(it->name, name) == 0; it++)
+    {
+        load_lazy_member(lazy_module, it);
+    }
+}
+
+void load_module_members_by_name(scope_entry_t* module, const char* name)
+{
+    lazy_module_t* lazy_module = get_lazy_module(module);
+    if (lazy_module == NULL)
+        return;
+
+    load_lazy_members_by_name(lazy_module, name);
+}
+
+void symbol_entity_specs_load_lazy_related_symbols(scope_entry_t* s)
+{
+    lazy_module_t* lazy_module = get_lazy_module(s);
+    if (lazy_module == NULL)
+    {
+        // A copy of a module whose members were being loaded on demand
+        s->lazy_related_symbols = 0;
+        return;
+    }
+
+    int i;
+    for (i = 0; i < lazy_module->num_members; i++)
+    {
+        load_lazy_member(lazy_module, &lazy_module->members[i]);
+    }
+}
+
+scope_entry_t* get_module_in_cache(const char* module_name)
+{
+    rb_red_blk_node* query = rb_tree_query(CURRENT_COMPILED_FILE->module_file_cache, module_name);
+    ERROR_CONDITION(query == NULL, "Module '%s' has not been registered", module_name);
+    scope_entry_t* module_sym = (scope_entry_t*)rb_node_get_info(query);
+    return module_sym;
+}
+
+
+static void define_snapshot_schema(sqlite3* handle)
+{
+    run_query(handle, "CREATE TABLE snapshot_info(version, build, environment, global_scope, "
+            "prefix_hash, prefix_num_lines);");
+    run_query(handle, "CREATE TABLE snapshot_external(oid PRIMARY KEY, name, kind);");
+    run_query(handle, "CREATE TABLE snapshot_symbol(symbol);");
+    run_query(handle, "CREATE TABLE snapshot_decl(symbol, file, line);");
+    run_query(handle, "CREATE TABLE snapshot_definition(file, line, code);");
+}
+
+typedef
+struct snapshot_symbols_tag
+{
+    int num_symbols;
+    scope_entry_t** symbols;
+} snapshot_symbols_t;
+
+static void snapshot_gather_symbols(scope_entry_list_t* entry_list, void *data)
+{
+    snapshot_symbols_t* p = (snapshot_symbols_t*)data;
+
+    scope_entry_list_iterator_t* it = NULL;
+    for (it = entry_list_iterator_begin(entry_list);
+            !entry_list_iterator_end(it);
+            entry_list_iterator_next(it))
+    {
+        scope_entry_t* entry = entry_list_iterator_current(it);
+        if (symbol_entity_specs_get_is_builtin(entry)
+                || dhash_ptr_query(snapshot_preexisting_symbols, (const char*)entry) != NULL)
+            continue;
+
+        P_LIST_ADD(p->symbols, p->num_symbols, entry);
+    }
+    entry_list_iterator_free(it);
+}
+
+char dump_global_scope_snapshot(const char* filename,
+        const decl_context_t* global_context,
+        dhash_ptr_t* preexisting_symbols,
+        nodecl_t top_level_list,
+        unsigned long long prefix_hash,
+        int prefix_num_lines)
+{
+    timing_t timing_dump_snapshot;
+    timing_start(&timing_dump_snapshot);
+
+    snapshot_unsupported = NULL;
+
+    // Function definitions are stored as code that is parsed again when the
+    // snapshot is loaded. Other top level nodes cannot be restored
+    int num_items = 0;
+    nodecl_t* list = nodecl_unpack_list(top_level_list, &num_items);
+    int i;
+    for (i = 0; i < num_items; i++)
+    {
+        if (nodecl_get_kind(list[i]) != NODECL_CXX_DECL
+                && nodecl_get_kind(list[i]) != NODECL_FUNCTION_CODE)
+        {
+            snapshot_unsupported = "pragmas or other top level constructs";
+            break;
+        }
+    }
+
+    if (snapshot_unsupported == NULL)
+    {
+        if (access(filename, F_OK) == 0
+                && remove(filename) != 0)
+        {
+            fatal_error("Error while removing old snapshot '%s' (%s)\n", filename, strerror(errno));
+        }
+
+        sqlite3* handle = NULL;
+        load_storage(&handle, filename);
+
+        start_transaction(handle);
+
+        init_storage(handle);
+        define_snapshot_schema(handle);
+
+        // The functions defined are stored as if they were only declared,
+        // otherwise loading the snapshot would define them twice
+        nodecl_t* function_codes = NEW_VEC0(nodecl_t, num_items + 1);
+        for (i = 0; i < num_items; i++)
+        {
+            if (nodecl_get_kind(list[i]) != NODECL_FUNCTION_CODE)
+                continue;
+
+            scope_entry_t* function = nodecl_get_symbol(list[i]);
+            function_codes[i] = symbol_entity_specs_get_function_code(function);
+            symbol_entity_specs_set_function_code(function, nodecl_null());
+
+            const locus_t* locus = nodecl_get_locus(list[i]);
+            char* insert_definition_query = sqlite3_mprintf("INSERT INTO snapshot_definition(file, line, code) "
+                    "VALUES(" Q ", %u, " Q ");",
+                    locus_get_filename(locus),
+                    locus_get_line(locus),
+                    codegen_to_str(list[i], global_context));
+            run_query(handle, insert_definition_query);
+            sqlite3_free(insert_definition_query);
+        }
+
+        snapshot_mode = 1;
+        snapshot_preexisting_symbols = preexisting_symbols;
+
+        snapshot_symbols_t gathered;
+        memset(&gathered, 0, sizeof(gathered));
+        scope_for_each_entity(global_context->global_scope, &gathered, snapshot_gather_symbols);
+
+        for (i = 0; i < gathered.num_symbols; i++)
+        {
+            char* insert_symbol_query = sqlite3_mprintf("INSERT INTO snapshot_symbol(symbol) VALUES(%llu);",
+                    insert_symbol(handle, gathered.symbols[i]));
+            run_query(handle, insert_symbol_query);
+            sqlite3_free(insert_symbol_query);
+        }
+        DELETE(gathered.symbols);
+
+        for (i = 0; i < num_items; i++)
+        {
+            if (nodecl_get_kind(list[i]) != NODECL_CXX_DECL)
+                continue;
+
+            const locus_t* locus = nodecl_get_locus(list[i]);
+            char* insert_decl_query = sqlite3_mprintf("INSERT INTO snapshot_decl(symbol, file, line) "
+                    "VALUES(%llu, " Q ", %u);",
+                    insert_symbol(handle, nodecl_get_symbol(list[i])),
+                    locus_get_filename(locus),
+                    locus_get_line(locus));
+            run_query(handle, insert_decl_query);
+            sqlite3_free(insert_decl_query);
+        }
+
+        snapshot_mode = 0;
+        snapshot_preexisting_symbols = NULL;
+
+        for (i = 0; i < num_items; i++)
+        {
+            if (nodecl_get_kind(list[i]) == NODECL_FUNCTION_CODE)
+            {
+                symbol_entity_specs_set_function_code(nodecl_get_symbol(list[i]),
+                        function_codes[i]);
+            }
+        }
+        DELETE(function_codes);
+
+        char prefix_hash_str[32];
+        snprintf(prefix_hash_str, sizeof(prefix_hash_str), "%llx", prefix_hash);
+
+        char* insert_info = sqlite3_mprintf("INSERT INTO snapshot_info(version, build, environment, "
+                "global_scope, prefix_hash, prefix_num_lines) "
+                "VALUES(%d, " Q ", " Q ", %llu, " Q ", %d);",
+                CURRENT_MODULE_VERSION,
+                MCXX_BUILD_VERSION,
+                CURRENT_CONFIGURATION->type_environment->environ_id,
+                P2ULL(global_context->global_scope),
+                prefix_hash_str,
+                prefix_num_lines);
+        run_query(handle, insert_info);
+        sqlite3_free(insert_info);
+
+        end_transaction(handle);
+
+        dispose_storage(handle);
+
+        if (snapshot_unsupported != NULL)
+        {
+            remove(filename);
+        }
+    }
+    DELETE(list);
+
+    if (snapshot_unsupported != NULL)
+    {
+        fprintf(stderr, "warning: global scope snapshot '%s' not created because the "
+                "translation unit contains %s\n",
+                filename, snapshot_unsupported);
+        return 0;
+    }
+
+    timing_end(&timing_dump_snapshot);
+
+    if (CURRENT_CONFIGURATION->verbose)
+    {
+        fprintf(stderr, "Global scope snapshot '%s' written in %.2f seconds\n",
+                filename,
+                timing_elapsed(&timing_dump_snapshot));
+    }
+
+    return 1;
+}
+
+typedef
+struct snapshot_info_tag
+{
+    char valid;
+    sqlite3_uint64 global_scope;
+    unsigned long long prefix_hash;
+    int prefix_num_lines;
+} snapshot_info_t;
+
+static int get_snapshot_info_(void *datum,
+        int ncols UNUSED_PARAMETER,
+        char **values,
+        char **names UNUSED_PARAMETER)
+{
+    snapshot_info_t* p = (snapshot_info_t*)datum;
+
+    // Snapshots only work with the same build and type environment
+    p->valid = (safe_atoi(values[0]) == CURRENT_MODULE_VERSION
+            && values[1] != NULL
+            && strcmp(values[1], MCXX_BUILD_VERSION) == 0
+            && values[2] != NULL
+            && strcmp(values[2], CURRENT_CONFIGURATION->type_environment->environ_id) == 0
+            && values[4] != NULL);
+
+    if (p->valid)
+    {
+        p->global_scope = safe_atoull(values[3]);
+        p->prefix_hash = strtoull(values[4], NULL, 16);
+        p->prefix_num_lines = safe_atoi(values[5]);
+    }
+
+    return 0;
+}
+
+static char get_snapshot_info(sqlite3* handle, snapshot_info_t* info)
+{
+    memset(info, 0, sizeof(*info));
+
+    // Do not use run_select_query: this file might not be a snapshot at all
+    char* errmsg = NULL;
+    if (sqlite3_exec(handle, "SELECT version, build, environment, global_scope, prefix_hash, "
+                "prefix_num_lines FROM snapshot_info LIMIT 1;",
+                get_snapshot_info_, info, &errmsg) != SQLITE_OK)
+    {
+        sqlite3_free(errmsg);
+        return 0;
+    }
+
+    return info->valid;
+}
+
+char global_scope_snapshot_get_prefix(const char* filename,
+        unsigned long long *prefix_hash,
+        int *prefix_num_lines)
+{
+    sqlite3* handle = NULL;
+    if (sqlite3_open_v2(filename, &handle, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK)
+    {
+        sqlite3_close(handle);
+        return 0;
+    }
+
+    snapshot_info_t info;
+    char valid = get_snapshot_info(handle, &info);
+
+    sqlite3_close(handle);
+
+    if (valid)
+    {
+        *prefix_hash = info.prefix_hash;
+        *prefix_num_lines = info.prefix_num_lines;
+    }
+
+    return valid;
+}
+
+typedef
+struct snapshot_row_tag
+{
+    sqlite3_uint64 symbol;
+    const char* file;
+    int line;
+} snapshot_row_t;
+
+typedef
+struct snapshot_rows_tag
+{
+    int num_rows;
+    snapshot_row_t* rows;
+} snapshot_rows_t;
+
+static int get_snapshot_rows_(void *datum,
+        int ncols,
+        char **values,
+        char **names UNUSED_PARAMETER)
+{
+    snapshot_rows_t* p = (snapshot_rows_t*)datum;
+
+    snapshot_row_t row;
+    memset(&row, 0, sizeof(row));
+    row.symbol = safe_atoull(values[0]);
+    if (ncols == 3)
+    {
+        row.file = uniquestr(values[1]);
+        row.line = safe_atoi(values[2]);
+    }
+
+    P_LIST_ADD(p->rows, p->num_rows, row);
+
+    return 0;
+}
+
+typedef
+struct snapshot_externals_tag
+{
+    sqlite3* handle;
+    const decl_context_t* global_context;
+    char all_found;
+} snapshot_externals_t;
+
+static int get_snapshot_external_(void *datum,
+        int ncols UNUSED_PARAMETER,
+        char **values,
+        char **names UNUSED_PARAMETER)
+{
+    snapshot_externals_t* p = (snapshot_externals_t*)datum;
+
+    enum cxx_symbol_kind kind = symbol_str_to_kind(values[2]);
+    scope_entry_t* found = NULL;
+
+    scope_entry_list_t* entry_list = query_in_scope_str(p->global_context, uniquestr(values[1]), NULL);
+    scope_entry_list_iterator_t* it = NULL;
+    for (it = entry_list_iterator_begin(entry_list);
+            !entry_list_iterator_end(it) && found == NULL;
+            entry_list_iterator_next(it))
+    {
+        scope_entry_t* entry = entry_list_iterator_current(it);
+        if (entry->kind == kind)
+            found = entry;
+    }
+    entry_list_iterator_free(it);
+    entry_list_free(entry_list);
+
+    if (found != NULL)
+    {
+        insert_map_ptr(p->handle, safe_atoull(values[0]), found);
+    }
+    else
+    {
+        p->all_found = 0;
+    }
+
+    return 0;
+}
+
+static int get_snapshot_definition_(void *datum,
+        int ncols UNUSED_PARAMETER,
+        char **values,
+        char **names UNUSED_PARAMETER)
+{
+    const char** definitions = (const char**)datum;
+
+    // The line marker keeps the loci of the original definition
+    const char* definition = NULL;
+    uniquestr_sprintf(&definition, "# %d \"%s\"\n%s\n",
+            safe_atoi(values[1]),
+            values[0],
+            values[2]);
+    *definitions = strappend(*definitions, definition);
+
+    return 0;
+}
+
+char load_global_scope_snapshot(const char* filename,
+        const decl_context_t* global_context,
+        nodecl_t* top_level_list,
+        const char** definitions)
+{
+    timing_t timing_load_snapshot;
+    timing_start(&timing_load_snapshot);
+
+    sqlite3* handle = NULL;
+    load_storage(&handle, filename);
+
+    // Let sqlite map the snapshot instead of reading it
+    run_query(handle, "PRAGMA mmap_size = 268435456;");
+
+    snapshot_info_t info;
+    if (!get_snapshot_info(handle, &info))
+    {
+        sqlite3_close(handle);
+        return 0;
+    }
+
+    prepare_statements(handle);
+
+    start_transaction(handle);
+
+    // Relocate the global scope and the symbols that already exist in this
+    // translation unit before anything is added to it
+    insert_map_ptr(handle, info.global_scope, global_context->global_scope);
+
+    snapshot_externals_t externals = { handle, global_context, /* all_found */ 1 };
+    char* errmsg = NULL;
+    run_select_query(handle, "SELECT oid, name, kind FROM snapshot_external;",
+            get_snapshot_external_, &externals, &errmsg);
+
+    if (!externals.all_found)
+    {
+        end_transaction(handle);
+        dispose_storage(handle);
+        return 0;
+    }
+
+    snapshot_rows_t symbols;
+    memset(&symbols, 0, sizeof(symbols));
+    run_select_query(handle, "SELECT symbol FROM snapshot_symbol ORDER BY rowid;",
+            get_snapshot_rows_, &symbols, &errmsg);
+
+    int i;
+    for (i = 0; i < symbols.num_rows; i++)
+    {
+        load_symbol(handle, symbols.rows[i].symbol);
+    }
+    DELETE(symbols.rows);
+
+    snapshot_rows_t decls;
+    memset(&decls, 0, sizeof(decls));
+    run_select_query(handle, "SELECT symbol, file, line FROM snapshot_decl ORDER BY rowid;",
+            get_snapshot_rows_, &decls, &errmsg);
+
+    for (i = 0; i < decls.num_rows; i++)
+    {
+        const locus_t* locus = make_locus(decls.rows[i].file, decls.rows[i].line, 0);
+        *top_level_list = nodecl_append_to_list(*top_level_list,
+                nodecl_make_cxx_decl(
+                    nodecl_make_context(nodecl_null(), global_context, locus),
+                    load_symbol(handle, decls.rows[i].symbol),
+                    locus));
+    }
+    DELETE(decls.rows);
+
+    *definitions = "";
+    run_select_query(handle, "SELECT file, line, code FROM snapshot_definition ORDER BY rowid;",
+            get_snapshot_definition_, definitions, &errmsg);
+
+    end_transaction(handle);
+
+    dispose_storage(handle);
+
+    timing_end(&timing_load_snapshot);
+
+    if (CURRENT_CONFIGURATION->verbose)
+    {
+        fprintf(stderr, "Global scope snapshot '%s' loaded in %.2f seconds\n",
+                filename,
+                timing_elapsed(&timing_load_snapshot));
+    }
+
+    return 1;
+}
 
 #ifdef DEBUG_SQLITE3_MPRINTF
  #error Disable DEBUG_SQLITE3_MPRINTF macro once no warnings for sqlite3_mprintf calls are signaled by gcc
@@ -29,6 +29,8 @@
 
 #include "cxx-scope-decls.h"
 #include "cxx-tltype.h"
+#include "cxx-nodecl-decls.h"
+#include "dhash_ptr.h"
 
 MCXX_BEGIN_DECLS
 
@@ -37,9 +39,40 @@ void load_module_info(const char* module_name, scope_entry_t** module);
 
 scope_entry_t* get_module_in_cache(const char* module_name);
 
+// Members of modules loaded from a binary image are loaded on demand. This
+// loads those called name (if any) without loading the others
+void load_module_members_by_name(scope_entry_t* module, const char* name);
+
 // This is used in TL
 void extend_module_info(scope_entry_t* module, const char* domain, int num_items, tl_type_t* info);
 
+// Rewrites the modules written by the current translation unit in their
+// final (binary) form. They cannot be extended afterwards
+void compact_module_files(void);
+
+// Global scope snapshots (C only) reuse the sqlite module storage, so they
+// live here and not in a file of their own. The snapshot records the symbols
+// declared in the global scope, except those in preexisting_symbols and
+// builtins which are looked up by name when loading. The symbols are loaded
+// row by row into an already initialized translation unit: this is not a
+// relocatable image of the compiler state.
+// Both functions return 0 (and leave the file or the scope untouched) if
+// the snapshot cannot be written or used. Function definitions are not
+// loaded: their code is returned in definitions and has to be parsed again
+char dump_global_scope_snapshot(const char* filename,
+        const decl_context_t* global_context,
+        dhash_ptr_t* preexisting_symbols,
+        nodecl_t top_level_list,
+        unsigned long long prefix_hash,
+        int prefix_num_lines);
+char global_scope_snapshot_get_prefix(const char* filename,
+        unsigned long long *prefix_hash,
+        int *prefix_num_lines);
+char load_global_scope_snapshot(const char* filename,
+        const decl_context_t* global_context,
+        nodecl_t* top_level_list,
+        const char** definitions);
+
 MCXX_END_DECLS
 
 #endif // FORTRAN03_MODULES_H
@@ -34,6 +34,7 @@
 #include "fortran03-buildscope.h"
 #include "fortran03-typeutils.h"
 #include "fortran03-intrinsics.h"
+#include "fortran03-modules.h"
 #include <string.h>
 #include <ctype.h>
 
@@ -697,11 +698,14 @@ scope_entry_list_t* fortran_query_module_for_name(scope_entry_t* module_symbol,
             || module_symbol->kind != SK_MODULE, "Invalid symbol", 0);
     ERROR_CONDITION(name == NULL, "Invalid name", 0);
 
+    // Only the members called name are needed, do not load the others
+    load_module_members_by_name(module_symbol, name);
+
     scope_entry_list_t* result = NULL;
     int i;
-    for (i = 0; i < symbol_entity_specs_get_num_related_symbols(module_symbol); i++)
+    for (i = 0; i < symbol_entity_specs_get_num_loaded_related_symbols(module_symbol); i++)
     {
-        scope_entry_t* sym = symbol_entity_specs_get_related_symbols_num(module_symbol, i);
+        scope_entry_t* sym = symbol_entity_specs_get_loaded_related_symbols_num(module_symbol, i);
 
         if (strcasecmp(sym->symbol_name, name) == 0
                 // Filter private symbols
@@ -713,3 +717,221 @@ scope_entry_list_t* fortran_query_module_for_name(scope_entry_t* module_symbol,
 
     return result;
 }
+
+typedef
+struct fortran_lazy_use_tag
+{
+    scope_entry_t* module_symbol;
+
+    int num_renamed_symbols;
+    scope_entry_t** renamed_symbols;
+
+    const locus_t* locus;
+} fortran_lazy_use_t;
+
+struct fortran_lazy_uses_tag
+{
+    const decl_context_t* decl_context;
+
+    int num_uses;
+    fortran_lazy_use_t* uses;
+
+    // Names (in lowercase) already signed in
+    dhash_ptr_t* signed_in;
+
+    // Nonzero if every public name of every module has been signed in
+    char all_signed_in;
+};
+
+static void sign_in_lazy_use(fortran_lazy_uses_t* lazy_uses,
+        fortran_lazy_use_t* use,
+        const char* lower_name)
+{
+    scope_entry_list_t* syms_in_module =
+        fortran_query_module_for_name(use->module_symbol, lower_name);
+
+    scope_entry_list_iterator_t* it = NULL;
+    for (it = entry_list_iterator_begin(syms_in_module);
+            !entry_list_iterator_end(it);
+            entry_list_iterator_next(it))
+    {
+        scope_entry_t* sym_in_module = entry_list_iterator_current(it);
+
+        char found = 0;
+        int j;
+        for (j = 0; j < use->num_renamed_symbols && !found; j++)
+        {
+            found = (use->renamed_symbols[j] == sym_in_module);
+        }
+        if (!found)
+        {
+            insert_symbol_from_module(sym_in_module,
+                    lazy_uses->decl_context,
+                    sym_in_module->symbol_name,
+                    use->module_symbol,
+                    use->locus);
+        }
+    }
+    entry_list_iterator_free(it);
+    entry_list_free(syms_in_module);
+}
+
+typedef
+struct gather_names_tag
+{
+    int num_names;
+    const char** names;
+} gather_names_t;
+
+static void gather_names(const char* key, void* info UNUSED_PARAMETER, void* walk_info)
+{
+    gather_names_t* gathered = (gather_names_t*)walk_info;
+    P_LIST_ADD(gathered->names, gathered->num_names, key);
+}
+
+void fortran_lazy_uses_add(const decl_context_t* decl_context,
+        scope_entry_t* module_symbol,
+        int num_renamed_symbols,
+        scope_entry_t** renamed_symbols,
+        const locus_t* locus)
+{
+    scope_t* sc = decl_context->current_scope;
+
+    gather_names_t gathered;
+    memset(&gathered, 0, sizeof(gathered));
+
+    if (sc->fortran_lazy_uses == NULL)
+    {
+        sc->fortran_lazy_uses = NEW0(fortran_lazy_uses_t);
+        sc->fortran_lazy_uses->decl_context = decl_context;
+        sc->fortran_lazy_uses->signed_in = dhash_ptr_new(5);
+
+        // Names already in the scope will not be looked up again
+        dhash_ptr_walk(sc->dhash, gather_names, &gathered);
+        int i;
+        for (i = 0; i < gathered.num_names; i++)
+        {
+            dhash_ptr_insert(sc->fortran_lazy_uses->signed_in,
+                    strtolower(gathered.names[i]),
+                    (dhash_ptr_info_t)sc->fortran_lazy_uses);
+        }
+        DELETE(gathered.names);
+        memset(&gathered, 0, sizeof(gathered));
+    }
+    fortran_lazy_uses_t* lazy_uses = sc->fortran_lazy_uses;
+
+    lazy_uses->num_uses++;
+    lazy_uses->uses = NEW_REALLOC(fortran_lazy_use_t,
+            lazy_uses->uses,
+            lazy_uses->num_uses);
+
+    fortran_lazy_use_t* new_use = &lazy_uses->uses[lazy_uses->num_uses - 1];
+    new_use->module_symbol = module_symbol;
+    new_use->num_renamed_symbols = num_renamed_symbols;
+    new_use->renamed_symbols = NEW_VEC(scope_entry_t*, num_renamed_symbols);
+    memcpy(new_use->renamed_symbols, renamed_symbols,
+            num_renamed_symbols * sizeof(*renamed_symbols));
+    new_use->locus = locus;
+
+    lazy_uses->all_signed_in = 0;
+
+    // Names signed in so far must be signed in for this USE too. Gather them
+    // first as signing them in may add more names
+    dhash_ptr_walk(lazy_uses->signed_in, gather_names, &gathered);
+    int i;
+    for (i = 0; i < gathered.num_names; i++)
+    {
+        sign_in_lazy_use(lazy_uses,
+                &lazy_uses->uses[lazy_uses->num_uses - 1],
+                gathered.names[i]);
+    }
+    DELETE(gathered.names);
+}
+
+void fortran_lazy_uses_sign_in(scope_t* sc, const char* name)
+{
+    fortran_lazy_uses_t* lazy_uses = sc->fortran_lazy_uses;
+    if (lazy_uses == NULL)
+        return;
+
+    const char* lower_name = strtolower(name);
+    if (dhash_ptr_query(lazy_uses->signed_in, lower_name) != NULL)
+        return;
+
+    // Set it first as inserting the symbols will ask us again about this name
+    dhash_ptr_insert(lazy_uses->signed_in, lower_name, (dhash_ptr_info_t)lazy_uses);
+
+    int i;
+    for (i = 0; i < lazy_uses->num_uses; i++)
+    {
+        sign_in_lazy_use(lazy_uses, &lazy_uses->uses[i], lower_name);
+    }
+}
+
+void fortran_lazy_uses_sign_in_all(scope_t* sc)
+{
+    fortran_lazy_uses_t* lazy_uses = sc->fortran_lazy_uses;
+    if (lazy_uses == NULL
+            || lazy_uses->all_signed_in)
+        return;
+
+    int i;
+    for (i = 0; i < lazy_uses->num_uses; i++)
+    {
+        scope_entry_t* module_symbol = lazy_uses->uses[i].module_symbol;
+
+        int j;
+        for (j = 0; j < symbol_entity_specs_get_num_related_symbols(module_symbol); j++)
+        {
+            scope_entry_t* sym_in_module = symbol_entity_specs_get_related_symbols_num(module_symbol, j);
+
+            if (symbol_entity_specs_get_access(sym_in_module) == AS_PRIVATE)
+                continue;
+
+            fortran_lazy_uses_sign_in(sc, sym_in_module->symbol_name);
+        }
+    }
+
+    lazy_uses->all_signed_in = 1;
+}
+
+void fortran_lazy_uses_copy(const decl_context_t* decl_context, scope_t* orig_scope)
+{
+    fortran_lazy_uses_t* orig_lazy_uses = orig_scope->fortran_lazy_uses;
+    if (orig_lazy_uses == NULL)
+        return;
+
+    scope_t* sc = decl_context->current_scope;
+    ERROR_CONDITION(sc->fortran_lazy_uses != NULL, "The scope already has USE-associated names", 0);
+
+    fortran_lazy_uses_t* lazy_uses = NEW0(fortran_lazy_uses_t);
+    lazy_uses->decl_context = decl_context;
+    lazy_uses->signed_in = dhash_ptr_new(5);
+    lazy_uses->all_signed_in = orig_lazy_uses->all_signed_in;
+
+    // The names signed in so far were copied along with the original scope
+    gather_names_t gathered;
+    memset(&gathered, 0, sizeof(gathered));
+    dhash_ptr_walk(orig_lazy_uses->signed_in, gather_names, &gathered);
+    int i;
+    for (i = 0; i < gathered.num_names; i++)
+    {
+        dhash_ptr_insert(lazy_uses->signed_in, gathered.names[i], (dhash_ptr_info_t)lazy_uses);
+    }
+    DELETE(gathered.names);
+
+    lazy_uses->num_uses = orig_lazy_uses->num_uses;
+    lazy_uses->uses = NEW_VEC(fortran_lazy_use_t, lazy_uses->num_uses);
+    for (i = 0; i < lazy_uses->num_uses; i++)
+    {
+        fortran_lazy_use_t* orig_use = &orig_lazy_uses->uses[i];
+        fortran_lazy_use_t* new_use = &lazy_uses->uses[i];
+
+        *new_use = *orig_use;
+        new_use->renamed_symbols = NEW_VEC(scope_entry_t*, orig_use->num_renamed_symbols);
+        memcpy(new_use->renamed_symbols, orig_use->renamed_symbols,
+                orig_use->num_renamed_symbols * sizeof(*orig_use->renamed_symbols));
+    }
+
+    sc->fortran_lazy_uses = lazy_uses;
+}
@@ -83,6 +83,29 @@ LIBMF03_EXTERN scope_entry_list_t* fortran_query_module_for_name(scope_entry_t*
 // Gets the ultimate symbol of a symbol coming from a module
 LIBMF03_EXTERN scope_entry_t* fortran_get_ultimate_symbol(scope_entry_t* entry);
 
+// USE statements without ONLY in program units do not insert every public
+// name of the module upfront. They are signed in the current scope of
+// decl_context the first time their name is looked up (or declared) there.
+// renamed_symbols are the symbols of the module that are not USE-associated
+// with their own name (because of renames in the USE statement)
+LIBMF03_EXTERN void fortran_lazy_uses_add(const decl_context_t* decl_context,
+        scope_entry_t* module_symbol,
+        int num_renamed_symbols,
+        scope_entry_t** renamed_symbols,
+        const locus_t* locus);
+
+// Signs in the USE-associated names called name attached to sc that have not
+// been signed in yet
+LIBMF03_EXTERN void fortran_lazy_uses_sign_in(scope_t* sc, const char* name);
+
+// Signs in every USE-associated name attached to sc that has not been signed
+// in yet. Code that walks all the entities of a scope must call this first
+LIBMF03_EXTERN void fortran_lazy_uses_sign_in_all(scope_t* sc);
+
+// Attaches to the current scope of decl_context the USE statements attached
+// to orig_scope, whose entities have already been copied there
+LIBMF03_EXTERN void fortran_lazy_uses_copy(const decl_context_t* decl_context, scope_t* orig_scope);
+
 MCXX_END_DECLS
 
 #endif // FORTRAN03_SCOPE_H
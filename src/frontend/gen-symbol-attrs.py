@@ -141,10 +141,42 @@ def print_type_and_name(_type, name):
         raise Exception("Invalid type %s" % (_type))
 
 
+def split_array_name(name):
+    field_names = name.split(",")
+    if (len(field_names) == 1):
+        return ("num_" + name, name)
+    elif (len(field_names) == 2):
+        return (field_names[0], field_names[1])
+    else:
+        raise Exception(
+            "Invalid number of fields in array name. Only 1 or 2 comma-separated are allowed"
+        )
+
+
+# Most symbols only use a handful of attributes. Boolean attributes and the
+# attributes listed here are stored in the symbol itself. The remaining ones
+# are rare and they are stored in a separate entity_specifiers_sparse_t that
+# is only allocated when one of them is set
+dense_attributes = [
+    "access", "class_type", "alias_to", "linkage_spec", "function_code",
+    "related_symbols", "function_parameter_info", "default_argument_info",
+    "gcc_attributes"
+]
+
+
+def is_sparse_attribute(_type, name):
+    if _type == "bool":
+        return False
+    if _type.startswith("array"):
+        (num_name, name) = split_array_name(name)
+    return name not in dense_attributes
+
+
 def print_entity_specifiers(lines):
     indent = " " * 4
     current_language = "all"
     decls = []
+    sparse_decls = []
     for l in lines:
         fields = l.split("|")
         (_type, language, name, description) = fields
@@ -155,7 +187,10 @@ def print_entity_specifiers(lines):
         if (language != current_language):
             current_language = language
         descr = description.strip(" \n")
-        decls += print_type_and_name(_type, name)
+        if is_sparse_attribute(_type, name):
+            sparse_decls += print_type_and_name(_type, name)
+        else:
+            decls += print_type_and_name(_type, name)
 
     print("""
 #ifndef CXX_ENTITY_SPECIFIERS_H
@@ -165,6 +200,8 @@ def print_entity_specifiers(lines):
 
 // Include this file only from cxx-scope-decls.h and not from anywhere else
 
+typedef struct entity_specifiers_sparse_tag entity_specifiers_sparse_t;
+
 typedef struct entity_specifiers_tag\n{""")
 
     for tk in [
@@ -174,12 +211,45 @@ typedef struct entity_specifiers_tag\n{""")
             (typename, name, suffix, k) = d
             if k == tk:
                 print(indent + typename + " " + name + suffix + ";")
+        if tk == TypeKind.POINTER:
+            print(indent + "// Rare attributes, NULL until one of them is set")
+            print(indent + "entity_specifiers_sparse_t* _sparse;")
 
     print("} entity_specifiers_t;")
     print("")
+    print("struct entity_specifiers_sparse_tag\n{")
+    print(indent + "// Number of symbols using this structure. Symbols copied as a whole")
+    print(indent + "// share it until one of them sets one of its attributes")
+    print(indent + "int _refcount;")
+    for tk in [TypeKind.OTHER, TypeKind.POINTER, TypeKind.INTEGER]:
+        for d in sparse_decls:
+            (typename, name, suffix, k) = d
+            if k == tk:
+                print(indent + typename + " " + name + suffix + ";")
+    print("};")
+    print("")
     print("#endif")
 
 
+# The values of these attributes may be loaded on demand, see
+# symbol_entity_specs_load_lazy_related_symbols in fortran03-modules.c
+lazy_attributes = ["related_symbols"]
+
+
+def specs_access(_type, name, var, writes):
+    """Returns the declarations needed to access the attribute 'name' of
+    the symbol 'var' and the prefix of its fields"""
+    if not is_sparse_attribute(_type, name):
+        return ("", "%s->_entity_specs." % (var))
+    if writes:
+        decl = "    entity_specifiers_sparse_t* %s_specs = symbol_entity_specs_sparse_rw(%s);\n" % (
+            var, var)
+    else:
+        decl = "    const entity_specifiers_sparse_t* %s_specs = symbol_entity_specs_sparse_ro(%s);\n" % (
+            var, var)
+    return (decl, "%s_specs->" % (var))
+
+
 def print_getters_setters(lines):
     print("""
 #ifndef CXX_ENTITY_SPECIFIERS_OPS_H
@@ -195,6 +265,33 @@ def print_getters_setters(lines):
 
 // Include this file only from cxx-scope-decls.h and not from anywhere else
 
+// We need libmf03-common.h for LIBMF03_EXTERN
+#include "fortran/libmf03-common.h"
+
+// Rare attributes are read from this empty structure when the symbol does
+// not have its own entity_specifiers_sparse_t
+LIBMCXX_EXTERN const entity_specifiers_sparse_t entity_specifiers_sparse_empty;
+// Gives the symbol its own entity_specifiers_sparse_t
+LIBMCXX_EXTERN void symbol_entity_specs_allocate_sparse(scope_entry_t* s);
+LIBMCXX_EXTERN void symbol_entity_specs_free_sparse(scope_entry_t* s);
+// Must be called after copying a symbol as a whole, s being the copy
+LIBMCXX_EXTERN void symbol_entity_specs_share_sparse(scope_entry_t* s);
+
+static inline const entity_specifiers_sparse_t* symbol_entity_specs_sparse_ro(scope_entry_t* s)
+{
+    if (s->_entity_specs._sparse == NULL)
+        return &entity_specifiers_sparse_empty;
+    return s->_entity_specs._sparse;
+}
+
+static inline entity_specifiers_sparse_t* symbol_entity_specs_sparse_rw(scope_entry_t* s)
+{
+    if (s->_entity_specs._sparse == NULL
+            || s->_entity_specs._sparse->_refcount > 1)
+        symbol_entity_specs_allocate_sparse(s);
+    return s->_entity_specs._sparse;
+}
+
 """)
     current_language = "all"
     decls = []
@@ -208,32 +305,32 @@ def print_getters_setters(lines):
         if (_type in
             ["integer", "bool", "string", "AST", "nodecl", "type", "symbol"]
             ) or _type.startswith("typeof"):
+            (ro_decl, ro) = specs_access(_type, name, "s", False)
+            (rw_decl, rw) = specs_access(_type, name, "s", True)
             decls = print_type_and_name(_type, name)
             if len(decls) != 1:
                 raise Exception("Expecting one declaration")
             (typename, name, suffix, k) = decls[0]
+            # Setting a null value to a rare attribute of a symbol without
+            # rare attributes does not allocate them
+            skip_null = ""
+            if (rw_decl != "" and k in [TypeKind.INTEGER, TypeKind.POINTER]
+                    and typename != "nodecl_t"):
+                skip_null = "    if (v == 0 && s->_entity_specs._sparse == NULL)\n        return;\n"
             print("// Single value attribute: '%s' " % (name))
             print(
-                "static inline %s symbol_entity_specs_get_%s(scope_entry_t* s)\n{\n    return s->_entity_specs.%s;\n}"
-                % (typename, name, name))
+                "static inline %s symbol_entity_specs_get_%s(scope_entry_t* s)\n{\n%s    return %s%s;\n}"
+                % (typename, name, ro_decl, ro, name))
             print(
-                "static inline void symbol_entity_specs_set_%s(scope_entry_t* s, %s v)\n{\n    s->_entity_specs.%s = v;\n}"
-                % (name, typename, name))
+                "static inline void symbol_entity_specs_set_%s(scope_entry_t* s, %s v)\n{\n%s%s    %s%s = v;\n}"
+                % (name, typename, skip_null, rw_decl, rw, name))
             print("")
         # Compound types
         elif _type.startswith("array"):
+            (ro_decl, ro) = specs_access(_type, name, "s", False)
+            (rw_decl, rw) = specs_access(_type, name, "s", True)
             type_name = get_up_to_matching_paren(_type[len("array"):])
-            field_names = name.split(",")
-            if (len(field_names) == 1):
-                num_name = "num_" + name
-                list_name = name
-            elif (len(field_names) == 2):
-                num_name = field_names[0]
-                list_name = field_names[1]
-            else:
-                raise Exception(
-                    "Invalid number of fields in array name. Only 1 or 2 comma-separated are allowed"
-                )
+            (num_name, list_name) = split_array_name(name)
 
             decls = print_type_and_name(type_name, "")
             if len(decls) != 1:
@@ -251,54 +348,91 @@ def print_getters_setters(lines):
                     "// Note: The number of values of this attribute is stored in attribute '%s'"
                     % (num_name))
 
+            # Values of lazy attributes are completed before they are
+            # accessed. The _loaded_ getters only see those already there
+            complete = ""
+            if list_name in lazy_attributes:
+                print(
+                    "// Loads the values of '%s' not loaded yet\nLIBMF03_EXTERN void symbol_entity_specs_load_lazy_%s(scope_entry_t* s);"
+                    % (list_name, list_name))
+                print(
+                    "static inline void symbol_entity_specs_complete_%s(scope_entry_t* s)\n{\n    if (s->lazy_%s)\n        symbol_entity_specs_load_lazy_%s(s);\n}"
+                    % (list_name, list_name, list_name))
+                print(
+                    "static inline int symbol_entity_specs_get_num_loaded_%s(scope_entry_t* s)\n{\n%s    return %s%s;\n}"
+                    % (list_name, ro_decl, ro, num_name))
+                print(
+                    "static inline %s symbol_entity_specs_get_loaded_%s_num(scope_entry_t* s, int i)\n{\n%s    ERROR_CONDITION(i >= %s%s,\n        \"Invalid index %%d >= %%d\",\n        i, %s%s);\n    return %s%s[i];\n}"
+                    % (type_name, list_name, ro_decl, ro, num_name, ro,
+                       num_name, ro, list_name))
+                complete = "    symbol_entity_specs_complete_%s(s);\n" % (list_name)
+
             print(
-                "static inline int symbol_entity_specs_get_%s(scope_entry_t* s)\n{\n    return s->_entity_specs.%s;\n}"
-                % (num_name, num_name))
+                "static inline int symbol_entity_specs_get_%s(scope_entry_t* s)\n{\n%s%s    return %s%s;\n}"
+                % (num_name, complete, ro_decl, ro, num_name))
             print(
-                "static inline %s symbol_entity_specs_get_%s_num(scope_entry_t* s, int i)\n{\n    ERROR_CONDITION(i >= s->_entity_specs.%s,\n        \"Invalid index %%d >= %%d\",\n        i, s->_entity_specs.%s);\n    return s->_entity_specs.%s[i];\n}"
-                % (type_name, list_name, num_name, num_name, list_name))
+                "static inline %s symbol_entity_specs_get_%s_num(scope_entry_t* s, int i)\n{\n%s%s    ERROR_CONDITION(i >= %s%s,\n        \"Invalid index %%d >= %%d\",\n        i, %s%s);\n    return %s%s[i];\n}"
+                % (type_name, list_name, complete, ro_decl, ro, num_name, ro,
+                   num_name, ro, list_name))
             print(
-                "static inline void symbol_entity_specs_set_%s_num(scope_entry_t* s, int i, %s v)\n{\n    ERROR_CONDITION(i >= s->_entity_specs.%s,\n        \"Invalid index %%d >= %%d\",\n         i, s->_entity_specs.%s);\n    s->_entity_specs.%s[i] = v;\n}"
-                % (list_name, type_name, num_name, num_name, list_name))
+                "static inline void symbol_entity_specs_set_%s_num(scope_entry_t* s, int i, %s v)\n{\n%s%s    ERROR_CONDITION(i >= %s%s,\n        \"Invalid index %%d >= %%d\",\n         i, %s%s);\n    %s%s[i] = v;\n}"
+                % (list_name, type_name, complete, rw_decl, rw, num_name, rw,
+                   num_name, rw, list_name))
             print(
-                "static inline void symbol_entity_specs_append_%s(scope_entry_t* s, %s item)\n{\n    P_LIST_ADD(s->_entity_specs.%s, s->_entity_specs.%s, item);\n}"
-                % (list_name, type_name, list_name, num_name))
+                "static inline void symbol_entity_specs_append_%s(scope_entry_t* s, %s item)\n{\n%s    P_LIST_ADD(%s%s, %s%s, item);\n}"
+                % (list_name, type_name, rw_decl, rw, list_name, rw, num_name))
             if type_name not in cannot_be_compared:
                 print(
-                    "static inline void symbol_entity_specs_remove_%s(scope_entry_t* s, %s item)\n{\n    P_LIST_REMOVE(s->_entity_specs.%s, s->_entity_specs.%s, item);\n}"
-                    % (list_name, type_name, list_name, num_name))
+                    "static inline void symbol_entity_specs_remove_%s(scope_entry_t* s, %s item)\n{\n%s%s    P_LIST_REMOVE(%s%s, %s%s, item);\n}"
+                    % (list_name, type_name, complete, rw_decl, rw, list_name,
+                       rw, num_name))
                 print(
-                    "static inline void symbol_entity_specs_insert_%s(scope_entry_t* s, %s item)\n{\n    P_LIST_ADD_ONCE(s->_entity_specs.%s, s->_entity_specs.%s, item);\n}"
-                    % (list_name, type_name, list_name, num_name))
+                    "static inline void symbol_entity_specs_insert_%s(scope_entry_t* s, %s item)\n{\n%s%s    P_LIST_ADD_ONCE(%s%s, %s%s, item);\n}"
+                    % (list_name, type_name, complete, rw_decl, rw, list_name,
+                       rw, num_name))
             print(
-                "static inline void symbol_entity_specs_remove_%s_cmp(scope_entry_t* s, %s item,\n        char (*cmp)(%s, %s))\n{\n    P_LIST_REMOVE_FUN(s->_entity_specs.%s, s->_entity_specs.%s, item, cmp);\n}"
-                % (list_name, type_name, type_name, type_name, list_name,
-                   num_name))
+                "static inline void symbol_entity_specs_remove_%s_cmp(scope_entry_t* s, %s item,\n        char (*cmp)(%s, %s))\n{\n%s%s    P_LIST_REMOVE_FUN(%s%s, %s%s, item, cmp);\n}"
+                % (list_name, type_name, type_name, type_name, complete,
+                   rw_decl, rw, list_name, rw, num_name))
             print(
-                "static inline void symbol_entity_specs_insert_%s_cmp(scope_entry_t* s, %s item,\n        char (*cmp)(%s, %s))\n{\n    P_LIST_ADD_ONCE_FUN(s->_entity_specs.%s, s->_entity_specs.%s, item, cmp);\n}"
-                % (list_name, type_name, type_name, type_name, list_name,
-                   num_name))
+                "static inline void symbol_entity_specs_insert_%s_cmp(scope_entry_t* s, %s item,\n        char (*cmp)(%s, %s))\n{\n%s%s    P_LIST_ADD_ONCE_FUN(%s%s, %s%s, item, cmp);\n}"
+                % (list_name, type_name, type_name, type_name, complete,
+                   rw_decl, rw, list_name, rw, num_name))
             print(
                 "static inline void symbol_entity_specs_add_%s(scope_entry_t* s, %s item)\n{\n    symbol_entity_specs_append_%s(s, item);\n}"
                 % (list_name, type_name, list_name))
             print(
-                "static inline void symbol_entity_specs_reserve_%s(scope_entry_t* s, int num)\n{\n    s->_entity_specs.%s = num;\n    s->_entity_specs.%s = NEW_VEC0(%s, num);\n}"
-                % (list_name, num_name, list_name, type_name))
-            # print "static inline void symbol_entity_specs_clear_%s(scope_entry_t* s)\n{\n    s->_entity_specs.%s = NULL;\n    s->_entity_specs.%s = 0;\n}" % (list_name, list_name, num_name)
+                "static inline void symbol_entity_specs_reserve_%s(scope_entry_t* s, int num)\n{\n%s    %s%s = num;\n    %s%s = NEW_VEC0(%s, num);\n}"
+                % (list_name, rw_decl, rw, num_name, rw, list_name, type_name))
+            # Nothing to free or copy if the symbols do not have rare attributes
+            no_sparse = ""
+            no_sparse_copy = ""
+            if rw_decl != "":
+                no_sparse = "    if (s->_entity_specs._sparse == NULL)\n        return;\n"
+                # Symbols sharing their rare attributes have the same lists
+                no_sparse_copy = "    if (source->_entity_specs._sparse == dest->_entity_specs._sparse)\n        return;\n"
             print(
-                "static inline void symbol_entity_specs_free_%s(scope_entry_t* s)\n{\n    s->_entity_specs.%s = 0;\n    DELETE(s->_entity_specs.%s);\n    s->_entity_specs.%s = NULL;\n}"
-                % (list_name, num_name, list_name, list_name))
+                "static inline void symbol_entity_specs_free_%s(scope_entry_t* s)\n{\n%s%s%s    %s%s = 0;\n    DELETE(%s%s);\n    %s%s = NULL;\n}"
+                % (list_name, complete, no_sparse, rw_decl, rw, num_name, rw,
+                   list_name, rw, list_name))
+            (source_decl, source) = specs_access(_type, name, "source", False)
+            (dest_decl, dest) = specs_access(_type, name, "dest", True)
             print(
-                "static inline void symbol_entity_specs_copy_%s_from(scope_entry_t* dest, scope_entry_t* source)\n{\n    symbol_entity_specs_reserve_%s(dest, source->_entity_specs.%s);\n    memcpy(dest->_entity_specs.%s,\n        source->_entity_specs.%s,\n        dest->_entity_specs.%s\n        * (sizeof (*(dest->_entity_specs.%s))));\n} "
-                % (list_name, list_name, num_name, list_name, list_name,
-                   num_name, list_name))
+                "static inline void symbol_entity_specs_copy_%s_from(scope_entry_t* dest, scope_entry_t* source)\n{\n%s%s%s    symbol_entity_specs_reserve_%s(dest, %s%s);\n%s    memcpy(%s%s,\n        %s%s,\n        %s%s\n        * (sizeof (*(%s%s))));\n} "
+                % (list_name, complete.replace("(s)", "(source)"),
+                   no_sparse_copy, source_decl, list_name, source, num_name,
+                   dest_decl, dest, list_name, source, list_name, dest,
+                   num_name, dest, list_name))
             print("")
 
     print(
         "static inline void symbol_entity_specs_copy_from(scope_entry_t* dest, scope_entry_t* source)"
     )
     print("{")
+    print("    // Rare attributes are shared until the copies of their lists below")
+    print("    symbol_entity_specs_free_sparse(dest);")
     print("    dest->_entity_specs = source->_entity_specs;")
+    print("    symbol_entity_specs_share_sparse(dest);")
     # Now copy every list
     for l in lines:
         fields = l.split("|")
@@ -306,44 +440,58 @@ def print_getters_setters(lines):
         if name[0] == "*":
             name = name[1:]
         if _type.startswith("array"):
-            type_name = get_up_to_matching_paren(_type[len("array"):])
-            field_names = name.split(",")
-            if (len(field_names) == 1):
-                num_name = "num_" + name
-                list_name = name
-            elif (len(field_names) == 2):
-                num_name = field_names[0]
-                list_name = field_names[1]
-            else:
-                raise Exception(
-                    "Invalid number of fields in array name. Only 1 or 2 comma-separated are allowed"
-                )
+            (num_name, list_name) = split_array_name(name)
             print("    symbol_entity_specs_copy_%s_from(dest, source);" %
                   (list_name))
     print("}")
     print("")
     print("static inline void symbol_entity_specs_free(scope_entry_t* symbol)")
     print("{")
-    # Now copy every list
+    # Now free every list
+    sparse_lists = []
     for l in lines:
         fields = l.split("|")
         (_type, language, name, description) = fields
         if name[0] == "*":
             name = name[1:]
         if _type.startswith("array"):
-            type_name = get_up_to_matching_paren(_type[len("array"):])
-            field_names = name.split(",")
-            if (len(field_names) == 1):
-                num_name = "num_" + name
-                list_name = name
-            elif (len(field_names) == 2):
-                num_name = field_names[0]
-                list_name = field_names[1]
+            (num_name, list_name) = split_array_name(name)
+            if is_sparse_attribute(_type, name):
+                sparse_lists.append(list_name)
             else:
-                raise Exception(
-                    "Invalid number of fields in array name. Only 1 or 2 comma-separated are allowed"
-                )
-            print("    symbol_entity_specs_free_%s(symbol);" % (list_name))
+                print("    symbol_entity_specs_free_%s(symbol);" % (list_name))
+    print("    // The lists of rare attributes are freed with the last symbol using them")
+    print("    if (symbol->_entity_specs._sparse != NULL")
+    print("            && symbol->_entity_specs._sparse->_refcount == 1)")
+    print("    {")
+    for list_name in sparse_lists:
+        print("        symbol_entity_specs_free_%s(symbol);" % (list_name))
+    print("    }")
+    print("    symbol_entity_specs_free_sparse(symbol);")
+    print("}")
+    print("")
+    print("// A symbol that stops sharing its rare attributes needs its own lists")
+    print(
+        "static inline void entity_specifiers_sparse_copy_lists(entity_specifiers_sparse_t* sparse)"
+    )
+    print("{")
+    for l in lines:
+        fields = l.split("|")
+        (_type, language, name, description) = fields
+        if name[0] == "*":
+            name = name[1:]
+        if _type.startswith("array") and is_sparse_attribute(_type, name):
+            type_name = get_up_to_matching_paren(_type[len("array"):])
+            (type_name, _name, _suffix, _k) = print_type_and_name(type_name, "")[0]
+            (num_name, list_name) = split_array_name(name)
+            print("    if (sparse->%s != NULL)" % (list_name))
+            print("    {")
+            print("        %s* %s = NEW_VEC(%s, sparse->%s);" %
+                  (type_name, list_name, type_name, num_name))
+            print("        memcpy(%s, sparse->%s, sparse->%s * sizeof(*%s));" %
+                  (list_name, list_name, num_name, list_name))
+            print("        sparse->%s = %s;" % (list_name, list_name))
+            print("    }")
     print("}")
 
     print("#endif")
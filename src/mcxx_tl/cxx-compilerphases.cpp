@@ -44,6 +44,7 @@
 #include "cxx-utils.h"
 #include "cxx-diagnostic.h"
 #include "cxx-nodecl-checker.h"
+#include "cxx-phaseprofile.h"
 #include "cxx-compilerphases.hpp"
 #include "tl-compilerphase.hpp"
 #include "tl-setdto-phase.hpp"
@@ -176,7 +177,9 @@ namespace TL
                         fprintf(stderr, "COMPILERPHASES: Running phase '%s'\n", phase->get_phase_name().c_str());
                     }
 
+                    phase_profile_start(phase->get_phase_name().c_str());
                     phase->run(dto);
+                    phase_profile_end(phase->get_phase_name().c_str());
 
                     if (phase->get_phase_status() != CompilerPhase::PHASE_STATUS_OK)
                     {
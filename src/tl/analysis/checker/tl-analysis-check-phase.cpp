@@ -1057,7 +1057,7 @@ namespace {
 
         // 1.- Execute analyses
         // 1.1.- Compute all data-flow analysis
-        AnalysisBase analysis(_ompss_mode_enabled);
+        AnalysisBase analysis(_ompss_mode_enabled, AnalysisCache::get_cache(dto));
         analysis.parallel_control_flow_graph(ast);    // At least, we compute the PCFG
         if (_analysis_mask._which_analysis & WhichAnalysis::RANGE_ANALYSIS)
         {
@@ -27,6 +27,7 @@
 
 
 #include "cxx-cexpr.h"
+#include "cxx-nodecl.h"
 #include "cxx-process.h"
 
 #include "tl-analysis-base.hpp"
@@ -46,8 +47,140 @@
 namespace TL {
 namespace Analysis {
 
-    AnalysisBase::AnalysisBase(bool is_ompss_enabled)
-            : _pcfgs(), _tdgs(), _all_functions(), _is_ompss_enabled(is_ompss_enabled),
+    // ************************************************************************************ //
+    // ************** Class keeping the PCFGs of a translation unit among phases ********** //
+
+    AnalysisCache::AnalysisCache()
+            : _entries(), _function_pcfgs()
+    {}
+
+    AnalysisCache* AnalysisCache::get_cache(DTO& dto)
+    {
+        if (!dto.get_keys().contains("analysis_cache"))
+        {
+            std::shared_ptr<AnalysisCache> cache(new AnalysisCache());
+            dto.set_object("analysis_cache", cache);
+            return cache.get();
+        }
+        return std::static_pointer_cast<AnalysisCache>(dto["analysis_cache"]).get();
+    }
+
+    void AnalysisCache::remove_modified_functions()
+    {
+        ObjectList<ExtensibleGraph*> removed;
+        for (Pcfg_to_entry_map::iterator it = _entries.begin(); it != _entries.end(); ++it)
+        {
+            nodecl_t function = it->second._function.get_internal_nodecl();
+            if (!nodecl_has_structural_hash(function)
+                    || nodecl_get_structural_hash(function) != it->second._hash)
+                removed.append(it->first);
+        }
+
+        while (!removed.empty())
+        {
+            ExtensibleGraph* pcfg = removed.back();
+            removed.pop_back();
+            if (_entries.find(pcfg) == _entries.end())
+                continue;
+
+            if (VERBOSE)
+                std::cerr << "PCFG '" << pcfg->get_name() << "' removed from the analysis cache" << std::endl;
+            Symbol func_sym = pcfg->get_function_symbol();
+            remove_pcfg(pcfg);
+            if (!func_sym.is_valid())
+                continue;
+
+            for (Pcfg_to_entry_map::iterator it = _entries.begin(); it != _entries.end(); ++it)
+            {
+                if (it->first->get_function_calls().contains(func_sym))
+                    removed.append(it->first);
+            }
+        }
+    }
+
+    ExtensibleGraph* AnalysisCache::get_pcfg(const NBase& function, bool is_ompss_enabled) const
+    {
+        Function_to_pcfg_map::const_iterator it = _function_pcfgs.find(function);
+        if (it == _function_pcfgs.end())
+            return NULL;
+        const Entry& entry = _entries.find(it->second)->second;
+        if (entry._is_ompss_enabled != is_ompss_enabled)
+            return NULL;
+        return it->second;
+    }
+
+    NBase AnalysisCache::get_function(ExtensibleGraph* pcfg) const
+    {
+        Pcfg_to_entry_map::const_iterator it = _entries.find(pcfg);
+        ERROR_CONDITION(it == _entries.end(),
+                        "PCFG '%s' is not in the analysis cache\n", pcfg->get_name().c_str());
+        return it->second._function;
+    }
+
+    void AnalysisCache::set_pcfg(const NBase& function, ExtensibleGraph* pcfg, bool is_ompss_enabled)
+    {
+        Function_to_pcfg_map::iterator it = _function_pcfgs.find(function);
+        if (it != _function_pcfgs.end())
+            remove_pcfg(it->second);
+
+        Entry entry;
+        entry._function = function;
+        entry._hash = nodecl_get_structural_hash(function.get_internal_nodecl());
+        entry._is_ompss_enabled = is_ompss_enabled;
+        entry._usage = false;
+        entry._propagate_graph_nodes = false;
+        entry._analyses = WhichAnalysis::PCFG_ANALYSIS;
+
+        _entries[pcfg] = entry;
+        _function_pcfgs[function] = pcfg;
+    }
+
+    void AnalysisCache::remove_pcfg(ExtensibleGraph* pcfg)
+    {
+        Pcfg_to_entry_map::iterator it = _entries.find(pcfg);
+        if (it == _entries.end())
+            return;
+        _function_pcfgs.erase(it->second._function);
+        _entries.erase(it);
+    }
+
+    bool AnalysisCache::usage_is_computed(ExtensibleGraph* pcfg, bool propagate_graph_nodes) const
+    {
+        Pcfg_to_entry_map::const_iterator it = _entries.find(pcfg);
+        return it != _entries.end()
+            && it->second._usage
+            && it->second._propagate_graph_nodes == propagate_graph_nodes;
+    }
+
+    void AnalysisCache::set_usage_computed(ExtensibleGraph* pcfg, bool propagate_graph_nodes)
+    {
+        Pcfg_to_entry_map::iterator it = _entries.find(pcfg);
+        if (it == _entries.end())
+            return;
+        it->second._usage = true;
+        it->second._propagate_graph_nodes = propagate_graph_nodes;
+    }
+
+    bool AnalysisCache::is_computed(ExtensibleGraph* pcfg, WhichAnalysis::Analysis_tag analysis) const
+    {
+        Pcfg_to_entry_map::const_iterator it = _entries.find(pcfg);
+        return it != _entries.end()
+            && (it->second._analyses & analysis) != 0;
+    }
+
+    void AnalysisCache::set_computed(ExtensibleGraph* pcfg, WhichAnalysis::Analysis_tag analysis)
+    {
+        Pcfg_to_entry_map::iterator it = _entries.find(pcfg);
+        if (it == _entries.end())
+            return;
+        it->second._analyses |= analysis;
+    }
+
+    // ************ END class keeping the PCFGs of a translation unit among phases ******** //
+    // ************************************************************************************ //
+
+    AnalysisBase::AnalysisBase(bool is_ompss_enabled, AnalysisCache* cache)
+            : _pcfgs(), _tdgs(), _all_functions(), _cache(cache), _is_ompss_enabled(is_ompss_enabled),
               _pcfg(false), /*_constants_propagation(false),*/ _canonical(false),
               _use_def(false), _liveness(false), _loops(false),
               _reaching_definitions(false), _induction_variables(false),
@@ -94,23 +227,41 @@ namespace Analysis {
             const std::map<Symbol, NBase>& asserted_funcs,
             std::set<Symbol>& visited_funcs)
     {
-        // Generate the hashed name corresponding to the AST of the function
-        std::string pcfg_name = Utils::generate_hashed_name(ast);
+        // The PCFG depends on the asserts of the whole translation unit, so only cache it when there are none
+        bool cacheable = (_cache != NULL && ast.is<Nodecl::FunctionCode>() && asserted_funcs.empty());
 
-        // Create the PCFG
-        if (VERBOSE)
-            std::cerr << "Parallel Control Flow Graph (PCFG) '" << pcfg_name << "'" << std::endl;
-        PCFGVisitor v(pcfg_name, ast);
-        ExtensibleGraph* pcfg = v.parallel_control_flow_graph(ast, asserted_funcs);
+        ExtensibleGraph* pcfg = NULL;
+        if (cacheable)
+            pcfg = _cache->get_pcfg(ast, _is_ompss_enabled);
 
-        // Synchronize the tasks, if applies
-        if (VERBOSE)
-            std::cerr << "Task Synchronization of PCFG '" << pcfg_name << "'" << std::endl;
-        TaskAnalysis::TaskSynchronizations task_sync_analysis(pcfg, _is_ompss_enabled);
-        task_sync_analysis.compute_task_synchronizations();
+        if (pcfg != NULL)
+        {
+            if (VERBOSE)
+                std::cerr << "Parallel Control Flow Graph (PCFG) '" << pcfg->get_name() << "' taken from the analysis cache" << std::endl;
+        }
+        else
+        {
+            // Generate the hashed name corresponding to the AST of the function
+            std::string pcfg_name = Utils::generate_hashed_name(ast);
+
+            // Create the PCFG
+            if (VERBOSE)
+                std::cerr << "Parallel Control Flow Graph (PCFG) '" << pcfg_name << "'" << std::endl;
+            PCFGVisitor v(pcfg_name, ast);
+            pcfg = v.parallel_control_flow_graph(ast, asserted_funcs);
+
+            // Synchronize the tasks, if applies
+            if (VERBOSE)
+                std::cerr << "Task Synchronization of PCFG '" << pcfg_name << "'" << std::endl;
+            TaskAnalysis::TaskSynchronizations task_sync_analysis(pcfg, _is_ompss_enabled);
+            task_sync_analysis.compute_task_synchronizations();
+
+            if (cacheable)
+                _cache->set_pcfg(ast, pcfg, _is_ompss_enabled);
+        }
 
         // Store the pcfg
-        _pcfgs[pcfg_name] = pcfg;
+        _pcfgs[pcfg->get_name()] = pcfg;
 
         // Store the symbol of the function we just visited
         Symbol func_sym = pcfg->get_function_symbol();
@@ -161,6 +312,9 @@ namespace Analysis {
 
         _pcfg = true;
 
+        if (_cache != NULL)
+            _cache->remove_modified_functions();
+
         ObjectList<NBase> unique_asts;
         std::map<Symbol, NBase> asserted_funcs;
 
@@ -297,6 +451,26 @@ namespace Analysis {
         }
     }
 
+    void AnalysisBase::rebuild_cached_pcfgs(bool propagate_graph_nodes)
+    {
+        // Use-def and the analyses depending on it are attached to the nodes of the PCFG,
+        // so they cannot be recomputed with a different propagation on the same graph
+        Name_to_pcfg_map pcfgs(_pcfgs);
+        for (Name_to_pcfg_map::iterator it = pcfgs.begin(); it != pcfgs.end(); ++it)
+        {
+            ExtensibleGraph* pcfg = it->second;
+            if (!_cache->usage_is_computed(pcfg, !propagate_graph_nodes))
+                continue;
+
+            NBase function = _cache->get_function(pcfg);
+            _cache->remove_pcfg(pcfg);
+            _pcfgs.erase(it->first);
+
+            std::set<Symbol> visited_funcs;
+            create_pcfg(function, std::map<Symbol, NBase>(), visited_funcs);
+        }
+    }
+
     void AnalysisBase::use_def(
             const NBase& ast,
             bool propagate_graph_nodes,
@@ -315,6 +489,9 @@ namespace Analysis {
 
         _use_def = true;
 
+        if (_cache != NULL)
+            rebuild_cached_pcfgs(propagate_graph_nodes);
+
         std::set<Symbol> visited_funcs;
         ObjectList<ExtensibleGraph*> pcfgs = get_pcfgs();
         for (ObjectList<ExtensibleGraph*>::iterator it = pcfgs.begin(); it != pcfgs.end(); ++it)
@@ -325,6 +502,8 @@ namespace Analysis {
                 ps.compute_pointer_vars_size();
                 use_def_rec((*it)->get_function_symbol(), propagate_graph_nodes, visited_funcs, pcfgs);
             }
+            if (_cache != NULL)
+                _cache->set_usage_computed(*it, propagate_graph_nodes);
         }
 
         if (ANALYSIS_PERFORMANCE_MEASURE)
@@ -353,10 +532,15 @@ namespace Analysis {
         const ObjectList<ExtensibleGraph*>& pcfgs = get_pcfgs();
         for (ObjectList<ExtensibleGraph*>::const_iterator it = pcfgs.begin(); it != pcfgs.end(); ++it)
         {
+            if (_cache != NULL && _cache->is_computed(*it, WhichAnalysis::LIVENESS_ANALYSIS))
+                continue;
             if (VERBOSE)
                 std::cerr << "Liveness of PCFG '" << (*it)->get_name() << "'" << std::endl;
             Liveness l(*it, propagate_graph_nodes);
             l.compute_liveness();
+
+            if (_cache != NULL)
+                _cache->set_computed(*it, WhichAnalysis::LIVENESS_ANALYSIS);
         }
 
         if (ANALYSIS_PERFORMANCE_MEASURE)
@@ -384,10 +568,15 @@ namespace Analysis {
         const ObjectList<ExtensibleGraph*>& pcfgs = get_pcfgs();
         for (ObjectList<ExtensibleGraph*>::const_iterator it = pcfgs.begin(); it != pcfgs.end(); ++it)
         {
+            if (_cache != NULL && _cache->is_computed(*it, WhichAnalysis::REACHING_DEFS_ANALYSIS))
+                continue;
             if (VERBOSE)
                 std::cerr << "Reaching Definitions of PCFG '" << (*it)->get_name() << "'" << std::endl;
             ReachingDefinitions rd(*it);
             rd.compute_reaching_definitions();
+
+            if (_cache != NULL)
+                _cache->set_computed(*it, WhichAnalysis::REACHING_DEFS_ANALYSIS);
         }
 
         if (ANALYSIS_PERFORMANCE_MEASURE)
@@ -415,6 +604,8 @@ namespace Analysis {
         const ObjectList<ExtensibleGraph*>& pcfgs = get_pcfgs();
         for (ObjectList<ExtensibleGraph*>::const_iterator it = pcfgs.begin(); it != pcfgs.end(); ++it)
         {
+            if (_cache != NULL && _cache->is_computed(*it, WhichAnalysis::INDUCTION_VARS_ANALYSIS))
+                continue;
             if (VERBOSE)
                 std::cerr << "Induction Variables of PCFG '" << (*it)->get_name() << "'" << std::endl;
 
@@ -430,6 +621,9 @@ namespace Analysis {
             if (VERBOSE)
                 Utils::print_induction_vars(ivs);
 
+            if (_cache != NULL)
+                _cache->set_computed(*it, WhichAnalysis::INDUCTION_VARS_ANALYSIS);
+
             if (ANALYSIS_PERFORMANCE_MEASURE)
                 fprintf(stderr, "ANALYSIS: INDUCTION_VARIABLES computation time: %lf\n", (time_nsec() - init)*1E-9);
         }
@@ -455,12 +649,17 @@ namespace Analysis {
         const ObjectList<ExtensibleGraph*>& pcfgs = get_pcfgs();
         for (ObjectList<ExtensibleGraph*>::const_iterator it = pcfgs.begin(); it != pcfgs.end(); ++it)
         {
+            if (_cache != NULL && _cache->is_computed(*it, WhichAnalysis::RANGE_ANALYSIS))
+                continue;
             if (VERBOSE)
                 std::cerr << "Range Analysis of PCFG '" << (*it)->get_name() << "'" << std::endl;
 
             // Compute the induction variables of all loops of each PCFG
             RangeAnalysis ra(*it);
             ra.compute_range_analysis();
+
+            if (_cache != NULL)
+                _cache->set_computed(*it, WhichAnalysis::RANGE_ANALYSIS);
         }
 
         if (ANALYSIS_PERFORMANCE_MEASURE)
@@ -521,11 +720,16 @@ namespace Analysis {
         const ObjectList<ExtensibleGraph*>& pcfgs = get_pcfgs();
         for (ObjectList<ExtensibleGraph*>::const_iterator it = pcfgs.begin(); it != pcfgs.end(); ++it)
         {
+            if (_cache != NULL && _cache->is_computed(*it, WhichAnalysis::AUTO_SCOPING))
+                continue;
             if (VERBOSE)
                 std::cerr << "Auto-Scoping of PCFG '" << (*it)->get_name() << "'" << std::endl;
 
             AutoScoping as(*it);
             as.compute_auto_scoping();
+
+            if (_cache != NULL)
+                _cache->set_computed(*it, WhichAnalysis::AUTO_SCOPING);
         }
 
         if (ANALYSIS_PERFORMANCE_MEASURE)
@@ -29,6 +29,7 @@
 
 #include <map>
 
+#include "tl-dto.hpp"
 #include "tl-extensible-graph.hpp"
 #include "tl-induction-variables-data.hpp"
 #include "tl-task-dependency-graph.hpp"
@@ -83,6 +84,64 @@ namespace Analysis {
     typedef std::map<std::string, ExtensibleGraph*> Name_to_pcfg_map;
     typedef std::map<std::string, TaskDependencyGraph*> Name_to_tdg_map;
 
+    // ************************************************************************************ //
+    // ************** Class keeping the PCFGs of a translation unit among phases ********** //
+
+    /*!This class keeps the PCFGs built by the AnalysisBase objects of the phases run on a translation unit
+     * A PCFG is reused, together with the analyses already computed on it, until the code of its function is modified.
+     * Modifications are detected by the structural hash cached in the tree (see nodecl_get_structural_hash),
+     * which is dropped when any node of the function is replaced or has its children, symbol, type or constant changed.
+     */
+    class LIBTL_CLASS AnalysisCache : public TL::Object
+    {
+    private:
+        struct Entry
+        {
+            NBase _function;            //!<FunctionCode from which the PCFG has been built
+            unsigned int _hash;         //!<Structural hash of _function when the PCFG was built
+            bool _is_ompss_enabled;
+            bool _usage;                //!<True when use-definition chains have been calculated
+            bool _propagate_graph_nodes;//!<Propagation of the use-definition chains, if computed
+            int _analyses;              //!<WhichAnalysis tags of the analyses computed on the PCFG
+        };
+
+        typedef std::map<ExtensibleGraph*, Entry> Pcfg_to_entry_map;
+        typedef std::map<NBase, ExtensibleGraph*> Function_to_pcfg_map;
+
+        Pcfg_to_entry_map _entries;
+        Function_to_pcfg_map _function_pcfgs;
+
+    public:
+        // *** Constructor *** //
+        AnalysisCache();
+
+        //!Returns the cache of the translation unit stored in \dto, creating it the first time
+        static AnalysisCache* get_cache(DTO& dto);
+
+        //!Drops the PCFGs of the functions modified since they were built
+        //!The PCFGs of their callers are dropped too, because use-def propagates the usage of the callees
+        void remove_modified_functions();
+
+        //!Returns the PCFG of \function, or NULL if it is not cached
+        ExtensibleGraph* get_pcfg(const NBase& function, bool is_ompss_enabled) const;
+        NBase get_function(ExtensibleGraph* pcfg) const;
+        void set_pcfg(const NBase& function, ExtensibleGraph* pcfg, bool is_ompss_enabled);
+        void remove_pcfg(ExtensibleGraph* pcfg);
+
+        //!Returns true when use-def has been computed on \pcfg with the given propagation of graph nodes
+        bool usage_is_computed(ExtensibleGraph* pcfg, bool propagate_graph_nodes) const;
+        void set_usage_computed(ExtensibleGraph* pcfg, bool propagate_graph_nodes);
+
+        //!Returns true when \analysis has been computed on \pcfg
+        bool is_computed(ExtensibleGraph* pcfg, WhichAnalysis::Analysis_tag analysis) const;
+        void set_computed(ExtensibleGraph* pcfg, WhichAnalysis::Analysis_tag analysis);
+    };
+
+    // ************ END class keeping the PCFGs of a translation unit among phases ******** //
+    // ************************************************************************************ //
+
+
+
     // ************************************************************************************ //
     // ********* Class representing a Singleton object used for analysis purposes ********* //
     //! This class implements a Meyers Singleton that includes methods for any kind of analysis
@@ -94,6 +153,7 @@ namespace Analysis {
         Name_to_pcfg_map _pcfgs;
         Name_to_tdg_map _tdgs;
         ObjectList<NBase> _all_functions;
+        AnalysisCache* _cache;
 
         bool _is_ompss_enabled;
         
@@ -133,6 +193,9 @@ namespace Analysis {
                 const std::map<Symbol, NBase>& asserted_funcs,
                 std::set<Symbol>& visited_funcs);
 
+        //!Rebuilds the PCFGs taken from the cache whose use-def has been computed with a different propagation
+        void rebuild_cached_pcfgs(bool propagate_graph_nodes);
+
         // *************** Private methods **************** //
 
         //!Prevents copy construction.
@@ -144,7 +207,8 @@ namespace Analysis {
     public:
 
         // *** Constructor *** //
-        AnalysisBase(bool is_ompss_enabled);
+        //!When \cache is not NULL, the PCFGs and analyses are shared with the other users of the cache
+        AnalysisBase(bool is_ompss_enabled, AnalysisCache* cache = NULL);
 
         // *** Getters *** //
         ObjectList<ExtensibleGraph*> get_pcfgs() const;
@@ -25,6 +25,7 @@ Cambridge, MA 02139, USA.
 --------------------------------------------------------------------*/
 
 #include "tl-analysis-utils.hpp"
+#include "tl-dataflow.hpp"
 #include "tl-liveness.hpp"
 #include "tl-node.hpp"
 #include "tl-task-concurrency.hpp"
@@ -35,338 +36,366 @@ namespace Analysis {
     // **************************************************************************************************** //
     // ******************************* Class implementing liveness analysis ******************************* //
 
-    Liveness::Liveness(ExtensibleGraph* graph, bool propagate_graph_nodes)
-        : _graph(graph), _propagate_graph_nodes(propagate_graph_nodes)
-    {}
+namespace {
 
-    void Liveness::compute_liveness()
+    //! Node whose Live In variables are part of the Live Out of another node.
+    //! When #graph is not NULL, the variables local to #graph are not propagated
+    struct LiveInSource
     {
-        // Compute graph concurrent tasks since this information is needed to
-        // properly propagate liveness information over the graph
-        TaskAnalysis::TaskConcurrency tc(_graph);
-        tc.compute_tasks_concurrency();
-        
-        Node* graph = _graph->get_graph();
-        Node* exit = graph->get_graph_exit_node();
+        Node* node;
+        Node* graph;
 
-        // Compute initial info (liveness only regarding the current node => UE vars)
-        initialize_live_sets(graph);
-        Node* post_sync = _graph->get_post_sync();
-        if (post_sync != NULL)
-            initialize_live_sets(post_sync);
-        // Note: 'n', which is the most outer node of the graph, must be cleaned up separatedly
-        //       because clear_visits_backwards_in_level skips entering the first node it is called with
-        //       in case it is a graph node
-        ExtensibleGraph::clear_visits_backwards_in_level(exit, graph);
-        if (post_sync != NULL)
-            ExtensibleGraph::clear_visits_backwards_in_level(post_sync, graph);
-        graph->set_visited(false);
-
-        // Common Liveness analysis
-        bool changed = true;
-        while(changed)
-        {
-            changed = false;
-            solve_live_equations_rec(graph, changed);
-            if (post_sync != NULL)
-                solve_live_equations_rec(post_sync, changed);
-            ExtensibleGraph::clear_visits_backwards_in_level(exit, graph);
-            if (post_sync != NULL)
-                ExtensibleGraph::clear_visits_backwards_in_level(post_sync, graph);
-            graph->set_visited(false);
-        }
-    }
+        LiveInSource(Node* n, Node* g)
+            : node(n), graph(g)
+        {}
+    };
 
-    void Liveness::initialize_live_sets(Node* n)
+    //! Liveness equations of the nodes of a DataFlowSolver, computed on bit vectors of variables
+    class LivenessProblem : public DataFlowProblem
     {
-        if (n->is_visited())
-            return;
-
-        n->set_visited(true);
-
-        if (n->is_entry_node())
-            return;
-
-        if (n->is_graph_node())
+    private:
+        const DataFlowSolver& _solver;
+        bool _propagate_graph_nodes;
+
+        NodeclNumbering _vars;
+        BitVector _empty;
+
+        // Indexed by the position of the nodes in the solver
+        std::vector<BitVector> _ue;
+        std::vector<BitVector> _killed;
+        std::vector<BitVector> _live_in;
+        std::vector<BitVector> _live_out;
+        std::vector<ObjectList<LiveInSource> > _sources;
+        std::vector<BitVector> _removed_from_live_in;
+        std::vector<BitVector> _removed_from_live_out;
+
+        //! Variables removed when the Live In of a graph is propagated to the predecessors of the graph
+        std::map<Node*, BitVector> _removed_from_successors;
+
+        //! Exit flushes of tasks: variables always alive and variables private to the task
+        std::map<Node*, BitVector> _task_flush_live;
+        std::map<Node*, BitVector> _task_flush_private;
+
+        BitVector compute_context_local_vars(Node* graph)
         {
-            initialize_live_sets(n->get_graph_exit_node());
-            if (_propagate_graph_nodes)
-                set_graph_node_liveness(n);
-        }
-        else if (!n->is_exit_node())
-        {
-            n->set_live_in(n->get_ue_vars());
+            BitVector result;
+            Scope sc(graph->get_graph_related_ast().retrieve_context());
+            for (unsigned int id = 0; id < _vars.size(); ++id)
+            {
+                // A variable is represented by one of its occurrences, so use the scope where it is
+                // declared and not the scope of the occurrence, that may be nested in the context
+                const NBase& base = Utils::get_nodecl_base(_vars.get_nodecl(id));
+                Symbol sym = base.get_symbol();
+                Scope base_sc = sym.is_valid() ? sym.get_scope() : base.retrieve_context();
+                if (base_sc.scope_is_enclosed_by(sc))
+                    result.insert(id);
+            }
+            return result;
         }
 
-        const ObjectList<Node*>& parents = n->get_parents();
-        for (ObjectList<Node*>::const_iterator it = parents.begin(); it != parents.end(); ++it)
-            initialize_live_sets(*it);
-    }
-
-    void Liveness::solve_live_equations_rec(Node* n, bool& changed)
-    {
-        if (n->is_visited())
-            return;
-
-        n->set_visited(true);
-
-        if (n->is_entry_node())
-            return;
-
-        if (n->is_graph_node())
+        // Variables removed from the Live In of the inner entries of #c
+        // when they are propagated to the predecessors of #c
+        void compute_removed_from_successors(Node* c)
         {
-            Node* exit = n->get_graph_exit_node();
-            if (n->is_omp_task_node()
-                || n->is_omp_async_target_node())
-                solve_task_live_equations_rec(exit, changed, n);
+            if (_removed_from_successors.find(c) != _removed_from_successors.end())
+                return;
+
+            if (c->is_context_node())
+            {   // Variables declared within the current context
+                _removed_from_successors[c] = compute_context_local_vars(c);
+            }
+            // FIXME We should include here any OpenMP|OmpSs node that may have private variables
             else
-                solve_live_equations_rec(exit, changed);
-            if (_propagate_graph_nodes)
-                set_graph_node_liveness(n);
+            {   // Variables private to the task
+                _removed_from_successors[c] = _vars.find_set(c->get_private_vars());
+            }
         }
-        else if (!n->is_exit_node())
+
+        void compute_live_in_sources(Node* n, ObjectList<LiveInSource>& sources)
         {
-            // 1.- Gather old liveness sets
-            const NodeclSet& old_live_out = n->get_live_out_vars();
-            const NodeclSet& old_live_in = n->get_live_in_vars();
-
-            // 2.- Compute new liveness sets
-            // 2.1.- Compute Live Out: LO(x) = U LI(y), forall y ∈ Succ(x)
-            const NodeclSet& live_out = compute_successors_live_in(n);
-            // 2.2.-Compute Live In: LI(x) = UE(x) U ( LO(x) - KILL(x) )
-            const NodeclSet& live_in = Utils::nodecl_set_union(n->get_ue_vars(),
-                    Utils::nodecl_set_difference(live_out, n->get_killed_vars()));
-
-            // 3.- Compare the two sets to see whether something has changed and, if yes, set the new values
-            if (!Utils::nodecl_set_equivalence(old_live_in, live_in)
-                    || !Utils::nodecl_set_equivalence(old_live_out, live_out))
+            const ObjectList<Node*>& children = n->get_children();
+            for (ObjectList<Node*>::const_iterator it = children.begin(); it != children.end(); ++it)
             {
-                n->set_live_in(live_in);
-                n->set_live_out(live_out);
-                changed = true;
+                Node* c = *it;
+                bool child_is_exit = c->is_exit_node();
+                if (child_is_exit)
+                {
+                    // Iterate over outer children while we found an EXIT node
+                    Node* exit_outer_node = c->get_outer_node();
+                    ObjectList<Node*> outer_children;
+                    while (child_is_exit)
+                    {
+                        outer_children = exit_outer_node->get_children();
+                        child_is_exit = (outer_children.size() == 1) && outer_children[0]->is_exit_node();
+                        exit_outer_node = (child_is_exit ? outer_children[0]->get_outer_node() : NULL);
+                    }
+                    for (ObjectList<Node*>::iterator itoc = outer_children.begin(); itoc != outer_children.end(); ++itoc)
+                        sources.append(LiveInSource(*itoc, NULL));
+                }
+                else if (!_propagate_graph_nodes && c->is_graph_node())
+                {   // Gather the LiveIn variables of the graph: LI(graph) = U LI(inner entries)
+                    Node* graph = NULL;
+                    if (c->is_context_node()
+                            || c->is_omp_task_node()
+                            || c->is_omp_async_target_node()
+                            || c->is_omp_sync_target_node())
+                    {
+                        graph = c;
+                        compute_removed_from_successors(c);
+                    }
+                    const ObjectList<Node*>& grandchildren = c->get_graph_entry_node()->get_children();
+                    for (ObjectList<Node*>::const_iterator itt = grandchildren.begin();
+                         itt != grandchildren.end(); ++itt)
+                        sources.append(LiveInSource(*itt, graph));
+                }
+                else
+                {
+                    sources.append(LiveInSource(c, NULL));
+                }
             }
         }
 
-        const ObjectList<Node*>& parents = n->get_parents();
-        for (ObjectList<Node*>::const_iterator it = parents.begin(); it != parents.end(); ++it)
-            solve_live_equations_rec(*it, changed);
-    }
+        const BitVector& get_live_in(Node* n) const
+        {
+            int i = _solver.get_index(n);
+            return (i == -1) ? _empty : _live_in[i];
+        }
 
-    void Liveness::solve_task_live_equations_rec(Node* n, bool& changed, Node* task)
-    {
-        if (!n->is_exit_node())
-            return;
-
-        n->set_visited(true);
-
-        // 1.- Compute the task successors LI set
-        const ObjectList<Node*>& parents = n->get_parents();
-        ERROR_CONDITION(parents.size()!=1,
-                        "The number of parents of a task exit node must be 1 (a flush node), but %d found.\n",
-                        parents.size());
-        Node* exit_flush = parents[0];
-        NodeclSet succ_live_in = compute_successors_live_in(exit_flush);
-        // 1.2.- If the task has a post_sync successor, then all shared variables must be alive at the exit of the task
-        if (ExtensibleGraph::task_synchronizes_in_post_sync(task))
+        const BitVector& get_live_out(Node* n) const
         {
-            const NodeclSet& shared_accesses = task->get_all_shared_accesses();
-            succ_live_in.insert(shared_accesses.begin(), shared_accesses.end());
+            int i = _solver.get_index(n);
+            return (i == -1) ? _empty : _live_out[i];
         }
 
-        // 2.- Add to the list of successors, the flow successors of the Task Creation node of the current task
-        Node* task_creation = ExtensibleGraph::get_task_creation_from_task(task);
-        const ObjectList<Node*>& tc_children = task_creation->get_children();
-        for (ObjectList<Node*>::const_iterator it = tc_children.begin(); it != tc_children.end(); ++it)
+        //! U(Live In(Y)), for all Y successors of X
+        BitVector compute_successors_live_in(unsigned int i) const
         {
-            if (*it != task)
+            BitVector result;
+            const ObjectList<LiveInSource>& sources = _sources[i];
+            for (ObjectList<LiveInSource>::const_iterator it = sources.begin(); it != sources.end(); ++it)
             {
-                const NodeclSet& li = (*it)->get_live_in_vars();
-                succ_live_in.insert(li.begin(), li.end());
+                if (it->graph == NULL)
+                    result.merge(get_live_in(it->node));
+                else
+                    result.merge_difference(get_live_in(it->node),
+                                            _removed_from_successors.find(it->graph)->second);
             }
+            return result;
         }
 
-        // 3.- Remove from the set of successors LI those variables private to the task
-        const NodeclSet& private_vars = task->get_all_private_vars();
-        for (NodeclSet::const_iterator it = private_vars.begin(); it != private_vars.end(); ++it)
-            if (Utils::nodecl_set_contains_nodecl(*it, succ_live_in))
-                succ_live_in.erase(*it);
-
-        // 4.- Gather the old liveness sets
-        const NodeclSet& old_live_out = exit_flush->get_live_out_vars();
-        const NodeclSet& old_live_in = exit_flush->get_live_in_vars();
+        bool update(unsigned int i, const BitVector& live_in, const BitVector& live_out)
+        {
+            if (_live_in[i] == live_in && _live_out[i] == live_out)
+                return false;
+            _live_in[i] = live_in;
+            _live_out[i] = live_out;
+            return true;
+        }
 
-        // 5.- Compare the two sets to see whether something has changed and, if yes, set the new values
-        if (!Utils::nodecl_set_equivalence(old_live_in, succ_live_in)
-                || !Utils::nodecl_set_equivalence(old_live_out, succ_live_in))
+        bool transfer_task_flush(Node* flush, unsigned int i)
         {
-            exit_flush->set_live_out(succ_live_in);
-            exit_flush->set_live_in(succ_live_in);
-            changed = true;
+            // LO(flush) = LI(flush) = U LI(successors of the task and of its task creation node)
+            //                         U shared variables synchronized in the post_sync - Private(task)
+            BitVector succ_live_in = compute_successors_live_in(i);
+            succ_live_in.merge(_task_flush_live[flush]);
+            succ_live_in.subtract(_task_flush_private[flush]);
+            return update(i, succ_live_in, succ_live_in);
         }
 
-        // 6.- Keep iterating normally within the task
-        exit_flush->set_visited(true);
-        const ObjectList<Node*>& flush_parents = exit_flush->get_parents();
-        for (ObjectList<Node*>::const_iterator it = flush_parents.begin(); it != flush_parents.end(); ++it)
-            solve_live_equations_rec(*it, changed);
-    }
+        bool transfer_graph(Node* n, unsigned int i)
+        {
+            // LO(graph) = U L0(inner exits)
+            BitVector live_out;
+            const ObjectList<Node*>& parents = n->get_graph_exit_node()->get_parents();
+            for (ObjectList<Node*>::const_iterator it = parents.begin(); it != parents.end(); ++it)
+                live_out.merge_difference(get_live_out(*it), _removed_from_live_out[i]);
+
+            // LI(graph) = U LI(inner entries)
+            BitVector live_in;
+            const ObjectList<Node*>& children = n->get_graph_entry_node()->get_children();
+            for (ObjectList<Node*>::const_iterator it = children.begin(); it != children.end(); ++it)
+                live_in.merge_difference(get_live_in(*it), _removed_from_live_in[i]);
+
+            return update(i, live_in, live_out);
+        }
 
-    NodeclSet Liveness::compute_successors_live_in(Node* n)
-    {
-        NodeclSet succ_live_in;
-        const ObjectList<Node*>& children = n->get_children();
-        for (ObjectList<Node*>::const_iterator it = children.begin(); it != children.end(); ++it)
+    public:
+        LivenessProblem(const DataFlowSolver& solver, bool propagate_graph_nodes)
+            : _solver(solver), _propagate_graph_nodes(propagate_graph_nodes),
+              _vars(), _empty(),
+              _ue(solver.get_nodes().size()), _killed(solver.get_nodes().size()),
+              _live_in(solver.get_nodes().size()), _live_out(solver.get_nodes().size()),
+              _sources(solver.get_nodes().size()),
+              _removed_from_live_in(solver.get_nodes().size()),
+              _removed_from_live_out(solver.get_nodes().size()),
+              _removed_from_successors(), _task_flush_live(), _task_flush_private()
         {
-            Node* c = *it;
-            bool child_is_exit = c->is_exit_node();
-            if (child_is_exit)
+            const ObjectList<Node*>& nodes = solver.get_nodes();
+
+            // 1.- Number the variables that can be alive: upper exposed variables
+            //     and shared variables of tasks synchronized in the post_sync
+            for (unsigned int i = 0; i < nodes.size(); ++i)
             {
-                // Iterate over outer children while we found an EXIT node
-                Node* exit_outer_node = c->get_outer_node();
-                ObjectList<Node*> outer_children;
-                while (child_is_exit)
+                Node* n = nodes[i];
+                if (n->is_graph_node())
                 {
-                    outer_children = exit_outer_node->get_children();
-                    child_is_exit = (outer_children.size() == 1) && outer_children[0]->is_exit_node();
-                    exit_outer_node = (child_is_exit ? outer_children[0]->get_outer_node() : NULL);
+                    if ((n->is_omp_task_node() || n->is_omp_async_target_node())
+                            && ExtensibleGraph::task_synchronizes_in_post_sync(n))
+                        _vars.insert_set(n->get_all_shared_accesses());
                 }
-                // Get the Live in of the current successors
-                for (ObjectList<Node*>::iterator itoc = outer_children.begin(); itoc != outer_children.end(); ++itoc)
+                else if (!n->is_entry_node() && !n->is_exit_node())
                 {
-                    const NodeclSet& outer_live_in = (*itoc)->get_live_in_vars();
-                    succ_live_in.insert(outer_live_in.begin(), outer_live_in.end());
+                    _ue[i] = _vars.insert_set(n->get_ue_vars());
                 }
             }
-            else
+
+            // 2.- Compute the constant information of each node
+            for (unsigned int i = 0; i < nodes.size(); ++i)
             {
-                if (!_propagate_graph_nodes && c->is_graph_node())
-                {   // Gather the LiveIn variables of the graph
-                    // 1.- Compute all LiveIn variables: LI(graph) = U LI(inner entries)
-                    NodeclSet all_live_in;
-                    const ObjectList<Node*>& grandchildren = c->get_graph_entry_node()->get_children();
-                    for (ObjectList<Node*>::const_iterator itt = grandchildren.begin();
-                         itt != grandchildren.end(); ++itt)
+                Node* n = nodes[i];
+                if (n->is_graph_node())
+                {
+                    if (_propagate_graph_nodes)
                     {
-                        const NodeclSet& li = (*itt)->get_live_in_vars();
-                        all_live_in.insert(li.begin(), li.end());
-                    }
-                    // 2.- Delete those variables which are local to the graph
-                    if (c->is_context_node())
-                    {   // Variables declared within the current context
-                        Scope sc(c->get_graph_related_ast().retrieve_context());
-                        for (NodeclSet::iterator itt = all_live_in.begin(); itt != all_live_in.end(); ++itt)
-                        {
-                            const NBase& it_base = Utils::get_nodecl_base(*itt);
-                            if (!it_base.retrieve_context().scope_is_enclosed_by(sc))
-                                succ_live_in.insert(*itt);
+                        if (n->is_context_node())
+                        {   // Variables declared within the current context
+                            _removed_from_live_in[i] = compute_context_local_vars(n);
+                            _removed_from_live_out[i] = _removed_from_live_in[i];
                         }
-                    }
-                    // FIXME We should include here any OpenMP|OmpSs node that may have private variables
-                    else if (c->is_omp_task_node()
-                            || c->is_omp_async_target_node()
-                            || c->is_omp_sync_target_node())
-                    {   // Variables private to the task
-                        const NodeclSet& p_vars = c->get_private_vars();
-                        for (NodeclSet::iterator itt = all_live_in.begin(); itt != all_live_in.end(); ++itt)
-                        {
-                            if (p_vars.find(*itt) == p_vars.end())
-                                succ_live_in.insert(*itt);
+                        else if (n->is_omp_node())
+                        {   // Private and firstprivate (Live Out) or lastprivate (Live In) variables
+                            BitVector private_vars = _vars.find_set(n->get_private_vars());
+                            _removed_from_live_out[i] = private_vars;
+                            _removed_from_live_out[i].merge(_vars.find_set(n->get_firstprivate_vars()));
+                            _removed_from_live_in[i] = private_vars;
+                            _removed_from_live_in[i].merge(_vars.find_set(n->get_lastprivate_vars()));
                         }
                     }
-                    else
+
+                    if (n->is_omp_task_node() || n->is_omp_async_target_node())
                     {
-                        succ_live_in.insert(all_live_in.begin(), all_live_in.end());
+                        const ObjectList<Node*>& parents = n->get_graph_exit_node()->get_parents();
+                        ERROR_CONDITION(parents.size()!=1,
+                                        "The number of parents of a task exit node must be 1 (a flush node), but %d found.\n",
+                                        parents.size());
+                        Node* exit_flush = parents[0];
+                        int f = solver.get_index(exit_flush);
+                        if (f == -1)
+                            continue;
+
+                        // If the task has a post_sync successor, then all shared variables must be alive at the exit of the task
+                        BitVector& flush_live = _task_flush_live[exit_flush];
+                        if (ExtensibleGraph::task_synchronizes_in_post_sync(n))
+                            flush_live = _vars.find_set(n->get_all_shared_accesses());
+                        _task_flush_private[exit_flush] = _vars.find_set(n->get_all_private_vars());
+
+                        // The flow successors of the Task Creation node of the current task are also successors
+                        compute_live_in_sources(exit_flush, _sources[f]);
+                        Node* task_creation = ExtensibleGraph::get_task_creation_from_task(n);
+                        const ObjectList<Node*>& tc_children = task_creation->get_children();
+                        for (ObjectList<Node*>::const_iterator it = tc_children.begin(); it != tc_children.end(); ++it)
+                            if (*it != n)
+                                _sources[f].append(LiveInSource(*it, NULL));
                     }
                 }
-                else
+                else if (!n->is_entry_node() && !n->is_exit_node())
                 {
-                    const NodeclSet& li = c->get_live_in_vars();
-                    succ_live_in.insert(li.begin(), li.end());
+                    _killed[i] = _vars.find_set(n->get_killed_vars());
+                    // Live In (X) = Upper exposed (X)
+                    _live_in[i] = _ue[i];
                 }
             }
+            for (unsigned int i = 0; i < nodes.size(); ++i)
+            {
+                Node* n = nodes[i];
+                if (!n->is_graph_node() && !n->is_entry_node() && !n->is_exit_node()
+                        && _task_flush_live.find(n) == _task_flush_live.end())
+                    compute_live_in_sources(n, _sources[i]);
+            }
         }
-        return succ_live_in;
-    }
 
-    void Liveness::set_graph_node_liveness(Node* n)
-    {
-        if (!n->is_graph_node())
-            return;
-
-        // 1.- LO(graph) = U L0(inner exits)
-        NodeclSet all_live_out;
-        const ObjectList<Node*>& parents = n->get_graph_exit_node()->get_parents();
-        for (ObjectList<Node*>::const_iterator it = parents.begin(); it != parents.end(); ++it)
+        void get_dependences(Node* n, ObjectList<Node*>& deps)
         {
-            const NodeclSet& lo = (*it)->get_live_out_vars();
-            all_live_out.insert(lo.begin(), lo.end());
-        }
-
-        // 1.1.- Delete those variables which are local to the graph
-        NodeclSet live_out;
-        if (n->is_context_node())
-        {   // Variables declared within the current context
-            Scope sc(n->get_graph_related_ast().retrieve_context());
-            for(NodeclSet::iterator it = all_live_out.begin(); it != all_live_out.end(); ++it)
+            unsigned int i = _solver.get_index(n);
+            if (n->is_graph_node())
             {
-                const NBase& it_base = Utils::get_nodecl_base(*it);
-                if (!it_base.retrieve_context().scope_is_enclosed_by(sc))
-                    live_out.insert(*it);
+                if (_propagate_graph_nodes)
+                {
+                    deps.append(n->get_graph_exit_node()->get_parents());
+                    deps.append(n->get_graph_entry_node()->get_children());
+                }
             }
-        }
-        else if (n->is_omp_node())
-        {   // Private and firstprivate variables
-            NodeclSet to_remove_vars = n->get_private_vars();
-            NodeclSet fp_vars = n->get_firstprivate_vars();
-            to_remove_vars.insert(fp_vars.begin(), fp_vars.end());
-            for (NodeclSet::iterator it = all_live_out.begin(); it != all_live_out.end(); ++it)
+            else
             {
-                if (to_remove_vars.find(*it) == to_remove_vars.end())
-                    live_out.insert(*it);
+                const ObjectList<LiveInSource>& sources = _sources[i];
+                for (ObjectList<LiveInSource>::const_iterator it = sources.begin(); it != sources.end(); ++it)
+                    deps.append(it->node);
             }
         }
-        else
+
+        bool transfer(Node* n)
         {
-            live_out = all_live_out;
+            unsigned int i = _solver.get_index(n);
+            if (_task_flush_live.find(n) != _task_flush_live.end())
+                return transfer_task_flush(n, i);
+
+            if (n->is_entry_node() || n->is_exit_node())
+                return false;
+
+            if (n->is_graph_node())
+                return _propagate_graph_nodes && transfer_graph(n, i);
+
+            // LO(x) = U LI(y), forall y ∈ Succ(x)
+            // LI(x) = UE(x) U ( LO(x) - KILL(x) )
+            const BitVector& live_out = compute_successors_live_in(i);
+            BitVector live_in = _ue[i];
+            live_in.merge_difference(live_out, _killed[i]);
+            return update(i, live_in, live_out);
         }
-        n->set_live_out(live_out);
 
-        // 2.- LI(graph) = U LI(inner entries)
-        NodeclSet all_live_in;
-        const ObjectList<Node*>& children = n->get_graph_entry_node()->get_children();
-        for (ObjectList<Node*>::const_iterator it = children.begin(); it != children.end(); ++it)
+        //! Stores the liveness sets computed in the nodes of the graph
+        void store_liveness()
         {
-            const NodeclSet& li = (*it)->get_live_in_vars();
-            all_live_in.insert(li.begin(), li.end());
-        }
-        // 2.1.- Delete those variables which are local to the graph
-        NodeclSet live_in;
-        if (n->is_context_node())
-        {   // Variables declared within the current context
-            Scope sc(n->get_graph_related_ast().retrieve_context());
-            for(NodeclSet::iterator it = all_live_in.begin(); it != all_live_in.end(); ++it)
+            const ObjectList<Node*>& nodes = _solver.get_nodes();
+            for (unsigned int i = 0; i < nodes.size(); ++i)
             {
-                const NBase& it_base = Utils::get_nodecl_base(*it);
-                if (!it_base.retrieve_context().scope_is_enclosed_by(sc))
-                    live_in.insert(*it);
-            }
-        }
-        else if (n->is_omp_node())
-        {   // Private and lastprivate variables
-            NodeclSet to_remove_vars = n->get_private_vars();
-            NodeclSet lp_vars = n->get_lastprivate_vars();
-            to_remove_vars.insert(lp_vars.begin(), lp_vars.end());
-            for (NodeclSet::iterator it = all_live_in.begin(); it != all_live_in.end(); ++it)
-            {
-                if (to_remove_vars.find(*it) == to_remove_vars.end())
-                    live_in.insert(*it);
+                Node* n = nodes[i];
+                if (_task_flush_live.find(n) == _task_flush_live.end())
+                {
+                    if (n->is_entry_node() || n->is_exit_node()
+                            || (n->is_graph_node() && !_propagate_graph_nodes))
+                        continue;
+                }
+                n->set_live_in(_vars.get_set(_live_in[i]));
+                n->set_live_out(_vars.get_set(_live_out[i]));
             }
         }
-        else
-        {
-            live_in = all_live_in;
-        }
-        n->set_live_in(live_in);
+    };
+
+}
+
+    Liveness::Liveness(ExtensibleGraph* graph, bool propagate_graph_nodes)
+        : _graph(graph), _propagate_graph_nodes(propagate_graph_nodes)
+    {}
+
+    void Liveness::compute_liveness()
+    {
+        // Compute graph concurrent tasks since this information is needed to
+        // properly propagate liveness information over the graph
+        TaskAnalysis::TaskConcurrency tc(_graph);
+        tc.compute_tasks_concurrency();
+
+        // Liveness is solved bottom-up from the graph and from the post_sync node
+        ObjectList<Node*> roots;
+        roots.append(_graph->get_graph());
+        Node* post_sync = _graph->get_post_sync();
+        if (post_sync != NULL)
+            roots.append(post_sync);
+
+        DataFlowSolver solver(roots, DATAFLOW_BACKWARD);
+        LivenessProblem problem(solver, _propagate_graph_nodes);
+        solver.solve(problem);
+        problem.store_liveness();
     }
 
     // ***************************** END class implementing liveness analysis ***************************** //
@@ -44,6 +44,7 @@ namespace Analysis {
      *      - General case:                 LO(x) = U LI(y),
      *                                      where y = all successors of x
      *      - x is a task:                  L0(x) = UE(x) U ( LO(x) - (KILL(x) - Private|Firstprivate(x)) ), 
+     *  The equations are solved with a DataFlowSolver over bit vectors of the variables of the graph.
      */
     class LIBTL_CLASS Liveness
     {
@@ -51,24 +52,6 @@ namespace Analysis {
         ExtensibleGraph* _graph;
         bool _propagate_graph_nodes;
 
-        //! Computes the liveness information of each node regarding only its inner statements
-        //! Live In (X) = Upper exposed (X)
-        void initialize_live_sets(Node* current);
-
-        //! Computes liveness equations for a given node and calls recursively to its children
-        void solve_live_equations_rec(Node* current, bool& changed);
-        void solve_task_live_equations_rec(Node* n, bool& changed, Node* task);
-
-        //! Initiates computation of a task liveness sets
-        //! Excludes from the exit node LiveOut those variables private to the task
-        void solve_specific_live_in_tasks(Node* current);
-
-        //! U(Live In(Y)), for all Y successors of X
-        NodeclSet compute_successors_live_in(Node* n);
-
-        //! Propagates liveness information from inner to outer nodes
-        void set_graph_node_liveness(Node* current);
-
     public:
         //! Constructor
         Liveness(ExtensibleGraph* graph, bool propagate_graph_nodes);
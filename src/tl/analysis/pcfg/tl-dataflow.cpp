@@ -0,0 +1,415 @@
+/*--------------------------------------------------------------------
+ ( C) Copyright 2006-2014 Barcelona* Supercomputing Center
+ Centro Nacional de Supercomputacion
+
+ This file is part of Mercurium C/C++ source-to-source compiler.
+
+ See AUTHORS file in the top level directory for information
+ regarding developers and contributors.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 3 of the License, or (at your option) any later version.
+
+ Mercurium C/C++ source-to-source compiler is distributed in the hope
+ that it will be useful, but WITHOUT ANY WARRANTY; without even the
+ implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the GNU Lesser General Public License for more
+ details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with Mercurium C/C++ source-to-source compiler; if
+ not, write to the Free Software Foundation, Inc., 675 Mass Ave,
+ Cambridge, MA 02139, USA.
+ --------------------------------------------------------------------*/
+
+#include "tl-dataflow.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <queue>
+#include <set>
+
+namespace TL {
+namespace Analysis {
+
+    // **************************************************************************************************** //
+    // ******************************** Bit vectors used by data-flow analyses **************************** //
+
+    static const unsigned int word_bits = sizeof(unsigned long) * CHAR_BIT;
+
+    BitVector::BitVector()
+        : _words()
+    {}
+
+    void BitVector::insert(unsigned int id)
+    {
+        unsigned int w = id / word_bits;
+        if (w >= _words.size())
+            _words.resize(w + 1, 0);
+        _words[w] |= (1UL << (id % word_bits));
+    }
+
+    bool BitVector::contains(unsigned int id) const
+    {
+        unsigned int w = id / word_bits;
+        return (w < _words.size())
+            && ((_words[w] & (1UL << (id % word_bits))) != 0);
+    }
+
+    bool BitVector::empty() const
+    {
+        for (std::vector<unsigned long>::const_iterator it = _words.begin(); it != _words.end(); ++it)
+            if (*it != 0)
+                return false;
+        return true;
+    }
+
+    bool BitVector::merge(const BitVector& s)
+    {
+        if (s._words.size() > _words.size())
+            _words.resize(s._words.size(), 0);
+
+        bool changed = false;
+        for (unsigned int i = 0; i < s._words.size(); ++i)
+        {
+            unsigned long w = _words[i] | s._words[i];
+            if (w != _words[i])
+            {
+                _words[i] = w;
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    bool BitVector::merge_difference(const BitVector& s, const BitVector& removed)
+    {
+        if (s._words.size() > _words.size())
+            _words.resize(s._words.size(), 0);
+
+        bool changed = false;
+        for (unsigned int i = 0; i < s._words.size(); ++i)
+        {
+            unsigned long w = s._words[i];
+            if (i < removed._words.size())
+                w &= ~removed._words[i];
+            w |= _words[i];
+            if (w != _words[i])
+            {
+                _words[i] = w;
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    void BitVector::subtract(const BitVector& s)
+    {
+        unsigned int size = std::min(_words.size(), s._words.size());
+        for (unsigned int i = 0; i < size; ++i)
+            _words[i] &= ~s._words[i];
+    }
+
+    ObjectList<unsigned int> BitVector::get_elements() const
+    {
+        ObjectList<unsigned int> result;
+        for (unsigned int i = 0; i < _words.size(); ++i)
+        {
+            unsigned long w = _words[i];
+            for (unsigned int b = 0; w != 0; ++b, w >>= 1)
+                if (w & 1UL)
+                    result.append(i * word_bits + b);
+        }
+        return result;
+    }
+
+    bool BitVector::operator==(const BitVector& s) const
+    {
+        const std::vector<unsigned long>& shorter = (_words.size() < s._words.size()) ? _words : s._words;
+        const std::vector<unsigned long>& longer = (_words.size() < s._words.size()) ? s._words : _words;
+        for (unsigned int i = 0; i < shorter.size(); ++i)
+            if (shorter[i] != longer[i])
+                return false;
+        for (unsigned int i = shorter.size(); i < longer.size(); ++i)
+            if (longer[i] != 0)
+                return false;
+        return true;
+    }
+
+    bool BitVector::operator!=(const BitVector& s) const
+    {
+        return !(*this == s);
+    }
+
+    bool NodeclNumbering::IdEqual::operator()(const NBase& n1, const NBase& n2) const
+    {
+        return Nodecl::Utils::structurally_equal_nodecls(n1, n2, /*skip_conversion_nodecls*/ true);
+    }
+
+    NodeclNumbering::NodeclNumbering()
+        : _ids(), _nodecls()
+    {}
+
+    unsigned int NodeclNumbering::insert(const NBase& n)
+    {
+        std::pair<IdMap::iterator, bool> res = _ids.insert(IdMap::value_type(n, _nodecls.size()));
+        if (res.second)
+            _nodecls.append(n);
+        return res.first->second;
+    }
+
+    int NodeclNumbering::find(const NBase& n) const
+    {
+        IdMap::const_iterator it = _ids.find(n);
+        if (it == _ids.end())
+            return -1;
+        return it->second;
+    }
+
+    const NBase& NodeclNumbering::get_nodecl(unsigned int id) const
+    {
+        return _nodecls[id];
+    }
+
+    unsigned int NodeclNumbering::size() const
+    {
+        return _nodecls.size();
+    }
+
+    BitVector NodeclNumbering::insert_set(const NodeclSet& s)
+    {
+        BitVector result;
+        for (NodeclSet::const_iterator it = s.begin(); it != s.end(); ++it)
+            result.insert(insert(*it));
+        return result;
+    }
+
+    BitVector NodeclNumbering::find_set(const NodeclSet& s) const
+    {
+        BitVector result;
+        for (NodeclSet::const_iterator it = s.begin(); it != s.end(); ++it)
+        {
+            int id = find(*it);
+            if (id != -1)
+                result.insert(id);
+        }
+        return result;
+    }
+
+    NodeclSet NodeclNumbering::get_set(const BitVector& s) const
+    {
+        NodeclSet result;
+        const ObjectList<unsigned int>& ids = s.get_elements();
+        for (ObjectList<unsigned int>::const_iterator it = ids.begin(); it != ids.end(); ++it)
+            result.insert(_nodecls[*it]);
+        return result;
+    }
+
+    // ****************************** END bit vectors used by data-flow analyses ************************** //
+    // **************************************************************************************************** //
+
+
+
+    // **************************************************************************************************** //
+    // ************************************* Worklist data-flow solver ************************************ //
+
+    DataFlowSolver::DataFlowSolver(const ObjectList<Node*>& roots, DataFlowDirection direction)
+        : _nodes(), _index(), _num_evaluations(0)
+    {
+        compute_order(roots, direction);
+    }
+
+    static ObjectList<Node*> get_flow_successors(Node* n, DataFlowDirection direction)
+    {
+        ObjectList<Node*> result;
+        if (direction == DATAFLOW_FORWARD)
+        {
+            if (n->is_graph_node())
+                result.append(n->get_graph_entry_node());
+            if (n->is_exit_node())
+            {
+                Node* outer = n->get_outer_node();
+                if (outer != NULL)
+                    result.append(outer->get_children());
+            }
+            else
+                result.append(n->get_children());
+        }
+        else
+        {
+            if (n->is_graph_node())
+                result.append(n->get_graph_exit_node());
+            if (n->is_entry_node())
+            {
+                Node* outer = n->get_outer_node();
+                if (outer != NULL)
+                    result.append(outer->get_parents());
+            }
+            else
+                result.append(n->get_parents());
+        }
+        return result;
+    }
+
+    void DataFlowSolver::compute_order(const ObjectList<Node*>& roots, DataFlowDirection direction)
+    {
+        // 1.- Compute the postorder of a depth-first traversal from the roots
+        ObjectList<Node*> postorder;
+        std::set<Node*> visited;
+        std::vector<std::pair<Node*, ObjectList<Node*> > > stack;
+        for (ObjectList<Node*>::const_iterator it = roots.begin(); it != roots.end(); ++it)
+        {
+            if (!visited.insert(*it).second)
+                continue;
+            stack.push_back(std::make_pair(*it, get_flow_successors(*it, direction)));
+            while (!stack.empty())
+            {
+                ObjectList<Node*>& pending = stack.back().second;
+                if (pending.empty())
+                {
+                    postorder.append(stack.back().first);
+                    stack.pop_back();
+                    continue;
+                }
+                Node* next = pending.back();
+                pending.pop_back();
+                if (visited.insert(next).second)
+                    stack.push_back(std::make_pair(next, get_flow_successors(next, direction)));
+            }
+        }
+
+        // 2.- Reverse the postorder, moving each graph node right after the node
+        //     where the flow leaves its inner graph (exit when forward, entry when backward)
+        for (ObjectList<Node*>::reverse_iterator it = postorder.rbegin(); it != postorder.rend(); ++it)
+        {
+            Node* n = *it;
+            if (n->is_graph_node())
+            {
+                Node* anchor = (direction == DATAFLOW_FORWARD) ? n->get_graph_exit_node()
+                                                               : n->get_graph_entry_node();
+                if (visited.find(anchor) != visited.end())
+                    continue;
+            }
+
+            _index[n] = _nodes.size();
+            _nodes.append(n);
+
+            if ((direction == DATAFLOW_FORWARD && n->is_exit_node())
+                    || (direction == DATAFLOW_BACKWARD && n->is_entry_node()))
+            {
+                Node* outer = n->get_outer_node();
+                if (outer != NULL && visited.find(outer) != visited.end())
+                {
+                    _index[outer] = _nodes.size();
+                    _nodes.append(outer);
+                }
+            }
+        }
+
+        // 3.- Move the graph nodes whose inner flow never reaches that node (e.g. a context ending
+        //     with a break) right after their last inner node. Inner graphs are moved first
+        for (int i = _nodes.size() - 1; i >= 0; --i)
+        {
+            Node* n = _nodes[i];
+            if (!n->is_graph_node())
+                continue;
+            Node* anchor = (direction == DATAFLOW_FORWARD) ? n->get_graph_exit_node()
+                                                           : n->get_graph_entry_node();
+            if (visited.find(anchor) != visited.end())
+                continue;
+
+            int last_inner = i;
+            for (unsigned int j = i + 1; j < _nodes.size(); ++j)
+            {
+                for (Node* outer = _nodes[j]->get_outer_node(); outer != NULL; outer = outer->get_outer_node())
+                {
+                    if (outer == n)
+                    {
+                        last_inner = j;
+                        break;
+                    }
+                }
+            }
+            for (int j = i; j < last_inner; ++j)
+            {
+                _nodes[j] = _nodes[j + 1];
+                _index[_nodes[j]] = j;
+            }
+            _nodes[last_inner] = n;
+            _index[n] = last_inner;
+        }
+    }
+
+    const ObjectList<Node*>& DataFlowSolver::get_nodes() const
+    {
+        return _nodes;
+    }
+
+    int DataFlowSolver::get_index(Node* n) const
+    {
+        std::map<Node*, unsigned int>::const_iterator it = _index.find(n);
+        if (it == _index.end())
+            return -1;
+        return it->second;
+    }
+
+    unsigned int DataFlowSolver::get_num_evaluations() const
+    {
+        return _num_evaluations;
+    }
+
+    void DataFlowSolver::solve(DataFlowProblem& problem)
+    {
+        unsigned int num_nodes = _nodes.size();
+
+        // 1.- Invert the dependences: a node has to be evaluated again when any node it reads changes
+        std::vector<ObjectList<unsigned int> > readers(num_nodes);
+        for (unsigned int i = 0; i < num_nodes; ++i)
+        {
+            ObjectList<Node*> deps;
+            problem.get_dependences(_nodes[i], deps);
+            for (ObjectList<Node*>::iterator it = deps.begin(); it != deps.end(); ++it)
+            {
+                int d = get_index(*it);
+                if (d != -1)
+                    readers[d].append(i);
+            }
+        }
+
+        // 2.- Evaluate the nodes in order until no value changes
+        std::priority_queue<unsigned int, std::vector<unsigned int>, std::greater<unsigned int> > worklist;
+        std::vector<bool> queued(num_nodes, true);
+        for (unsigned int i = 0; i < num_nodes; ++i)
+            worklist.push(i);
+
+        _num_evaluations = 0;
+        while (!worklist.empty())
+        {
+            unsigned int i = worklist.top();
+            worklist.pop();
+            queued[i] = false;
+
+            ++_num_evaluations;
+            if (!problem.transfer(_nodes[i]))
+                continue;
+
+            const ObjectList<unsigned int>& r = readers[i];
+            for (ObjectList<unsigned int>::const_iterator it = r.begin(); it != r.end(); ++it)
+            {
+                if (!queued[*it])
+                {
+                    queued[*it] = true;
+                    worklist.push(*it);
+                }
+            }
+        }
+    }
+
+    // *********************************** END worklist data-flow solver ********************************** //
+    // **************************************************************************************************** //
+
+}
+}
@@ -0,0 +1,165 @@
+/*--------------------------------------------------------------------
+ ( C) Copyright 2006-2014 Barcelona* Supercomputing Center
+ Centro Nacional de Supercomputacion
+
+ This file is part of Mercurium C/C++ source-to-source compiler.
+
+ See AUTHORS file in the top level directory for information
+ regarding developers and contributors.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 3 of the License, or (at your option) any later version.
+
+ Mercurium C/C++ source-to-source compiler is distributed in the hope
+ that it will be useful, but WITHOUT ANY WARRANTY; without even the
+ implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ PURPOSE.  See the GNU Lesser General Public License for more
+ details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with Mercurium C/C++ source-to-source compiler; if
+ not, write to the Free Software Foundation, Inc., 675 Mass Ave,
+ Cambridge, MA 02139, USA.
+ --------------------------------------------------------------------*/
+
+#ifndef TL_DATAFLOW_HPP
+#define TL_DATAFLOW_HPP
+
+#include "tl-node.hpp"
+
+#include <map>
+#include <vector>
+#include <tr1/unordered_map>
+
+namespace TL {
+namespace Analysis {
+
+    // **************************************************************************************************** //
+    // ******************************** Bit vectors used by data-flow analyses **************************** //
+
+    //! Set of dense identifiers represented as a bit vector
+    //! Vectors of different sizes can be combined: missing words are considered to be 0
+    class LIBTL_CLASS BitVector
+    {
+    private:
+        std::vector<unsigned long> _words;
+
+    public:
+        BitVector();
+
+        void insert(unsigned int id);
+        bool contains(unsigned int id) const;
+        bool empty() const;
+
+        //! this = this U s. Returns true if this has changed
+        bool merge(const BitVector& s);
+        //! this = this U (s - removed). Returns true if this has changed
+        bool merge_difference(const BitVector& s, const BitVector& removed);
+        //! this = this - s
+        void subtract(const BitVector& s);
+
+        //! Returns the identifiers in the set in increasing order
+        ObjectList<unsigned int> get_elements() const;
+
+        bool operator==(const BitVector& s) const;
+        bool operator!=(const BitVector& s) const;
+    };
+
+    //! Numbers structurally different nodecls with dense identifiers
+    class LIBTL_CLASS NodeclNumbering
+    {
+    private:
+        //! Same equivalence as Nodecl_structural_less: structurally equal trees skipping conversions
+        struct IdEqual
+        {
+            bool operator()(const NBase& n1, const NBase& n2) const;
+        };
+
+        //! Keyed by the structural hash cached in the trees, so only trees with the same hash are compared
+        typedef std::tr1::unordered_map<NBase, unsigned int, Nodecl::Utils::Nodecl_hash, IdEqual> IdMap;
+        IdMap _ids;
+        NodeclList _nodecls;
+
+    public:
+        NodeclNumbering();
+
+        //! Returns the identifier of #n, numbering it if it has not been numbered yet
+        unsigned int insert(const NBase& n);
+        //! Returns the identifier of #n, or -1 if it has not been numbered
+        int find(const NBase& n) const;
+
+        const NBase& get_nodecl(unsigned int id) const;
+        unsigned int size() const;
+
+        //! Numbers all elements of #s and returns them as a bit vector
+        BitVector insert_set(const NodeclSet& s);
+        //! Returns the elements of #s already numbered as a bit vector
+        BitVector find_set(const NodeclSet& s) const;
+        NodeclSet get_set(const BitVector& s) const;
+    };
+
+    // ****************************** END bit vectors used by data-flow analyses ************************** //
+    // **************************************************************************************************** //
+
+
+
+    // **************************************************************************************************** //
+    // ************************************* Worklist data-flow solver ************************************ //
+
+    //! Interface of a data-flow problem solved by DataFlowSolver
+    class LIBTL_CLASS DataFlowProblem
+    {
+    public:
+        virtual ~DataFlowProblem() {}
+
+        //! Adds to #deps the nodes whose values are read by the transfer function of #n
+        virtual void get_dependences(Node* n, ObjectList<Node*>& deps) = 0;
+
+        //! Recomputes the values of #n. Returns true if they have changed
+        virtual bool transfer(Node* n) = 0;
+    };
+
+    enum DataFlowDirection {
+        DATAFLOW_FORWARD,
+        DATAFLOW_BACKWARD
+    };
+
+    /*! Solves data-flow problems with a worklist ordered by reverse postorder
+     *  The nodes are ordered once, when the solver is built, traversing the PCFG from #roots in the
+     *  direction of the problem and entering graph nodes. A graph node is ordered right after the
+     *  exit (forward) or the entry (backward) of its inner graph, or after its last inner node when
+     *  the flow does not reach that node, so its value is computed from the values of its inner nodes.
+     *  A node is evaluated again only when one of the nodes it depends on changes.
+     */
+    class LIBTL_CLASS DataFlowSolver
+    {
+    private:
+        ObjectList<Node*> _nodes;
+        std::map<Node*, unsigned int> _index;
+        unsigned int _num_evaluations;
+
+        void compute_order(const ObjectList<Node*>& roots, DataFlowDirection direction);
+
+    public:
+        DataFlowSolver(const ObjectList<Node*>& roots, DataFlowDirection direction);
+
+        //! Nodes reached from the roots, in evaluation order
+        const ObjectList<Node*>& get_nodes() const;
+        //! Position of #n in the evaluation order, or -1 if #n has not been reached
+        int get_index(Node* n) const;
+        //! Number of evaluations of transfer functions in the last call to #solve
+        unsigned int get_num_evaluations() const;
+
+        //! Evaluates the transfer functions of #problem until a fixed point is reached
+        void solve(DataFlowProblem& problem);
+    };
+
+    // *********************************** END worklist data-flow solver ********************************** //
+    // **************************************************************************************************** //
+
+}
+}
+
+#endif      // TL_DATAFLOW_HPP
@@ -26,6 +26,7 @@ Cambridge, MA 02139, USA.
 #include "cxx-cexpr.h"
 
 #include "tl-analysis-utils.hpp"
+#include "tl-dataflow.hpp"
 #include "tl-reaching-definitions.hpp"
 
 namespace TL {
@@ -140,42 +141,89 @@ namespace Analysis {
         }
     }
 
-    void ReachingDefinitions::solve_reaching_definition_equations(Node* current)
+namespace {
+
+    //! Reaching definition equations of the nodes of a DataFlowSolver, computed on bit vectors of definitions
+    class ReachingDefinitionsProblem : public DataFlowProblem
     {
-        bool changed = true;
-        while (changed)
+    private:
+        const DataFlowSolver& _solver;
+        Node* _first_stmt_node;
+
+        // A definition is a defined variable together with its value and statement
+        NodeclNumbering _vars;
+        std::map<std::pair<unsigned int, NodeclPair>, unsigned int> _def_ids;
+        NodeclList _def_vars;
+        ObjectList<NodeclPair> _def_values;
+        std::vector<BitVector> _var_defs;
+        BitVector _empty;
+
+        // Indexed by the position of the nodes in the solver
+        std::vector<BitVector> _gen;
+        std::vector<BitVector> _killed;
+        std::vector<BitVector> _rd_in;
+        std::vector<BitVector> _rd_out;
+        //! Nodes whose Reach Out (simple nodes) or Reach In (graph nodes) is part of the Reach In of the node
+        std::vector<ObjectList<Node*> > _rd_in_sources;
+        BitVector _first_stmt_rd_in;
+
+        BitVector insert_definitions(const NodeclMap& m)
         {
-            changed = false;
-            solve_reaching_definition_equations_rec(current, changed);
-            ExtensibleGraph::clear_visits(current);
+            BitVector result;
+            for (NodeclMap::const_iterator it = m.begin(); it != m.end(); ++it)
+            {
+                unsigned int var = _vars.insert(it->first);
+                std::pair<std::map<std::pair<unsigned int, NodeclPair>, unsigned int>::iterator, bool> res
+                    = _def_ids.insert(std::make_pair(std::make_pair(var, it->second), (unsigned int)_def_vars.size()));
+                if (res.second)
+                {
+                    _def_vars.append(it->first);
+                    _def_values.append(it->second);
+                    if (var >= _var_defs.size())
+                        _var_defs.resize(var + 1);
+                    _var_defs[var].insert(res.first->second);
+                }
+                result.insert(res.first->second);
+            }
+            return result;
         }
-    }
-
-    void ReachingDefinitions::solve_reaching_definition_equations_rec(Node* current, bool& changed)
-    {
-        if (current->is_visited())
-            return;
 
-        current->set_visited(true);
+        //! Definitions of the variables in #killed
+        BitVector get_killed_definitions(const NodeclSet& killed) const
+        {
+            BitVector result;
+            for (NodeclSet::const_iterator it = killed.begin(); it != killed.end(); ++it)
+            {
+                int var = _vars.find(*it);
+                if (var != -1)
+                    result.merge(_var_defs[var]);
+            }
+            return result;
+        }
 
-        if (current->is_exit_node())
-            return;
+        NodeclMap get_definitions(const BitVector& s) const
+        {
+            NodeclMap result;
+            const ObjectList<unsigned int>& ids = s.get_elements();
+            for (ObjectList<unsigned int>::const_iterator it = ids.begin(); it != ids.end(); ++it)
+                result.insert(std::pair<NBase, NodeclPair>(_def_vars[*it], _def_values[*it]));
+            return result;
+        }
 
-        if (current->is_graph_node())
+        const BitVector& get_rd_in(Node* n) const
         {
-            solve_reaching_definition_equations_rec(current->get_graph_entry_node(), changed);
-            set_graph_node_reaching_definitions(current);
+            int i = _solver.get_index(n);
+            return (i == -1) ? _empty : _rd_in[i];
         }
-        else if (!current->is_entry_node())
+
+        const BitVector& get_rd_out(Node* n) const
         {
-            const NodeclMap& old_rd_in = current->get_reaching_definitions_in();
-            const NodeclMap& old_rd_out = current->get_reaching_definitions_out();
-            NodeclMap rd_out, rd_in, pred_rd_out;
+            int i = _solver.get_index(n);
+            return (i == -1) ? _empty : _rd_out[i];
+        }
 
-            // Computing Reach Defs In
-            // First node with statements may have RDI comming from the parameters
-            if (current == _first_stmt_node)
-                rd_in = current->get_reaching_definitions_in();
+        void compute_predecessors(Node* current, ObjectList<Node*>& preds)
+        {
             const ObjectList<Node*>& parents = current->get_parents();
             for (ObjectList<Node*>::const_iterator it = parents.begin(); it != parents.end(); ++it)
             {
@@ -183,7 +231,6 @@ namespace Analysis {
                 {
                     // Iterate over outer parents while we found an ENTRY node
                     // Gather all parents which are not entry nodes
-                    ObjectList<Node*> non_entry_outer_parents;
                     std::stack<Node*> entries;
                     entries.push(*it);
                     while (!entries.empty())
@@ -209,61 +256,173 @@ namespace Analysis {
                             entry_outer_node = (parent_is_entry ? outer_parents[0]->get_outer_node() : NULL);
                         }
                         if (!outer_parents.empty())
-                            non_entry_outer_parents.append(outer_parents[0]);
-                    }
-                    // Get the Reach Def Out of the current predecessors
-                    for (ObjectList<Node*>::iterator itop = non_entry_outer_parents.begin();
-                         itop != non_entry_outer_parents.end(); ++itop)
-                    {
-                        const NodeclMap& outer_rd_out = (*itop)->get_reaching_definitions_out();
-                        pred_rd_out.insert(outer_rd_out.begin(), outer_rd_out.end());
+                            preds.append(outer_parents[0]);
                     }
                 }
                 else
                 {
-                    pred_rd_out = (*it)->get_reaching_definitions_out();
+                    preds.append(*it);
                 }
-                rd_in = Utils::nodecl_map_union(rd_in, pred_rd_out);
             }
+        }
 
-            // Computing Reach Defs Out
-            NodeclSet killed;
-            if (current->is_omp_task_creation_node())
-            {   // Variables from non-task children nodes do not count here
-                Node* created_task = ExtensibleGraph::get_task_from_task_creation(current);
-                ERROR_CONDITION(created_task==NULL,
-                                "Task created by task creation node %d not found.\n",
-                                current->get_id());
-                const NodeclSet& task_killed = created_task->get_killed_vars();
-                const NodeclSet& shared_vars = created_task->get_all_shared_accesses();
-                for (NodeclSet::const_iterator it = task_killed.begin(); it != task_killed.end(); ++it)
-                {
-                    if (shared_vars.find(*it) != shared_vars.end())
-                        killed.insert(*it);
-                }
+        void compute_graph_entries(Node* current, ObjectList<Node*>& entries)
+        {
+            const ObjectList<Node*>& children = current->get_graph_entry_node()->get_children();
+            bool has_non_goto_entry = false;
+            for (ObjectList<Node*>::const_iterator it = children.begin(); it != children.end(); ++it)
+                if (!(*it)->is_goto_node())
+                    has_non_goto_entry = true;
+
+            for (ObjectList<Node*>::const_iterator it = children.begin(); it != children.end(); ++it)
+            {   // Remove those definitions coming from any goto to a labeled node
+                if (!(*it)->is_labeled_node() || has_non_goto_entry)
+                    entries.append(*it);
             }
-            else
+        }
+
+        bool update(unsigned int i, const BitVector& rd_in, const BitVector& rd_out)
+        {
+            if (_rd_in[i] == rd_in && _rd_out[i] == rd_out)
+                return false;
+            _rd_in[i] = rd_in;
+            _rd_out[i] = rd_out;
+            return true;
+        }
+
+    public:
+        ReachingDefinitionsProblem(const DataFlowSolver& solver, Node* first_stmt_node)
+            : _solver(solver), _first_stmt_node(first_stmt_node),
+              _vars(), _def_ids(), _def_vars(), _def_values(), _var_defs(), _empty(),
+              _gen(solver.get_nodes().size()), _killed(solver.get_nodes().size()),
+              _rd_in(solver.get_nodes().size()), _rd_out(solver.get_nodes().size()),
+              _rd_in_sources(solver.get_nodes().size()), _first_stmt_rd_in()
+        {
+            const ObjectList<Node*>& nodes = solver.get_nodes();
+
+            // 1.- Number the definitions: those of the parameters and those generated by each node
+            if (_first_stmt_node != NULL)
+                _first_stmt_rd_in = insert_definitions(_first_stmt_node->get_reaching_definitions_in());
+            for (unsigned int i = 0; i < nodes.size(); ++i)
+            {
+                Node* n = nodes[i];
+                if (!n->is_graph_node() && !n->is_entry_node() && !n->is_exit_node())
+                    _gen[i] = insert_definitions(n->get_generated_stmts());
+            }
+
+            // 2.- Compute the definitions killed by each node and the sources of its Reach In
+            for (unsigned int i = 0; i < nodes.size(); ++i)
             {
-                killed = current->get_killed_vars();
+                Node* n = nodes[i];
+                if (n->is_graph_node())
+                {
+                    compute_graph_entries(n, _rd_in_sources[i]);
+                }
+                else if (!n->is_entry_node() && !n->is_exit_node())
+                {
+                    compute_predecessors(n, _rd_in_sources[i]);
+
+                    if (n->is_omp_task_creation_node())
+                    {   // Variables from non-task children nodes do not count here
+                        Node* created_task = ExtensibleGraph::get_task_from_task_creation(n);
+                        ERROR_CONDITION(created_task==NULL,
+                                        "Task created by task creation node %d not found.\n",
+                                        n->get_id());
+                        NodeclSet killed;
+                        const NodeclSet& task_killed = created_task->get_killed_vars();
+                        const NodeclSet& shared_vars = created_task->get_all_shared_accesses();
+                        for (NodeclSet::const_iterator it = task_killed.begin(); it != task_killed.end(); ++it)
+                        {
+                            if (shared_vars.find(*it) != shared_vars.end())
+                                killed.insert(*it);
+                        }
+                        _killed[i] = get_killed_definitions(killed);
+                    }
+                    else
+                    {
+                        _killed[i] = get_killed_definitions(n->get_killed_vars());
+                    }
+                }
             }
-            NodeclMap diff = Utils::nodecl_map_minus_nodecl_set(rd_in, killed);
+        }
+
+        void get_dependences(Node* n, ObjectList<Node*>& deps)
+        {
+            unsigned int i = _solver.get_index(n);
+            deps.append(_rd_in_sources[i]);
+            if (n->is_graph_node())
+                deps.append(n->get_graph_exit_node()->get_parents());
+        }
+
+        bool transfer(Node* n)
+        {
+            if (n->is_entry_node() || n->is_exit_node())
+                return false;
 
-            const NodeclMap& gen = current->get_generated_stmts();
-            rd_out = Utils::nodecl_map_union(gen, diff);
-            if (!Utils::nodecl_map_equivalence(old_rd_in, rd_in) ||
-                !Utils::nodecl_map_equivalence(old_rd_out, rd_out))
+            unsigned int i = _solver.get_index(n);
+            const ObjectList<Node*>& sources = _rd_in_sources[i];
+            if (n->is_graph_node())
             {
-                current->set_reaching_definitions_in(rd_in);
-                current->set_reaching_definitions_out(rd_out);
-                changed = true;
+                // RDI(graph) = U RDI(inner entries)
+                BitVector graph_rdi;
+                for (ObjectList<Node*>::const_iterator it = sources.begin(); it != sources.end(); ++it)
+                    graph_rdi.merge(get_rd_in(*it));
+
+                // RDO(graph) = U RDO(inner exits)
+                BitVector graph_rdo;
+                const ObjectList<Node*>& exits = n->get_graph_exit_node()->get_parents();
+                for (ObjectList<Node*>::const_iterator it = exits.begin(); it != exits.end(); ++it)
+                    graph_rdo.merge(get_rd_out(*it));
+                if (graph_rdo.empty())
+                {   // This may happen when no Reaching Defintion has been computed inside the graph or
+                    // when there is no statement inside the task and the information has not been propagated
+                    // (Entry and Exit nodes do not contain any analysis information)
+                    // In this case, we propagate the Reaching Definition Out from the parents
+                    graph_rdo = graph_rdi;
+                }
+                return update(i, graph_rdi, graph_rdo);
             }
+
+            // Computing Reach Defs In
+            // First node with statements may have RDI comming from the parameters
+            BitVector rd_in;
+            if (n == _first_stmt_node)
+                rd_in = _first_stmt_rd_in;
+            for (ObjectList<Node*>::const_iterator it = sources.begin(); it != sources.end(); ++it)
+                rd_in.merge(get_rd_out(*it));
+
+            // Computing Reach Defs Out
+            BitVector rd_out = _gen[i];
+            rd_out.merge_difference(rd_in, _killed[i]);
+            return update(i, rd_in, rd_out);
         }
 
-        ObjectList<Node*> children = current->get_children();
-        for (ObjectList<Node*>::iterator it = children.begin(); it != children.end(); ++it)
+        //! Stores the reaching definitions computed in the nodes of the graph
+        void store_reaching_definitions()
         {
-            solve_reaching_definition_equations_rec(*it, changed);
+            const ObjectList<Node*>& nodes = _solver.get_nodes();
+            for (unsigned int i = 0; i < nodes.size(); ++i)
+            {
+                Node* n = nodes[i];
+                if (n->is_entry_node() || n->is_exit_node())
+                    continue;
+                n->set_reaching_definitions_in(get_definitions(_rd_in[i]));
+                n->set_reaching_definitions_out(get_definitions(_rd_out[i]));
+            }
         }
+    };
+
+}
+
+    void ReachingDefinitions::solve_reaching_definition_equations(Node* current)
+    {
+        ObjectList<Node*> roots;
+        roots.append(current);
+
+        DataFlowSolver solver(roots, DATAFLOW_FORWARD);
+        ReachingDefinitionsProblem problem(solver, _first_stmt_node);
+        solver.solve(problem);
+        problem.store_reaching_definitions();
     }
 
     void ReachingDefinitions::set_graph_node_generated_statements(Node* current)
@@ -306,51 +465,6 @@ namespace Analysis {
         current->set_generated_stmts(graph_gen);
     }
 
-    void ReachingDefinitions::set_graph_node_reaching_definitions(Node* current)
-    {
-        if(current->is_graph_node())
-        {
-            // RDI(graph) = U RDI(inner entries)
-            NodeclMap graph_rdi;
-            ObjectList<Node*> entries = current->get_graph_entry_node()->get_children();
-            for(ObjectList<Node*>::iterator it = entries.begin(); it != entries.end(); ++it)
-            {
-                if(!(*it)->is_labeled_node())
-                {
-                    graph_rdi = Utils::nodecl_map_union(graph_rdi, (*it)->get_reaching_definitions_in());
-                }
-                else
-                {   // Remove those definitions coming from any goto to this labeled node
-                    ObjectList<Node*> parents = (*it)->get_parents();
-                    for(ObjectList<Node*>::iterator itt = entries.begin(); itt != entries.end(); ++itt)
-                    {
-                        if(!(*itt)->is_goto_node())
-                        {
-                            graph_rdi = Utils::nodecl_map_union(graph_rdi, (*it)->get_reaching_definitions_in());
-                        }
-                    }
-                }
-            }
-            current->set_reaching_definitions_in(graph_rdi);
-
-            // RDO(graph) = U RDO(inner exits)
-            NodeclMap graph_rdo;
-            ObjectList<Node*> exits = current->get_graph_exit_node()->get_parents();
-            for(ObjectList<Node*>::iterator it = exits.begin(); it != exits.end(); ++it)
-            {
-                graph_rdo = Utils::nodecl_map_union(graph_rdo, (*it)->get_reaching_definitions_out());
-            }
-            if(graph_rdo.empty())
-            {   // This may happen when no Reaching Defintion has been computed inside the graph or
-                // when there is no statement inside the task and the information has not been propagated 
-                // (Entry and Exit nodes do not contain any analysis information)
-                // In this case, we propagate the Reaching Definition Out from the parents
-                graph_rdo = graph_rdi;
-            }
-            current->set_reaching_definitions_out(graph_rdo);
-        }
-    }
-
     // *********************** End class implementing reaching definitions analysis *********************** //
     // **************************************************************************************************** //
 
@@ -49,16 +49,13 @@ namespace Analysis {
         //!Reach Out (X) = Gen (X)
         void gather_reaching_definitions_initial_information( Node* current );
 
-        //!Computes reaching definition equations for a given node and calls recursively to its children
+        //!Solves the reaching definition equations with a DataFlowSolver over bit vectors of definitions
         /*!
          * Reach in (X) = Union of all Reach Out (Y), for all Y predecessors of X
          * Reach out (X) = Gen (X) + ( Reach In (X) - Killed (X) )
          */
         void solve_reaching_definition_equations( Node* current );
-        void solve_reaching_definition_equations_rec( Node* current, bool& changed );
 
-        //! Propagates reaching definitions information from inner to outer nodes
-        void set_graph_node_reaching_definitions( Node* current );
         void set_graph_node_generated_statements(Node* current);
 
         NodeclMap combine_generated_statements(Node* current);
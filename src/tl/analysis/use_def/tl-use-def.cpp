@@ -192,9 +192,10 @@ namespace {
     
     void UseDef::compute_usage()
     {
-        Node* graph = _graph->get_graph();
-        compute_usage_rec(graph);
-        ExtensibleGraph::clear_visits(graph);
+        ObjectList<Node*> roots;
+        roots.append(_graph->get_graph());
+        DataFlowSolver solver(roots, DATAFLOW_FORWARD);
+        solver.solve(*this);
         _graph->set_usage_computed();
 
         if (ANALYSIS_INFO)
@@ -203,31 +204,32 @@ namespace {
         }
     }
 
-    // Top bottom traversal
-    void UseDef::compute_usage_rec(Node* n)
+    bool UseDef::is_inside_asm_node(Node* n) const
     {
-        // 1.- Base case 1: the node has already been visited
-        if (n->is_visited())
-            return;
+        for (Node* outer = n->get_outer_node(); outer != NULL; outer = outer->get_outer_node())
+        {
+            if (outer->is_asm_def_node() || outer->is_asm_op_node())
+                return true;
+        }
+        return false;
+    }
 
-        n->set_visited(true);
+    void UseDef::get_dependences(Node* n, ObjectList<Node*>& deps)
+    {}
 
-        // 2.- Base case 2_ the node is the exit of a graph node
-        //    (we will keep iterating from the graph node)
-        if (n->is_exit_node())
-            return;
+    bool UseDef::transfer(Node* n)
+    {
+        // 1.- Exit nodes have no usage, and the nodes inside an asm are not analyzed separately
+        if (n->is_exit_node() || is_inside_asm_node(n))
+            return false;
 
-        // 3.- Treat the current node
+        // 2.- Treat the current node
         if (n->is_graph_node()
                 && !n->is_asm_def_node() && !n->is_asm_op_node())
         {
-            // 3.1.- Use-def info is computed from inner nodes to outer nodes
-            compute_usage_rec(n->get_graph_entry_node());
-
-            // 3.2.- If the node contains tasks, analyze the tasks first
-            // We need to do this here because in order to propagate the tasks usage
-            // to the outer nodes where they are created,
-            // all children of the task_creation node must have the use-def computed
+            // 2.1.- If the node contains tasks, analyze the tasks first
+            // The inner nodes have already been computed, so
+            // all children of the task_creation node have the use-def computed
             ObjectList<Node*> inner_tasks;
             if (ExtensibleGraph::node_contains_tasks(n, n, inner_tasks))
             {
@@ -237,7 +239,7 @@ namespace {
                     propagate_task_usage_to_task_creation_node(*it);
             }
 
-            // 3.3.- Propagate usage info from inner to outer nodes
+            // 2.2.- Propagate usage info from inner to outer nodes
             if (_propagate_graph_nodes)
             {
                 set_graph_node_use_def(n);
@@ -255,10 +257,8 @@ namespace {
             }
         }
 
-        // 4.- Keep iterating from the children
-        const ObjectList<Node*>& children = n->get_children();
-        for (ObjectList<Node*>::const_iterator it = children.begin(); it != children.end(); ++it)
-            compute_usage_rec(*it);
+        // 3.- The usage is computed only once
+        return false;
     }
 
     void UseDef::propagate_task_usage_to_task_creation_node(Node* task_creation)
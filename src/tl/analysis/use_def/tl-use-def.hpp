@@ -28,6 +28,7 @@
 #define TL_USE_DEF_HPP
 
 
+#include "tl-dataflow.hpp"
 #include "tl-extensible-graph.hpp"
 #include "tl-nodecl-calc.hpp"
 #include "tl-nodecl-visitor.hpp"
@@ -43,8 +44,11 @@ namespace Analysis {
     
     extern SizeMap _pointer_to_size_map;
     
-    //! Class implementing Use-Def Analysis
-    class LIBTL_CLASS UseDef
+    /*! Class implementing Use-Def Analysis
+     *  The usage of each node is computed once by a DataFlowSolver traversing the graph forwards,
+     *  so the predecessors and the inner nodes of a node are computed before the node itself
+     */
+    class LIBTL_CLASS UseDef : public DataFlowProblem
     {
     private:
         //!Graph we are analyzing the usage which
@@ -69,10 +73,8 @@ namespace Analysis {
         //!Initialize all IPA modifiable variables' usage to NONE
         void initialize_ipa_var_usage();
 
-        /*!Method that computes recursively the Use-Definition information from a node
-         * \param current Node from which the method begins the computation
-         */
-        void compute_usage_rec(Node* current);
+        //! Returns true if #n is inside an asm definition or an asm operand, which are analyzed as a whole
+        bool is_inside_asm_node(Node* n) const;
 
         //! Propagate the use-def of the children of a task creation to the task_creation node
         void propagate_task_usage_to_task_creation_node(Node* task_creation);
@@ -88,6 +90,12 @@ namespace Analysis {
 
         //! Method computing the Use-Definition information on the member #graph
         void compute_usage();
+
+        //! The usage of a node does not have to be computed again when other nodes change
+        void get_dependences(Node* n, ObjectList<Node*>& deps);
+
+        //! Computes the Use-Definition information of #n. Always returns false
+        bool transfer(Node* n);
     };
 
     // ************************** End class implementing use-definition analysis ************************** //
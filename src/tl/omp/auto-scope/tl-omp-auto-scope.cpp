@@ -112,7 +112,7 @@ namespace OpenMP {
             IsOmpssEnabled = _ompss_mode_enabled;
             
             // Automatically set the scope of the variables involved in the task, if possible
-            TL::Analysis::AnalysisBase analysis(IsOmpssEnabled);
+            TL::Analysis::AnalysisBase analysis(IsOmpssEnabled, TL::Analysis::AnalysisCache::get_cache(dto));
             analysis.auto_scoping(ast);
             
             // Print the results if any and modify the environment for later lowering
@@ -2084,7 +2084,7 @@ skip_current_var: ;
             ompss_mode_enabled = _ompss_mode_enabled;
             
             // 2.- Compute the necessary analyses for reporting correctness logs
-            TL::Analysis::AnalysisBase analysis(ompss_mode_enabled);
+            TL::Analysis::AnalysisBase analysis(ompss_mode_enabled, TL::Analysis::AnalysisCache::get_cache(dto));
             // We compute liveness analysis (that includes PCFG and use-def) because 
             // we need the information computed by TaskConcurrency (last and next synchronization points of a task)
             if (VERBOSE)
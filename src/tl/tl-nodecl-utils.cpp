@@ -778,6 +778,10 @@ namespace Nodecl
         }
         */
 
+        // Structurally equal trees have the same structural hash
+        if (nodecl_get_structural_hash(n1_) != nodecl_get_structural_hash(n2_))
+            return false;
+
         bool equals = equal_trees_rec(n1_, n2_, skip_conversion_nodecls);
         return equals;
     }
@@ -800,7 +804,7 @@ namespace Nodecl
 
     size_t Utils::Nodecl_hash::operator() (const Nodecl::NodeclBase& n) const
     {
-        return nodecl_hash_table(n.get_internal_nodecl());
+        return nodecl_get_structural_hash(n.get_internal_nodecl());
     }
 
     bool Utils::Nodecl_structural_equal::operator() (const Nodecl::NodeclBase& n1, const Nodecl::NodeclBase& n2) const
@@ -84,6 +84,9 @@ namespace Utils {
         bool operator() (const Nodecl::NodeclBase& n1, const Nodecl::NodeclBase& n2) const;
     };
     
+    //! Strict weak ordering of structurally different trees (skipping conversions).
+    //! It does not use the structural hash: the hash mixes symbol addresses and
+    //! the analyses depend on the order of the sets, which must not change between runs
     struct Nodecl_structural_less {
         bool operator() (const Nodecl::NodeclBase& n1, const Nodecl::NodeclBase& n2) const;
     };
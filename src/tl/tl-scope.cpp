@@ -193,6 +193,7 @@ namespace TL
         ObjectList<Symbol> result;
 
         walk_scope_data_t walk_data(result, include_hidden);
+        ::scope_sign_in_lazy_entities(_decl_context->current_scope);
         dhash_ptr_walk(_decl_context->current_scope->dhash, (dhash_ptr_walk_fn*)walk_scope, &walk_data);
 
         return result;
@@ -35,6 +35,7 @@
 #include "cxx-ambiguity.h"
 #include "cxx-printscope.h"
 #include "cxx-utils.h"
+#include "cxx-process.h"
 #include "cxx-parser.h"
 #include "c99-parser.h"
 #include "fortran03-lexer.h"
@@ -46,6 +47,7 @@
 #include <sstream>
 #include <iomanip>
 #include <cstring>
+#include <map>
 
 namespace TL
 {
@@ -471,6 +473,57 @@ namespace TL
         CURRENT_CONFIGURATION->source_language = lang;
     }
 
+    // Trees of the sources parsed in the current translation unit, before any
+    // semantic analysis. Phases generate the same snippets many times, so
+    // their scanning and parsing is done once and every parse gets a copy.
+    // Semantic analysis is not cached because its result depends on the
+    // contents of the scope at the time of the parse
+    typedef std::pair<int (*)(AST*), std::string> parse_cache_key_t;
+    typedef std::map<parse_cache_key_t, AST> parse_cache_t;
+    static parse_cache_t parse_cache;
+    static translation_unit_t* parse_cache_translation_unit = NULL;
+
+    enum { PARSE_CACHE_MAX_ENTRIES = 4096 };
+
+    static void parse_cache_clear(bool free_trees)
+    {
+        if (free_trees)
+        {
+            for (parse_cache_t::iterator it = parse_cache.begin(); it != parse_cache.end(); ++it)
+                ast_free(it->second);
+        }
+        parse_cache.clear();
+    }
+
+    static AST parse_cache_get(const parse_cache_key_t& key)
+    {
+        if (parse_cache_translation_unit != CURRENT_COMPILED_FILE)
+        {
+            // The trees of the previous translation unit may have been
+            // released along with its region, so they cannot be freed here
+            parse_cache_clear(/* free_trees */ false);
+            parse_cache_translation_unit = CURRENT_COMPILED_FILE;
+            return NULL;
+        }
+
+        parse_cache_t::iterator it = parse_cache.find(key);
+        if (it == parse_cache.end())
+            return NULL;
+        return ast_copy(it->second);
+    }
+
+    static void parse_cache_set(const parse_cache_key_t& key, AST a)
+    {
+        // Sources embedding nodecls are hardly ever parsed twice
+        if (key.second.find("@NODECL-LITERAL-") != std::string::npos)
+            return;
+
+        if (parse_cache.size() >= PARSE_CACHE_MAX_ENTRIES)
+            parse_cache_clear(/* free_trees */ true);
+
+        parse_cache[key] = ast_copy(a);
+    }
+
     Nodecl::NodeclBase Source::parse_common(ReferenceScope ref_scope,
             ParseFlags parse_flags,
             const std::string& subparsing_prefix,
@@ -487,17 +540,23 @@ namespace TL
 
         std::string mangled_text = subparsing_prefix + extended_source;
 
-        prepare_lexer(mangled_text.c_str());
+        parse_cache_key_t key(parse, mangled_text);
+        AST a = parse_cache_get(key);
+        if (a == NULL)
+        {
+            prepare_lexer(mangled_text.c_str());
 
-        int parse_result = 0;
-        AST a = NULL;
+            int parse_result = 0;
 
-        parse_result = parse(&a);
+            parse_result = parse(&a);
 
-        if (parse_result != 0)
-        {
-            fatal_error("Could not parse source\n\n%s\n", 
-                    format_source(extended_source).c_str());
+            if (parse_result != 0)
+            {
+                fatal_error("Could not parse source\n\n%s\n", 
+                        format_source(extended_source).c_str());
+            }
+
+            parse_cache_set(key, a);
         }
 
         const decl_context_t* decl_context = decl_context_map_fun(ref_scope.get_scope().get_decl_context());
@@ -0,0 +1,19 @@
+/*
+<testinfo>
+test_generator=config/mercurium-fe-only
+test_CXXFLAGS="-std=c++11 --constexpr-steps=100"
+test_compile_fail=yes
+</testinfo>
+*/
+
+constexpr int sum(int n)
+{
+    return n == 0 ? 0 : n + sum(n - 1);
+}
+
+// This is fine
+static_assert(sum(50) == 1275, "");
+
+// This needs more evaluation steps than allowed, so it is diagnosed
+// as having exceeded the maximum number of steps
+static_assert(sum(1000) == 500500, "");
@@ -0,0 +1,25 @@
+/*
+<testinfo>
+test_generator=config/mercurium-fe-only
+test_CXXFLAGS="-std=c++11"
+</testinfo>
+*/
+
+// Without memoization of the calls this would take 2^90 evaluations
+constexpr unsigned long long fib(int n)
+{
+    return n < 2 ? n : fib(n - 1) + fib(n - 2);
+}
+
+static_assert(fib(10) == 55ULL, "");
+static_assert(fib(90) == 2880067194370816120ULL, "");
+
+constexpr int choose(int n, int k)
+{
+    return (k == 0 || k == n) ? 1 : choose(n - 1, k - 1) + choose(n - 1, k);
+}
+
+static_assert(choose(30, 15) == 155117520, "");
+
+int a[fib(20)];
+static_assert(sizeof(a) == 6765 * sizeof(int), "");
@@ -0,0 +1,51 @@
+/*
+<testinfo>
+test_generator=config/mercurium-fe-only
+test_CXXFLAGS="-std=c++11"
+</testinfo>
+*/
+
+// Interpretations discarded when solving ambiguous statements must not
+// remove symbols of the block scope nor leave checked expressions that
+// refer to symbols they introduced
+
+struct A
+{
+    A();
+    A(int);
+    A(int, int);
+};
+
+int g(int);
+
+void f(int a, int b)
+{
+    struct S { int x; };
+    S s = { 1 };
+
+    // Both interpretations declare U and V in the block, the symbols of the
+    // discarded one are removed
+    A (c)(int(sizeof(struct U*)));
+    A (d)[sizeof(struct V*)];
+    A (e)(int(sizeof(struct S*)), s.x);
+
+    static_assert(sizeof(c) == sizeof(A), "c is an object");
+    static_assert(sizeof(d) == sizeof(A) * sizeof(struct V*), "d is an array");
+    static_assert(sizeof(e) == sizeof(A), "e is an object");
+
+    // Names of the block scope are still bound to the same symbols
+    struct U* pu = 0;
+    struct V* pv = 0;
+    S t = s;
+    t.x = g(a) + sizeof(struct S);
+
+    // Expressions checked while solving the ambiguity are not checked again
+    g(a);
+    __typeof(g(a)) h = a + b;
+    A (i)[sizeof(struct V*) + sizeof(h)];
+
+    static_assert(sizeof(i) == sizeof(A) * (sizeof(struct V*) + sizeof(int)), "");
+}
+
+struct U { int y; };
+static_assert(sizeof(struct U) == sizeof(int), "global U is a different struct");
@@ -0,0 +1,35 @@
+/*
+<testinfo>
+test_generator=config/mercurium-fe-only
+test_CXXFLAGS="-std=c++11"
+</testinfo>
+*/
+
+// Implicit conversion sequences computed while a class is incomplete
+// must not be reused once the class has been completed
+
+struct B;
+char f(const B&);
+int f(...);
+
+static_assert(sizeof(f(1)) == sizeof(int), "int cannot be converted to an incomplete B");
+
+struct B
+{
+    B(int);
+};
+
+static_assert(sizeof(f(1)) == sizeof(char), "int is converted to B by its constructor");
+
+struct Base;
+struct Derived;
+char g(Base*);
+int g(...);
+
+Derived* d = 0;
+static_assert(sizeof(g(d)) == sizeof(int), "Derived* cannot be converted to Base* yet");
+
+struct Base { };
+struct Derived : Base { };
+
+static_assert(sizeof(g(d)) == sizeof(char), "Derived* is converted to Base*");
@@ -0,0 +1,59 @@
+/*--------------------------------------------------------------------
+  (C) Copyright 2006-2012 Barcelona Supercomputing Center
+                          Centro Nacional de Supercomputacion
+  
+  This file is part of Mercurium C/C++ source-to-source compiler.
+  
+  See AUTHORS file in the top level directory for information
+  regarding developers and contributors.
+  
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3 of the License, or (at your option) any later version.
+  
+  Mercurium C/C++ source-to-source compiler is distributed in the hope
+  that it will be useful, but WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+  PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public
+  License along with Mercurium C/C++ source-to-source compiler; if
+  not, write to the Free Software Foundation, Inc., 675 Mass Ave,
+  Cambridge, MA 02139, USA.
+--------------------------------------------------------------------*/
+
+
+/*
+<testinfo>
+test_generator=config/mercurium-analysis
+test_nolink=yes
+</testinfo>
+*/
+
+// Variables local to a block are not alive out of the block
+int foo(int n)
+{
+    int s = 0;
+    #pragma analysis_check assert live_in(n, s) live_out(s)
+    {
+        int t = n * 2;
+        s = s + t;
+    }
+    return s;
+}
+
+// x is alive after its first definition only through the goto
+int bar(int a, int b)
+{
+    int x;
+    #pragma analysis_check assert live_in(a, b) live_out(b, x)
+    x = a;
+    if (b > 0)
+        goto end;
+    x = b;
+end:
+    x = x + 1;
+    return x;
+}
@@ -0,0 +1,60 @@
+/*--------------------------------------------------------------------
+  (C) Copyright 2006-2012 Barcelona Supercomputing Center
+                          Centro Nacional de Supercomputacion
+  
+  This file is part of Mercurium C/C++ source-to-source compiler.
+  
+  See AUTHORS file in the top level directory for information
+  regarding developers and contributors.
+  
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 3 of the License, or (at your option) any later version.
+  
+  Mercurium C/C++ source-to-source compiler is distributed in the hope
+  that it will be useful, but WITHOUT ANY WARRANTY; without even the
+  implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+  PURPOSE.  See the GNU Lesser General Public License for more
+  details.
+  
+  You should have received a copy of the GNU Lesser General Public
+  License along with Mercurium C/C++ source-to-source compiler; if
+  not, write to the Free Software Foundation, Inc., 675 Mass Ave,
+  Cambridge, MA 02139, USA.
+--------------------------------------------------------------------*/
+
+
+/*
+<testinfo>
+test_generator=config/mercurium-analysis
+test_nolink=yes
+</testinfo>
+*/
+
+#include <string>
+
+std::string UNKNOWN = "UNKNOWN";
+std::string UNDEFINED = "UNDEFINED";
+
+// The parameters reach the first statement of the function
+int f(int a, int b)
+{
+    int c;
+#pragma analysis_check assert reaching_definition_in(a: UNKNOWN; b: UNKNOWN; c: UNDEFINED) \
+                              reaching_definition_out(a: UNKNOWN; b: UNKNOWN; c: a + b)
+    c = a + b;
+    return c;
+}
+
+// The definition within the loop reaches the loop body again through the back edge
+void g(int n)
+{
+    int x, i;
+    x = 0;
+    for (i = 0; i < n; i++)
+    {
+#pragma analysis_check assert reaching_definition_in(x: 0; x: i + 1; n: UNKNOWN)
+        x = i + 1;
+    }
+}
@@ -0,0 +1,57 @@
+/*
+<testinfo>
+test_generator="config/mercurium-hlt run"
+</testinfo>
+*/
+
+#include <cassert>
+
+// All the functions are expanded from SUM_FUNCTIONS on the same line, so the
+// argument of their collapse clauses is the same text, which is parsed once.
+// It must still be looked up in the scope of each pragma: collapsing the
+// loop of sum_1 by 2 or 3 is an error
+
+#define SUM_FUNCTION(name, n, params, loops) \
+    int name params \
+    { \
+        typedef char N[n]; \
+        int result = 0; \
+        _Pragma("hlt collapse(sizeof(N))") \
+        loops \
+        return result; \
+    }
+
+#define SUM_FUNCTIONS \
+    SUM_FUNCTION(sum_3, 3, (int m[2][3][4]), \
+            for (int i = 0; i < 2; i++) \
+                for (int j = 0; j < 3; j++) \
+                    for (int k = 0; k < 4; k++) \
+                        result += m[i][j][k];) \
+    SUM_FUNCTION(sum_1, 1, (int v[4]), \
+            for (int i = 0; i < 4; i++) \
+                result += v[i];) \
+    SUM_FUNCTION(sum_2, 2, (int m[3][4]), \
+            for (int i = 0; i < 3; i++) \
+                for (int j = 0; j < 4; j++) \
+                    result += m[i][j];)
+
+SUM_FUNCTIONS
+
+int main()
+{
+    int m3[2][3][4];
+    for (int i = 0; i < 2; i++)
+        for (int j = 0; j < 3; j++)
+            for (int k = 0; k < 4; k++)
+                m3[i][j][k] = 1;
+    assert(sum_3(m3) == 24);
+
+    int m[3][4];
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 4; j++)
+            m[i][j] = i * 4 + j;
+    assert(sum_1(m[0]) == 6);
+    assert(sum_2(m) == 66);
+
+    return 0;
+}